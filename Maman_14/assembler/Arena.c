@@ -0,0 +1,288 @@
+#include "Arena.h"
+
+/* Alignment of allocated memory in bytes. */
+#define ARENA_ALIGN (sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*))
+
+/* Size of block header rounded up to alignment. */
+#define ARENA_HEADER_SIZE (((sizeof(ArenaBlock) + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN)
+
+/* Arena used by Allocate() and Reallocate(). */
+static Arena* current_arena = NULL;
+/* Key of arena of thread (see EnableThreadArenas()). */
+static pthread_key_t thread_arena_key;
+/* 1 if threads can have own arenas. */
+static int thread_arenas = 0;
+/* Arenas of worker threads (see WorkerArena()). */
+static Arena* worker_arenas[MAX_WORKER_ARENAS];
+/* Number of created worker arenas. */
+static int num_worker_arenas = 0;
+
+/* Creates new arena without blocks.
+   Arguments:
+    blockSize   -- Size of memory blocks in bytes.
+   Returns:
+    New arena allocated on heap. */
+Arena* CreateArena(size_t blockSize) {
+    /* Allocating structure. */
+    Arena* arena = (Arena*)TRACKED_MALLOC(sizeof(Arena), site_arena);
+    if (arena == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+
+    /* Blocks will be allocated on first use. */
+    arena->head = NULL;
+    arena->spare = NULL;
+    arena->block_size = blockSize;
+
+    return arena;
+}
+
+/* Gets empty block for the arena. Spare block is taken if
+   one of them is big enough, otherwise new block is allocated.
+   Block is added to the list of used blocks. If block is
+   taken for a big allocation while first block still has
+   free space it is placed after the first block, so next
+   small allocations will continue to fill the first block.
+   Arguments:
+    arena   -- Arena.
+    size    -- Minimal size of block memory area.
+   Returns:
+    Empty block. */
+ArenaBlock* AddArenaBlock(Arena* arena, size_t size) {
+    ArenaBlock* block = arena->spare; /* Spare blocks iterator. */
+    ArenaBlock* prev = NULL;          /* Block before block iterator. */
+    size_t request = size;            /* Requested size. */
+
+    /* Searching spare block with enough space. */
+    while (block != NULL && block->size < size) {
+        prev = block;
+        block = block->next;
+    }
+
+    if (block != NULL) {
+        /* Removing block from spare list. */
+        if (prev != NULL)
+            prev->next = block->next;
+        else
+            arena->spare = block->next;
+    }
+    else {
+        if (size < arena->block_size)
+            size = arena->block_size;
+
+        /* Allocating header and memory area together. */
+        block = (ArenaBlock*)TRACKED_MALLOC(ARENA_HEADER_SIZE + size, site_arena);
+        if (block == NULL) {
+            perror("Failed to allocate memory.");
+            exit(1);
+        }
+        block->size = size;
+    }
+    block->used = 0;
+
+    /* Adding block to the list of used blocks. */
+    if (arena->head != NULL && request > arena->block_size/4 &&
+        arena->head->size - arena->head->used >= arena->block_size/4) {
+        block->next = arena->head->next;
+        arena->head->next = block;
+    }
+    else {
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    return block;
+}
+
+/* Allocates memory from arena.
+   Memory is aligned for any type.
+   Arguments:
+    arena   -- Arena.
+    size    -- Number of bytes.
+   Returns:
+    Pointer to allocated memory. Exits program if memory can't be allocated.
+   Algorithm:
+    Memory is taken from the first block. If it has not enough space
+    block is taken by AddArenaBlock(). Other used blocks are never
+    searched, so allocation does not depend on number of blocks. */
+void* ArenaAlloc(Arena* arena, size_t size) {
+    ArenaBlock* block = arena->head; /* Block to allocate from. */
+    char* mem; /* Allocated memory. */
+
+    /* Rounding size up to alignment. */
+    size = ((size + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN;
+    if (size == 0)
+        size = ARENA_ALIGN;
+
+    /* Getting another block if first one has not enough free space. */
+    if (block == NULL || block->size - block->used < size)
+        block = AddArenaBlock(arena, size);
+
+    /* Taking memory from the block. */
+    mem = (char*)block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+
+    return mem;
+}
+
+/* Releases all memory allocated from arena.
+   Blocks are not freed and will be reused.
+   Arguments:
+    arena   -- Arena. */
+void ResetArena(Arena* arena) {
+    ArenaBlock* block = arena->head; /* Block iterator. */
+    ArenaBlock* next; /* Block after iterator. */
+
+    /* Moving used blocks to spare list. */
+    while (block != NULL) {
+        next = block->next;
+        block->used = 0;
+        block->next = arena->spare;
+        arena->spare = block;
+        block = next;
+    }
+    arena->head = NULL;
+    TRACK_ARENA_RESET();
+}
+
+/* Frees arena blocks and arena structure.
+   Arguments:
+    arena   -- Arena. */
+void FreeArena(Arena* arena) {
+    ArenaBlock* block; /* Block iterator. */
+    ArenaBlock* next; /* Block after iterator. */
+
+    /* Moving all blocks to spare list and freeing it. */
+    ResetArena(arena);
+    block = arena->spare;
+    while (block != NULL) {
+        next = block->next;
+        TRACKED_FREE(block, ARENA_HEADER_SIZE + block->size);
+        block = next;
+    }
+    if (current_arena == arena)
+        current_arena = NULL;
+    TRACKED_FREE(arena, sizeof(Arena));
+}
+
+/* Sets arena that will be used by Allocate() and Reallocate().
+   Arguments:
+    arena   -- Arena for current source file. */
+void UseArena(Arena* arena) {
+    current_arena = arena;
+}
+
+/* Makes arena used by Allocate() and Reallocate() specific to thread.
+   Should be called by main thread before threads that call UseThreadArena() are started.
+   Threads without own arena use arena set by UseArena(). */
+void EnableThreadArenas(void) {
+    if (thread_arenas)
+        return;
+    if (pthread_key_create(&thread_arena_key, NULL) != 0) {
+        perror("Failed to create thread key.");
+        exit(1);
+    }
+    thread_arenas = 1;
+}
+
+/* Sets arena that will be used by Allocate() and Reallocate() in calling thread.
+   Arguments:
+    arena   -- Arena of the thread, NULL to use arena set by UseArena(). */
+void UseThreadArena(Arena* arena) {
+    pthread_setspecific(thread_arena_key, arena);
+}
+
+/* Returns arena used by Allocate() and Reallocate() in calling thread.
+   If current arena is not set it is created. */
+Arena* CurrentArena(void) {
+    Arena* arena = NULL; /* Arena of the thread. */
+
+    if (thread_arenas)
+        arena = (Arena*)pthread_getspecific(thread_arena_key);
+    if (arena == NULL) {
+        if (current_arena == NULL)
+            current_arena = CreateArena(ARENA_BLOCK_SIZE);
+        arena = current_arena;
+    }
+    return arena;
+}
+
+/* Returns arena for worker thread, creates it on first use.
+   Arguments:
+    i       -- Number of worker (0 to MAX_WORKER_ARENAS-1).
+   Returns:
+    Arena of the worker.
+   Algorithm:
+    Arenas are kept between parallel stages, so their blocks are reused
+    the same way as blocks of file arena. */
+Arena* WorkerArena(int i) {
+    while (num_worker_arenas <= i)
+        worker_arenas[num_worker_arenas++] = CreateArena(ARENA_BLOCK_SIZE);
+    return worker_arenas[i];
+}
+
+/* Releases memory of all worker arenas.
+   Should be called before workers of next parallel stage are started. */
+void ResetWorkerArenas(void) {
+    int i; /* Arenas iterator. */
+
+    for (i = 0; i < num_worker_arenas; i++)
+        ResetArena(worker_arenas[i]);
+}
+
+/* Frees all worker arenas. */
+void FreeWorkerArenas(void) {
+    while (num_worker_arenas > 0)
+        FreeArena(worker_arenas[--num_worker_arenas]);
+}
+
+/* Allocates memory from current arena (set by UseArena(), or UseThreadArena()).
+   If current arena is not set it is created.
+   Arguments:
+    size    -- Number of bytes.
+   Returns:
+    Pointer to allocated memory. */
+void* Allocate(size_t size) {
+    CountStat(cnt_allocs);
+    return ArenaAlloc(CurrentArena(), size);
+}
+
+/* Changes size of memory allocated from current arena.
+   If ptr is the last allocation and block has enough space it is
+   expanded in place. Otherwise new memory is allocated and old content
+   is copied, old memory is not reused until arena reset.
+   Arguments:
+    ptr     -- Memory allocated by Allocate(), or NULL.
+    oldSize -- Current size of memory in bytes.
+    newSize -- New size of memory in bytes.
+   Returns:
+    Pointer to new memory. */
+void* Reallocate(void* ptr, size_t oldSize, size_t newSize) {
+    void* mem; /* New memory. */
+    Arena* arena = CurrentArena(); /* Arena of the thread. */
+
+    CountStat(cnt_reallocs);
+
+    /* Expanding last allocation of the first block in place. */
+    if (ptr != NULL && arena->head != NULL) {
+        ArenaBlock* block = arena->head; /* Block where last allocation was made. */
+        char* start = (char*)block + ARENA_HEADER_SIZE; /* Memory area of the block. */
+        size_t oldAligned = ((oldSize + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN; /* Aligned old size. */
+        size_t newAligned = ((newSize + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN; /* Aligned new size. */
+
+        if (oldAligned != 0 && (char*)ptr + oldAligned == start + block->used
+            && newAligned >= oldAligned && block->used - oldAligned + newAligned <= block->size) {
+            block->used = block->used - oldAligned + newAligned;
+            return ptr;
+        }
+    }
+
+    mem = Allocate(newSize);
+
+    /* Copying old content. */
+    if (ptr != NULL)
+        memcpy(mem, ptr, oldSize < newSize ? oldSize : newSize);
+
+    return mem;
+}
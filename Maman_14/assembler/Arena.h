@@ -0,0 +1,117 @@
+#ifndef ARENA_H
+    #define ARENA_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "Stats.h"
+
+/* Default size of arena memory block in bytes. */
+#define ARENA_BLOCK_SIZE 65536
+
+/* Maximum number of arenas of worker threads (see WorkerArena()). */
+#define MAX_WORKER_ARENAS 64
+
+/* Block of memory owned by arena.
+   Allocated memory area follows the header. */
+typedef struct ArenaBlock {
+    struct ArenaBlock* next; /* Next block in the arena. */
+    size_t size;             /* Size of memory area of the block in bytes. */
+    size_t used;             /* Number of bytes given away from the block. */
+} ArenaBlock;
+
+/* Arena (bump) allocator.
+   Memory is taken from big blocks by advancing a pointer
+   and cannot be freed individually. All memory is released
+   at once by ResetArena(), blocks are kept for next use.
+   Arena is used for all objects that live while one source file
+   is assembled - symbols, references, instructions, list nodes,
+   strings and dynamic arrays. */
+typedef struct Arena {
+    ArenaBlock* head;    /* List of used blocks, first block is the one being filled. */
+    ArenaBlock* spare;   /* List of empty blocks left after reset. */
+    size_t block_size;   /* Size of new blocks in bytes. */
+} Arena;
+
+/* Creates new arena without blocks.
+   Arguments:
+    blockSize   -- Size of memory blocks in bytes.
+   Returns:
+    New arena allocated on heap. */
+Arena* CreateArena(size_t blockSize);
+
+/* Allocates memory from arena.
+   Memory is aligned for any type.
+   Arguments:
+    arena   -- Arena.
+    size    -- Number of bytes.
+   Returns:
+    Pointer to allocated memory. Exits program if memory can't be allocated. */
+void* ArenaAlloc(Arena* arena, size_t size);
+
+/* Releases all memory allocated from arena.
+   Blocks are not freed and will be reused.
+   Arguments:
+    arena   -- Arena. */
+void ResetArena(Arena* arena);
+
+/* Frees arena blocks and arena structure.
+   Arguments:
+    arena   -- Arena. */
+void FreeArena(Arena* arena);
+
+/* Sets arena that will be used by Allocate() and Reallocate().
+   Arguments:
+    arena   -- Arena for current source file. */
+void UseArena(Arena* arena);
+
+/* Makes arena used by Allocate() and Reallocate() specific to thread.
+   Should be called by main thread before threads that call UseThreadArena() are started.
+   Threads without own arena use arena set by UseArena(). */
+void EnableThreadArenas(void);
+
+/* Sets arena that will be used by Allocate() and Reallocate() in calling thread.
+   Arguments:
+    arena   -- Arena of the thread, NULL to use arena set by UseArena(). */
+void UseThreadArena(Arena* arena);
+
+/* Returns arena used by Allocate() and Reallocate() in calling thread.
+   If current arena is not set it is created. */
+Arena* CurrentArena(void);
+
+/* Returns arena for worker thread, creates it on first use.
+   Arguments:
+    i       -- Number of worker (0 to MAX_WORKER_ARENAS-1).
+   Returns:
+    Arena of the worker. */
+Arena* WorkerArena(int i);
+
+/* Releases memory of all worker arenas.
+   Should be called before workers of next parallel stage are started. */
+void ResetWorkerArenas(void);
+
+/* Frees all worker arenas. */
+void FreeWorkerArenas(void);
+
+/* Allocates memory from current arena (set by UseArena(), or UseThreadArena()).
+   If current arena is not set it is created.
+   Arguments:
+    size    -- Number of bytes.
+   Returns:
+    Pointer to allocated memory. */
+void* Allocate(size_t size);
+
+/* Changes size of memory allocated from current arena.
+   If ptr is the last allocation and block has enough space it is
+   expanded in place. Otherwise new memory is allocated and old content
+   is copied, old memory is not reused until arena reset.
+   Arguments:
+    ptr     -- Memory allocated by Allocate(), or NULL.
+    oldSize -- Current size of memory in bytes.
+    newSize -- New size of memory in bytes.
+   Returns:
+    Pointer to new memory. */
+void* Reallocate(void* ptr, size_t oldSize, size_t newSize);
+
+#endif
@@ -12,24 +12,17 @@
     Returns -1 if statement not recognized) */
 int GetDirectiveType(char *line, int *pos)
 {
-    char name[MAX_STATEMENT_LEN + 2]; /* Buffer for holding word from line. */
-    char *res;                        /* Result of getting the word. */
+    Span name; /* Directive name in line. */
+    int type;  /* Directive type. */
 
     /* Reading first word (after label). */
-    res = GetNextWord(line, pos, name, MAX_STATEMENT_LEN + 1, ",");
     /* If there is no word. */
-    if (res == NULL)
+    if (!GetNextSpan(line, pos, &name, MAX_STATEMENT_LEN + 1, ","))
         return -1;
 
-    /* Checking directive names. */
-    if (CompareStrings(name, ".data"))
-        return dir_data;
-    if (CompareStrings(name, ".string"))
-        return dir_string;
-    if (CompareStrings(name, ".entry"))
-        return dir_entry;
-    if (CompareStrings(name, ".extern"))
-        return dir_extern;
+    /* Checking directive names (keywords that start with '.'). */
+    if (line[name.start] == '.' && ClassifyWord(line + name.start, name.len, &type) == rw_keyword)
+        return type;
 
     return -1;
 }
@@ -38,21 +31,22 @@ int GetDirectiveType(char *line, int *pos)
 
 /* Writes .data line arguments to data binary segment.
    Arguments:
-    dataArgs    -- Parsed numeric values of .data arguments.
+    values      -- Parsed numeric values of .data arguments.
+    count       -- Number of values.
     data        -- Data binary segment. */
-void DataToBinary(DynArr *dataArgs, BinarySegment *data)
+void DataToBinary(int *values, int count, BinarySegment *data)
 {
     int i = 0;   /* Iterator. */
     int are = 4; /* Absolute addressing mode 100 = 4*/
 
     /* Writing .data argument values to binary data segment.*/
-    for (i = 0; i < dataArgs->count; i++)
+    for (i = 0; i < count; i++)
     {
         int word = 0;                  /* Binary word. */
         int isNegative = 0;            /* Flag that shows if value is negative. */
         int one = 1;                   /* Number one. */
         int bit = 0;                   /* Bit iterator. */
-        int value = dataArgs->data[i]; /* Argument value. */
+        int value = values[i];         /* Argument value. */
         /* Truncating value to 16 bits by copying into word only 16 least significant bits of the value. */
         /* If value is negative its positive compliment found before truncating. */
         if (value < 0)
@@ -79,23 +73,20 @@ void DataToBinary(DynArr *dataArgs, BinarySegment *data)
 
 /* Writes .string line argument to data binary segment.
    Arguments:
-    line    -- Line containing .string directive.
-    pos     -- Position in line after word .string and before arguments.
+    str     -- Characters of the string (content of "", not null-terminated).
+    len     -- Number of characters.
     data    -- Data binary segment.
-    lineNum -- Number of line in expanded source code.
-    errors  -- List of errors.
-    slr     -- Source line reference.
  */
-void StringToBinary(char *arg, BinarySegment *data)
+void StringToBinary(char *str, int len, BinarySegment *data)
 {
     int i=0;       /* Iterator. */
     int are = 4; /* Absolute mode ARE = 100 = 4. */
     int word;    /* Binary word. */
 
     /* Writing individual letters to data segment. */
-    while (arg[i] != '\0')
+    while (i < len)
     {
-        word = arg[i];
+        word = str[i];
         word += are << 16;
         AddBinary(data, word);
         i++;
@@ -109,27 +100,23 @@ void StringToBinary(char *arg, BinarySegment *data)
 
 /* Translates given instruction structure to binary words
    and writes them into code binary segment.
-   Creates label references if found and adds them to list.
+   Creates label references if found and adds them to references.
    Arguments:
     ins          -- Instruction structure.
     code         -- Code binary segment.
-    references   -- List of label arguments (label references).
+    references   -- Vector of label arguments (label references).
     lineNum      -- Number of line in expanded source file where instruction originates.
    Algorithm:
-    Breaks down each word to elements (opcode, addressing mode, etc), determines element value
-    and uses binary shifts to combine elements into binary word.
-    Uses InsInfo to get instruction description and uses it alongside with ins structure
-    to produce elements. */
-void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int lineNum) {
-    InsInfo info;      /* Info about instruction. */
-    int word;          /* Number representing machine word. */
-    int are;           /* Number that represent adressing mode for word. */
-    int opcode;        /* Number that represent opcode. */
-    int funct;         /* Number that represent funct.*/
-    int src = 0;       /* Number that represent source register. */
-    int src_mode = 0;  /* Number that represent source register addressing mode. */
-    int dest = 0;      /* Number that represent destination register. */
-    int dest_mode = 0; /* Number that represent destination register addressing mode.*/
+    First word and second word without register fields are taken from
+    instruction info table (indexed by source and destination addressing modes).
+    Register numbers are added to second word by binary shifts.
+    Then data words are added according to addressing modes of arguments. */
+void InstructionToBinary(Ins* ins, BinarySegment* code, Vector* references, int lineNum) {
+    const InsInfo* info; /* Info about instruction. */
+    int word;            /* Number representing machine word. */
+    int are = 4;         /* ARE of data words is ablosute = 100 = 4. */
+    int src_mode = 0;    /* Number that represent source register addressing mode. */
+    int dest_mode;       /* Number that represent destination register addressing mode.*/
     /* Typical two-word instruction:
        0[are][opcode]
        0[are][funct][src][src_mode][dest][dest_mode]*/
@@ -137,62 +124,33 @@ void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int li
     /* Getting instruction info. */
     info = GetInstructionInfo(ins->ins);
 
-    /* ***** Encoding opcode word. ***** */
-    /* ARE for instruction word is ablosute = 100 = 4*/
-    are = 4;
-    /* Encoding opcode by shifting 1 to 'opcode' bit. */
-    opcode = 1 << info.opcode;
-    /* Combining ARE and opcode to word. */
-    word = opcode + (are << 16);
-    /* Writing word to code segment. */
-    AddBinary(code, word);
+    /* ***** Writing opcode word. ***** */
+    AddBinary(code, info->first_word);
 
     /* If instruction does not have arguments we are done. */
-    if (info.amodes_dest == 0 && info.amodes_source == 0)
+    /* If instruction has argument it at least has destination argument. */
+    if (info->amodes_dest == 0)
         return;
 
-    /* If instruction has arguments. */
-
     /* ***** Encoding funct word ***** */
-    /* ARE stays absolute, so are=4. */
-    /* Encoding funct. */
-    if (info.funct >=10 && info.funct <= 13)
-        funct = info.funct;
-    else   
-        funct = 0;
-    /* If instruction has argument it at least has destination argument. */
-    /* Encoding destination addressing mode. */
     dest_mode = ins->dest->amode;
-    /* Encoding destination register. */
-    if (dest_mode == am_immediate || dest_mode == am_direct)
-        /* In direct and immediate modes register not specified. */
-        dest = 0;
-    else
-        /* In indexed and register modes register is saved in value field of argument structure. */
-        dest = ins->dest->val;
     /* If there is source argument */
-    if (info.amodes_source != 0) {
-        /* Encoding source addressing mode. */
+    if (info->amodes_source != 0)
         src_mode = ins->source->amode;
-        /* Encoding source register. */
-        if (src_mode == am_immediate || src_mode == am_direct)
-            src = 0;
-        else
-            src = ins->source->val;
-    }
-    /* Combining fields to funct word using binary shift. */
-    word = dest_mode;
-    word += dest << 2;
-    word += src_mode << 6;
-    word += src << 8;
-    word += funct << 12;
-    word += are << 16;
+    /* Getting word with funct and addressing modes. */
+    word = info->second_words[src_mode][dest_mode];
+    /* In indexed and register modes register is saved in value field of argument structure.
+       In direct and immediate modes register not specified and left 0. */
+    if (dest_mode == am_index || dest_mode == am_rdirect)
+        word |= ins->dest->val << 2;
+    if (info->amodes_source != 0 && (src_mode == am_index || src_mode == am_rdirect))
+        word |= ins->source->val << 8;
     /* Writing word to code segment. */
     AddBinary(code, word);
     
     /* ***** Encoding data words ***** */
     /* If function has source argument. */
-    if (info.amodes_source != 0) {
+    if (info->amodes_source != 0) {
         /* If source mode is immediate writing value word. */
         if (src_mode == am_immediate) {
             word = ins->source->val + (are << 16);
@@ -200,9 +158,8 @@ void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int li
         }
         /* If source mode is direct, or indexed modes leave 2 blank words to resolve data+offset later. */
         if (src_mode == am_direct || src_mode == am_index) {
-            /* Adding label to list of unresolved references. */
-            LabelReference* ref = CreateLabelReference(ins->source->label, NextSegmentAddress(code), lineNum);
-            ListAdd(references, ref);
+            /* Adding label to unresolved references. */
+            AddLabelReference(references, ins->source->label, NextSegmentAddress(code), lineNum);
             /* Adding binary words. */
             AddBinary(code, 0);
             AddBinary(code, 0);
@@ -218,9 +175,8 @@ void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int li
     }
     /* If destination is in direct, or indexed modes leave 2 blank words to resolve base+offset later. */
     if (dest_mode == am_direct || dest_mode == am_index) {
-        /* Adding label to list of unresolved references. */
-        LabelReference* ref = CreateLabelReference(ins->dest->label, NextSegmentAddress(code), lineNum);
-        ListAdd(references, ref);
+        /* Adding label to unresolved references. */
+        AddLabelReference(references, ins->dest->label, NextSegmentAddress(code), lineNum);
         /* Adding binary words. */
         AddBinary(code, 0);
         AddBinary(code, 0);
@@ -234,7 +190,8 @@ void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int li
    Also produces structure that describes label before the line if it is present.
    Arguments:
     line        -- String that contains statement.
-    references  -- List of label arguments (label references).
+    symbols     -- Symbols table where labels are interned.
+    references  -- Vector of label arguments (label references).
     code        -- Code binary segment.
     data        -- Data binary segment.
     errors      -- Errors list.
@@ -252,7 +209,7 @@ void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int li
     for .entry and .extern.
     If command name does not begin with a dot ParseInstructionLine is called and Ins structure produced. Then InstructionToBinary 
     called to translate and write Ins structure to binary code. */
-Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, BinarySegment* data, Errors* errors) {
+Symbol* StatementToBinary(char* line, SymbolsTable* symbols, Vector* references, BinarySegment* code, BinarySegment* data, Errors* errors) {
     int pos = 0;                       /* Position in line. */
     char label[MAX_STATEMENT_LEN + 2]; /* Buffer for holding label. */
     char* lptr;                        /* Variable for holding result of getting the label.*/
@@ -287,31 +244,38 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
 
         /* If directive is .data. */
         if (dir_type == dir_data) {
-            List* raw_data_args;                         /* Raw .data arguments (strings). */
-            DynArr* data_args;                           /* parsed .data arguments (values). */
+            Span stack_args[MAX_ARGS];                   /* .data arguments (spans in line). */
+            int stack_values[MAX_ARGS];                  /* Parsed .data arguments (values). */
+            Span* args = stack_args;                     /* Arguments buffer used. */
+            int* values = stack_values;                  /* Values buffer used. */
+            int max_args = MAX_ARGS;                     /* Size of arguments buffers. */
+            int num_args;                                /* Number of arguments. */
             int data_counter = NextSegmentAddress(data); /* Adress of this data block. */
 
+            /* Line longer than allowed can have more arguments than fit in buffers on stack. */
+            if (StringLen(line) > MAX_STATEMENT_LEN) {
+                max_args = StringLen(line)/2 + 1;
+                args = (Span*)Allocate(sizeof(Span)*max_args);
+                values = (int*)Allocate(sizeof(int)*max_args);
+            }
+
             /* Getting raw arguments. */
-            raw_data_args = GetRawArgs(line, &pos, errors);
+            num_args = GetRawArgs(line, &pos, args, max_args, errors);
             /* Checking if arguments are present. */
-            if (raw_data_args->count == 0)
+            if (num_args == 0)
             {
                 AddError(errors, ErrDt_DtNoArgument, line, NULL);
-                FreeListAndData(raw_data_args);
                 return NULL;
             }
             /* Parsing arguments. */
-            data_args = ParseDataArgs(line, raw_data_args, errors);
             /* Checking if parsing failed. */
-            if (data_args == NULL) {
-                FreeListAndData(raw_data_args);
+            if (!ParseDataArgs(line, args, num_args, values, errors))
                 return NULL;
-            }
             /* Adding .data arguments to data segment. */
-            DataToBinary(data_args, data);
+            DataToBinary(values, num_args, data);
             /* If line opened with label returning the symbol. */
             if (lptr != NULL)
-                return CreateSymbol(label, data_counter, att_data);
+                return CreateSymbol(symbols, label, data_counter, att_data);
             else
                 return NULL;
         }
@@ -319,41 +283,33 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
         /* If directive is .string. */
         if (dir_type == dir_string)
         {
-            List *raw_string_args;                       /* List of raw (string) arguments for .string.*/
-            char *arg;                                   /* Parsed argument (content of ""). */
+            Span raw_arg;                                /* First raw argument of .string. */
+            Span str;                                    /* Parsed argument (content of ""). */
+            int num_args;                                /* Number of arguments. */
             int data_counter = NextSegmentAddress(data); /* Adress of this data block. */
             /* Getting raw arguments of .string directive. */
-            raw_string_args = GetRawArgs(line, &pos, errors);
+            num_args = GetRawArgs(line, &pos, &raw_arg, 1, errors);
             /* Checking if arguments are present. */
-            if (raw_string_args->count == 0)
+            if (num_args == 0)
             {
                 AddError(errors, ErrDt_StrNoArgument, line, NULL);
-                FreeListAndData(raw_string_args);
                 return NULL;
             }
             /* Checking if more that one argument given. */
-            if (raw_string_args->count > 1)
+            if (num_args > 1)
             {
                 AddError(errors, ErrDt_StrExtra, line, NULL);
             }
             /* Parsing the argument. */
-            arg = ParseStringArgument(line, raw_string_args->head->data, errors);
             /* If parsing failed. */
-            if (arg == NULL)
-            {
-                FreeListAndData(raw_string_args);
-                free(arg);
+            if (!ParseStringArgument(line, raw_arg, &str, errors))
                 return NULL;
-            }
             /* Adding string data to data segment. */
-            StringToBinary(arg, data);
-            /* Freeing memory. */
-            FreeListAndData(raw_string_args);
-            free(arg);
+            StringToBinary(line + str.start, str.len, data);
 
             /* If line opened with label returning the symbol. */
             if (lptr != NULL)
-                return CreateSymbol(label, data_counter, att_data);
+                return CreateSymbol(symbols, label, data_counter, att_data);
             else
                 return NULL;
         }
@@ -370,16 +326,17 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
             /* If line opened with a label print warning and ignore it. */
             if (lptr != NULL) {
                 char *linecp = CopyStringToHeap(line); /* Making line copy. */
+                char message[MAX_STATEMENT_LEN + 100]; /* Warning message. */
                 RemoveLeadingBlanks(linecp);           /* Preparing line copy for printing. */
                 ReplaceNewLine(linecp, '\0');
-                printf("Warning: Line %d: \"%s\" <- Label before .entry or .extern will be ignored.\n", errors->cur_line_num, linecp);
-                free(linecp);
+                sprintf(message, "Warning: Line %d: \"%.*s\" <- Label before .entry or .extern will be ignored.\n", errors->cur_line_num, MAX_STATEMENT_LEN + 1, linecp);
+                AddWarning(errors, message);
             }
             /* Creating appropriate symbol structure. */
             if (dir_type == dir_entry)
-                return CreateSymbol(arg, 0, att_entry);
+                return CreateSymbol(symbols, arg, 0, att_entry);
             else /* dir_type == dir_extern*/
-                return CreateSymbol(arg, 0, att_extern);
+                return CreateSymbol(symbols, arg, 0, att_extern);
         }
     } /* If name starts with a dot section end. */
 
@@ -389,7 +346,7 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
         Ins *ins;                                   /* Pointer to parsed instruction structure. */
         int ins_counter = NextSegmentAddress(code); /* Saving address where this instructions block starts. */
         /* Trying to parse the instruction. */
-        ins = ParseInstructionLine(line, &pos, errors);
+        ins = ParseInstructionLine(line, &pos, symbols, errors);
         /* Checking if instruction parsing succeeded. */
         if (ins == NULL)
             return NULL;
@@ -397,7 +354,7 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
         InstructionToBinary(ins, code, references, (errors->slr->data)[errors->cur_line_num]);
         /* If label existed creating the symbol. */
         if (lptr != NULL)
-            return CreateSymbol(label, ins_counter, att_code);
+            return CreateSymbol(symbols, label, ins_counter, att_code);
         else
             return NULL;
     }
@@ -405,74 +362,303 @@ Symbol* StatementToBinary(char* line, List* references, BinarySegment* code, Bin
 
 
 
-/* Reads expanded source file and produces binary segments with unresolved label arguments.
-   Also produces symbols table and list of label references.
+/* Reserves capacity of binary segments for words of expanded source,
+   so segments are usually not expanded while it is encoded.
+   Arguments:
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    chars       -- Number of characters of expanded source lines.
+   Algorithm:
+    Shortest instruction line takes a few characters per code word (label
+    arguments give two words), and data values take a digit and a comma at least.
+    Estimates are taken for usual sources, segments grow if they are exceeded. */
+void ReserveSegments(BinarySegment* code, BinarySegment* data, long chars) {
+    ReserveBinary(code, (int)(chars / EST_CODE_WORD_CHARS));
+    ReserveBinary(data, (int)(chars / EST_DATA_WORD_CHARS));
+}
+
+
+
+/* Reads expanded source lines and produces binary segments with unresolved label arguments.
+   Also produces symbols table and vector of label references.
    After this step it is neccessary only to resolve label references.
    Arguments:
-    fileName    -- Name of source file without extension.
+    expanded    -- Expanded source lines produced by Preprocess().
     code        -- Code binary segment.
     data        -- Data binary segment.
     symbols     -- Symbols table.
-    references  -- List of references to labels as instruction arguments.
+    references  -- Vector of references to labels as instruction arguments.
     errors      -- Errors list.
    Algorithm:
-    Opens expanded source file.
-    Reads statements from file and uses StatementToBinary to translate them into binary words,
+    Takes statements from expanded lines one by one and uses StatementToBinary to translate them into binary words,
     extract symbols and register label references. Adds symbols to symbols table.
     After code and data segments are constructed sets initial addres of data segment to be next address after code segment.
     Initial binary contains data segment in full and in code segment everything is ready, except for base+offset 
     data words which set to 0 and should be resolved using LabelReference and symbols table. */
-void ProduceInitialBinary(char* fileName, BinarySegment* code, BinarySegment* data, List* symbols, List* references, Errors* errors) {
-    int lineNum = 1; /* Current line number. */
-    FILE* source;    /* Handler of expanded source file. */
-    char* fullFname; /* Name of the file with extension. */
-    int fullNameLen; /* Length of the full file name (not counting termination character). */
-    char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding line from source file. */
-
-    /* Opening the file. */
-    fullNameLen = StringLen(fileName) + 3;
-    fullFname = (char*)malloc(sizeof(char)*(fullNameLen+1));
-    if (fullFname == NULL) { 
-        perror("Failed to allocate memory.\n"); 
-        exit(1); }
-    /* Getting full file name. */
-    AppendExtension(fileName, "am", fullFname, fullNameLen);
-    source = fopen(fullFname, "r"); /* Opening target file for reading */
-    /* Check. */
-    if (source == NULL) { 
-        perror("Failed to open file.\n"); 
-        exit(2); 
-    }
+void ProduceInitialBinary(Lines* expanded, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors) {
+    int lineNum;     /* Current line number. */
+    int num_lines = LinesCount(expanded); /* Number of expanded lines. */
+
+    ReserveSegments(code, data, expanded->length);
 
-    /* Reading file line by line and creating binary representation. */
-    while (fgets(line, MAX_STATEMENT_LEN+1, source) != NULL) {
+    /* Going through expanded lines and creating binary representation. */
+    for (lineNum = 1; lineNum <= num_lines; lineNum++) {
         Symbol* smb; /* Line label info. */
         /* Changing current line for errors. */
         ChangeErrCurLine(errors, lineNum);
         /* Processing current statement. */
-        smb = StatementToBinary(line, references, code, data, errors);
+        smb = StatementToBinary(GetLine(expanded, lineNum-1), symbols, references, code, data, errors);
         /* If line strats with a label adding it to the symbols table. */
         if (smb != NULL)
             AddSymbol(symbols, smb, errors);
-        /* Adviancing iterator. */
-        lineNum++;    
     }
 
-    fclose(source);
-
     /* Moving data segment to address after instructions segment. */
+    PlaceDataSegment(code, data, symbols);
+}
+
+
+
+/* Moves data segment to address after code segment and
+   moves addresses of data symbols to new data base.
+   Arguments:
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table.
+   Algorithm:
+    Data symbols addresses are relative to data segment until it is placed,
+    so data base is added to them. */
+void PlaceDataSegment(BinarySegment* code, BinarySegment* data, SymbolsTable* symbols) {
+    int i; /* Symbols iterator. */
+
     data->base = NextSegmentAddress(code);
 
     /* Moving data symbols addresses to new data base. */
-    {
-        ListNode* cur = symbols->head;
-        while (cur != NULL) {
-            Symbol* smb = cur->data;
-            if (IsData(smb))
-                smb->adress += data->base;
-            cur = cur->next;
+    for (i = 0; i < SymbolsCount(symbols); i++) {
+        Symbol* smb = SymbolAt(symbols, i);
+        if (IsData(smb))
+            smb->adress += data->base;
+    }
+}
+
+
+
+/* Encodes statements of chunk lines (thread function).
+   Objects of the chunk are allocated in arena of the chunk.
+   Arguments:
+    arg     -- Chunk (EncodedChunk) with lines to encode.
+   Returns:
+    NULL.
+   Algorithm:
+    Same as loop of ProduceInitialBinary(), but symbols of labeled lines are kept
+    in defs list instead of adding them to symbols table: errors of symbols table
+    depend on symbols of previous chunks, so symbols are added when chunks are merged.
+    Warnings are kept in errors list of the chunk to be printed in order of lines. */
+void* EncodeChunk(void* arg) {
+    EncodedChunk* chunk = (EncodedChunk*)arg; /* Chunk to encode. */
+    int lineNum; /* Current line number. */
+
+    /* Objects and statistics of the thread are kept apart from other threads. */
+    UseThreadArena(chunk->arena);
+    UseThreadStats(&chunk->stats);
+
+    chunk->code = CreateBinary();
+    chunk->data = CreateBinary();
+    /* Chunk takes its part of expanded text in proportion to number of lines. */
+    ReserveSegments(chunk->code, chunk->data, (long)chunk->expanded->length*(chunk->last - chunk->first + 1)/LinesCount(chunk->expanded));
+    chunk->symbols = CreateSymbolsTable(64);
+    chunk->references = CreateReferences(64);
+    chunk->defs = CreateVector(sizeof(Symbol), 64);
+    /* Every line has at most one label, so array is not expanded. */
+    chunk->def_lines = CreateDynArr(chunk->last - chunk->first + 1);
+    chunk->errors = CreateErrors();
+    chunk->errors->slr = chunk->slr;
+    chunk->errors->warnings = CreateLines(16);
+
+    for (lineNum = chunk->first; lineNum <= chunk->last; lineNum++) {
+        Symbol* smb; /* Line label info. */
+        ChangeErrCurLine(chunk->errors, lineNum);
+        smb = StatementToBinary(GetLine(chunk->expanded, lineNum-1), chunk->symbols, chunk->references, chunk->code, chunk->data, chunk->errors);
+        if (smb != NULL) {
+            *(Symbol*)VectorAdd(chunk->defs) = *smb;
+            AddDynArr(chunk->def_lines, lineNum);
         }
     }
+
+    UseThreadArena(NULL);
+    UseThreadStats(NULL);
+    return NULL;
+}
+
+
+
+/* Adds encoded chunk to binary segments, symbols table, references and errors of the file.
+   Chunks should be merged in order of lines.
+   Arguments:
+    chunk       -- Encoded chunk.
+    code        -- Code binary segment.
+    data        -- Data binary segment (data base is not set yet).
+    symbols     -- Symbols table.
+    references  -- Vector of label references.
+    errors      -- Errors list.
+   Algorithm:
+    Labels of the chunk are interned in symbols table in order of chunk ids.
+    Chunk ids are given in order of first appearance in the chunk, so labels get
+    the same ids as when the file is encoded by one thread.
+    Code addresses of the chunk start from 0, so address of the first word of the chunk
+    in code segment is added to references and code symbols. Data symbols get offset
+    of the chunk in data segment (data base is added later by PlaceDataSegment()).
+    Symbols are added to symbols table in order of lines with current line of their
+    definition, so errors of symbols table are the same too. */
+void MergeChunk(EncodedChunk* chunk, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors) {
+    int code_offset = NextSegmentAddress(code); /* Address of first code word of the chunk. */
+    int data_offset = data->counter;            /* Offset of first data word of the chunk. */
+    int num_labels = chunk->symbols->labels->count; /* Number of labels of the chunk. */
+    int* ids = (int*)Allocate(sizeof(int)*(num_labels+1)); /* Ids of chunk labels in symbols table. */
+    int i;         /* Iterator. */
+
+    for (i = 0; i < num_labels; i++)
+        ids[i] = InternLabel(symbols, LabelName(chunk->symbols, i));
+
+    AddBinaryWords(code, chunk->code->words, chunk->code->counter);
+    AddBinaryWords(data, chunk->data->words, chunk->data->counter);
+
+    /* Moving label references to file. */
+    for (i = 0; i < chunk->references->count; i++) {
+        LabelReference* ref = ReferenceAt(chunk->references, i);
+        ref->id = ids[ref->id];
+        ref->address += code_offset;
+    }
+    VectorConcat(references, chunk->references);
+
+    /* Errors and warnings of chunk statements. */
+    MergeErrors(errors, chunk->errors);
+
+    /* Adding symbols of labeled lines. */
+    for (i = 0; i < chunk->defs->count; i++) {
+        Symbol* smb = (Symbol*)VectorAt(chunk->defs, i);
+        smb->id = ids[smb->id];
+        smb->name = LabelName(symbols, smb->id);
+        if (IsCode(smb))
+            smb->adress += code_offset;
+        else if (IsData(smb))
+            smb->adress += data_offset;
+        ChangeErrCurLine(errors, (chunk->def_lines->data)[i]);
+        AddSymbol(symbols, smb, errors);
+    }
+}
+
+
+
+/* Same as ProduceInitialBinary(), but statements are encoded by given number of threads.
+   Results (binary, symbols, references, errors and printed warnings) are the same.
+   Small files are encoded by calling thread.
+   Arguments:
+    expanded    -- Expanded source lines produced by Preprocess().
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table.
+    references  -- Vector of references to labels as instruction arguments.
+    errors      -- Errors list.
+    threads     -- Maximum number of threads.
+   Algorithm:
+    Expanded lines are divided to chunks of equal number of lines, and every chunk is
+    encoded by its own thread with addresses starting from 0 (EncodeChunk()).
+    Sizes of encoded chunks give addresses of chunks in segments (prefix sums), so
+    segments and references are expanded once and chunks are copied to them in order (MergeChunk()). */
+void ProduceInitialBinaryParallel(Lines* expanded, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors, int threads) {
+    int num_lines = LinesCount(expanded); /* Number of expanded lines. */
+    pthread_t ids[MAX_ENCODE_THREADS];    /* Threads of chunks. */
+    int started[MAX_ENCODE_THREADS];      /* 1 if thread of chunk is started. */
+    EncodedChunk* chunks;                 /* Chunks of lines. */
+    int code_words = 0;                   /* Number of code words of all chunks. */
+    int data_words = 0;                   /* Number of data words of all chunks. */
+    int num_refs = 0;                     /* Number of label references of all chunks. */
+    int n = threads;                      /* Number of chunks. */
+    int i;                                /* Chunks iterator. */
+
+    if (n > MAX_ENCODE_THREADS)
+        n = MAX_ENCODE_THREADS;
+    if (n > num_lines / MIN_CHUNK_LINES)
+        n = num_lines / MIN_CHUNK_LINES;
+#ifdef TRACK_ALLOC
+    /* Tracking table of allocations is not shared by threads. */
+    n = 1;
+#endif
+    if (n <= 1) {
+        ProduceInitialBinary(expanded, code, data, symbols, references, errors);
+        return;
+    }
+
+    EnableThreadArenas();
+    EnableThreadStats();
+
+    /* Objects of chunks are used until the file is done, so worker arenas are reset here
+       (objects of previous stages are copied to file arena). */
+    ResetWorkerArenas();
+
+    /* Encoding chunks. */
+    chunks = (EncodedChunk*)Allocate(sizeof(EncodedChunk)*n);
+    memset(chunks, 0, sizeof(EncodedChunk)*n);
+    for (i = 0; i < n; i++) {
+        chunks[i].expanded = expanded;
+        chunks[i].slr = errors->slr;
+        chunks[i].first = (int)((long)num_lines*i/n) + 1;
+        chunks[i].last = (int)((long)num_lines*(i+1)/n);
+        chunks[i].arena = WorkerArena(i);
+        /* Last chunk is encoded by calling thread, chunk is encoded by it too if thread can't be started. */
+        started[i] = i < n-1 && pthread_create(&ids[i], NULL, EncodeChunk, &chunks[i]) == 0;
+        if (!started[i])
+            EncodeChunk(&chunks[i]);
+    }
+    for (i = 0; i < n; i++) {
+        if (started[i])
+            pthread_join(ids[i], NULL);
+        code_words += chunks[i].code->counter;
+        data_words += chunks[i].data->counter;
+        num_refs += chunks[i].references->count;
+    }
+
+    /* Merging chunks in order of lines. */
+    ReserveBinary(code, code_words);
+    ReserveBinary(data, data_words);
+    ReserveVector(references, references->count + num_refs);
+    for (i = 0; i < n; i++) {
+        MergeThreadStats(&chunks[i].stats);
+        MergeChunk(&chunks[i], code, data, symbols, references, errors);
+        FreeBinary(chunks[i].code);
+        FreeBinary(chunks[i].data);
+        FreeErrors(chunks[i].errors);
+    }
+    ChangeErrCurLine(errors, num_lines);
+
+    /* Moving data segment to address after instructions segment. */
+    PlaceDataSegment(code, data, symbols);
+}
+
+
+
+
+/* Makes base and offset data words of label argument.
+   Arguments:
+    smb     -- Symbol of the label.
+    words   -- Array for two words - base and offset.
+   Algorithm:
+    If symbol marked as extern ARE is External = 001 = 1 and
+    both words are empty. Otherwise ARE is Relocatable = 010 = 2 and
+    words contain base and offset parts of symbol address. */
+void SymbolToWords(Symbol* smb, int words[2]) {
+    if (IsExtern(smb)) {
+        /* Writing 2 empty data words. */
+        words[0] = 1 << 16;
+        words[1] = 1 << 16;
+    }
+    else {
+        /* Calculating base and offset of the memory address. */
+        BOAddress bo = AddressToBO(smb->adress); /* Address in base+offset format. */
+        words[0] = (2 << 16) + bo.base;
+        words[1] = (2 << 16) + bo.offset;
+    }
 }
 
 
@@ -481,59 +667,34 @@ void ProduceInitialBinary(char* fileName, BinarySegment* code, BinarySegment* da
    Arguments:
     code        -- Code binary segment.
     symbols     -- Symbols table.
-    references  -- List of label references.
+    references  -- Vector of label references.
     errors      -- Errors list.
    Algorithm:
-    For each label reference saved in references table searches
-    symbol by same name in symbols table and substitutes
+    For each label reference saved in references table takes
+    symbol by label id from symbols table and substitutes
     binary words in code segment pointed by reference structure
     with base+offset address stored in symbols table.
     If symbol marked as extern 0 is written. */
-void ResolveReferences(BinarySegment* code, List* symbols, List* references, Errors* errors) {
-    /* Going trough references list. */
-    ListNode* cur = references->head; /* References iterator. */
+void ResolveReferences(BinarySegment* code, SymbolsTable* symbols, Vector* references, Errors* errors) {
+    int i; /* References iterator. */
 
-    while (cur != NULL) {
+    /* Going trough references. */
+    for (i = 0; i < references->count; i++) {
         Symbol* smb;
-        LabelReference* ref = cur->data;
+        LabelReference* ref = ReferenceAt(references, i);
 
-        /* Searching for symbol in symbols table. */
-        smb = FindSymbolByName(symbols, ref->name);
+        /* Getting symbol of the label. */
+        smb = FindSymbolById(symbols, ref->id);
 
         /* If symbol found resolving reference. */
         if (smb != NULL) {
-            int are; /* ARE part of binary word. */
-            int word; /* Binary word. */
-            
-            /* Setting ARE mode. */
-            if (IsExtern(smb)) {
-                /* If Symbol is .extern setting ARE to External = 001 = 1 */
-                are = 1;        
-                /* Writing 2 empty data words. */
-                word = are <<16;
-                SetBinary(code, ref->address, word);
-                SetBinary(code, ref->address+1, word);
-            }        
-            else {
-                BOAddress bo; /* Variable for storing address. */
-                /* If symbol is code or data setting ARE to Relocatable = 010 = 2 */
-                are = 2;
-
-                /* Calculating base and offset of the memory address. */
-                bo = AddressToBO(smb->adress);
-
-                /* Writitng base data word. */
-                word = (are << 16) + bo.base;
-                SetBinary(code, ref->address, word);
-                /* Writing offset data word */
-                word = (are<<16)+bo.offset;
-                SetBinary(code, ref->address+1, word);
-            }
+            int words[2]; /* Base and offset words. */
+            SymbolToWords(smb, words);
+            SetBinary(code, ref->address, words[0]);
+            SetBinary(code, ref->address+1, words[1]);
         }
         else { /* If symbol not found. */
-            AddErrorManual(errors, ref->origin, ErrSmb_NotFound, ref->name, NULL);
+            AddErrorManual(errors, ref->origin, ErrSmb_NotFound, LabelName(symbols, ref->id), NULL);
         }
-        /* Advancing iterator */
-        cur = cur->next;
     }
 }
\ No newline at end of file
@@ -2,12 +2,43 @@
     #define BINARY_H
 
 #include <stdio.h>
+#include <pthread.h>
 #include "MyString.h"
 #include "Definitions.h"
 #include "Data.h"
 #include "DataContainers.h"
 #include "Errors.h"
 #include "Parsing.h"
+#include "Arena.h"
+#include "Stats.h"
+
+/* Maximum number of threads that encode statements of one file (-t option, not more than MAX_WORKER_ARENAS). */
+#define MAX_ENCODE_THREADS 64
+/* Minimal number of expanded lines encoded by one thread. Smaller files are encoded by one thread. */
+#define MIN_CHUNK_LINES 2048
+/* Characters of expanded source per code word and per data word assumed when
+   segments are reserved by ReserveSegments() (segments grow if there are more words). */
+#define EST_CODE_WORD_CHARS 4
+#define EST_DATA_WORD_CHARS 8
+
+/* Chunk of expanded lines encoded by one thread.
+   Chunk is encoded as if it was whole file: its segments start from address 0
+   and labels get ids of chunk symbols table. Encoded chunks are merged in order of lines. */
+typedef struct EncodedChunk {
+    Lines* expanded;       /* Expanded source lines (shared, read only). */
+    DynArr* slr;           /* Source line reference of the file (shared, read only). */
+    int first;             /* Number of first line of the chunk. */
+    int last;              /* Number of last line of the chunk. */
+    Arena* arena;          /* Arena of the thread. */
+    Stats stats;           /* Statistics of the thread. */
+    BinarySegment* code;   /* Code words of the chunk. */
+    BinarySegment* data;   /* Data words of the chunk. */
+    SymbolsTable* symbols; /* Labels interned by the chunk, symbols are not added to it. */
+    Vector* references;    /* Label references of the chunk. */
+    Vector* defs;          /* Symbols of labeled lines in order of lines. */
+    DynArr* def_lines;     /* Numbers of lines where symbols of defs are found. */
+    Errors* errors;        /* Errors and kept warnings of the chunk. */
+} EncodedChunk;
 
 /* Determines type of the directive:
    string, data, or extern/entry. 
@@ -23,62 +54,115 @@ int GetDirectiveType(char* line, int* pos);
 
 /* Writes .data line arguments to data binary segment.
    Arguments:
-    dataArgs    -- Parsed numeric values of .data arguments.
+    values      -- Parsed numeric values of .data arguments.
+    count       -- Number of values.
     data        -- Data binary segment. */
-void DataToBinary(DynArr* dataArgs, BinarySegment* data);
+void DataToBinary(int* values, int count, BinarySegment* data);
 
 /* Writes .string line argument to data binary segment.
    Arguments:
-    line    -- Line containing .string directive.
-    pos     -- Position in line after word .string and before arguments. 
+    str     -- Characters of the string (content of "", not null-terminated).
+    len     -- Number of characters.
     data    -- Data binary segment.
-    lineNum -- Number of line in expanded source code.
-    errors  -- List of errors.
-    slr     -- Source line reference.
  */
-void StringToBinary(char* arg, BinarySegment* data);
+void StringToBinary(char* str, int len, BinarySegment* data);
 
 /* Translates given instruction structure to binary words
    and writes them into code binary segment.
-   Creates label references if found and adds them to list.
+   Creates label references if found and adds them to references.
    Arguments:
     ins          -- Instruction structure.
     code         -- Code binary segment.
-    references   -- List of label arguments (label references).
+    references   -- Vector of label arguments (label references).
     lineNum      -- Number of line in expanded source file where instruction originates. */
-void InstructionToBinary(Ins* ins, BinarySegment* code, List* references, int lineNum);
+void InstructionToBinary(Ins* ins, BinarySegment* code, Vector* references, int lineNum);
 
 /* Translates given statement of any kind (instruction, or directive)
    to binary words and writes them to appropriate binary segment.
    Also produces structure that describes label before the line if it is present.
    Arguments:
     line        -- String that contains statement.
-    references  -- List of label arguments (label references).
+    symbols     -- Symbols table where labels are interned.
+    references  -- Vector of label arguments (label references).
     code        -- Code binary segment.
     data        -- Data binary segment.
     errors      -- Errors list.
    Returns:
     If statement opened with a label symbol is created with appropriate address and attribute fields.
     If line not contained opening label returns NULL (not considere a failure). */
-Symbol* StatementToBinary(char *line, List *unresolved, BinarySegment *code, BinarySegment *data, Errors *errors);
+Symbol* StatementToBinary(char *line, SymbolsTable *symbols, Vector *unresolved, BinarySegment *code, BinarySegment *data, Errors *errors);
 
-/* Reads expanded source file and produces binary segments with unresolved label arguments.
-   Also produces symbols table and list of label references.
+/* Reserves capacity of binary segments for words of expanded source,
+   so segments are usually not expanded while it is encoded.
+   Arguments:
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    chars       -- Number of characters of expanded source lines. */
+void ReserveSegments(BinarySegment* code, BinarySegment* data, long chars);
+
+/* Reads expanded source lines and produces binary segments with unresolved label arguments.
+   Also produces symbols table and vector of label references.
    After this step it is neccessary only to resolve label references.
    Arguments:
-    fileName    -- Name of source file without extension.
+    expanded    -- Expanded source lines produced by Preprocess().
     code        -- Code binary segment.
     data        -- Data binary segment.
     symbols     -- Symbols table.
-    references  -- List of references to labels as instruction arguments.
+    references  -- Vector of references to labels as instruction arguments.
+    errors      -- Errors list. */
+void ProduceInitialBinary(Lines* expanded, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors);
+
+/* Moves data segment to address after code segment and
+   moves addresses of data symbols to new data base.
+   Arguments:
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table. */
+void PlaceDataSegment(BinarySegment* code, BinarySegment* data, SymbolsTable* symbols);
+
+/* Encodes statements of chunk lines (thread function).
+   Objects of the chunk are allocated in arena of the chunk.
+   Arguments:
+    arg     -- Chunk (EncodedChunk) with lines to encode.
+   Returns:
+    NULL. */
+void* EncodeChunk(void* arg);
+
+/* Adds encoded chunk to binary segments, symbols table, references and errors of the file.
+   Chunks should be merged in order of lines.
+   Arguments:
+    chunk       -- Encoded chunk.
+    code        -- Code binary segment.
+    data        -- Data binary segment (data base is not set yet).
+    symbols     -- Symbols table.
+    references  -- Vector of label references.
     errors      -- Errors list. */
-void ProduceInitialBinary(char* fileName, BinarySegment* code, BinarySegment* data, List* symbols, List* references, Errors* errors);
+void MergeChunk(EncodedChunk* chunk, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors);
+
+/* Same as ProduceInitialBinary(), but statements are encoded by given number of threads.
+   Results (binary, symbols, references, errors and printed warnings) are the same.
+   Small files are encoded by calling thread.
+   Arguments:
+    expanded    -- Expanded source lines produced by Preprocess().
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table.
+    references  -- Vector of references to labels as instruction arguments.
+    errors      -- Errors list.
+    threads     -- Maximum number of threads. */
+void ProduceInitialBinaryParallel(Lines* expanded, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references, Errors* errors, int threads);
+
+/* Makes base and offset data words of label argument.
+   Arguments:
+    smb     -- Symbol of the label.
+    words   -- Array for two words - base and offset. */
+void SymbolToWords(Symbol* smb, int words[2]);
 
 /* Resolves label references in binary code segment.
    Arguments:
     code        -- Code binary segment.
     symbols     -- Symbols table.
-    references  -- List of label references.
+    references  -- Vector of label references.
     errors      -- Errors list. */
-void ResolveReferences(BinarySegment* code, List* symbols, List* references, Errors* errors);
+void ResolveReferences(BinarySegment* code, SymbolsTable* symbols, Vector* references, Errors* errors);
 #endif
\ No newline at end of file
@@ -0,0 +1,398 @@
+#include "Cache.h"
+
+/* Prime numbers of hash function (same as in xxHash32). */
+#define HASH_PRIME1 2654435761UL
+#define HASH_PRIME2 2246822519UL
+#define HASH_PRIME3 3266489917UL
+#define HASH_PRIME4 668265263UL
+#define HASH_PRIME5 374761393UL
+/* Mask of 32 bits (unsigned long can be longer). */
+#define HASH_MASK 0xffffffffUL
+
+/* Rotates 32 bit value left.
+   Arguments:
+    x   -- Value.
+    r   -- Number of bits (1-31).
+   Returns:
+    Rotated value. */
+unsigned long RotateLeft32(unsigned long x, int r) {
+    x &= HASH_MASK;
+    return ((x << r) | (x >> (32 - r))) & HASH_MASK;
+}
+
+/* Mixes 4 input bytes into accumulator of hash.
+   Arguments:
+    acc     -- Accumulator.
+    input   -- 32 bit input.
+   Returns:
+    New value of accumulator. */
+unsigned long HashRound(unsigned long acc, unsigned long input) {
+    acc = (acc + input*HASH_PRIME2) & HASH_MASK;
+    acc = RotateLeft32(acc, 13);
+    return (acc*HASH_PRIME1) & HASH_MASK;
+}
+
+/* Calculates final hash of one half from accumulators and bytes left after 16 byte stripes.
+   Arguments:
+    acc     -- Four accumulators.
+    seed    -- Seed of the half.
+    rest    -- Bytes after the last stripe.
+    restLen -- Number of bytes after the last stripe (0-15).
+    len     -- Total number of bytes.
+   Returns:
+    32 bit hash. */
+unsigned long HashFinish(unsigned long acc[4], unsigned long seed, unsigned char* rest, size_t restLen, size_t len) {
+    unsigned long h; /* Resulting hash. */
+    size_t pos = 0;  /* Position in rest. */
+
+    if (len >= 16)
+        h = RotateLeft32(acc[0], 1) + RotateLeft32(acc[1], 7) + RotateLeft32(acc[2], 12) + RotateLeft32(acc[3], 18);
+    else
+        h = seed + HASH_PRIME5;
+    h = (h + (unsigned long)len) & HASH_MASK;
+
+    /* Mixing the rest by 4 bytes and then by single bytes. */
+    for (; pos + 4 <= restLen; pos += 4) {
+        h = (h + GetUInt32(rest + pos)*HASH_PRIME3) & HASH_MASK;
+        h = (RotateLeft32(h, 17)*HASH_PRIME4) & HASH_MASK;
+    }
+    for (; pos < restLen; pos++) {
+        h = (h + rest[pos]*HASH_PRIME5) & HASH_MASK;
+        h = (RotateLeft32(h, 11)*HASH_PRIME1) & HASH_MASK;
+    }
+
+    /* Final avalanche. */
+    h ^= h >> 15;
+    h = (h*HASH_PRIME2) & HASH_MASK;
+    h ^= h >> 13;
+    h = (h*HASH_PRIME3) & HASH_MASK;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Calculates 64 bit hash of bytes as two 32 bit halves.
+   Arguments:
+    data    -- Bytes.
+    len     -- Number of bytes.
+    hash    -- Seeds of two halves (hash of preceding data, or 0), replaced by resulting hash.
+   Algorithm:
+    Every half is xxHash32 of the data with its own seed (second seed is
+    changed, so halves differ for equal seeds). Both halves are calculated in
+    one pass over 16 byte stripes, every stripe updates four accumulators of a half. */
+void HashBytes(unsigned char* data, size_t len, unsigned long hash[2]) {
+    unsigned long a[4], b[4]; /* Accumulators of the halves. */
+    unsigned long seed_a = hash[0] & HASH_MASK; /* Seed of the first half. */
+    unsigned long seed_b = (hash[1] + HASH_PRIME3) & HASH_MASK; /* Seed of the second half. */
+    size_t pos = 0; /* Position in data. */
+
+    a[0] = (seed_a + HASH_PRIME1 + HASH_PRIME2) & HASH_MASK;
+    a[1] = (seed_a + HASH_PRIME2) & HASH_MASK;
+    a[2] = seed_a;
+    a[3] = (seed_a - HASH_PRIME1) & HASH_MASK;
+    b[0] = (seed_b + HASH_PRIME1 + HASH_PRIME2) & HASH_MASK;
+    b[1] = (seed_b + HASH_PRIME2) & HASH_MASK;
+    b[2] = seed_b;
+    b[3] = (seed_b - HASH_PRIME1) & HASH_MASK;
+
+    for (; pos + 16 <= len; pos += 16) {
+        unsigned long w0 = GetUInt32(data + pos);      /* Words of the stripe. */
+        unsigned long w1 = GetUInt32(data + pos + 4);
+        unsigned long w2 = GetUInt32(data + pos + 8);
+        unsigned long w3 = GetUInt32(data + pos + 12);
+        a[0] = HashRound(a[0], w0);
+        a[1] = HashRound(a[1], w1);
+        a[2] = HashRound(a[2], w2);
+        a[3] = HashRound(a[3], w3);
+        b[0] = HashRound(b[0], w0);
+        b[1] = HashRound(b[1], w1);
+        b[2] = HashRound(b[2], w2);
+        b[3] = HashRound(b[3], w3);
+    }
+
+    hash[0] = HashFinish(a, seed_a, data + pos, len - pos, len);
+    hash[1] = HashFinish(b, seed_b, data + pos, len - pos, len);
+}
+
+/* Writes 64 bit hash as CACHE_KEY_LEN hex digits.
+   Arguments:
+    hash    -- Two 32 bit halves of hash.
+    key     -- Buffer for key (at least CACHE_KEY_LEN+1 characters). */
+void HashToKey(unsigned long hash[2], char* key) {
+    sprintf(key, "%08lx%08lx", hash[0] & HASH_MASK, hash[1] & HASH_MASK);
+}
+
+/* Returns name of file in cache directory.
+   Arguments:
+    dir     -- Cache directory.
+    name    -- File name without extension.
+    ext     -- Extension.
+   Returns:
+    Full file name allocated in current arena. */
+char* CachePath(char* dir, char* name, char* ext) {
+    int dirLen = StringLen(dir);   /* Length of directory name. */
+    int nameLen = StringLen(name); /* Length of file name. */
+    int extLen = StringLen(ext);   /* Length of extension. */
+    char* path = (char*)Allocate(sizeof(char)*(dirLen + nameLen + extLen + 3)); /* Resulting name. */
+
+    memcpy(path, dir, dirLen);
+    path[dirLen] = '/';
+    memcpy(path + dirLen + 1, name, nameLen);
+    path[dirLen + 1 + nameLen] = '.';
+    memcpy(path + dirLen + nameLen + 2, ext, extLen + 1);
+    return path;
+}
+
+/* Writes file of cache directory with single write.
+   File is written under temporary name and renamed, so other processes
+   never see partially written file.
+   Arguments:
+    path    -- Name of the file.
+    buf     -- Content of the file.
+   Returns:
+    1 if file is written, 0 otherwise (message is printed). */
+int WriteCacheFile(char* path, OutputBuffer* buf) {
+    char* tmpName = (char*)Allocate(sizeof(char)*(StringLen(path) + 32)); /* Name of temporary file. */
+    FILE* file; /* Handler of temporary file. */
+    int failed; /* 1 if writing failed. */
+
+    sprintf(tmpName, "%s.%ld.tmp", path, (long)getpid());
+    file = fopen(tmpName, "w");
+    if (file == NULL) {
+        printf("Warning: Failed to write cache file [ %s ].\n", path);
+        return 0;
+    }
+    setvbuf(file, NULL, _IONBF, 0);
+
+    failed = buf->length > 0 && fwrite(buf->text, sizeof(char), buf->length, file) != (size_t)buf->length;
+    failed = fclose(file) != 0 || failed;
+    if (failed || rename(tmpName, path) != 0) {
+        printf("Warning: Failed to write cache file [ %s ].\n", path);
+        remove(tmpName);
+        return 0;
+    }
+    return 1;
+}
+
+/* Creates cache directory if it does not exist.
+   Arguments:
+    dir     -- Cache directory.
+   Returns:
+    1 if directory can be used, 0 otherwise (message is printed). */
+int OpenCacheDir(char* dir) {
+    struct stat info; /* Directory info. */
+
+    if (mkdir(dir, 0777) != 0 && (stat(dir, &info) != 0 || !S_ISDIR(info.st_mode))) {
+        printf("Failed to use cache directory [ %s ], files will be assembled without cache.\n", dir);
+        return 0;
+    }
+    return 1;
+}
+
+/* Finds cache key of source file.
+   Arguments:
+    dir         -- Cache directory.
+    fileName    -- Source file name without extension.
+    salt        -- Assembler version and options that change outputs.
+    key         -- Buffer for key (at least CACHE_KEY_LEN+1 characters).
+   Returns:
+    1 if key is found, 0 if source file can't be read.
+   Algorithm:
+    Key is hash of salt, source file name and source bytes. Hash of salt and
+    name gives name of index file, which keeps size, modification time and inode
+    of the source with its key. If they are the same as source file has, key is
+    taken from index and source is not read. Otherwise source is hashed and index
+    is written again. Index is not written while modification time is the current
+    second, because file can be changed again in the same second. */
+int FindCacheKey(char* dir, char* fileName, char* salt, char* key) {
+    int len = StringLen(fileName) + 3; /* Length of source file name. */
+    char* srcName = (char*)Allocate(sizeof(char)*(len+1)); /* Source file name. */
+    char idxKey[CACHE_KEY_LEN+1]; /* Name of index file. */
+    char* idxName;          /* Full name of index file. */
+    struct stat info;       /* Source file info. */
+    unsigned long hash[2];  /* Hash. */
+    unsigned char* text;    /* Source file content. */
+    size_t size;            /* Size of source file. */
+    FILE* idx;              /* Index file. */
+
+    AppendExtension(fileName, "as", srcName, len);
+    if (stat(srcName, &info) != 0)
+        return 0;
+
+    /* Hashing salt and source file name (with termination characters). */
+    hash[0] = 0;
+    hash[1] = 0;
+    HashBytes((unsigned char*)salt, StringLen(salt) + 1, hash);
+    HashBytes((unsigned char*)srcName, len + 1, hash);
+    HashToKey(hash, idxKey);
+    idxName = CachePath(dir, idxKey, "idx");
+
+    /* Checking index. */
+    idx = fopen(idxName, "r");
+    if (idx != NULL) {
+        unsigned long idx_size, idx_mtime, idx_ino; /* Source file info saved in index. */
+        int res = fscanf(idx, "%lu %lu %lu %16s", &idx_size, &idx_mtime, &idx_ino, key); /* Number of read values. */
+        fclose(idx);
+        if (res == 4 && StringLen(key) == CACHE_KEY_LEN && idx_size == (unsigned long)info.st_size &&
+            idx_mtime == (unsigned long)info.st_mtime && idx_ino == (unsigned long)info.st_ino)
+            return 1;
+    }
+
+    /* Hashing source bytes. */
+    text = MapFile(srcName, &size);
+    if (text == NULL)
+        return 0;
+    HashBytes(text, size, hash);
+    UnmapFile(text, size);
+    HashToKey(hash, key);
+
+    /* Writing index. */
+    if (info.st_mtime < time(NULL)) {
+        OutputBuffer buf; /* Text of index. */
+        InitOutputBuffer(&buf, 128);
+        buf.length = sprintf(buf.text, "%lu %lu %lu %s\n", (unsigned long)info.st_size,
+            (unsigned long)info.st_mtime, (unsigned long)info.st_ino, key);
+        WriteCacheFile(idxName, &buf);
+    }
+
+    return 1;
+}
+
+/* Restores outputs of source file from cache entry.
+   Output files are written and messages are printed.
+   Arguments:
+    dir         -- Cache directory.
+    key         -- Cache key of source file.
+    fileName    -- Source file name without extension.
+   Returns:
+    1 if entry is found and restored, 0 if there is no correct entry.
+   Algorithm:
+    Entry starts with CACHE_MAGIC line and a line with number of sections,
+    then for every section a line "EXT SIZE". Contents of sections follow
+    one after another. Whole header is checked before anything is written. */
+int RestoreCacheEntry(char* dir, char* key, char* fileName) {
+    char* path = CachePath(dir, key, "cache"); /* Name of entry file. */
+    CacheSection sections[MAX_CACHE_SECTIONS]; /* Sections of entry. */
+    int num_sections; /* Number of sections. */
+    unsigned char* text; /* Content of entry file. */
+    size_t size;      /* Size of entry file. */
+    size_t pos;       /* Position in entry file. */
+    size_t total = 0; /* Total size of sections. */
+    int i;            /* Sections iterator. */
+
+    text = MapFile(path, &size);
+    if (text == NULL)
+        return 0;
+
+    /* Reading header. */
+    pos = StringLen(CACHE_MAGIC);
+    num_sections = -1;
+    if (size > pos && memcmp(text, CACHE_MAGIC, pos) == 0) {
+        num_sections = ReadTextNumber(text, &pos, size);
+        pos++;
+    }
+    if (num_sections < 0 || num_sections > MAX_CACHE_SECTIONS) {
+        UnmapFile(text, size);
+        return 0;
+    }
+    for (i = 0; i < num_sections; i++) {
+        int len = 0; /* Length of extension. */
+        int sec_size; /* Size of section. */
+        while (pos < size && text[pos] != ' ' && len < MAX_CACHE_EXT_LEN)
+            sections[i].ext[len++] = text[pos++];
+        sections[i].ext[len] = '\0';
+        pos++;
+        sec_size = ReadTextNumber(text, &pos, size);
+        if (len == 0 || sec_size < 0 || pos >= size || text[pos] != '\n') {
+            UnmapFile(text, size);
+            return 0;
+        }
+        pos++;
+        sections[i].size = sec_size;
+        total += sec_size;
+    }
+    if (pos + total != size) {
+        UnmapFile(text, size);
+        return 0;
+    }
+
+    /* Printing messages and writing files. */
+    for (i = 0; i < num_sections; i++) {
+        sections[i].data = text + pos;
+        pos += sections[i].size;
+        if (CompareStrings(sections[i].ext, "log"))
+            fwrite(sections[i].data, 1, sections[i].size, stdout);
+        else {
+            OutputBuffer buf; /* Content of output file. */
+            buf.text = (char*)sections[i].data;
+            buf.length = sections[i].size;
+            buf.capacity = sections[i].size;
+            WriteOutputFile(fileName, sections[i].ext, &buf);
+        }
+    }
+
+    UnmapFile(text, size);
+    return 1;
+}
+
+/* Writes cache entry of source file.
+   Failure to write is reported and ignored.
+   Arguments:
+    dir         -- Cache directory.
+    key         -- Cache key of source file.
+    fileName    -- Source file name without extension.
+    log         -- Printed messages.
+    logLen      -- Length of messages.
+    exts        -- Extensions of written output files.
+    numExts     -- Number of output files.
+   Algorithm:
+    Output files are mapped and copied to entry after messages
+    (see RestoreCacheEntry() for layout). */
+void StoreCacheEntry(char* dir, char* key, char* fileName, char* log, int logLen, char** exts, int numExts) {
+    CacheSection sections[MAX_CACHE_SECTIONS]; /* Sections of entry. */
+    int len = StringLen(fileName); /* Length of file name. */
+    OutputBuffer buf; /* Content of entry file. */
+    size_t total = logLen; /* Total size of sections. */
+    int i; /* Sections iterator. */
+
+    if (numExts + 1 > MAX_CACHE_SECTIONS)
+        return;
+
+    /* Messages. */
+    memcpy(sections[0].ext, "log", 4);
+    sections[0].data = (unsigned char*)log;
+    sections[0].size = logLen;
+
+    /* Mapping output files. */
+    for (i = 0; i < numExts; i++) {
+        char* name = (char*)Allocate(sizeof(char)*(len + StringLen(exts[i]) + 2)); /* Output file name. */
+        CacheSection* sec = &(sections[i+1]); /* Section of the file. */
+        AppendExtension(fileName, exts[i], name, len + StringLen(exts[i]) + 1);
+        memcpy(sec->ext, exts[i], StringLen(exts[i]) + 1);
+        sec->data = MapFile(name, &(sec->size));
+        if (sec->data == NULL) {
+            while (--i >= 0)
+                UnmapFile(sections[i+1].data, sections[i+1].size);
+            return;
+        }
+        total += sec->size;
+    }
+
+    /* Header and sections. */
+    InitOutputBuffer(&buf, total + 64*(numExts+2));
+    AppendText(&buf, CACHE_MAGIC, StringLen(CACHE_MAGIC));
+    AppendNumber(&buf, numExts + 1, 0);
+    AppendText(&buf, "\n", 1);
+    for (i = 0; i <= numExts; i++) {
+        AppendText(&buf, sections[i].ext, StringLen(sections[i].ext));
+        AppendText(&buf, " ", 1);
+        AppendNumber(&buf, sections[i].size, 0);
+        AppendText(&buf, "\n", 1);
+    }
+    for (i = 0; i <= numExts; i++)
+        AppendText(&buf, (char*)sections[i].data, sections[i].size);
+
+    for (i = 1; i <= numExts; i++)
+        UnmapFile(sections[i].data, sections[i].size);
+
+    WriteCacheFile(CachePath(dir, key, "cache"), &buf);
+}
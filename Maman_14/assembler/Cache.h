@@ -0,0 +1,90 @@
+#ifndef CACHE_H
+    #define CACHE_H
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "MyString.h"
+#include "Arena.h"
+#include "Output.h"
+#include "Object.h"
+
+/* First line of cache entry file. */
+#define CACHE_MAGIC "ASMCACHE1\n"
+/* Length of cache key (hex digits of 64 bit hash). */
+#define CACHE_KEY_LEN 16
+/* Maximum number of files in cache entry (messages and output files). */
+#define MAX_CACHE_SECTIONS 8
+/* Maximum length of extension of file in cache entry. */
+#define MAX_CACHE_EXT_LEN 7
+
+/* Build cache.
+   Outputs of assembled source file are kept in cache directory under a key - hash of
+   the source bytes, source file name and salt (assembler version, version of cached
+   outputs and options).
+   Entry <key>.cache contains printed messages and every written file.
+   Index <hash of name and salt>.idx remembers key of the source file with its
+   size, modification time and inode, so unchanged file is found without reading it. */
+
+/* Part of cache entry - messages, or one output file. */
+typedef struct CacheSection {
+    char ext[MAX_CACHE_EXT_LEN+1]; /* Extension of output file, "log" for printed messages. */
+    unsigned char* data;           /* Content. */
+    size_t size;                   /* Size of content. */
+} CacheSection;
+
+/* Calculates 64 bit hash of bytes as two 32 bit halves.
+   Arguments:
+    data    -- Bytes.
+    len     -- Number of bytes.
+    hash    -- Seeds of two halves (hash of preceding data, or 0), replaced by resulting hash. */
+void HashBytes(unsigned char* data, size_t len, unsigned long hash[2]);
+
+/* Writes 64 bit hash as CACHE_KEY_LEN hex digits.
+   Arguments:
+    hash    -- Two 32 bit halves of hash.
+    key     -- Buffer for key (at least CACHE_KEY_LEN+1 characters). */
+void HashToKey(unsigned long hash[2], char* key);
+
+/* Creates cache directory if it does not exist.
+   Arguments:
+    dir     -- Cache directory.
+   Returns:
+    1 if directory can be used, 0 otherwise (message is printed). */
+int OpenCacheDir(char* dir);
+
+/* Finds cache key of source file.
+   Arguments:
+    dir         -- Cache directory.
+    fileName    -- Source file name without extension.
+    salt        -- Assembler version and options that change outputs.
+    key         -- Buffer for key (at least CACHE_KEY_LEN+1 characters).
+   Returns:
+    1 if key is found, 0 if source file can't be read. */
+int FindCacheKey(char* dir, char* fileName, char* salt, char* key);
+
+/* Restores outputs of source file from cache entry.
+   Output files are written and messages are printed.
+   Arguments:
+    dir         -- Cache directory.
+    key         -- Cache key of source file.
+    fileName    -- Source file name without extension.
+   Returns:
+    1 if entry is found and restored, 0 if there is no correct entry. */
+int RestoreCacheEntry(char* dir, char* key, char* fileName);
+
+/* Writes cache entry of source file.
+   Failure to write is reported and ignored.
+   Arguments:
+    dir         -- Cache directory.
+    key         -- Cache key of source file.
+    fileName    -- Source file name without extension.
+    log         -- Printed messages.
+    logLen      -- Length of messages.
+    exts        -- Extensions of written output files.
+    numExts     -- Number of output files. */
+void StoreCacheEntry(char* dir, char* key, char* fileName, char* log, int logLen, char** exts, int numExts);
+
+#endif
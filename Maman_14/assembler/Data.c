@@ -1,125 +1,285 @@
 #include "Data.h"
 
-/* Creates new linked list.
+/* Creates new empty vector in current arena.
+   Arguments:
+    itemSize    -- Size of item in bytes.
+    capacity    -- Expected number of items. Vector will grow if needed.
+   Returns:
+    Empty vector. */
+Vector* CreateVector(int itemSize, int capacity) {
+    Vector* vec = (Vector*)Allocate(sizeof(Vector)); /* New vector. */
+
+    if (capacity < 8)
+        capacity = 8;
+    vec->items = TRACKED_ALLOCATE((size_t)itemSize*capacity, site_vector_add);
+    vec->count = 0;
+    vec->capacity = capacity;
+    vec->item_size = itemSize;
+
+    return vec;
+}
+
+/* Expands capacity of vector so that given number of items can be added without expansion.
+   Arguments:
+    vec     -- Vector.
+    count   -- Number of items that will be added.
+   Algorithm:
+    Capacity is doubled until items fit, so series of additions
+    moves every item a constant number of times on average. */
+void ReserveVector(Vector* vec, int count) {
+    int new_cap = vec->capacity; /* New capacity. */
+
+    if (vec->count + count <= vec->capacity)
+        return;
+    while (vec->count + count > new_cap)
+        new_cap *= 2;
+    vec->items = TRACKED_REALLOCATE(vec->items, (size_t)vec->item_size*vec->capacity, (size_t)vec->item_size*new_cap, site_vector_add);
+    vec->capacity = new_cap;
+}
+
+/* Adds item to the end of vector.
+   Arguments:
+    vec     -- Vector.
    Returns:
-    Empty linked list. */
-List* CreateList() {
-    /* Creating structure */
-    List* list = (List*)malloc(sizeof(List));
-    if (list == NULL) {
-        perror("Failed to allocate memory");
-        exit(1);
+    Pointer to new item (not initialized). */
+void* VectorAdd(Vector* vec) {
+    if (vec->count == vec->capacity)
+        ReserveVector(vec, 1);
+    vec->count++;
+    return (char*)vec->items + (size_t)vec->item_size*(vec->count-1);
+}
+
+/* Returns item of vector.
+   Arguments:
+    vec     -- Vector.
+    i       -- Number of item (0 to count-1).
+   Returns:
+    Pointer to item. */
+void* VectorAt(Vector* vec, int i) {
+    return (char*)vec->items + (size_t)vec->item_size*i;
+}
+
+/* Copies items of other vector to the end of vector.
+   Arguments:
+    vec     -- Vector to add to.
+    other   -- Vector with items of the same size (not changed). */
+void VectorConcat(Vector* vec, Vector* other) {
+    ReserveVector(vec, other->count);
+    memcpy((char*)vec->items + (size_t)vec->item_size*vec->count, other->items, (size_t)vec->item_size*other->count);
+    vec->count += other->count;
+}
+
+/* Computes hash value of null-terminated string.
+   Uses FNV-1a algorithm.
+   Arguments:
+    key -- Null-terminated string.
+   Returns:
+    Hash value. */
+unsigned long HashString(char* key) {
+    unsigned long hash = 2166136261UL; /* FNV offset basis. */
+    int pos = 0; /* String iterator. */
+
+    while (key[pos] != '\0') {
+        hash ^= (unsigned char)key[pos];
+        hash *= 16777619UL; /* FNV prime. */
+        pos++;
     }
 
-    /* Setting initial value */
-    list->head = NULL;
-    list->count = 0;
-
-    return list;
-}
-
-/* Adds node containing given data to a list.
-   If given list does not exists (NULL) does nothing.
-   Arguments:
-    list    -- list to add to.
-    data    -- pointer to data of new node. */
-void ListAdd(List* list, void* data) {
-    if (list != NULL) {
-        ListNode* node; /* New node */
-        /* Setting up node */
-        node = (ListNode*)malloc(sizeof(ListNode));
-        if (node == NULL) { 
-            perror("Failed to allocate memory.");
-            exit(1); 
-        }
-
-        node->data = data;
-        node->next = NULL;
-
-        /* Adding node to the list. */
-        if (list->head == NULL) /* If list is empty new node becomes head. */
-            list->head = node;
-        else { /* If list is not empty searching last node. */
-            ListNode* cur = list->head;
-            while ((cur->next) != NULL) 
-                cur = (cur->next);
-            cur->next = node;
-        }
-        /* Increasing number of elements in the list. */
-        (list->count)++;
+    return hash;
+}
+
+/* Tells if two null-terminated strings are identical.
+   (MyString.h:CompareStrings is not used to keep Data independent.) */
+int KeysEqual(char* k1, char* k2) {
+    int pos = 0; /* String iterator. */
+    while (k1[pos] != '\0' && k1[pos] == k2[pos])
+        pos++;
+    return k1[pos] == k2[pos];
+}
+
+/* Allocates slots array of given size and fills it
+   with indexes of existing entries.
+   Arguments:
+    map         -- Hash map.
+    num_slots   -- New number of slots (power of 2). */
+void RebuildHashMapSlots(HashMap* map, int num_slots) {
+    int i; /* Iterator. */
+
+    /* Old slots array stays in arena until it is reset. */
+    map->slots = (int*)Allocate(sizeof(int)*num_slots);
+    map->num_slots = num_slots;
+
+    /* Marking all slots empty. */
+    for (i = 0; i < num_slots; i++)
+        map->slots[i] = -1;
+
+    /* Placing entries to slots. */
+    for (i = 0; i < map->count; i++) {
+        int slot = (int)(map->entries[i].hash & (unsigned long)(num_slots-1)); /* Slot of the entry. */
+        while (map->slots[slot] != -1)
+            slot = (slot+1) & (num_slots-1);
+        map->slots[slot] = i;
     }
 }
 
-/* Frees memory occupied by list and its data.
-   Frees every data field, every node and list 
-   itself.*/
-void FreeListAndData(List* list) {
-    if (list != NULL) {
-        if (list->count >0) {
-            ListNode* prev; /* Node before cur node. */
-            ListNode* cur = list->head; /* Iterator. */
-            while (cur != NULL) {
-                prev = cur; /* Referencing previous node. */
-                cur = cur->next; /* Advancing iterator. */
-                free(prev->data); /* Freeing data. */
-                free(prev); /* Freeing node. */
-            }
-            free(list); /* Freeing list structure. */
-        }
-        /* If there is no nodes. */
-        else {
-            /* Freeing list structure. */
-            free(list);
-            return;
-        }
+/* Creates new empty hash map.
+   Arguments:
+    capacity    -- Expected number of elements. Map will grow if needed.
+   Returns:
+    New hash map allocated in current arena. */
+HashMap* CreateHashMap(int capacity) {
+    int num_slots = 16; /* Initial number of slots. */
+    /* Allocating structure. */
+    HashMap* map = (HashMap*)Allocate(sizeof(HashMap));
+
+    if (capacity < 8)
+        capacity = 8;
+
+    /* Allocating entries array. */
+    map->entries = (HashMapEntry*)Allocate(sizeof(HashMapEntry)*capacity);
+    map->capacity = capacity;
+    map->count = 0;
+
+    /* Number of slots is kept at least twice bigger than number of entries. */
+    while (num_slots < capacity*2)
+        num_slots *= 2;
+    RebuildHashMapSlots(map, num_slots);
+
+    return map;
+}
+
+/* Searches entry by key in hash map.
+   Arguments:
+    map     -- Hash map.
+    key     -- Null-terminated key string.
+   Returns:
+    Number of entry with given key (in order of adding).
+    -1 if key is not in the map.
+   Algorithm:
+    Starts from slot given by hash and goes forward until
+    entry with the same key, or empty slot is found. */
+int HashMapFind(HashMap* map, char* key) {
+    unsigned long hash = HashString(key); /* Hash of the key. */
+    int slot = (int)(hash & (unsigned long)(map->num_slots-1)); /* Slot iterator. */
+
+    while (map->slots[slot] != -1) {
+        HashMapEntry* entry = &(map->entries[map->slots[slot]]);
+        if (entry->hash == hash && KeysEqual(entry->key, key))
+            return map->slots[slot];
+        slot = (slot+1) & (map->num_slots-1);
     }
+
+    return -1;
 }
 
-/* Creates dynamic array of integer type.
+/* Searches value by key in hash map.
    Arguments:
-    step    -- Expansion step in cells.
+    map     -- Hash map.
+    key     -- Null-terminated key string.
    Returns:
-    New dinamic array of size equal step. */
-DynArr* CreateDynArr(int step) {
-    /* Allocating structure */
-    DynArr* arr = (DynArr*)malloc(sizeof(DynArr));
-    if (arr == NULL) {
-        perror("Failed to allocate memory");
-        exit(1);
+    Value stored with given key.
+    NULL if key is not in the map. */
+void* HashMapGet(HashMap* map, char* key) {
+    int i = HashMapFind(map, key); /* Number of entry. */
+    return i == -1 ? NULL : map->entries[i].value;
+}
+
+/* Adds value to the hash map.
+   Assumes that key is not in the map yet (HashMapGet should be checked before).
+   Arguments:
+    map     -- Hash map.
+    key     -- Null-terminated key string. Not copied.
+    value   -- Pointer to data. */
+void HashMapAdd(HashMap* map, char* key, void* value) {
+    HashMapEntry* entry; /* New entry. */
+    int slot; /* Slot iterator. */
+
+    /* Expanding entries array if needed. */
+    if (map->count == map->capacity) {
+        int new_cap = map->capacity*2; /* New capacity. */
+        map->entries = (HashMapEntry*)Reallocate(map->entries, sizeof(HashMapEntry)*map->capacity, sizeof(HashMapEntry)*new_cap);
+        map->capacity = new_cap;
     }
 
+    /* Keeping load factor at most 1/2. */
+    if ((map->count+1)*2 > map->num_slots)
+        RebuildHashMapSlots(map, map->num_slots*2);
+
+    /* Writing entry. */
+    entry = &(map->entries[map->count]);
+    entry->key = key;
+    entry->hash = HashString(key);
+    entry->value = value;
+
+    /* Searching empty slot. */
+    slot = (int)(entry->hash & (unsigned long)(map->num_slots-1));
+    while (map->slots[slot] != -1)
+        slot = (slot+1) & (map->num_slots-1);
+    map->slots[slot] = map->count;
+
+    (map->count)++;
+}
+
+/* Returns value of entry number i in order of adding.
+   Arguments:
+    map     -- Hash map.
+    i       -- Entry number (0 to map->count-1).
+   Returns:
+    Value of the entry. */
+void* HashMapValueAt(HashMap* map, int i) {
+    return map->entries[i].value;
+}
+
+/* Creates dynamic array of integer type in current arena.
+   Arguments:
+    capacity    -- Initial size of array in cells.
+   Returns:
+    New dinamic array of given size. */
+DynArr* CreateDynArr(int capacity) {
+    /* Allocating structure */
+    DynArr* arr = (DynArr*)Allocate(sizeof(DynArr));
+
+    /* Array should be able to double. */
+    if (capacity < 1)
+        capacity = 1;
+
     /* Allocating data array */
-    arr->data = (int*)malloc(sizeof(int)*step);
-    if (arr->data == NULL) {
-        perror("Failed to allocate memory");
-        exit(1);
-    }
+    arr->data = (int*)Allocate(sizeof(int)*capacity);
     
     /* Setting initial values */
     arr->count = 0;
-    arr->step = step;
-    arr->size = step;
+    arr->size = capacity;
 
     return arr;
 }
 
-/* Expands dynamic integer array by one step.
+/* Expands dynamic integer array twice.
    Arguments:
     arr  -- Dynamic array for expansion. */
 void ExpandDynArr(DynArr* arr) {
-    int newSize; /* New array size */
-    int* result; /* Resulting data pointer after reallocation. */
+    ReserveDynArr(arr, arr->size - arr->count + 1);
+}
+
+/* Expands dynamic integer array so that given number
+   of elements can be added without expansion.
+   Arguments:
+    arr     -- Dynamic array.
+    count   -- Number of elements that will be added.
+   Algorithm:
+    Size is at least doubled, so series of small reservations
+    does not copy the array on every call. */
+void ReserveDynArr(DynArr* arr, int count) {
+    int newSize = arr->size*2; /* New array size */
+
+    if (arr->count + count <= arr->size)
+        return;
+    if (newSize < arr->count + count)
+        newSize = arr->count + count;
 
     /* Expanding data array */
-    newSize = (arr->size)+arr->step;
-    result = (int*)realloc(arr->data, sizeof(int)*newSize);
-    if (result == NULL) {
-        perror("Failed to allocate memory");
-        exit(1);
-    }
+    arr->data = (int*)TRACKED_REALLOCATE(arr->data, sizeof(int)*(arr->size), sizeof(int)*newSize, site_expand_dyn_arr);
 
     /* Setting new properties */
-    arr->data = result;
     arr->size = newSize;
 }
 
@@ -138,22 +298,105 @@ void AddDynArr(DynArr* arr, int data) {
     (arr->count)++;
 }
 
-/* Frees memory allocated for dynamic array.
-   Removes data and structure.
+/* Creates empty lines collection in current arena.
    Arguments:
-    arr  -- Dynamic array to free. */
-void FreeDynArr(DynArr* arr) {
-    /* Removing data. */
-    free(arr->data);
-    /* Removing structure. */
-    free(arr);
+    capacity    -- Initial capacity of text buffer in characters.
+   Returns:
+    New lines collection. */
+Lines* CreateLines(int capacity) {
+    /* Allocating structure. */
+    Lines* lines = (Lines*)Allocate(sizeof(Lines));
+
+    if (capacity < 256)
+        capacity = 256;
+
+    /* Allocating text buffer and offsets array. */
+    lines->text = (char*)Allocate(sizeof(char)*capacity);
+    lines->capacity = capacity;
+    lines->length = 0;
+    /* Offsets array step is estimated from buffer capacity
+       (average line is assumed to be at least 16 characters). */
+    lines->offsets = CreateDynArr(capacity/16);
+
+    return lines;
+}
+
+/* Adds copy of line to the end of lines collection.
+   Text buffer is expanded automatically.
+   Arguments:
+    lines   -- Lines collection.
+    line    -- Null-terminated line. */
+void AddLine(Lines* lines, char* line) {
+    int len = 0; /* Length of the line. */
+
+    while (line[len] != '\0')
+        len++;
+
+    /* Doubling text buffer until line and its termination fit. */
+    if (lines->length + len + 1 > lines->capacity) {
+        int new_cap = lines->capacity; /* New capacity of text buffer. */
+        while (lines->length + len + 1 > new_cap)
+            new_cap *= 2;
+        lines->text = (char*)Reallocate(lines->text, sizeof(char)*(lines->length), sizeof(char)*new_cap);
+        lines->capacity = new_cap;
+    }
+
+    /* Saving line position and copying the line with termination character. */
+    AddDynArr(lines->offsets, lines->length);
+    memcpy(lines->text + lines->length, line, len+1);
+    lines->length += len+1;
+}
+
+/* Adds all lines of one collection to the end of another.
+   Arguments:
+    lines   -- Lines collection to add to.
+    source  -- Lines to add.
+   Algorithm:
+    Text of source lines is copied as one block,
+    offsets of source lines are shifted by current length of text. */
+void AddLines(Lines* lines, Lines* source) {
+    int i; /* Source lines iterator. */
+
+    /* Doubling text buffer until source text fits. */
+    if (lines->length + source->length > lines->capacity) {
+        int new_cap = lines->capacity; /* New capacity of text buffer. */
+        while (lines->length + source->length > new_cap)
+            new_cap *= 2;
+        lines->text = (char*)Reallocate(lines->text, sizeof(char)*(lines->length), sizeof(char)*new_cap);
+        lines->capacity = new_cap;
+    }
+
+    /* Saving shifted positions of source lines. */
+    for (i = 0; i < source->offsets->count; i++)
+        AddDynArr(lines->offsets, lines->length + source->offsets->data[i]);
+
+    /* Copying source text. */
+    memcpy(lines->text + lines->length, source->text, source->length);
+    lines->length += source->length;
+}
+
+/* Returns number of lines in collection.
+   Arguments:
+    lines   -- Lines collection. */
+int LinesCount(Lines* lines) {
+    return lines->offsets->count;
+}
+
+/* Returns line from collection by its index.
+   Arguments:
+    lines   -- Lines collection.
+    i       -- Index of line (0 to LinesCount()-1).
+   Returns:
+    Null-terminated line. */
+char* GetLine(Lines* lines, int i) {
+    return lines->text + lines->offsets->data[i];
 }
 
 /* Initializes BinarySegment dynamic array structure.
    Returns pointer to BinarySegment allocated on heap. */
 BinarySegment* CreateBinary() {
    /* Allocating structure. */
-   BinarySegment* bin = (BinarySegment*)malloc(sizeof(BinarySegment));
+   BinarySegment* bin = (BinarySegment*)TRACKED_MALLOC(sizeof(BinarySegment), site_create_binary);
    if (bin == NULL) {
       perror("Failed to allocate memory.");
       exit(1);
@@ -162,11 +405,10 @@ BinarySegment* CreateBinary() {
    /* Setting initial values.*/
    bin->base = 0;
    bin->counter = 0;
-   bin->step = 64;
-   bin->capacity = bin->step;
+   bin->capacity = 64;
 
    /* Allocating data array. */
-   bin->words = (int*)malloc(sizeof(int)*(bin->capacity));
+   bin->words = (int*)TRACKED_MALLOC(sizeof(int)*(bin->capacity), site_create_binary);
    if (bin->words == NULL) {
       perror("Failed to allocate memory.");
       exit(1);
@@ -183,17 +425,8 @@ BinarySegment* CreateBinary() {
 */
 void AddBinary(BinarySegment* bin, int val) {
    /* Checking if capacity should be expanded. */
-   if (bin->counter == (bin->capacity - 1)) {
-      int new_cap = bin->capacity + bin->step; /* New capacity. */
-      int* res; /* Result of reallocation. */
-      res = (int*)realloc(bin->words, sizeof(int)*new_cap); /* Reallocating words. */
-      if (res == NULL) {
-         perror("Failed to allocate memory.");
-         exit(1);
-      }
-      /* Setting new capacity. */
-      bin->capacity = new_cap;
-   }
+   if (bin->counter == (bin->capacity - 1))
+      ReserveBinary(bin, 1);
    
    /* Writing new value */
    (bin->words)[bin->counter] = val;
@@ -201,6 +434,43 @@ void AddBinary(BinarySegment* bin, int val) {
    (bin->counter)++;
 }
 
+/* Expands capacity of binary segment array so that given number
+   of words can be added without expansion.
+   Arguments:
+    bin     -- Pointer to binary segment structure.
+    count   -- Number of words that will be added.
+   Algorithm:
+    Capacity is at least doubled, so words added one by one, or in small
+    groups, are copied a constant number of times on average. */
+void ReserveBinary(BinarySegment* bin, int count) {
+   /* AddBinary() keeps one free word after the last word. */
+   int new_cap = bin->counter + count + 1; /* Needed capacity. */
+   int* res; /* Result of reallocation. */
+
+   if (new_cap <= bin->capacity)
+      return;
+   if (new_cap < bin->capacity*2)
+      new_cap = bin->capacity*2;
+   res = (int*)TRACKED_REALLOC(bin->words, sizeof(int)*(bin->capacity), sizeof(int)*new_cap, site_add_binary);
+   if (res == NULL) {
+      perror("Failed to allocate memory.");
+      exit(1);
+   }
+   bin->words = res;
+   bin->capacity = new_cap;
+}
+
+/* Adds words to binary segment array.
+   Arguments:
+    bin     -- Pointer to binary segment structure.
+    words   -- Words to add.
+    count   -- Number of words. */
+void AddBinaryWords(BinarySegment* bin, int* words, int count) {
+   ReserveBinary(bin, count);
+   memcpy(bin->words + bin->counter, words, sizeof(int)*count);
+   bin->counter += count;
+}
+
 /* Gets binary word from BinarySegment structure
    by given address.
    If adress is incorrect returns 0.
@@ -238,10 +508,9 @@ void SetBinary(BinarySegment* bin, int adr, int val) {
    Arguments:
     bin  -- Binary segment structure. */
 void FreeBinary(BinarySegment* bin) {
-   if (bin->words != NULL)
-      free(bin->words);
+   TRACKED_FREE(bin->words, sizeof(int)*(bin->capacity));
 
-   free(bin);
+   TRACKED_FREE(bin, sizeof(BinarySegment));
 }
 
 /* Returns next address in binary segment pointed by counter.
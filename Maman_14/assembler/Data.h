@@ -3,73 +3,163 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include "Arena.h"
 
-/* Defines node of linked list.
-   Data is stored as a pointer.
-*/
-typedef struct ListNode {
-    void* data;
-    struct ListNode* next;
-} ListNode;
+/* Dynamic array of structures of one type stored by value one after another.
+   Capacity is doubled when array is full, so adding n items copies O(n) bytes.
+   Array is allocated in current arena. Array moves when it grows, so pointers
+   to items are valid only until next item is added.
+   Items of type T are accessed as ((T*)vec->items)[i], or by VectorAt(). */
+typedef struct Vector {
+    void* items;    /* Array of items. */
+    int count;      /* Number of items. */
+    int capacity;   /* Capacity of array in items. */
+    int item_size;  /* Size of item in bytes. */
+} Vector;
+
+/* Creates new empty vector in current arena.
+   Arguments:
+    itemSize    -- Size of item in bytes.
+    capacity    -- Expected number of items. Vector will grow if needed.
+   Returns:
+    Empty vector. */
+Vector* CreateVector(int itemSize, int capacity);
+
+/* Expands capacity of vector so that given number of items can be added without expansion.
+   Arguments:
+    vec     -- Vector.
+    count   -- Number of items that will be added. */
+void ReserveVector(Vector* vec, int count);
+
+/* Adds item to the end of vector.
+   Arguments:
+    vec     -- Vector.
+   Returns:
+    Pointer to new item (not initialized). */
+void* VectorAdd(Vector* vec);
+
+/* Returns item of vector.
+   Arguments:
+    vec     -- Vector.
+    i       -- Number of item (0 to count-1).
+   Returns:
+    Pointer to item. */
+void* VectorAt(Vector* vec, int i);
+
+/* Copies items of other vector to the end of vector.
+   Arguments:
+    vec     -- Vector to add to.
+    other   -- Vector with items of the same size (not changed). */
+void VectorConcat(Vector* vec, Vector* other);
+
+
+
+/* Entry of a hash map.
+   Key is not copied, it should stay valid while entry is in the map
+   (usually key is a name field of the value structure). */
+typedef struct HashMapEntry {
+    char* key;           /* Null-terminated key string. */
+    unsigned long hash;  /* Hash value of the key. */
+    void* value;         /* Pointer to stored data. */
+} HashMapEntry;
 
 
-/* Defines Linked List structure.
-   Data is stored as pointers and can be of any type. */
-typedef struct List {
-    struct ListNode* head;
-    int count;
-} List;
+/* Hash map from strings to pointers of any type.
+   Uses open addressing with linear probing. Slots array holds
+   indexes of entries and entries are stored in order of adding,
+   so map can be iterated in this order:
+    for (i = 0; i < map->count; i++)
+        ... map->entries[i].value ...
+   Elements can't be removed from the map.
+   Map is allocated in current arena and freed with it. */
+typedef struct HashMap {
+    HashMapEntry* entries; /* Array of entries in order of adding. */
+    int count;             /* Number of entries. */
+    int capacity;          /* Capacity of entries array. */
+    int* slots;            /* Array of indexes in entries, -1 marks empty slot. */
+    int num_slots;         /* Size of slots array (power of 2). */
+} HashMap;
 
-/* Creates new linked list.
+/* Creates new empty hash map.
+   Arguments:
+    capacity    -- Expected number of elements. Map will grow if needed.
    Returns:
-    Empty linked list.
- */
-List* CreateList();
+    New hash map allocated in current arena. */
+HashMap* CreateHashMap(int capacity);
 
-/* Adds node containing given data to a list.
-   If given list does not exists (NULL) does nothing.
+/* Searches value by key in hash map.
    Arguments:
-    list    -- list to add to.
-    data    -- pointer to data of new node.
- */
-void ListAdd(List* list, void* data);
+    map     -- Hash map.
+    key     -- Null-terminated key string.
+   Returns:
+    Value stored with given key.
+    NULL if key is not in the map. */
+void* HashMapGet(HashMap* map, char* key);
+
+/* Searches entry by key in hash map.
+   Arguments:
+    map     -- Hash map.
+    key     -- Null-terminated key string.
+   Returns:
+    Number of entry with given key (in order of adding).
+    -1 if key is not in the map. */
+int HashMapFind(HashMap* map, char* key);
+
+/* Adds value to the hash map.
+   Assumes that key is not in the map yet (HashMapGet should be checked before).
+   Arguments:
+    map     -- Hash map.
+    key     -- Null-terminated key string. Not copied.
+    value   -- Pointer to data. */
+void HashMapAdd(HashMap* map, char* key, void* value);
+
+/* Returns value of entry number i in order of adding.
+   Arguments:
+    map     -- Hash map.
+    i       -- Entry number (0 to map->count-1).
+   Returns:
+    Value of the entry. */
+void* HashMapValueAt(HashMap* map, int i);
 
-/* Frees memory occupied by list and its data.
-   Frees every data field, every node and list 
-   itself.*/
-void FreeListAndData(List* list);
 
 
 /* Dynamic array of integer type.
    Size of this array can be expanded by calling 
-   a function. Size is expanded in steps.
-   Steps are defined when creaing this structure.
+   a function. Size is doubled on every expansion, so adding
+   n elements copies O(n) elements in total.
    Elements can be added one after another with 
    a function. In this case array is expanded automatically.
    When user creates this array he should decide if he will
    add elements directly to ->data field and use function to expand
    capacity, or use function to add elements one after another in
    which case array will be expanded automatically.
+   Array is allocated in current arena and freed with it.
     */
 typedef struct DynArr {
    int* data;  /* Array holding data. */
    int size; /* Size of data array. */
-   int step; /* Expansion step in cells. */
    int count; /* Number of added elements. */
 } DynArr;
 
-/* Creates dynamic array of integer type.
+/* Creates dynamic array of integer type in current arena.
    Arguments:
-    step    -- Expansion step in cells.
+    capacity    -- Initial size of array in cells.
    Returns:
-    New dynamic array of size equal step. */
-DynArr* CreateDynArr(int step);
+    New dynamic array of given size. */
+DynArr* CreateDynArr(int capacity);
 
-/* Expands dynamic integer array by one step.
+/* Expands dynamic integer array twice.
    Arguments:
     arr  -- Dynamic array for expansion. */
 void ExpandDynArr(DynArr* arr);
 
+/* Expands dynamic integer array so that given number
+   of elements can be added without expansion.
+   Arguments:
+    arr     -- Dynamic array.
+    count   -- Number of elements that will be added. */
+void ReserveDynArr(DynArr* arr, int count);
+
 /* Writes data to dynamic array at position ->count
    and increases this counter.
    Arguments:
@@ -77,11 +167,54 @@ void ExpandDynArr(DynArr* arr);
     data    -- New data element. */
 void AddDynArr(DynArr* arr, int data);
 
-/* Frees memory allocated for dynamic array.
-   Removes data and structure.
+
+
+
+
+/* Collection of text lines stored one after another
+   in a single character buffer. Every line is kept with its
+   new line character and is terminated by '\0'.
+   Lines should be added by AddLine() and read by GetLine().
+   Structure is allocated in current arena and freed with it. */
+typedef struct Lines {
+   char* text;      /* Buffer holding the lines. */
+   int length;      /* Number of used characters in text. */
+   int capacity;    /* Capacity of text buffer in characters. */
+   DynArr* offsets; /* Position in text where each line starts. */
+} Lines;
+
+/* Creates empty lines collection in current arena.
    Arguments:
-    arr  -- Dynamic array to free. */
-void FreeDynArr(DynArr* arr);
+    capacity    -- Initial capacity of text buffer in characters.
+   Returns:
+    New lines collection. */
+Lines* CreateLines(int capacity);
+
+/* Adds copy of line to the end of lines collection.
+   Text buffer is expanded automatically.
+   Arguments:
+    lines   -- Lines collection.
+    line    -- Null-terminated line. */
+void AddLine(Lines* lines, char* line);
+
+/* Adds all lines of one collection to the end of another.
+   Arguments:
+    lines   -- Lines collection to add to.
+    source  -- Lines to add. */
+void AddLines(Lines* lines, Lines* source);
+
+/* Returns number of lines in collection.
+   Arguments:
+    lines   -- Lines collection. */
+int LinesCount(Lines* lines);
+
+/* Returns line from collection by its index.
+   Arguments:
+    lines   -- Lines collection.
+    i       -- Index of line (0 to LinesCount()-1).
+   Returns:
+    Null-terminated line. */
+char* GetLine(Lines* lines, int i);
 
 
 
@@ -92,6 +225,8 @@ void FreeDynArr(DynArr* arr);
    Structure should be created by calling CreateBinary().
    Elements should be added by calling AddBinary()
    and array will be expanded automatically and counter will be increased.
+   Capacity is doubled on expansion. If number of words is known, or can
+   be estimated, array can be expanded once by ReserveBinary().
    Elements can be read by calling GetBinary() and set by SetBinary().
    Memory can be freed by calling FreeBinary().
     */
@@ -100,7 +235,6 @@ typedef struct BinarySegment {
    int counter;  /* Offset from base pointing to empty word after last added word. (also word counter) */
    /* Base+counter form an adress of a word in memory. */
    int* words;   /* Array for storing binary words. */
-   int step;     /* Step of array expansion in sizeof(int). */
    int capacity; /* Current capacity of the array.*/
 } BinarySegment;
 
@@ -116,6 +250,20 @@ BinarySegment* CreateBinary();
 */
 void AddBinary(BinarySegment* bin, int val);
 
+/* Expands capacity of binary segment array so that given number
+   of words can be added without expansion.
+   Arguments:
+    bin     -- Pointer to binary segment structure.
+    count   -- Number of words that will be added. */
+void ReserveBinary(BinarySegment* bin, int count);
+
+/* Adds words to binary segment array.
+   Arguments:
+    bin     -- Pointer to binary segment structure.
+    words   -- Words to add.
+    count   -- Number of words. */
+void AddBinaryWords(BinarySegment* bin, int* words, int count);
+
 /* Gets binary word from BinarySegment structure
    by given address.
    If adress is incorrect returns 0.
@@ -4,28 +4,39 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "MyString.h"
+#include "Definitions.h"
 #include "Data.h"
 
 /* Structure that describes info about macro.*/
 typedef struct MacroInfo {
     char* name;  /* Macro name */
-    long body_pos; /* Index position in file where macro body starts. */
+    Lines* body; /* Macro body lines without blank and comment lines. */
+    DynArr* body_lines; /* For every line in body its index in macro body definition (from 0). */
     int body_line_num; /* Number of line in source file where macro body starts. */
     int num_lines; /* Length of macro body definition in lines (excluding name line and endm line) */    
 } MacroInfo;
 
 
+/* Part of a line given by position and length.
+   Used for referencing words in line without copying them. */
+typedef struct Span {
+    int start; /* Position of first character in line. */
+    int len;   /* Number of characters. */
+} Span;
+
+
 /* Structure that represents instruction argument.
    Can represent any kind of argument - number, label, label with index, register.
     */
 typedef struct InsArg {
    int amode;        /* Adressing mode according to AdressingModes enum. */
    int val;          /* Number in immediate mode, or register number in register direct or direct index modes. */
-   char label[32];   /* If argument is a label label is saved in this field (direct and direct index modes). */
+   int label;        /* If argument is a label id of the label is saved in this field (direct and direct index modes). */
 } InsArg;
 
 
-/* Structure that represents an instruction. */
+/* Structure that represents an instruction.
+   Instruction and its arguments are allocated in current arena. */
 typedef struct Ins {
    int ins;          /* Instruction according to InstructionsEnum */
    InsArg* source;   /* Source argument. */
@@ -38,11 +49,6 @@ typedef struct BOAddress {
    int offset;
 } BOAddress;
 
-/* Frees memory occupied by instruction. 
-   Removes argument structures if they are present
-   and instruction itself.*/
-void FreeIns(Ins* ins);
-
 /* Tells if binary value describing addressing modes
    in instruction info has specific mode.
    Arguments:
@@ -1,139 +1,194 @@
 #include "Definitions.h"
 
+/* ARE field value of absolute words (100). */
+#define ARE_ABSOLUTE 4
+
+/* First (opcode) word of instruction with given opcode. */
+#define FIRST_WORD(opcode) ((1 << (opcode)) | (ARE_ABSOLUTE << 16))
+
+/* Second (funct) word without register fields.
+   funct is -1 if instruction has no funct code. */
+#define SECOND_WORD(funct, src, dest) \
+    ((((funct) < 0 ? 0 : (funct)) << 12) | ((src) << 6) | (dest) | (ARE_ABSOLUTE << 16))
+
+/* Second word if source mode src and destination mode dest are allowed by
+   modes srcModes and destModes, -1 otherwise. Instructions without source
+   argument are encoded with source mode 0. */
+#define SECOND_WORD_IF_LEGAL(funct, srcModes, destModes, src, dest) \
+    ((((srcModes) == 0 ? (src) == 0 : HAS_MODE(srcModes, src)) && HAS_MODE(destModes, dest)) ? \
+     SECOND_WORD(funct, src, dest) : -1)
+
+/* Row of second words for all destination modes. */
+#define SECOND_WORDS_ROW(funct, srcModes, destModes, src) { \
+    SECOND_WORD_IF_LEGAL(funct, srcModes, destModes, src, am_immediate), \
+    SECOND_WORD_IF_LEGAL(funct, srcModes, destModes, src, am_direct), \
+    SECOND_WORD_IF_LEGAL(funct, srcModes, destModes, src, am_index), \
+    SECOND_WORD_IF_LEGAL(funct, srcModes, destModes, src, am_rdirect) }
+
+/* Second words for all source and destination modes. */
+#define SECOND_WORDS(funct, srcModes, destModes) { \
+    SECOND_WORDS_ROW(funct, srcModes, destModes, am_immediate), \
+    SECOND_WORDS_ROW(funct, srcModes, destModes, am_direct), \
+    SECOND_WORDS_ROW(funct, srcModes, destModes, am_index), \
+    SECOND_WORDS_ROW(funct, srcModes, destModes, am_rdirect) }
+
+/* Instruction info entry. */
+#define INS_INFO(name, opcode, funct, srcModes, destModes) \
+    { ins_##name, #name, opcode, funct, srcModes, destModes, FIRST_WORD(opcode), SECOND_WORDS(funct, srcModes, destModes) }
+
+/* Table of instructions indexed by InstructionsEnum.
+   Addressing modes: 1+2+4+8 - 0,1,2,3; 2+4+8 - 1,2,3; 2+4 - 1,2; 0 - no argument. */
+static const InsInfo instructions[16] = {
+    INS_INFO(mov, 0, -1, 1+2+4+8, 2+4+8),
+    INS_INFO(cmp, 1, -1, 1+2+4+8, 1+2+4+8),
+    INS_INFO(add, 2, 10, 1+2+4+8, 2+4+8),
+    INS_INFO(sub, 2, 11, 1+2+4+8, 2+4+8),
+    INS_INFO(lea, 4, -1, 2+4, 2+4+8),
+    INS_INFO(clr, 5, 10, 0, 2+4+8),
+    INS_INFO(not, 5, 11, 0, 2+4+8),
+    INS_INFO(inc, 5, 12, 0, 2+4+8),
+    INS_INFO(dec, 5, 13, 0, 2+4+8),
+    INS_INFO(jmp, 9, 10, 0, 2+4),
+    INS_INFO(bne, 9, 11, 0, 2+4),
+    INS_INFO(jsr, 9, 12, 0, 2+4),
+    INS_INFO(red, 12, -1, 0, 2+4+8),
+    INS_INFO(prn, 13, -1, 0, 1+2+4+8),
+    INS_INFO(rts, 14, -1, 0, 0),
+    INS_INFO(stop, 15, -1, 0, 0)
+};
+
 /* Return info about given instruction.
    Argument:
     code    -- Instruction code according to InstructionsEnum.
    Returns:
-    Instruction info structure.  */
-InsInfo GetInstructionInfo(int code) {
-    InsInfo info;
-
-    switch (code)
-    {
-    case ins_mov:
-        info.ins = ins_mov;
-        info.opcode = 0;
-        info.funct = -1;
-        info.amodes_source = 1+2+4+8; /* 0,1,2,3 */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
+    Pointer to constant instruction info structure.
+    NULL if code is not an instruction code.
+   Algorithm:
+    Info is taken from constant table indexed by instruction code.
+    Table is built at compile time by macros above, including
+    encoded first and second words for every allowed pair of modes. */
+const InsInfo* GetInstructionInfo(int code) {
+    if (code < ins_mov || code > ins_stop)
+        return NULL;
+
+    return &(instructions[code]);
+}
+
+
+
+/* Checks if first len characters of word are equal to name.
+   Arguments:
+    word    -- Word to check.
+    name    -- Reserved word to compare with.
+    len     -- Number of characters to compare.
+   Returns:
+    1 if characters are equal, 0 otherwise. */
+int WordEquals(char* word, char* name, int len) {
+    int i; /* Characters iterator. */
+    for (i = 0; i < len; i++) {
+        if (word[i] != name[i])
+            return 0;
+    }
+    return 1;
+}
+
+
+
+/* Classifies a word as instruction name, register name,
+   keyword, or not a reserved word.
+   Arguments:
+    word    -- Word (does not have to be null-terminated).
+    len     -- Length of the word.
+    value   -- Variable for returning number of the word according to its type:
+               InstructionsEnum for instructions, register number for registers,
+               DirectivesEnum for directive keywords and -1 for macro and endm.
+               May be NULL.
+   Returns:
+    Type of the word according to ReservedWordsEnum.
+   Algorithm:
+    Candidates are selected by length and, for
+    3 characters words, by first character. This leaves at most three
+    candidates that are compared with the word. */
+int ClassifyWord(char* word, int len, int* value) {
+    int type = rw_none; /* Type of the word. */
+    int val = -1; /* Number of the word. */
+
+    switch (len) {
+    case 2: /* r0-r9 */
+        if (word[0] == 'r' && word[1] >= '0' && word[1] <= '9') {
+            type = rw_register;
+            val = word[1] - '0';
+        }
         break;
-    case ins_cmp:
-        info.ins = ins_cmp;
-        info.opcode = 1;
-        info.funct = -1;
-        info.amodes_source = 1+2+4+8; /* 0,1,2,3 */
-        info.amodes_dest = 1+2+4+8; /* 0,1,2,3 */
+    case 3: /* Instructions (except stop) and r10-r15. */
+        switch (word[0]) {
+        case 'a':
+            if (WordEquals(word, "add", 3)) { type = rw_instruction; val = ins_add; }
+            break;
+        case 'b':
+            if (WordEquals(word, "bne", 3)) { type = rw_instruction; val = ins_bne; }
+            break;
+        case 'c':
+            if (WordEquals(word, "cmp", 3)) { type = rw_instruction; val = ins_cmp; }
+            else if (WordEquals(word, "clr", 3)) { type = rw_instruction; val = ins_clr; }
+            break;
+        case 'd':
+            if (WordEquals(word, "dec", 3)) { type = rw_instruction; val = ins_dec; }
+            break;
+        case 'i':
+            if (WordEquals(word, "inc", 3)) { type = rw_instruction; val = ins_inc; }
+            break;
+        case 'j':
+            if (WordEquals(word, "jmp", 3)) { type = rw_instruction; val = ins_jmp; }
+            else if (WordEquals(word, "jsr", 3)) { type = rw_instruction; val = ins_jsr; }
+            break;
+        case 'l':
+            if (WordEquals(word, "lea", 3)) { type = rw_instruction; val = ins_lea; }
+            break;
+        case 'm':
+            if (WordEquals(word, "mov", 3)) { type = rw_instruction; val = ins_mov; }
+            break;
+        case 'n':
+            if (WordEquals(word, "not", 3)) { type = rw_instruction; val = ins_not; }
+            break;
+        case 'p':
+            if (WordEquals(word, "prn", 3)) { type = rw_instruction; val = ins_prn; }
+            break;
+        case 'r':
+            if (WordEquals(word, "red", 3)) { type = rw_instruction; val = ins_red; }
+            else if (WordEquals(word, "rts", 3)) { type = rw_instruction; val = ins_rts; }
+            else if (word[1] == '1' && word[2] >= '0' && word[2] <= '5') {
+                type = rw_register;
+                val = 10 + word[2] - '0';
+            }
+            break;
+        case 's':
+            if (WordEquals(word, "sub", 3)) { type = rw_instruction; val = ins_sub; }
+            break;
+        }
         break;
-    case ins_add:
-        info.ins = ins_add;
-        info.opcode = 2;
-        info.funct = 10;
-        info.amodes_source = 1+2+4+8; /* 0,1,2,3 */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
+    case 4: /* stop, endm, data */
+        if (WordEquals(word, "stop", 4)) { type = rw_instruction; val = ins_stop; }
+        else if (WordEquals(word, "endm", 4)) { type = rw_keyword; val = -1; }
+        else if (WordEquals(word, "data", 4)) { type = rw_keyword; val = dir_data; }
         break;
-    case ins_sub:
-        info.ins = ins_sub;
-        info.opcode = 2;
-        info.funct = 11;
-        info.amodes_source = 1+2+4+8; /* 0,1,2,3 */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
+    case 5: /* macro, .data, entry */
+        if (WordEquals(word, "macro", 5)) { type = rw_keyword; val = -1; }
+        else if (WordEquals(word, ".data", 5)) { type = rw_keyword; val = dir_data; }
+        else if (WordEquals(word, "entry", 5)) { type = rw_keyword; val = dir_entry; }
         break;
-
-    case ins_lea:
-        info.ins = ins_lea;
-        info.opcode = 4;
-        info.funct = -1;
-        info.amodes_source = 2+4; /* 1,2 */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
+    case 6: /* string, extern, .entry */
+        if (WordEquals(word, "string", 6)) { type = rw_keyword; val = dir_string; }
+        else if (WordEquals(word, "extern", 6)) { type = rw_keyword; val = dir_extern; }
+        else if (WordEquals(word, ".entry", 6)) { type = rw_keyword; val = dir_entry; }
+        break;
+    case 7: /* .string, .extern */
+        if (WordEquals(word, ".string", 7)) { type = rw_keyword; val = dir_string; }
+        else if (WordEquals(word, ".extern", 7)) { type = rw_keyword; val = dir_extern; }
         break;
-    case ins_clr:
-        info.ins = ins_clr;
-        info.opcode = 5;
-        info.funct = 10;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
-        break;  
-    case ins_not:
-        info.ins = ins_not;
-        info.opcode = 5;
-        info.funct = 11;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
-        break;  
-    case ins_inc:
-        info.ins = ins_inc;
-        info.opcode = 5;
-        info.funct = 12;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
-        break;  
-
-    case ins_dec:
-        info.ins = ins_dec;
-        info.opcode = 5;
-        info.funct = 13;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
-        break;  
-    case ins_jmp:
-        info.ins = ins_jmp;
-        info.opcode = 9;
-        info.funct = 10;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4; /* 1,2 */
-        break;  
-    case ins_bne:
-        info.ins = ins_bne;
-        info.opcode = 9;
-        info.funct = 11;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4; /* 1,2 */
-        break;  
-    case ins_jsr:
-        info.ins = ins_jsr;
-        info.opcode = 9;
-        info.funct = 12;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4; /* 1,2 */
-        break;  
-
-    case ins_red:
-        info.ins = ins_red;
-        info.opcode = 12;
-        info.funct = -1;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 2+4+8; /* 1,2,3 */
-        break;      
-    case ins_prn:
-        info.ins = ins_prn;
-        info.opcode = 13;
-        info.funct = -1;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 1+2+4+8; /* 0,1,2,3 */
-        break;      
-    case ins_rts:
-        info.ins = ins_rts;
-        info.opcode = 14;
-        info.funct = -1;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 0; /* No destination operand. */
-        break;      
-    case ins_stop:
-        info.ins = ins_stop;
-        info.opcode = 15;
-        info.funct = -1;
-        info.amodes_source = 0; /* No source operand. */
-        info.amodes_dest = 0; /* No destination operand. */
-        break;      
-    
-    default:
-        info.ins = -1;
-        info.opcode = -1;
-        info.funct = -1;
-        info.amodes_source = -1;
-        info.amodes_dest = -1;
-        return info;
     }
 
-    return info;
-}
\ No newline at end of file
+    if (value != NULL)
+        *value = val;
+    return type;
+}
@@ -1,11 +1,19 @@
 #ifndef DEFINITIONS_H
     #define DEFINITIONS_H
 
+#include <stdlib.h>
+
 /* Maximum length of a statement in symbols in assembly
 source file not including end of the line \n symbol*/
 #define MAX_STATEMENT_LEN 80
+/* Maximum number of arguments in a statement
+   (every argument takes at least one character and a comma). */
+#define MAX_ARGS (MAX_STATEMENT_LEN/2 + 1)
 /* Maximum length of a label without : and termination character. */
 #define MAX_LABEL_LEN 31
+/* Average length of source line in characters assumed when capacities
+   are estimated from size of source (arrays grow if lines are shorter). */
+#define EST_LINE_LEN 16
 
 /* Enumeration of processor Instructions. */
 enum InstructionsEnum {
@@ -23,6 +31,15 @@ enum DirectivesEnum {
    dir_extern
 };
 
+/* Enumeration of reserved word types.
+   Values are the same as returned by IsReservedWord(). */
+enum ReservedWordsEnum {
+   rw_none,        /* Not a reserved word. */
+   rw_instruction, /* Instruction name. */
+   rw_register,    /* Register name (r0-r15). */
+   rw_keyword      /* Keyword - macro, endm and directive names with or without '.'. */
+};
+
 /* Enumeration of symbol attributes in symbols table. */
 enum SymbolAttributesEnum {
     att_entry,
@@ -43,6 +60,7 @@ enum AdressingModesEnum {
    and its structure. */
 typedef struct InsInfo {
    int ins;                /* Instruction number according to InstructionsEnum*/
+   const char* name;       /* Instruction name as written in source code. */
    int opcode;             /* Instruction opcode */
    int funct;              /* Instruction funct code. (0 if no code)*/
    int amodes_source;      /* 4-bit binary value that describes possible addressing modes
@@ -50,13 +68,45 @@ typedef struct InsInfo {
                               [8]immideate-[4]direct-[2]d-index-[1]register
                               For example if modes =  5 = 0101 possible modes are direct and register. */
    int amodes_dest;        /* Possible addressing modes for destination argument. */
+   int first_word;         /* Encoded first (opcode) word. */
+   int second_words[4][4]; /* Encoded second (funct) words indexed by source and destination
+                              addressing modes, without register fields.
+                              -1 if modes combination is not allowed.
+                              Source mode is 0 for instructions without source argument. */
 } InsInfo;
 
+/* Tells if addressing modes value (amodes fields of InsInfo)
+   has specific addressing mode. */
+#define HAS_MODE(amodes, mode) (((amodes) >> (mode)) & 1)
+
 /* Return info about given instruction.
    Argument:
     code    -- Instruction code according to InstructionsEnum.
    Returns:
-    Instruction info structure.  */
-InsInfo GetInstructionInfo(int code);
+    Pointer to constant instruction info structure.
+    NULL if code is not an instruction code. */
+const InsInfo* GetInstructionInfo(int code);
+
+/* Classifies a word as instruction name, register name,
+   keyword, or not a reserved word.
+   Arguments:
+    word    -- Word (does not have to be null-terminated).
+    len     -- Length of the word.
+    value   -- Variable for returning number of the word according to its type:
+               InstructionsEnum for instructions, register number for registers,
+               DirectivesEnum for directive keywords and -1 for macro and endm.
+               May be NULL.
+   Returns:
+    Type of the word according to ReservedWordsEnum. */
+int ClassifyWord(char* word, int len, int* value);
+
+/* Checks if first len characters of word are equal to name.
+   Arguments:
+    word    -- Word to check.
+    name    -- Reserved word to compare with.
+    len     -- Number of characters to compare.
+   Returns:
+    1 if characters are equal, 0 otherwise. */
+int WordEquals(char* word, char* name, int len);
 
 #endif
\ No newline at end of file
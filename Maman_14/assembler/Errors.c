@@ -20,30 +20,51 @@ void AddLineReference(Errors* errors, int exLineNum) {
 }
 
 
+/* Expands source line reference of errors structure so that given number
+   of references can be added without expansion.
+   Arguments:
+    errors      -- List of errors.
+    count       -- Number of references that will be added. */
+void ReserveLineReferences(Errors* errors, int count) {
+    ReserveDynArr(errors->slr, count);
+}
+
+
 /* Creates new errors array structure. */
 Errors* CreateErrors() {
     /* Allocating the structure. */
-    Errors* errors = (Errors*)malloc(sizeof(Errors));
+    Errors* errors = (Errors*)TRACKED_MALLOC(sizeof(Errors), site_create_errors);
     if (errors == NULL) {
         perror("Failed to allocate memory.");
         exit(1);
     }
 
     /* Allocating data array. */
-    errors->list = (Error*)malloc(sizeof(Error)*ERR_STEP);
+    errors->list = (Error*)TRACKED_MALLOC(sizeof(Error)*ERR_CAPACITY, site_create_errors);
     if (errors->list == NULL) {
         perror("Failed to allocate memory.");
         exit(1);
     }
 
+    /* Allocating strings pool with empty string at offset 0. */
+    errors->strings = (char*)TRACKED_MALLOC(sizeof(char)*ERR_STRINGS_SIZE, site_create_errors);
+    if (errors->strings == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    errors->strings[0] = '\0';
+    errors->strings_size = 1;
+    errors->strings_capacity = ERR_STRINGS_SIZE;
+
     /* Creating source line reference. */
     errors->slr = CreateDynArr(32);
     AddDynArr(errors->slr, 0);
 
     /* Setting other fields. */
     errors->cur_line_num = 0;
+    errors->warnings = NULL;
     errors->count = 0;
-    errors->capacity = ERR_STEP;
+    errors->capacity = ERR_CAPACITY;
 
     return errors;
 }
@@ -72,15 +93,13 @@ void AddError(Errors* errors, int errCode, char* source, char* info) {
     info        -- Optional additional info (can be NULL).*/
 void AddErrorManual(Errors* errors, int lineNum, int errCode, char* source, char* info) {
     Error* new;  /* Pointer to new error structure. */
-    int spos = 0; /* Position in source line. */
-    int cpos = 0; /* Position in copied line. */
 
     /* Checking if array should be expanded. */
     if (errors->count == errors->capacity) {
         Error* res; /* Result of array reallocation. */
-        int new_cap = (errors->capacity) + ERR_STEP; /* New errors array capacity */
+        int new_cap = (errors->capacity)*2; /* New errors array capacity */
         /* Reallocating array. */
-        res = (Error*)realloc(errors->list, sizeof(Error)*new_cap);
+        res = (Error*)TRACKED_REALLOC(errors->list, sizeof(Error)*errors->capacity, sizeof(Error)*new_cap, site_add_error);
         if (res == NULL) {
             perror("Failed to allocate memory.");
             exit(1);
@@ -100,234 +119,270 @@ void AddErrorManual(Errors* errors, int lineNum, int errCode, char* source, char
     /* Setting line number. */
     new->source_line_num = lineNum;
 
-    if (source != NULL) {
-        /* Copying source line. 
-        Leading blank characters and new line characters are not copied.*/
-        while (source[spos] == ' ' || source[spos] == '\t' || source[spos] == '\n')
-            spos++;
-        while (source[spos] != '\0' && spos < MAX_STATEMENT_LEN+1) {
-            if (source[spos] != '\n')
-                new->source[cpos] = source[spos];
-            cpos++;
-            spos++;
+    /* Copying source line and additional info to strings pool. */
+    new->source = AddErrorString(errors, source, MAX_STATEMENT_LEN+1);
+    new->info = AddErrorString(errors, info, MAX_INFO_LEN);
+
+    /* Increasing errors count */
+    (errors->count)++;    
+}
+
+
+
+/* Adds text to strings pool of errors list.
+   Leading blank characters are skipped and new line characters are not copied.
+   Arguments:
+    errors      -- Errors list.
+    text        -- Text to add (can be NULL).
+    maxLen      -- Maximum number of characters of text that are read.
+   Returns:
+    Offset of copied text in strings pool.
+   Algorithm:
+    Pool is expanded twice when text may not fit. Empty text
+    is not copied, offset of empty string (0) is returned. */
+int AddErrorString(Errors* errors, char* text, int maxLen) {
+    int spos = 0;   /* Position in text. */
+    int offset;     /* Offset of copied text. */
+
+    if (text == NULL)
+        return 0;
+
+    /* Skipping leading blank characters. */
+    while (text[spos] == ' ' || text[spos] == '\t' || text[spos] == '\n')
+        spos++;
+    if (text[spos] == '\0' || spos >= maxLen)
+        return 0;
+
+    /* Expanding pool, text takes at most maxLen characters and termination. */
+    while (errors->strings_size + maxLen + 1 > errors->strings_capacity) {
+        char* res = (char*)TRACKED_REALLOC(errors->strings, sizeof(char)*errors->strings_capacity, sizeof(char)*errors->strings_capacity*2, site_add_error); /* Expanded pool. */
+        if (res == NULL) {
+            perror("Failed to allocate memory.");
+            exit(1);
         }
-        new->source[cpos] = '\0';
+        errors->strings = res;
+        errors->strings_capacity *= 2;
     }
-    else
-        new->source[0] = '\0';
-    if (info != NULL) {
-        /* Copying additional info.
-        Leading blank characters and new line characters are not copied.*/
-        spos = 0;
-        cpos = 0;
-        while (info[spos] == ' ' || info[spos] == '\t' || info[spos] == '\n')
-            spos++;
-        while (info[spos] != '\0' && spos < MAX_INFO_LEN) {
-            if (info[spos] != '\n')
-                new->info[cpos] = info[spos];
-            spos++;
-            cpos++;
+
+    /* Copying text without new line characters. */
+    offset = errors->strings_size;
+    while (text[spos] != '\0' && spos < maxLen) {
+        if (text[spos] != '\n') {
+            errors->strings[errors->strings_size] = text[spos];
+            (errors->strings_size)++;
         }
-        new->info[cpos] = '\0';
+        spos++;
     }
-    else
-        new->info[0] = '\0';
+    errors->strings[errors->strings_size] = '\0';
+    (errors->strings_size)++;
 
-    /* Increasing errors count */
-    (errors->count)++;    
+    return offset;
 }
 
 
-/* Prints individual error message to stdout.
+/* Writes message of individual error to text.
    Arguments:
-    er  -- Error to print.
+    errors  -- Errors list.
+    er      -- Error to write.
+    text    -- Buffer for message (at least MAX_ERROR_MSG_LEN characters).
+   Returns:
+    Length of message.
    Algorithm:
-    Uses switch to print error description 
+    Uses switch to write error description 
     according to error code. */
-void PrintError(Error* er) {
-    /* Printing line number. If line number is 0, or negative it will not be printed. */
+int FormatError(Errors* errors, Error* er, char* text) {
+    char* source = errors->strings + er->source; /* Error source. */
+    char* info = errors->strings + er->info;     /* Additional error info. */
+    int len = 0; /* Length of message. */
+
+    /* Writing line number. If line number is 0, or negative it will not be written. */
     if (er->source_line_num > 0)
-        printf(" Line %d: ", er->source_line_num);
-    /* Printing error source */
-    if (er->source[0] != '\0')
-        printf("\"%s\" <- ", er->source);
+        len += sprintf(text + len, " Line %d: ", er->source_line_num);
+    /* Writing error source */
+    if (source[0] != '\0')
+        len += sprintf(text + len, "\"%s\" <- ", source);
 
-    /* Printing error explanation */
+    /* Writing error explanation */
     switch (er->error_code)
     {
     case ErrMacro_NameNumber:
-        printf("Macro name can't begin with a number.");
+        len += sprintf(text + len, "Macro name can't begin with a number.");
         break;
 
     case ErrMacro_NameIllegal:
-        printf("Macro name can contain only letter and number characters.");
+        len += sprintf(text + len, "Macro name can contain only letter and number characters.");
         break;
 
     case ErrMacro_NameNotDefined:
-        printf("Macro name is not defined.");
+        len += sprintf(text + len, "Macro name is not defined.");
         break;
 
     case ErrMacro_NameReserved:
-        if (er->info != NULL)
-            printf("Illegal macro name, \"%s\" is a reserved word.", er->info);
+        if (info[0] != '\0')
+            len += sprintf(text + len, "Illegal macro name, \"%s\" is a reserved word.", info);
         else
-            printf("Macro name can't be a reserved word.");
+            len += sprintf(text + len, "Macro name can't be a reserved word.");
         break;
 
     case ErrMacro_NameIdentical:
-        if (er->info[0] != '\0')
-            printf("Macro name %s already defined.", er->info);
+        if (info[0] != '\0')
+            len += sprintf(text + len, "Macro name %s already defined.", info);
         else
-            printf("Macro name already defined.");
+            len += sprintf(text + len, "Macro name already defined.");
         break;
 
     case ErrMacro_ExtraDef:
-        printf("Extra text after macro definition.");
+        len += sprintf(text + len, "Extra text after macro definition.");
         break;
 
     case ErrMacro_ExtraDefEnd:
-        printf("Extra text after macro closing tag.");
+        len += sprintf(text + len, "Extra text after macro closing tag.");
         break;
 
     case ErrMacro_ExtraCall:
-        printf("Extra text after macro call.");
+        len += sprintf(text + len, "Extra text after macro call.");
         break;
 
     case ErrMacro_Nested:
-        printf("Nested macro definitions are forbidden.");
+        len += sprintf(text + len, "Nested macro definitions are forbidden.");
+        break;
+
+    case ErrMacro_Unclosed:
+        len += sprintf(text + len, "Macro definition is not closed, endm not found.");
         break;
 
     case ErrStm_Empty:
-        printf("Statement is empty.");
+        len += sprintf(text + len, "Statement is empty.");
         break;
 
     case ErrStm_NotRecognized:
-        if (er->info[0] != '\0')
-            printf("Unknown command \"%s\".", er->info);
+        if (info[0] != '\0')
+            len += sprintf(text + len, "Unknown command \"%s\".", info);
         else
-            printf("Unknown command.");
+            len += sprintf(text + len, "Unknown command.");
         break;
 
     case ErrCmm_Before:
-        printf("Illegal comma(s) before arguments. ");
+        len += sprintf(text + len, "Illegal comma(s) before arguments. ");
         break;
 
     case ErrCmm_Multiple:
-        printf("Multiple commas between arguments.");
+        len += sprintf(text + len, "Multiple commas between arguments.");
         break;
 
     case ErrCmm_Missing:
-        printf("Missing comma between arguments.");
+        len += sprintf(text + len, "Missing comma between arguments.");
         break;
 
     case ErrCmm_After:
-        printf("Illegal comma(s) after arguments.");
+        len += sprintf(text + len, "Illegal comma(s) after arguments.");
         break;
 
     case ErrArg_NotANumber:
-        printf("Number was expected.");
+        len += sprintf(text + len, "Number was expected.");
         break;
 
     case ErrArg_InvalidLabel:
-        printf("Invalid symbol as argument.");
+        len += sprintf(text + len, "Invalid symbol as argument.");
         break;
 
     case ErrArg_LongSymbol:
-        printf("Label is too long. Max label length is %d.", MAX_LABEL_LEN);
+        len += sprintf(text + len, "Label is too long. Max label length is %d.", MAX_LABEL_LEN);
         break;
 
     case ErrArg_MissingIndex:
-        printf("Index not specified.");
+        len += sprintf(text + len, "Index not specified.");
         break;    
 
     case ErrArg_MissingBracket:    
-        printf("Closing ] bracket is missing..");
+        len += sprintf(text + len, "Closing ] bracket is missing..");
         break;
 
     case ErrArg_InvalidIndex:
-        printf("Expected register name as indexer (r0-r15).");
+        len += sprintf(text + len, "Expected register name as indexer (r0-r15).");
         break;
 
     case ErrArg_Extra:
-        printf("Text after indexer not allowed.");
+        len += sprintf(text + len, "Text after indexer not allowed.");
         break;
 
     case ErrIns_MissingArg:
-        printf("Missing argument for instruction.");
+        len += sprintf(text + len, "Missing argument for instruction.");
         break;
 
     case ErrIns_ExtraArg:
-        printf("Too many arguments.");
+        len += sprintf(text + len, "Too many arguments.");
         break;
 
     case ErrIns_InvalidSrcAmode:
-        printf("Unsupported source adressing mode.");
+        len += sprintf(text + len, "Unsupported source adressing mode.");
         break;
     
     case ErrIns_InvalidDestAmode:
-        printf("Unsupported destination adressing mode.");
+        len += sprintf(text + len, "Unsupported destination adressing mode.");
         break;
 
     case ErrDt_StrNoArgument:
-        printf("No argument provided for .string directive.");
+        len += sprintf(text + len, "No argument provided for .string directive.");
         break;
 
     case ErrDt_StrInvalidArg:
-        printf("Expected \"string\" as argument.");
+        len += sprintf(text + len, "Expected \"string\" as argument.");
         break;
 
     case ErrDt_StrMissingClosing:
-        printf("Closing \" is missing in argument [ %s ].", er->info);
+        len += sprintf(text + len, "Closing \" is missing in argument [ %s ].", info);
         break;
 
     case ErrDt_StrExtra:
-        printf("Extra text after argument.");
+        len += sprintf(text + len, "Extra text after argument.");
         break;
 
     case ErrDt_DtNoArgument:
-        printf("Expected argument for .data directive.");
+        len += sprintf(text + len, "Expected argument for .data directive.");
         break;
 
     case ErrDt_DtInvalidArg:
-        if (er->info[0] != '\0')
-            printf("[%s] - Expected number argument", er->info);
+        if (info[0] != '\0')
+            len += sprintf(text + len, "[%s] - Expected number argument", info);
         else    
-            printf("Expected number argument.");
+            len += sprintf(text + len, "Expected number argument.");
         break;
 
     case ErrDir_NotRecognized:
-        printf("Directive not recognized.");
+        len += sprintf(text + len, "Directive not recognized.");
         break;
 
     case ErrDir_NoArgument:
-        printf("Expected label argument.");
+        len += sprintf(text + len, "Expected label argument.");
         break;
 
     case ErrSmb_TooLong:
-        printf("Label is too long. Maximum %d characters allowed.", MAX_LABEL_LEN);
+        len += sprintf(text + len, "Label is too long. Maximum %d characters allowed.", MAX_LABEL_LEN);
         break;
 
     case ErrSmb_NameIdentical:
-        printf("Label already defined.");
+        len += sprintf(text + len, "Label already defined.");
         break;
 
     case ErrSmb_EntryExtern:
-        printf("Label cannot be defined as .entry and .extern simultaniously.");
+        len += sprintf(text + len, "Label cannot be defined as .entry and .extern simultaniously.");
         break;
 
     case ErrSmb_NotFound:
-        printf("Failed to resolve symbol argument. Label not found");
+        len += sprintf(text + len, "Failed to resolve symbol argument. Label not found");
         break;
 
     case ErrSmb_EntryUndefined:
-        printf("Symbol marked as entry does not have definition.");
+        len += sprintf(text + len, "Symbol marked as entry does not have definition.");
         break;
 
     default:
         break;
     }
 
-    printf("\n");
+    text[len] = '\n';
+    return len + 1;
 }
 
 
@@ -335,76 +390,131 @@ void PrintError(Error* er) {
    If list is empty nothing will be printed.
    Assumes that errors is not NULL.
    Arguments:
-    errors  -- errors list. */
+    errors  -- errors list.
+   Algorithm:
+    Messages are collected in a buffer, which is written when
+    next message may not fit, so output is written in big blocks. */
 void PrintErrorsList(Errors* errors) {
+    char buffer[ERR_PRINT_BUFFER]; /* Text of messages. */
+    int len = 0; /* Length of text in buffer. */
     int i; /* Iterator */
+
     if (errors->count > 0)
-        printf("Found %d errors:\n", errors->count);
+        len += sprintf(buffer, "Found %d errors:\n", errors->count);
     for (i = 0; i < errors->count; i++) {
-        Error* er = &(errors->list[i]);
-        PrintError(er);
+        if (len + MAX_ERROR_MSG_LEN > ERR_PRINT_BUFFER) {
+            fwrite(buffer, 1, len, stdout);
+            len = 0;
+        }
+        len += FormatError(errors, &(errors->list[i]), buffer + len);
     }
-        
+    fwrite(buffer, 1, len, stdout);
 }
 
 
 
-/* Copies error structure values from original to copy.
-   Assumes that copy is allocated. */
-void CopyError(Error* original, Error* copy) {
-    int pos; /* Characters iterator for line copying. */
+/* Prints warning message to stdout, or keeps it in warnings of errors list
+   if they are kept (warnings of threads are printed later in order of lines).
+   Arguments:
+    errors      -- Errors list.
+    message     -- Message with new line character. */
+void AddWarning(Errors* errors, char* message) {
+    if (errors->warnings != NULL)
+        AddLine(errors->warnings, message);
+    else
+        fputs(message, stdout);
+}
+
+
+
+/* Adds errors and warnings of other errors list to errors list.
+   Warnings are printed if errors list doesn't keep them.
+   Arguments:
+    errors  -- Errors list.
+    other   -- Errors list to add (not changed). */
+void MergeErrors(Errors* errors, Errors* other) {
+    int i; /* Iterator. */
 
-    /* Copying code and line number. */
-    copy->error_code = original->error_code;
-    copy->source_line_num = original->source_line_num;
-    /* Copying source. */
-    pos = 0;
-    while (original->source[pos] != '\0') {
-        copy->source[pos] = original->source[pos];
-        pos++;
+    for (i = 0; i < other->count; i++) {
+        Error* er = &(other->list[i]); /* Error to add. */
+        AddErrorManual(errors, er->source_line_num, er->error_code,
+            other->strings + er->source, other->strings + er->info);
     }
-    copy->source[pos] = '\0';
-    /* Copying info. */
-    pos = 0;
-    while (original->info[pos] != '\0') {
-        copy->info[pos] = original->info[pos];
-        pos++;
+
+    if (other->warnings != NULL) {
+        for (i = 0; i < LinesCount(other->warnings); i++)
+            AddWarning(errors, GetLine(other->warnings, i));
     }
-    copy->info[pos] = '\0';
 }
 
 
+
 /* Sorts errors list by number of error source line.
-   Uses insertion sort algorithm.
+   Errors with the same line stay in order of adding.
    Arguments:
     errors  -- Errors list.
-    */
+   Algorithm:
+    Bottom-up merge sort of errors indexes, so only integers are moved
+    while sorting. In a merge error of the left run goes first when lines
+    are equal, which keeps sort stable. Then errors are placed to new array
+    by sorted indexes. If errors are already in order nothing is done. */
 void SortErrors(Errors* errors) {
+    int n = errors->count; /* Number of errors. */
+    int* order;  /* Indexes of errors, sorted runs. */
+    int* merged; /* Indexes of errors, result of merging runs. */
+    Error* sorted; /* Errors in sorted order. */
+    int width; /* Length of runs that are merged. */
     int i; /* Iterator. */
-    Error* key = (Error*)malloc(sizeof(Error)); /* Buffer for stroring currently sorted error structure. */
-        if (key == NULL) {
-            perror("Failed to allocate memory.");
-            exit(1);
-    }
-
-    if (errors->count <= 1) /* No need to sort. */
-        return; 
 
-    /* In insertion sort beginning of the list (everything before "key" element) considered sorted.
-       Initial sorted part is first element and initial key is the second. */
-    for (i = 1; i < errors->count; i++) {
-        int j = i-1; /* Back going iterator. */
-        /* Copying currently sorted element to buffer. */
-        CopyError(&(errors->list[i]), key);
+    /* Checking if errors are already sorted (common case). */
+    for (i = 1; i < n; i++) {
+        if (errors->list[i].source_line_num < errors->list[i-1].source_line_num)
+            break;
+    }
+    if (i >= n)
+        return;
 
-        /* Moving sorted values that are bigger than key one cell forward. */
-        while (key->source_line_num < (errors->list[j]).source_line_num && j>0) {
-            CopyError(&(errors->list[j]),&(errors->list[j+1]));
-            j--;
+    order = (int*)TRACKED_MALLOC(sizeof(int)*n, site_sort_errors);
+    merged = (int*)TRACKED_MALLOC(sizeof(int)*n, site_sort_errors);
+    sorted = (Error*)TRACKED_MALLOC(sizeof(Error)*n, site_sort_errors);
+    if (order == NULL || merged == NULL || sorted == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    for (i = 0; i < n; i++)
+        order[i] = i;
+
+    for (width = 1; width < n; width *= 2) {
+        int* swap; /* For swapping arrays. */
+        int lo;    /* Start of left run. */
+
+        for (lo = 0; lo < n; lo += 2*width) {
+            int mid = lo + width < n ? lo + width : n;     /* Start of right run. */
+            int hi = lo + 2*width < n ? lo + 2*width : n;  /* End of right run. */
+            int l = lo, r = mid; /* Positions in left and right runs. */
+
+            for (i = lo; i < hi; i++) {
+                if (r >= hi || (l < mid && errors->list[order[l]].source_line_num <= errors->list[order[r]].source_line_num))
+                    merged[i] = order[l++];
+                else
+                    merged[i] = order[r++];
+            }
         }
-        /* Placing key after first value that is smaller. */
-        CopyError(key, &(errors->list[j+1]));
+
+        swap = order;
+        order = merged;
+        merged = swap;
     }
+
+    /* Placing errors by sorted indexes. */
+    for (i = 0; i < n; i++)
+        sorted[i] = errors->list[order[i]];
+    TRACKED_FREE(errors->list, sizeof(Error)*errors->capacity);
+    errors->list = sorted;
+    errors->capacity = n;
+
+    TRACKED_FREE(order, sizeof(int)*n);
+    TRACKED_FREE(merged, sizeof(int)*n);
 }
 
 
@@ -414,10 +524,10 @@ void SortErrors(Errors* errors) {
    Arguments:
     errors  -- Errors list.*/
 void FreeErrors(Errors* errors) {
-    /* Freeing errors list. */
-    free(errors->list);
-    /* Freeing source line reference. */
-    FreeDynArr(errors->slr);
+    /* Freeing errors list and strings pool. */
+    TRACKED_FREE(errors->list, sizeof(Error)*errors->capacity);
+    TRACKED_FREE(errors->strings, sizeof(char)*errors->strings_capacity);
+    /* Source line reference is allocated in arena and released with it. */
     /* Removing errors structure. */
-    free(errors);
+    TRACKED_FREE(errors, sizeof(Errors));
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #ifndef ERRORS_H
     #define ERRORS_H
 
-#define ERR_STEP 32 /* Step of expansion of errors dynamic array. */
+#define ERR_CAPACITY 32 /* Initial capacity of errors dynamic array, it is doubled when full. */
 #define MAX_INFO_LEN 31 /* Maximum length of additional info of error (without termination). */
+#define ERR_STRINGS_SIZE 1024 /* Initial size of errors strings pool. */
+#define MAX_ERROR_MSG_LEN 512 /* Maximum length of printed error message (source, info and explanation). */
+#define ERR_PRINT_BUFFER 16384 /* Size of buffer for printing errors list. */
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -23,6 +26,7 @@ enum ErrorsEnum {
     ErrMacro_ExtraDefEnd,        /* Extra text after endm */
     ErrMacro_ExtraCall,          /* Extra text after macro name in macro call line*/
     ErrMacro_Nested,             /* Macro defined inside macro. */
+    ErrMacro_Unclosed,           /* End of file reached before endm. */
     /* Statement errors. */
     ErrStm_Empty,                /* Statement is empty line. */
     ErrStm_NotRecognized,        /* Statement not recognized. */
@@ -64,12 +68,13 @@ enum ErrorsEnum {
 };
 
 
-/* Structure that describes error in source file. */
+/* Structure that describes error in source file.
+   Texts of error are kept in strings pool of errors list. */
 typedef struct Error {
     int source_line_num;    /* Number of line in original (not expanded) source file where error is found. */
     int error_code;         /* Error code according to ErrorsEnum. */
-    char source[MAX_STATEMENT_LEN+2]; /* Error source - line or argument. */
-    char info[MAX_INFO_LEN+1];        /* Additional error info. */
+    int source;             /* Offset of error source (line or argument) in strings pool. */
+    int info;               /* Offset of additional error info in strings pool. */
 } Error;
 
 
@@ -81,14 +86,20 @@ typedef struct Error {
 typedef struct Errors {
     Error* list; /* Array that holds errors. */
     int count;   /* Number of elements in errors array. */
+    /* Strings pool. Null-terminated sources and infos of errors one after another.
+       Offset 0 is empty string used when source or info is not given. */
+    char* strings;
+    int strings_size;     /* Number of used characters in strings pool. */
+    int strings_capacity; /* Allocated size of strings pool. */
     /* Source line reference. Allows to find source file line number
        using number of line in expanded source file.
        Indexes correspond to original file line numbers and values correspond to
        expanded file line numbers. Element by index [0] is -1 because line
-       numbering starts with 1. */
+       numbering starts with 1. Allocated in current arena. */
     DynArr* slr;
     int cur_line_num; /* Current line number in expanded file. Will be used to get source_line_num for added errors. */
     int capacity; /* Current capacity of this dynamic array. */
+    Lines* warnings; /* Kept warning messages (allocated in current arena), NULL if warnings are printed at once. */
 } Errors;
 
 /* Changes error list current line for adding errors.
@@ -103,6 +114,13 @@ void ChangeErrCurLine(Errors* errors, int val);
     exLineNum   -- Number of line in expanded source file. */
 void AddLineReference(Errors* errors, int exLineNum);
 
+/* Expands source line reference of errors structure so that given number
+   of references can be added without expansion.
+   Arguments:
+    errors      -- List of errors.
+    count       -- Number of references that will be added. */
+void ReserveLineReferences(Errors* errors, int count);
+
 /* Creates new errors array structure. */
 Errors* CreateErrors();
 
@@ -126,17 +144,45 @@ void AddError(Errors* errors, int errCode, char* source, char* info);
     info        -- Optional additional info (can be NULL).*/
 void AddErrorManual(Errors* errors, int lineNum, int errCode, char* source, char* info);
 
+/* Adds text to strings pool of errors list.
+   Leading blank characters are skipped and new line characters are not copied.
+   Arguments:
+    errors      -- Errors list.
+    text        -- Text to add (can be NULL).
+    maxLen      -- Maximum number of characters of text that are read.
+   Returns:
+    Offset of copied text in strings pool. */
+int AddErrorString(Errors* errors, char* text, int maxLen);
+
+/* Prints warning message to stdout, or keeps it in warnings of errors list
+   if they are kept (warnings of threads are printed later in order of lines).
+   Arguments:
+    errors      -- Errors list.
+    message     -- Message with new line character. */
+void AddWarning(Errors* errors, char* message);
+
+/* Adds errors and warnings of other errors list to errors list.
+   Warnings are printed if errors list doesn't keep them.
+   Arguments:
+    errors  -- Errors list.
+    other   -- Errors list to add (not changed). */
+void MergeErrors(Errors* errors, Errors* other);
+
 /* Sorts errors list by number of error source line.
-   Uses insertion sort algorithm.
+   Errors with the same line stay in order of adding.
    Arguments:
     errors  -- Errors list.
     */
 void SortErrors(Errors* errors);
 
-/* Prints individual error message to stdout.
+/* Writes message of individual error to text.
    Arguments:
-    er  -- Error to print. */
-void PrintError(Error* er);
+    errors  -- Errors list.
+    er      -- Error to write.
+    text    -- Buffer for message (at least MAX_ERROR_MSG_LEN characters).
+   Returns:
+    Length of message. */
+int FormatError(Errors* errors, Error* er, char* text);
 
 /* Prints errors in list to stdout in order.
    If list is empty nothing will be printed.
@@ -0,0 +1,13 @@
+;In this file macro definition is not closed
+	;Correct macro
+	macro ok
+		inc r5
+	endm
+	ok
+	;Macro without endm, rest of file is its body
+	macro unclosed
+		add DATA[r1], r5
+		macro nested
+		endm
+	unclosed
+DATA: .data 100, 200
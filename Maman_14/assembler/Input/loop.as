@@ -0,0 +1,32 @@
+;file loop.as
+; Benchmark program for simulator - nested countdown loops.
+; Executes about 10 million instructions.
+
+MAIN:	mov	#2000, r1
+		clr	r3
+OUTER:	mov	#1000, r2
+INNER:	add	r2, r3
+		inc	COUNT
+		dec	r2
+		cmp	r2, #0
+		bne	INNER
+		jsr	STEP
+		dec	r1
+		cmp	r1, #0
+		bne	OUTER
+		prn	r3
+		prn	COUNT
+		prn	TOTAL
+		stop
+
+; Adds next table value to TOTAL, r4 goes around table indexes.
+STEP:	add	TABLE[r4], TOTAL
+		inc	r4
+		cmp	r4, #4
+		bne	DONE
+		clr	r4
+DONE:	rts
+
+TABLE:	.data	1, 2, 3, 4
+COUNT:	.data	0
+TOTAL:	.data	0
@@ -0,0 +1,7 @@
+;file ps_data.as
+; Defines external symbols of ps.as, so ps and ps_data can be linked.
+.entry W
+.entry vall
+
+W:		.data	0
+vall:	.data	-6
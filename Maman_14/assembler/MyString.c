@@ -78,23 +78,19 @@ int CompareStrings(char* s1, char* s2) {
     return 1;
 }
 
-/* Allocates copy of string s on heap.
+/* Allocates copy of string s in current arena.
    Arguments:
     s   -- String to copy.
    Returns:
-    Copy of string s allocated on heap. */
+    Copy of string s allocated in current arena. */
 char* CopyStringToHeap(char* s) {
     int pos = 0; /* Position in string. */
     int len; /* String length (without termination).*/
-    char* hs; /* String on heap. */
+    char* hs; /* String in arena. */
     len = StringLen(s);
 
     /* Allocating the string. */
-    hs = (char*)malloc(sizeof(char)*(len+1));
-    if (hs == NULL) {
-        perror("Failed to allocate memory");
-        exit(1);
-    }
+    hs = (char*)Allocate(sizeof(char)*(len+1));
 
     /* Copying the string. */
     while (s[pos] != '\0') {
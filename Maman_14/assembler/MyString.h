@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include "Arena.h"
 
 /* Returns length of null-terminated string s.
    Argumetns:
@@ -31,11 +32,11 @@ void ConcatenateStrings(char* s1, char* s2, char* result, int res_len);
     1   -- Strings are identical. */
 int CompareStrings(char* s1, char* s2);
 
-/* Allocates copy of string s on heap.
+/* Allocates copy of string s in current arena.
    Arguments:
     s   -- String to copy.
    Returns:
-    Copy of string s allocated on heap. */
+    Copy of string s allocated in current arena. */
 char* CopyStringToHeap(char* s);
 
 /* Append file extension to file name.
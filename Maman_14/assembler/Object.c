@@ -0,0 +1,539 @@
+#include "Object.h"
+
+/* Writes 32 bit number in little endian order.
+   Arguments:
+    bytes   -- Buffer for 4 bytes.
+    val     -- Number. */
+void PutUInt32(unsigned char* bytes, unsigned long val) {
+    bytes[0] = val & 255;
+    bytes[1] = (val >> 8) & 255;
+    bytes[2] = (val >> 16) & 255;
+    bytes[3] = (val >> 24) & 255;
+}
+
+/* Reads 32 bit little endian number.
+   Arguments:
+    bytes   -- 4 bytes of the number.
+   Returns:
+    Number. */
+unsigned long GetUInt32(unsigned char* bytes) {
+    return (unsigned long)bytes[0] | ((unsigned long)bytes[1] << 8) |
+           ((unsigned long)bytes[2] << 16) | ((unsigned long)bytes[3] << 24);
+}
+
+/* Returns size of binary object file in bytes.
+   Arguments:
+    num_words       -- Number of code and data words.
+    num_entries     -- Number of entries.
+    num_externs     -- Number of external references.
+    strings_size    -- Size of strings pool. */
+size_t ObjectFileSize(int num_words, int num_entries, int num_externs, int strings_size) {
+    size_t words_size = (size_t)num_words*OBJ_WORD_SIZE; /* Size of words in bytes. */
+
+    /* Padding words to multiple of 4. */
+    words_size = (words_size + 3) / 4 * 4;
+
+    return OBJ_HEADER_SIZE + words_size + (size_t)(num_entries + num_externs)*OBJ_RECORD_SIZE + strings_size;
+}
+
+/* Maps whole file to memory for reading.
+   Arguments:
+    fileName    -- Full name of the file.
+    size        -- Variable for returning size of the file in bytes.
+   Returns:
+    Content of the file (not null-terminated). Empty file is returned
+    as a pointer to empty string. NULL if file can't be opened, or mapped. */
+unsigned char* MapFile(char* fileName, size_t* size) {
+    static char empty[1] = ""; /* Content of empty files (empty files can't be mapped). */
+    int fd;           /* File descriptor. */
+    struct stat info; /* File info. */
+    void* map;        /* Mapped file. */
+
+    /* Opening the file. */
+    fd = open(fileName, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    *size = info.st_size;
+    if (*size == 0) {
+        close(fd);
+        return (unsigned char*)empty;
+    }
+
+    /* Mapping the file. Mapping stays valid after file is closed. */
+    map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    return map;
+}
+
+/* Unmaps file mapped by MapFile().
+   Arguments:
+    content -- Content of the file.
+    size    -- Size of the file. */
+void UnmapFile(unsigned char* content, size_t size) {
+    if (size > 0)
+        munmap(content, size);
+}
+
+/* Reads decimal number from mapped text.
+   Arguments:
+    text    -- Text.
+    pos     -- Position in text, advanced to character after the number.
+    size    -- Size of text.
+   Returns:
+    Number, or -1 if there is no number at position. */
+int ReadTextNumber(unsigned char* text, size_t* pos, size_t size) {
+    int num = 0; /* Resulting number. */
+    size_t start = *pos; /* Position of first digit. */
+
+    while (*pos < size && text[*pos] >= '0' && text[*pos] <= '9' && num < 100000000) {
+        num = num*10 + (text[*pos] - '0');
+        (*pos)++;
+    }
+
+    if (*pos == start)
+        return -1;
+    return num;
+}
+
+/* Value of lower case hex digit character, -1 if character is not a hex digit. */
+#define HEX_VALUE(c) ((c) >= '0' && (c) <= '9' ? (c) - '0' : ((c) >= 'a' && (c) <= 'f' ? (c) - 'a' + 10 : -1))
+
+/* Values of 16 characters starting from given one. */
+#define HEX_VALUES_ROW(c) \
+    HEX_VALUE(c), HEX_VALUE(c+1), HEX_VALUE(c+2), HEX_VALUE(c+3), \
+    HEX_VALUE(c+4), HEX_VALUE(c+5), HEX_VALUE(c+6), HEX_VALUE(c+7), \
+    HEX_VALUE(c+8), HEX_VALUE(c+9), HEX_VALUE(c+10), HEX_VALUE(c+11), \
+    HEX_VALUE(c+12), HEX_VALUE(c+13), HEX_VALUE(c+14), HEX_VALUE(c+15)
+
+/* Values of hex digits by character (reverse of hex_digits table of Output). */
+static const signed char hex_values[256] = {
+    HEX_VALUES_ROW(0), HEX_VALUES_ROW(16), HEX_VALUES_ROW(32), HEX_VALUES_ROW(48),
+    HEX_VALUES_ROW(64), HEX_VALUES_ROW(80), HEX_VALUES_ROW(96), HEX_VALUES_ROW(112),
+    HEX_VALUES_ROW(128), HEX_VALUES_ROW(144), HEX_VALUES_ROW(160), HEX_VALUES_ROW(176),
+    HEX_VALUES_ROW(192), HEX_VALUES_ROW(208), HEX_VALUES_ROW(224), HEX_VALUES_ROW(240)
+};
+
+/* Returns value of lower case hex digit, or -1 if character is not a hex digit. */
+int HexDigitValue(unsigned char c) {
+    return hex_values[c];
+}
+
+/* Reads words from text .ob file (format of WriteBinaryToObject()).
+   Arguments:
+    fileName    -- Full file name.
+    codeCount   -- Variable for returning number of code words.
+    dataCount   -- Variable for returning number of data words.
+   Returns:
+    Array of code and then data words allocated in current arena.
+    NULL if file can't be read, or it is not correct (message is printed).
+   Algorithm:
+    Header is two numbers - code and data words counts. Every next line is address
+    and word in "special" base A?-B?-C?-D?-E?. Addresses are checked to be consecutive
+    starting from PROGRAM_BASE. Word has fixed layout, so its 5 digits are taken from
+    known positions by table of hex digit values and all separators are checked at once. */
+int* ReadTextObject(char* fileName, int* codeCount, int* dataCount) {
+    unsigned char* text; /* Content of the file. */
+    size_t size;         /* Size of the file. */
+    size_t pos = 0;      /* Position in text. */
+    int* words;          /* Resulting words. */
+    int i;               /* Words iterator. */
+    int ok = 1;          /* Result. */
+
+    text = MapFile(fileName, &size);
+    if (text == NULL) {
+        printf("Failed to open object file [ %s ]\n", fileName);
+        return NULL;
+    }
+
+    /* Reading header. */
+    *codeCount = ReadTextNumber(text, &pos, size);
+    if (pos < size && text[pos] == ' ')
+        pos++;
+    *dataCount = ReadTextNumber(text, &pos, size);
+    if (*codeCount < 0 || *dataCount < 0) {
+        printf("Object file [ %s ] has incorrect header.\n", fileName);
+        UnmapFile(text, size);
+        return NULL;
+    }
+
+    words = (int*)Allocate(sizeof(int)*(*codeCount + *dataCount + 1));
+
+    /* Reading words. */
+    for (i = 0; ok && i < *codeCount + *dataCount; i++) {
+        int word = 0; /* Word value. */
+
+        /* Skipping new line and reading address. */
+        if (pos < size && text[pos] == '\n')
+            pos++;
+        if (ReadTextNumber(text, &pos, size) != PROGRAM_BASE + i || pos + 15 > size || text[pos] != ' ')
+            ok = 0;
+        pos++;
+
+        /* Reading 5 groups: letter, hex digit and '-' after every group except the last one. */
+        if (ok) {
+            unsigned char* g = text + pos; /* Groups. */
+            int a = hex_values[g[1]], b = hex_values[g[4]], c = hex_values[g[7]]; /* Digits of groups. */
+            int d = hex_values[g[10]], e = hex_values[g[13]];
+
+            if (g[0] != 'A' || g[2] != '-' || g[3] != 'B' || g[5] != '-' || g[6] != 'C' || g[8] != '-' ||
+                g[9] != 'D' || g[11] != '-' || g[12] != 'E' || (a | b | c | d | e) < 0)
+                ok = 0;
+            word = (a << 16) | (b << 12) | (c << 8) | (d << 4) | e;
+            pos += 14;
+        }
+
+        words[i] = word;
+    }
+
+    UnmapFile(text, size);
+
+    if (!ok) {
+        printf("Object file [ %s ] has incorrect word in line %d.\n", fileName, i+1);
+        return NULL;
+    }
+
+    return words;
+}
+
+/* Decodes data words of instruction argument.
+   Arguments:
+    words   -- Code words.
+    count   -- Number of code words.
+    index   -- Index of first data word of argument.
+    mode    -- Addressing mode, -1 if instruction has no such argument.
+    reg     -- Register field of second word.
+    arg     -- Structure for returning decoded argument.
+   Returns:
+    Index of word after argument data words, or -1 if words are missing. */
+int DecodeArgument(int* words, int count, int index, int mode, int reg, DecodedArg* arg) {
+    arg->mode = mode;
+    arg->reg = 0;
+    arg->value = 0;
+    arg->are = 0;
+    arg->pos = index;
+
+    /* Register is given in second word. */
+    if (mode == am_index || mode == am_rdirect)
+        arg->reg = reg;
+    if (mode == am_rdirect || mode == -1)
+        return index;
+
+    if (index + (mode == am_immediate ? 0 : 1) >= count)
+        return -1;
+
+    arg->are = words[index] >> 16;
+    if (mode == am_immediate) {
+        /* Value is 16 bit signed number. */
+        arg->value = ((words[index] & 0xffff) ^ 0x8000) - 0x8000;
+        return index + 1;
+    }
+
+    /* Direct and index modes have base and offset words. */
+    arg->value = (words[index] & 0xffff) + (words[index+1] & 0xffff);
+    return index + 2;
+}
+
+/* Opcode by low 16 bits of first word of instruction, -1 if word is not a first word. */
+static signed char opcode_by_word[65536];
+/* Bits (1 << InstructionsEnum) of instructions whose second word matches low 16 bits of word. */
+static unsigned short ins_by_second[65536];
+/* Bits of instructions by opcode. */
+static unsigned short ins_by_opcode[16];
+/* 1 if decoding tables are filled. */
+static int decode_tables_ready = 0;
+
+/* Fills lookup tables of DecodeInstruction() from instructions info.
+   Algorithm:
+    For every instruction first word is marked in opcodes table. For every allowed
+    pair of addressing modes all 256 values of register fields are added to second
+    word template and instruction bit is set for resulting word. */
+void InitDecodeTables(void) {
+    int code;   /* Instructions iterator. */
+    int src, dest; /* Addressing modes iterators. */
+    int regs;   /* Register fields iterator. */
+
+    memset(opcode_by_word, -1, sizeof(opcode_by_word));
+    memset(ins_by_second, 0, sizeof(ins_by_second));
+    memset(ins_by_opcode, 0, sizeof(ins_by_opcode));
+
+    for (code = ins_mov; code <= ins_stop; code++) {
+        const InsInfo* info = GetInstructionInfo(code); /* Info about instruction. */
+
+        opcode_by_word[info->first_word & 0xffff] = info->opcode;
+        ins_by_opcode[info->opcode] |= 1 << code;
+
+        for (src = 0; src < 4; src++) {
+            for (dest = 0; dest < 4; dest++) {
+                if (info->second_words[src][dest] == -1)
+                    continue;
+                /* Register fields are bits 8-11 and 2-5. */
+                for (regs = 0; regs < 256; regs++)
+                    ins_by_second[(info->second_words[src][dest] & 0xffff) | ((regs >> 4) << 8) | ((regs & 15) << 2)] |= 1 << code;
+            }
+        }
+    }
+
+    decode_tables_ready = 1;
+}
+
+/* Decodes instruction from code words.
+   Arguments:
+    words   -- Code words.
+    count   -- Number of code words.
+    index   -- Index of first word of instruction.
+    ins     -- Structure for returning decoded instruction.
+   Returns:
+    Number of words of instruction, 0 if words are not a correct instruction.
+   Algorithm:
+    First word has one bit set by opcode and ARE=Absolute, opcode is taken from
+    table indexed by low 16 bits of the word. Instructions with the same opcode
+    differ by funct in second word. Table indexed by low 16 bits of second word
+    gives instructions whose second word template (funct and legal addressing modes)
+    matches it, and opcode selects one of them. So instruction is found
+    by two table lookups without loops. */
+int DecodeInstruction(int* words, int count, int index, DecodedIns* ins) {
+    const InsInfo* info; /* Info about instruction. */
+    int opcode;      /* Opcode of instruction. */
+    int second;      /* Second word. */
+    int candidates;  /* Bits of matching instructions. */
+    int code = 0;    /* Instruction code. */
+    int pos;         /* Index of next word. */
+
+    if (!decode_tables_ready)
+        InitDecodeTables();
+
+    if (index >= count || (words[index] >> 16) != 4)
+        return 0;
+
+    /* Finding opcode. */
+    opcode = opcode_by_word[words[index] & 0xffff];
+    if (opcode == -1)
+        return 0;
+    candidates = ins_by_opcode[opcode];
+
+    ins->num_args = 0;
+    ins->length = 1;
+    DecodeArgument(words, count, index, -1, 0, &(ins->src));
+    DecodeArgument(words, count, index, -1, 0, &(ins->dest));
+
+    /* Instructions without arguments are identified by opcode. */
+    while (!((candidates >> code) & 1))
+        code++;
+    info = GetInstructionInfo(code);
+    ins->ins = code;
+    if (info->amodes_dest == 0)
+        return 1;
+
+    /* Finding instruction by second word. */
+    if (index + 1 >= count || (words[index+1] >> 16) != 4)
+        return 0;
+    second = words[index+1];
+    candidates &= ins_by_second[second & 0xffff];
+    if (candidates == 0)
+        return 0;
+    for (code = 0; !((candidates >> code) & 1); code++)
+        ;
+    info = GetInstructionInfo(code);
+    ins->ins = code;
+
+    /* Decoding arguments. */
+    pos = index + 2;
+    if (info->amodes_source != 0) {
+        ins->num_args = 2;
+        pos = DecodeArgument(words, count, pos, (second >> 6) & 3, (second >> 8) & 15, &(ins->src));
+    }
+    else
+        ins->num_args = 1;
+    if (pos != -1)
+        pos = DecodeArgument(words, count, pos, second & 3, (second >> 2) & 15, &(ins->dest));
+    if (pos == -1)
+        return 0;
+
+    ins->length = pos - index;
+    return ins->length;
+}
+
+/* Maps binary object file to memory and checks its layout.
+   Arguments:
+    fileName    -- Full name of the file.
+   Returns:
+    Object file structure allocated in current arena.
+    NULL if file can't be read, or it is not a correct binary object file
+    (message is printed).
+   Algorithm:
+    File is mapped read only. Header numbers are read and size of the file
+    is compared with size calculated from them. Then pointers to tables are set
+    and names in tables are checked to be inside strings pool. */
+ObjectFile* OpenObjectFile(char* fileName) {
+    ObjectFile* obj;  /* Resulting structure. */
+    unsigned char* map; /* Mapped file. */
+    size_t size;      /* Size of the file. */
+    int i;            /* Tables iterator. */
+
+    /* Mapping the file. */
+    map = MapFile(fileName, &size);
+    if (map == NULL) {
+        printf("Failed to open object file [ %s ]\n", fileName);
+        return NULL;
+    }
+    if (size < OBJ_HEADER_SIZE) {
+        printf("Object file [ %s ] is not a binary object file.\n", fileName);
+        UnmapFile(map, size);
+        return NULL;
+    }
+
+    obj = (ObjectFile*)Allocate(sizeof(ObjectFile));
+    obj->file = map;
+    obj->size = size;
+
+    /* Reading header. */
+    obj->code_base = GetUInt32(obj->file + 4);
+    obj->code_count = GetUInt32(obj->file + 8);
+    obj->data_base = GetUInt32(obj->file + 12);
+    obj->data_count = GetUInt32(obj->file + 16);
+    obj->num_entries = GetUInt32(obj->file + 20);
+    obj->num_externs = GetUInt32(obj->file + 24);
+    obj->strings_size = GetUInt32(obj->file + 28);
+
+    /* Checking magic and size. */
+    if (memcmp(obj->file, OBJ_MAGIC, 4) != 0 ||
+        obj->code_count < 0 || obj->data_count < 0 || obj->num_entries < 0 ||
+        obj->num_externs < 0 || obj->strings_size < 0 ||
+        obj->code_count > (int)obj->size || obj->data_count > (int)obj->size ||
+        obj->num_entries > (int)obj->size || obj->num_externs > (int)obj->size ||
+        ObjectFileSize(obj->code_count + obj->data_count, obj->num_entries,
+                       obj->num_externs, obj->strings_size) != obj->size) {
+        printf("Object file [ %s ] is not a binary object file.\n", fileName);
+        CloseObjectFile(obj);
+        return NULL;
+    }
+
+    /* Setting tables. */
+    obj->words = obj->file + OBJ_HEADER_SIZE;
+    obj->entries = obj->file + ObjectFileSize(obj->code_count + obj->data_count, 0, 0, 0);
+    obj->externs = obj->entries + obj->num_entries*OBJ_RECORD_SIZE;
+    obj->strings = (char*)(obj->externs + obj->num_externs*OBJ_RECORD_SIZE);
+
+    /* Checking that every name is inside strings pool and is terminated. */
+    if (obj->strings_size > 0 && obj->strings[obj->strings_size-1] != '\0') {
+        printf("Object file [ %s ] is not a binary object file.\n", fileName);
+        CloseObjectFile(obj);
+        return NULL;
+    }
+    for (i = 0; i < obj->num_entries + obj->num_externs; i++) {
+        if (GetUInt32(obj->entries + i*OBJ_RECORD_SIZE) >= (unsigned long)obj->strings_size) {
+            printf("Object file [ %s ] is not a binary object file.\n", fileName);
+            CloseObjectFile(obj);
+            return NULL;
+        }
+    }
+
+    return obj;
+}
+
+/* Unmaps binary object file opened by OpenObjectFile().
+   Arguments:
+    obj     -- Object file. */
+void CloseObjectFile(ObjectFile* obj) {
+    UnmapFile(obj->file, obj->size);
+    obj->file = NULL;
+}
+
+/* Returns word of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of the word. Code words go first, then data words.
+   Returns:
+    20 bit word. */
+int GetObjectWord(ObjectFile* obj, int index) {
+    unsigned char* word = obj->words + index*OBJ_WORD_SIZE; /* Bytes of the word. */
+
+    return word[0] | (word[1] << 8) | (word[2] << 16);
+}
+
+/* Returns entry of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of entry.
+    address -- Variable for returning entry address.
+   Returns:
+    Entry name (points into the file). */
+char* GetObjectEntry(ObjectFile* obj, int index, int* address) {
+    unsigned char* record = obj->entries + index*OBJ_RECORD_SIZE; /* Entry record. */
+
+    *address = GetUInt32(record + 4);
+    return obj->strings + GetUInt32(record);
+}
+
+/* Returns external reference of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of reference.
+    address -- Variable for returning address of reference base word.
+   Returns:
+    Name of external symbol (points into the file). */
+char* GetObjectExtern(ObjectFile* obj, int index, int* address) {
+    unsigned char* record = obj->externs + index*OBJ_RECORD_SIZE; /* Reference record. */
+
+    *address = GetUInt32(record + 4);
+    return obj->strings + GetUInt32(record);
+}
+
+/* Reads code and data words of program.
+   Arguments:
+    name        -- Name of object file without extension.
+    binary      -- 1 if program is read from binary .obj file, 0 for text .ob file.
+    codeCount   -- Variable for returning number of code words.
+    dataCount   -- Variable for returning number of data words.
+   Returns:
+    Array of code and then data words allocated in current arena.
+    NULL if program can't be read, or binary file has references
+    to external symbols (message is printed).
+   Algorithm:
+    Text .ob file is read by ReadTextObject(). Binary .obj file is mapped,
+    its addresses and references are checked and words are copied. */
+int* ReadProgram(char* name, int binary, int* codeCount, int* dataCount) {
+    int len = StringLen(name); /* Length of name. */
+    char* fullName = (char*)Allocate(sizeof(char)*(len+5)); /* Name with extension. */
+    ObjectFile* obj; /* Binary object file. */
+    int* words;      /* Resulting words. */
+    int i;           /* Words iterator. */
+
+    if (!binary) {
+        AppendExtension(name, "ob", fullName, len+4);
+        return ReadTextObject(fullName, codeCount, dataCount);
+    }
+
+    AppendExtension(name, "obj", fullName, len+4);
+    obj = OpenObjectFile(fullName);
+    if (obj == NULL)
+        return NULL;
+
+    if (obj->num_externs != 0) {
+        printf("Object file [ %s ] has references to external symbols, link it first.\n", fullName);
+        CloseObjectFile(obj);
+        return NULL;
+    }
+    if (obj->code_base != PROGRAM_BASE || obj->data_base != PROGRAM_BASE + obj->code_count) {
+        printf("Object file [ %s ] has incorrect addresses.\n", fullName);
+        CloseObjectFile(obj);
+        return NULL;
+    }
+
+    *codeCount = obj->code_count;
+    *dataCount = obj->data_count;
+    words = (int*)Allocate(sizeof(int)*(*codeCount + *dataCount + 1));
+    for (i = 0; i < *codeCount + *dataCount; i++)
+        words[i] = GetObjectWord(obj, i);
+
+    CloseObjectFile(obj);
+    return words;
+}
@@ -0,0 +1,227 @@
+#ifndef OBJECT_H
+    #define OBJECT_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MyString.h"
+#include "Definitions.h"
+#include "DataContainers.h"
+
+/* Binary object file (.obj) layout.
+   All numbers are 32 bit unsigned little endian integers.
+    Header:
+     0  -- Magic "AOB1".
+     4  -- Code base address.
+     8  -- Number of code words.
+     12 -- Data base address.
+     16 -- Number of data words.
+     20 -- Number of entries.
+     24 -- Number of external references.
+     28 -- Size of strings pool in bytes.
+    Words:
+     32 -- Code words and then data words, 3 bytes (little endian) for every 20 bit word.
+           Padded with zeros to multiple of 4 bytes.
+    Entries table:
+     Record of 8 bytes for every entry - offset of name in strings pool and address.
+    Externals table:
+     Record of 8 bytes for every reference to external symbol - offset of name in
+     strings pool and address of base word of the reference (offset word follows it).
+    Strings pool:
+     Null-terminated symbol names. */
+
+/* Magic characters in the beginning of binary object file. */
+#define OBJ_MAGIC "AOB1"
+/* Size of binary object file header in bytes. */
+#define OBJ_HEADER_SIZE 32
+/* Size of one machine word in binary object file in bytes. */
+#define OBJ_WORD_SIZE 3
+/* Size of entry and external tables records in bytes. */
+#define OBJ_RECORD_SIZE 8
+
+/* Address of first code word in object files. */
+#define PROGRAM_BASE 100
+/* Number of memory words of the machine (addresses are 16 bit). */
+#define MEMORY_SIZE 65536
+/* Number of registers of the machine. */
+#define NUM_REGISTERS 16
+/* Maximum depth of subroutine calls (jsr) in simulated and translated programs. */
+#define CALL_STACK_SIZE 4096
+
+/* Decoded instruction argument. */
+typedef struct DecodedArg {
+    int mode;       /* Addressing mode according to AdressingModesEnum. */
+    int reg;        /* Register number in index and register direct modes. */
+    int value;      /* Value in immediate mode (16 bit signed), or
+                       address (base+offset) in direct and index modes. */
+    int are;        /* ARE of data words (4 absolute, 2 relocatable, 1 external). 0 if no data words. */
+    int pos;        /* Index of first data word of argument. */
+} DecodedArg;
+
+/* Instruction decoded from code words. */
+typedef struct DecodedIns {
+    int ins;        /* Instruction according to InstructionsEnum. */
+    int num_args;   /* Number of arguments (0, 1 - destination only, or 2). */
+    int length;     /* Number of words of instruction. */
+    DecodedArg src; /* Source argument. */
+    DecodedArg dest; /* Destination argument. */
+} DecodedIns;
+
+/* Binary object file mapped to memory.
+   Tables point into the mapped file, nothing is copied. */
+typedef struct ObjectFile {
+    unsigned char* file;      /* Mapped content of the file. */
+    size_t size;              /* Size of the file in bytes. */
+    int code_base;            /* Address of first code word. */
+    int code_count;           /* Number of code words. */
+    int data_base;            /* Address of first data word. */
+    int data_count;           /* Number of data words. */
+    int num_entries;          /* Number of entries. */
+    int num_externs;          /* Number of external references. */
+    int strings_size;         /* Size of strings pool. */
+    unsigned char* words;     /* Code and data words. */
+    unsigned char* entries;   /* Entries table. */
+    unsigned char* externs;   /* Externals table. */
+    char* strings;            /* Strings pool. */
+} ObjectFile;
+
+/* Writes 32 bit number in little endian order.
+   Arguments:
+    bytes   -- Buffer for 4 bytes.
+    val     -- Number. */
+void PutUInt32(unsigned char* bytes, unsigned long val);
+
+/* Reads 32 bit little endian number.
+   Arguments:
+    bytes   -- 4 bytes of the number.
+   Returns:
+    Number. */
+unsigned long GetUInt32(unsigned char* bytes);
+
+/* Returns size of binary object file in bytes.
+   Arguments:
+    num_words       -- Number of code and data words.
+    num_entries     -- Number of entries.
+    num_externs     -- Number of external references.
+    strings_size    -- Size of strings pool. */
+size_t ObjectFileSize(int num_words, int num_entries, int num_externs, int strings_size);
+
+/* Maps whole file to memory for reading.
+   Arguments:
+    fileName    -- Full name of the file.
+    size        -- Variable for returning size of the file in bytes.
+   Returns:
+    Content of the file (not null-terminated). Empty file is returned
+    as a pointer to empty string. NULL if file can't be opened, or mapped. */
+unsigned char* MapFile(char* fileName, size_t* size);
+
+/* Unmaps file mapped by MapFile().
+   Arguments:
+    content -- Content of the file.
+    size    -- Size of the file. */
+void UnmapFile(unsigned char* content, size_t size);
+
+/* Reads decimal number from mapped text.
+   Arguments:
+    text    -- Text.
+    pos     -- Position in text, advanced to character after the number.
+    size    -- Size of text.
+   Returns:
+    Number, or -1 if there is no number at position. */
+int ReadTextNumber(unsigned char* text, size_t* pos, size_t size);
+
+/* Returns value of lower case hex digit, or -1 if character is not a hex digit. */
+int HexDigitValue(unsigned char c);
+
+/* Reads words from text .ob file (format of WriteBinaryToObject()).
+   Arguments:
+    fileName    -- Full file name.
+    codeCount   -- Variable for returning number of code words.
+    dataCount   -- Variable for returning number of data words.
+   Returns:
+    Array of code and then data words allocated in current arena.
+    NULL if file can't be read, or it is not correct (message is printed). */
+int* ReadTextObject(char* fileName, int* codeCount, int* dataCount);
+
+/* Decodes data words of instruction argument.
+   Arguments:
+    words   -- Code words.
+    count   -- Number of code words.
+    index   -- Index of first data word of argument.
+    mode    -- Addressing mode, -1 if instruction has no such argument.
+    reg     -- Register field of second word.
+    arg     -- Structure for returning decoded argument.
+   Returns:
+    Index of word after argument data words, or -1 if words are missing. */
+int DecodeArgument(int* words, int count, int index, int mode, int reg, DecodedArg* arg);
+
+/* Fills lookup tables of DecodeInstruction() from instructions info.
+   Called by DecodeInstruction() when it is used first time. */
+void InitDecodeTables(void);
+
+/* Decodes instruction from code words.
+   Arguments:
+    words   -- Code words.
+    count   -- Number of code words.
+    index   -- Index of first word of instruction.
+    ins     -- Structure for returning decoded instruction.
+   Returns:
+    Number of words of instruction, 0 if words are not a correct instruction. */
+int DecodeInstruction(int* words, int count, int index, DecodedIns* ins);
+
+/* Maps binary object file to memory and checks its layout.
+   Arguments:
+    fileName    -- Full name of the file.
+   Returns:
+    Object file structure allocated in current arena.
+    NULL if file can't be read, or it is not a correct binary object file
+    (message is printed). */
+ObjectFile* OpenObjectFile(char* fileName);
+
+/* Unmaps binary object file opened by OpenObjectFile().
+   Arguments:
+    obj     -- Object file. */
+void CloseObjectFile(ObjectFile* obj);
+
+/* Returns word of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of the word. Code words go first, then data words.
+   Returns:
+    20 bit word. */
+int GetObjectWord(ObjectFile* obj, int index);
+
+/* Returns entry of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of entry.
+    address -- Variable for returning entry address.
+   Returns:
+    Entry name (points into the file). */
+char* GetObjectEntry(ObjectFile* obj, int index, int* address);
+
+/* Returns external reference of binary object file.
+   Arguments:
+    obj     -- Object file.
+    index   -- Index of reference.
+    address -- Variable for returning address of reference base word.
+   Returns:
+    Name of external symbol (points into the file). */
+char* GetObjectExtern(ObjectFile* obj, int index, int* address);
+
+/* Reads code and data words of program.
+   Arguments:
+    name        -- Name of object file without extension.
+    binary      -- 1 if program is read from binary .obj file, 0 for text .ob file.
+    codeCount   -- Variable for returning number of code words.
+    dataCount   -- Variable for returning number of data words.
+   Returns:
+    Array of code and then data words allocated in current arena.
+    NULL if program can't be read, or binary file has references
+    to external symbols (message is printed). */
+int* ReadProgram(char* name, int binary, int* codeCount, int* dataCount);
+
+#endif
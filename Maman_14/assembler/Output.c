@@ -1,24 +1,173 @@
 #include "Output.h"
 
-/* Converts integer values from 0-15 range to 
-   corresponding hex digit as character.
+/* Row of hex digits pairs with first digit h (h0, h1, ... hf). */
+#define HEX_ROW(h) \
+    {h,'0'}, {h,'1'}, {h,'2'}, {h,'3'}, {h,'4'}, {h,'5'}, {h,'6'}, {h,'7'}, \
+    {h,'8'}, {h,'9'}, {h,'a'}, {h,'b'}, {h,'c'}, {h,'d'}, {h,'e'}, {h,'f'}
+
+/* Two hex digits of every byte value (lower case). */
+static const char hex_digits[256][2] = {
+    HEX_ROW('0'), HEX_ROW('1'), HEX_ROW('2'), HEX_ROW('3'),
+    HEX_ROW('4'), HEX_ROW('5'), HEX_ROW('6'), HEX_ROW('7'),
+    HEX_ROW('8'), HEX_ROW('9'), HEX_ROW('a'), HEX_ROW('b'),
+    HEX_ROW('c'), HEX_ROW('d'), HEX_ROW('e'), HEX_ROW('f')
+};
+
+/* Initializes output buffer allocated in current arena.
    Arguments:
-    val     -- Integer value.
-   Returns:
-    Character that represents hex digit corresponding to that value.
-    If val is out of range 0-15 ' ' (blank) is returned. */
-char IntToHexDigit(int val) {
-    if (val < 16 && val >= 0) {
-        /* If value can be represented by decimal digit. */
-        if (val < 10)
-            return val+48; /* ASCII number of corresponding decimal digit character. */
-        else
-            /* If value should be represented by hex digit. */
-            return val-10+97; /* ASCII number of corresponding letter character. */
+    buf         -- Output buffer.
+    capacity    -- Expected length of the text. */
+void InitOutputBuffer(OutputBuffer* buf, int capacity) {
+    if (capacity < 64)
+        capacity = 64;
+    buf->text = (char*)Allocate(sizeof(char)*capacity);
+    buf->length = 0;
+    buf->capacity = capacity;
+}
+
+/* Makes sure that len more characters fit in output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    len     -- Number of characters that will be added.
+   Algorithm:
+    Capacity is doubled until text fits. */
+void ReserveOutput(OutputBuffer* buf, int len) {
+    int capacity = buf->capacity; /* New capacity. */
+
+    /* Checking if there is enough space. */
+    if (buf->length + len <= capacity)
+        return;
+
+    while (buf->length + len > capacity)
+        capacity *= 2;
+    buf->text = (char*)Reallocate(buf->text, sizeof(char)*buf->capacity, sizeof(char)*capacity);
+    buf->capacity = capacity;
+}
+
+/* Adds characters to output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    s       -- Characters to add.
+    len     -- Number of characters. */
+void AppendText(OutputBuffer* buf, char* s, int len) {
+    ReserveOutput(buf, len);
+    memcpy(buf->text + buf->length, s, len);
+    buf->length += len;
+}
+
+/* Adds decimal representation of a number to output buffer.
+   Same as printf "%0*d" format with width minDigits.
+   Arguments:
+    buf         -- Output buffer.
+    num         -- Number.
+    minDigits   -- Minimal number of digits, number padded with leading zeros. */
+void AppendNumber(OutputBuffer* buf, int num, int minDigits) {
+    char digits[12]; /* Digits of the number in reverse order. */
+    int len = 0;     /* Number of digits. */
+    unsigned int n;  /* Absolute value of the number. */
+
+    ReserveOutput(buf, 12 + minDigits);
+
+    /* Writing sign. */
+    if (num < 0) {
+        buf->text[buf->length++] = '-';
+        n = -(unsigned int)num;
+        minDigits--;
     }
     else
-        /* Value out of range. */
-        return ' ';
+        n = num;
+
+    /* Getting digits from last to first. */
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n != 0);
+
+    /* Writing padding zeros. */
+    while (minDigits-- > len)
+        buf->text[buf->length++] = '0';
+    /* Writing digits. */
+    while (len > 0)
+        buf->text[buf->length++] = digits[--len];
+}
+
+/* Writes output buffer to resulting file with single write.
+   Arguments:
+    fileName    -- Source file name without extension.
+    ext         -- Extension of resulting file.
+    buf         -- Text of the file. */
+void WriteOutputFile(char* fileName, char* ext, OutputBuffer* buf) {
+    FILE* file;      /* Handler of resulting file. */
+    char* fullFname; /* Name of the file with extension. */
+
+    /* Opening the file. */
+    file = OpenOutputFile(fileName, ext, &fullFname);
+    /* Text is already collected, so file buffer would only add a copy. */
+    setvbuf(file, NULL, _IONBF, 0);
+
+    /* Writing the text. */
+    if (buf->length > 0 && fwrite(buf->text, sizeof(char), buf->length, file) != (size_t)buf->length) {
+        perror("Failed to write file.\n");
+        exit(2);
+    }
+
+    /* Closing the file. */
+    CloseOutputFile(file, fullFname);
+}
+
+/* Opens resulting file for writing.
+   File is written under temporary name (full name with ".tmp" added)
+   and gets its full name only when it is closed by CloseOutputFile(),
+   so partially written file never appears under resulting file name.
+   Arguments:
+    fileName    -- Source file name without extension.
+    ext         -- Extension of resulting file.
+    fullName    -- Variable for returning full name of resulting file (allocated in current arena).
+   Returns:
+    Handler of temporary file. Exits program if file can't be opened. */
+FILE* OpenOutputFile(char* fileName, char* ext, char** fullName) {
+    FILE* file;      /* Handler of temporary file. */
+    char* tmpName;   /* Name of temporary file. */
+    int fullNameLen; /* Length of the full file name (not counting termination character). */
+
+    /* Getting full file name. */
+    fullNameLen = StringLen(fileName) + StringLen(ext) + 1;
+    *fullName = (char*)Allocate(sizeof(char)*(fullNameLen+1));
+    AppendExtension(fileName, ext, *fullName, fullNameLen);
+
+    /* Getting temporary file name. */
+    tmpName = (char*)Allocate(sizeof(char)*(fullNameLen+5));
+    AppendExtension(*fullName, "tmp", tmpName, fullNameLen+4);
+
+    /* Opening temporary file for writing. */
+    file = fopen(tmpName, "w");
+    /* Check. */
+    if (file == NULL) { 
+        perror("Failed to open file.\n"); 
+        exit(2); 
+    }
+
+    return file;
+}
+
+/* Closes file opened by OpenOutputFile() and
+   renames temporary file to resulting file name.
+   Arguments:
+    file        -- Handler of temporary file.
+    fullName    -- Full name of resulting file returned by OpenOutputFile(). */
+void CloseOutputFile(FILE* file, char* fullName) {
+    char* tmpName;   /* Name of temporary file. */
+    int fullNameLen = StringLen(fullName); /* Length of the full file name. */
+
+    /* Getting temporary file name. */
+    tmpName = (char*)Allocate(sizeof(char)*(fullNameLen+5));
+    AppendExtension(fullName, "tmp", tmpName, fullNameLen+4);
+
+    /* Closing and renaming the file. */
+    if (fclose(file) != 0 || rename(tmpName, fullName) != 0) {
+        perror("Failed to write file.\n");
+        exit(2);
+    }
 }
 
 /* Converts 20 bit binary word to text representation
@@ -27,31 +176,59 @@ char IntToHexDigit(int val) {
    expected and will be ignored.
    Arguments:
     val     -- 20 bit binary value.
-    word    -- Buffer for writing string representation of val in "special" base. */
+    word    -- Buffer for writing string representation of val in "special" base.
+   Algorithm:
+    Word is written as A?-B?-C?-D?-E? where ? are hex digits of 4 bit groups
+    from most significant to least significant. Digits of groups B-C and D-E
+    are taken by bytes from hex digits table. */
 void BinaryToSpecial(int val, char word[15]) {
-    int i; /* Iterator. */
-    int mask = 15; /* Mask that used to get first 4 bits of a binary number 15 = 0000 0000 0000 1111 */
-    char gname = 'A'; /* Name of a 4 bit group in "special" base. */
-    char gval; /* Hex digit value character of 4 bit group in "special" base. */
-    /* Iterating trough 5 4 bit groups A B C D E */
-    for (i = 0; i<5; i++, gname++) {
-        /* Getting 4 bit group value. */
-        /* Example: 
-           if val = 1010 1101 0010 0100, i = 2.
-           val >> (4-i)*4 = 0000 0000 1010 1101
-           (val >> (4-i)*4) & mask = 0000 0000 0000 1101 = 13 = 'd'
-        */
-        gval = IntToHexDigit((val >> ((4-i)*4)) & mask);
-
-        /*Writing group to result buffer. */
-        word[i*3] = gname;
-        word[(i*3)+1] = gval;
-        word[(i*3)+2] = '-';
-    }
+    const char* hex; /* Hex digits of a byte. */
+
+    word[0] = 'A';
+    word[1] = hex_digits[(val >> 16) & 15][1];
+    word[2] = '-';
+    hex = hex_digits[(val >> 8) & 255];
+    word[3] = 'B';
+    word[4] = hex[0];
+    word[5] = '-';
+    word[6] = 'C';
+    word[7] = hex[1];
+    word[8] = '-';
+    hex = hex_digits[val & 255];
+    word[9] = 'D';
+    word[10] = hex[0];
+    word[11] = '-';
+    word[12] = 'E';
+    word[13] = hex[1];
     /* Adding termination character. */
     word[14] = '\0';
 }
 
+/* Adds lines of binary segment words to object file text.
+   Line is address (4 digits at least) and word in "special" base.
+   Arguments:
+    buf     -- Object file text.
+    segment -- Binary segment.
+    last    -- 1 if segment is the last in the file (no new line after last word). */
+void AppendSegment(OutputBuffer* buf, BinarySegment* segment, int last) {
+    int i; /* Iterator. */
+
+    for (i = 0; i < segment->counter; i++) {
+        /* Reserving space for the longest line. */
+        ReserveOutput(buf, 32);
+        /* Writing word address. */
+        AppendNumber(buf, segment->base + i, 4);
+        buf->text[buf->length++] = ' ';
+        /* Writing word in "special" base. */
+        BinaryToSpecial(segment->words[i], buf->text + buf->length);
+        buf->length += 14;
+
+        /* Writing new line character if word is not last in the file. */
+        if (i != segment->counter - 1 || !last)
+            buf->text[buf->length++] = '\n';
+    }
+}
+
 /* Creates and fills .ob object file.
    Writes code and binary segments in "special" base to .ob file.
    Assumes that binary segment arguments are correct.
@@ -61,83 +238,154 @@ void BinaryToSpecial(int val, char word[15]) {
     data        -- Data binary segment.
 */
 void WriteBinaryToObject(char* fileName, BinarySegment* code, BinarySegment* data) {
-    FILE* object;    /* Handler of object file. */
-    char* fullFname; /* Name of the file with extension. */
-    int fullNameLen; /* Length of the full file name (not counting termination character). */
-    int i; /* Iterator. */
+    OutputBuffer buf; /* Text of object file. */
 
-    /* Opening the file. */
-    fullNameLen = StringLen(fileName) + 3;
-    fullFname = (char*)malloc(sizeof(char)*(fullNameLen+1));
-    if (fullFname == NULL) { 
-        perror("Failed to allocate memory.\n"); 
-        exit(1); }
-    /* Getting full file name. */
-    AppendExtension(fileName, "ob", fullFname, fullNameLen);
-    object = fopen(fullFname, "w"); /* Opening object file for writing */
-    /* Check. */
-    if (object == NULL) { 
-        perror("Failed to open file.\n"); 
-        exit(2); 
-    }
-    /* Freeing file name string. */
-    free(fullFname);
+    /* Every line takes 20 characters when addresses are up to 4 digits. */
+    InitOutputBuffer(&buf, 24 + (code->counter + data->counter)*20);
 
     /* Writing object file header. */
-    fprintf(object, "%d %d\n", code->counter, data->counter);
-
-    /* Writing binary words of the code segment. */
-    for (i = 0; i < code->counter; i++) {
-        int adr;    /* Word address in code segment. */
-        int word_val; /* Value of the word. */
-        char word_sp[15]; /* Word value in "special" base. */
-
-        /* Setting address. */
-        adr = code->base+i;
-        /* Getting word value by address. */
-        word_val = GetBinary(code, adr);
-        /* Getting word in "special" base. */ 
-        BinaryToSpecial(word_val, word_sp);
-
-        /* Writing word address to file. */
-        fprintf(object, "%04d ", adr);
-        /* Writing word in "special" base. */
-        fprintf(object, "%s", word_sp);
-        
-        /* Writing new line character if word is not last, or if it is last, but data segment expected after. */
-        if (i != code->counter-1)
-            fputc('\n', object);
-        else {
-            if (data->counter != 0)
-                fputc('\n', object);
+    AppendNumber(&buf, code->counter, 0);
+    AppendText(&buf, " ", 1);
+    AppendNumber(&buf, data->counter, 0);
+    AppendText(&buf, "\n", 1);
+
+    /* Writing binary words of the code segment.
+       New line after last word only if data segment expected after. */
+    AppendSegment(&buf, code, data->counter == 0);
+    /* Writing binary words of the data segment. */
+    AppendSegment(&buf, data, 1);
+
+    WriteOutputFile(fileName, "ob", &buf);
+}
+
+/* Creates binary object .obj file.
+   Writes code and data words, entries and external references
+   in binary object format (see Object.h).
+   Assumes that arguments are correct.
+   Arguments:
+    fileName    -- Name of the file without extension.
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table.
+    references  -- Vector of symbol references in arguments.
+   Algorithm:
+    Names of entry and extern symbols are put to strings pool once, offsets
+    of extern names are kept by label id for external references table.
+    Size of the file is known before writing, so buffer is allocated at once
+    and filled by positions. */
+void WriteBinaryObjectFile(char* fileName, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references) {
+    OutputBuffer buf;     /* Content of the file. */
+    int* extern_names;    /* Offsets of extern names in strings pool by label id, -1 if label is not extern. */
+    unsigned char* bytes; /* Content of the file as bytes. */
+    unsigned char* entry; /* Current record in entries table. */
+    unsigned char* ext;   /* Current record in externals table. */
+    char* strings;        /* Strings pool. */
+    int num_entries = 0;  /* Number of entries. */
+    int num_externs = 0;  /* Number of references to externs. */
+    int strings_size = 0; /* Size of strings pool. */
+    int num_words = code->counter + data->counter; /* Number of words. */
+    int i;                /* Iterator. */
+
+    /* Counting entries and strings pool size. */
+    extern_names = (int*)Allocate(sizeof(int)*(symbols->labels->count+1));
+    for (i = 0; i < symbols->labels->count; i++)
+        extern_names[i] = -1;
+    for (i = 0; i < SymbolsCount(symbols); i++) {
+        Symbol* smb = SymbolAt(symbols, i);
+        if (IsEntry(smb) || IsExtern(smb)) {
+            if (IsEntry(smb))
+                num_entries++;
+            else
+                extern_names[smb->id] = strings_size;
+            strings_size += StringLen(smb->name) + 1;
         }
     }
+    /* Counting references to externs. */
+    for (i = 0; i < references->count; i++) {
+        LabelReference* ref = ReferenceAt(references, i);
+        if (extern_names[ref->id] != -1)
+            num_externs++;
+    }
 
-    /* Writing binary words of the data segment. */
-    for (i = 0; i< data->counter; i++) {
-        int adr;    /* Word address in data segment. */
-        int word_val; /* Value of the word. */
-        char word_sp[15]; /* Word value in "special" base. */
-
-        /* Setting address. */
-        adr = data->base+i;
-        /* Getting word value by address. */
-        word_val = GetBinary(data, adr);
-        /* Getting word in "special" base. */ 
-        BinaryToSpecial(word_val, word_sp);
-
-        /* Writing word address to file. */
-        fprintf(object, "%04d ", adr);
-        /* Writing word in "special" base. */
-        fprintf(object, "%s", word_sp);
+    /* Allocating content of the file. */
+    InitOutputBuffer(&buf, ObjectFileSize(num_words, num_entries, num_externs, strings_size));
+    buf.length = ObjectFileSize(num_words, num_entries, num_externs, strings_size);
+    memset(buf.text, 0, buf.length);
+    bytes = (unsigned char*)buf.text;
+
+    /* Writing header. */
+    memcpy(bytes, OBJ_MAGIC, 4);
+    PutUInt32(bytes + 4, code->base);
+    PutUInt32(bytes + 8, code->counter);
+    PutUInt32(bytes + 12, data->base);
+    PutUInt32(bytes + 16, data->counter);
+    PutUInt32(bytes + 20, num_entries);
+    PutUInt32(bytes + 24, num_externs);
+    PutUInt32(bytes + 28, strings_size);
 
-        /* If word is not last adding new line character. */
-        if (i != data->counter - 1) 
-            fputc('\n', object);
+    /* Writing 20 bit words. */
+    for (i = 0; i < num_words; i++) {
+        unsigned char* word = bytes + OBJ_HEADER_SIZE + i*OBJ_WORD_SIZE; /* Bytes of the word. */
+        int val = i < code->counter ? code->words[i] : data->words[i - code->counter]; /* Word value. */
+        word[0] = val & 255;
+        word[1] = (val >> 8) & 255;
+        word[2] = (val >> 16) & 15;
     }
 
-    /* Closing the file. */
-    fclose(object);
+    /* Writing entries table and strings pool. */
+    entry = bytes + ObjectFileSize(num_words, 0, 0, 0);
+    ext = entry + num_entries*OBJ_RECORD_SIZE;
+    strings = (char*)(ext + num_externs*OBJ_RECORD_SIZE);
+    strings_size = 0;
+    for (i = 0; i < SymbolsCount(symbols); i++) {
+        Symbol* smb = SymbolAt(symbols, i);
+        if (IsEntry(smb) || IsExtern(smb)) {
+            int len = StringLen(smb->name); /* Length of the name. */
+            if (IsEntry(smb)) {
+                PutUInt32(entry, strings_size);
+                PutUInt32(entry + 4, smb->adress);
+                entry += OBJ_RECORD_SIZE;
+            }
+            memcpy(strings + strings_size, smb->name, len + 1);
+            strings_size += len + 1;
+        }
+    }
+
+    /* Writing externals table. */
+    for (i = 0; i < references->count; i++) {
+        LabelReference* ref = ReferenceAt(references, i);
+        int offset = extern_names[ref->id]; /* Offset of the name. */
+        if (offset != -1) {
+            PutUInt32(ext, offset);
+            PutUInt32(ext + 4, ref->address);
+            ext += OBJ_RECORD_SIZE;
+        }
+    }
+
+    WriteOutputFile(fileName, "obj", &buf);
+}
+
+/* Writes expanded source lines to .am file.
+   Arguments:
+    fileName    -- Source file name without extension.
+    expanded    -- Expanded source lines.
+   Algorithm:
+    Lines are stored one after another with their new line characters
+    and termination characters. Lines are copied to output buffer
+    without termination characters, so buffer never grows. */
+void WriteExpandedSource(char* fileName, Lines* expanded) {
+    OutputBuffer buf; /* Text of expanded source file. */
+    int i;            /* Lines iterator. */
+
+    InitOutputBuffer(&buf, expanded->length);
+
+    /* Copying lines. */
+    for (i = 0; i < LinesCount(expanded); i++) {
+        char* line = GetLine(expanded, i); /* Current line. */
+        AppendText(&buf, line, StringLen(line));
+    }
+
+    WriteOutputFile(fileName, "am", &buf);
 }
 
 /* Creates and fills entries .ent file.
@@ -145,134 +393,101 @@ void WriteBinaryToObject(char* fileName, BinarySegment* code, BinarySegment* dat
    Arguments:
     fileName    -- Source file name without extension.
     symbols     -- Symbols table. */
-void WriteEntries(char* fileName, List* symbols) {
-    FILE* ent;       /* Handler of entries file. */
-    char* fullFname; /* Name of the file with extension. */
-    int fullNameLen; /* Length of the full file name (not counting termination character). */
-    ListNode* cur;   /* List iterator.*/
+void WriteEntries(char* fileName, SymbolsTable* symbols) {
+    OutputBuffer ent; /* Text of entries file. */
+    int i;           /* Symbols iterator.*/
     int num = 0;    /* Number of entry symbols in symbols table. */
 
-    /* Opening the file. */
-    fullNameLen = StringLen(fileName) + 4;
-    fullFname = (char*)malloc(sizeof(char)*(fullNameLen+1));
-    if (fullFname == NULL) { 
-        perror("Failed to allocate memory.\n"); 
-        exit(1); }
-    /* Getting full file name. */
-    AppendExtension(fileName, "ent", fullFname, fullNameLen);
-    ent = fopen(fullFname, "w"); /* Opening entries file for writing */
-    /* Check. */
-    if (ent == NULL) { 
-        perror("Failed to open file.\n"); 
-        exit(2); 
-    }
-    /* Freeing file name string. */
-    free(fullFname);
-
     /* Iterating trough symbols table and counting entries. */
-    cur = symbols->head;
-    while (cur != NULL) {
-        if (IsEntry(cur->data))
+    for (i = 0; i < SymbolsCount(symbols); i++) {
+        if (IsEntry(SymbolAt(symbols, i)))
             num++;
-        cur = cur->next;
     }
 
+    /* Label name, two numbers and separators take less than 64 characters. */
+    InitOutputBuffer(&ent, num*64);
+
     /* Iterating trough symbols table and writing entries to file. */
-    cur = symbols->head;
-    while (cur != NULL) {
+    for (i = 0; i < SymbolsCount(symbols); i++) {
         /* Getting symbol. */
-        Symbol* smb = cur->data;
+        Symbol* smb = SymbolAt(symbols, i);
         /* Checking if symbol is entry. */
         if (IsEntry(smb)) {
             /* Converting symbol address to base+offset format. */
             BOAddress bo = AddressToBO(smb->adress);
 
             /* Writing entry name. */
-            fprintf(ent, "%s,", smb->name);
+            AppendText(&ent, smb->name, StringLen(smb->name));
+            AppendText(&ent, ",", 1);
             /* Writing base+offset address. */
-            fprintf(ent, "%d,%d", bo.base, bo.offset);
+            AppendNumber(&ent, bo.base, 0);
+            AppendText(&ent, ",", 1);
+            AppendNumber(&ent, bo.offset, 0);
             /* Counting entry as written. */
             num--;
             /* If entry not the last one adding new line character. */
             if (num != 0)
-                fputc('\n', ent);
+                AppendText(&ent, "\n", 1);
 
         }
-        cur = cur->next;
     }   
 
-    /* Closing the file */
-    fclose(ent);
+    /* Writing the file */
+    WriteOutputFile(fileName, "ent", &ent);
 }
 
 /* Writes external symbols info to .ext file. 
    Arguments:
     fileName    -- Name of source file without extension.
     symbols     -- Symbols table.
-    references  -- List of symbol references in arguments. */
-void WriteExterns(char* fileName, List* symbols, List* references) {
-    FILE* ext;       /* Handler of externals file. */
-    char* fullFname; /* Name of the file with extension. */
-    int fullNameLen; /* Length of the full file name (not counting termination character). */
-    ListNode* cur;   /* List iterator.*/
+    references  -- Vector of symbol references in arguments. */
+void WriteExterns(char* fileName, SymbolsTable* symbols, Vector* references) {
+    OutputBuffer ext; /* Text of externals file. */
     int num = 0;    /* Number of references to externs. */
-
-    /* Opening the file. */
-    fullNameLen = StringLen(fileName) + 4;
-    fullFname = (char*)malloc(sizeof(char)*(fullNameLen+1));
-    if (fullFname == NULL) { 
-        perror("Failed to allocate memory.\n"); 
-        exit(1); }
-    /* Getting full file name. */
-    AppendExtension(fileName, "ext", fullFname, fullNameLen);
-    ext = fopen(fullFname, "w"); /* Opening externs file for writing */
-    /* Check. */
-    if (ext == NULL) { 
-        perror("Failed to open file.\n"); 
-        exit(2); 
-    }
-    /* Freeing file name string. */
-    free(fullFname);  
+    int i;          /* References iterator. */
 
     /* Iteterating trough references table and checking if referenced symbol
        has attribute extern. Counting extern references. */
-    cur = references->head;
-    while (cur != NULL) {
+    for (i = 0; i < references->count; i++) {
         Symbol* smb;
         /* Getting current symbol reference. */
-        LabelReference* ref = cur->data;
-        /* Searching it in symbols table. */
-        smb = FindSymbolByName(symbols, ref->name);
+        LabelReference* ref = ReferenceAt(references, i);
+        /* Getting its symbol by label id. */
+        smb = FindSymbolById(symbols, ref->id);
         /* Checking if symbol is marked extern. */
         if (IsExtern(smb))
             num++;
-        /* Advancing iterator. */
-        cur = cur->next;
     }
 
-    /* Iterating trough references list and writitng symbols that have attribute extern. */
-    cur = references->head;
-    while (cur != NULL) {
+    /* Two lines with label name and a number take less than 128 characters. */
+    InitOutputBuffer(&ext, num*128);
+
+    /* Iterating trough references and writitng symbols that have attribute extern. */
+    for (i = 0; i < references->count; i++) {
         Symbol* smb;
         /* Getting current symbol reference. */
-        LabelReference* ref = cur->data;
-        /* Searching it in symbols table. */
-        smb = FindSymbolByName(symbols, ref->name);
+        LabelReference* ref = ReferenceAt(references, i);
+        /* Getting its symbol by label id. */
+        smb = FindSymbolById(symbols, ref->id);
         /* If symbol marked extern writing info to file. */
         if (IsExtern(smb)) {
+            int name_len = StringLen(smb->name); /* Length of symbol name. */
             /* Writing base line. */
-            fprintf(ext, "%s BASE %d\n", ref->name, ref->address);
+            AppendText(&ext, smb->name, name_len);
+            AppendText(&ext, " BASE ", 6);
+            AppendNumber(&ext, ref->address, 0);
+            AppendText(&ext, "\n", 1);
             /* Writing offset line */
-            fprintf(ext, "%s OFFSET %d", ref->name, ref->address+1);
+            AppendText(&ext, smb->name, name_len);
+            AppendText(&ext, " OFFSET ", 8);
+            AppendNumber(&ext, ref->address+1, 0);
             /* Counting external reference as written. */
             num--;
             /* If reference is not the last one adding empty line. */
             if (num != 0)
-                fprintf(ext, "\n\n");
+                AppendText(&ext, "\n\n", 2);
         }
-        /* Advancing iterator. */
-        cur = cur->next;
     }
 
-    fclose(ext);
+    WriteOutputFile(fileName, "ext", &ext);
 }
\ No newline at end of file
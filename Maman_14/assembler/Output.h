@@ -6,15 +6,68 @@
 #include "Data.h"
 #include "DataContainers.h"
 #include "Symbols.h"
+#include "Object.h"
 
-/* Converts integer values from 0-15 range to 
-   corresponding hex digit as character.
+/* Text of resulting file collected before writing.
+   Text is allocated in current arena. */
+typedef struct OutputBuffer {
+    char* text;   /* Text (not null-terminated). */
+    int length;   /* Number of characters in text. */
+    int capacity; /* Allocated size of text. */
+} OutputBuffer;
+
+/* Initializes output buffer allocated in current arena.
+   Arguments:
+    buf         -- Output buffer.
+    capacity    -- Expected length of the text. */
+void InitOutputBuffer(OutputBuffer* buf, int capacity);
+
+/* Makes sure that len more characters fit in output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    len     -- Number of characters that will be added. */
+void ReserveOutput(OutputBuffer* buf, int len);
+
+/* Adds characters to output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    s       -- Characters to add.
+    len     -- Number of characters. */
+void AppendText(OutputBuffer* buf, char* s, int len);
+
+/* Adds decimal representation of a number to output buffer.
+   Same as printf "%0*d" format with width minDigits.
    Arguments:
-    val     -- Integer value.
+    buf         -- Output buffer.
+    num         -- Number.
+    minDigits   -- Minimal number of digits, number padded with leading zeros. */
+void AppendNumber(OutputBuffer* buf, int num, int minDigits);
+
+/* Writes output buffer to resulting file with single write.
+   Arguments:
+    fileName    -- Source file name without extension.
+    ext         -- Extension of resulting file.
+    buf         -- Text of the file. */
+void WriteOutputFile(char* fileName, char* ext, OutputBuffer* buf);
+
+/* Opens resulting file for writing.
+   File is written under temporary name (full name with ".tmp" added)
+   and gets its full name only when it is closed by CloseOutputFile(),
+   so partially written file never appears under resulting file name.
+   Arguments:
+    fileName    -- Source file name without extension.
+    ext         -- Extension of resulting file.
+    fullName    -- Variable for returning full name of resulting file (allocated in current arena).
    Returns:
-    Character that represents hex digit corresponding to that value.
-    If val is out of range 0-15 ' ' (blank) is returned. */
-char IntToHexDigit(int val);
+    Handler of temporary file. Exits program if file can't be opened. */
+FILE* OpenOutputFile(char* fileName, char* ext, char** fullName);
+
+/* Closes file opened by OpenOutputFile() and
+   renames temporary file to resulting file name.
+   Arguments:
+    file        -- Handler of temporary file.
+    fullName    -- Full name of resulting file returned by OpenOutputFile(). */
+void CloseOutputFile(FILE* file, char* fullName);
 
 /* Converts 20 bit binary word to text representation
    of that word in "special" base. 
@@ -25,6 +78,32 @@ char IntToHexDigit(int val);
     word    -- Buffer for writing string representation of val in "special" base. */
 void BinaryToSpecial(int val, char word[15]);
 
+/* Adds lines of binary segment words to object file text.
+   Line is address (4 digits at least) and word in "special" base.
+   Arguments:
+    buf     -- Object file text.
+    segment -- Binary segment.
+    last    -- 1 if segment is the last in the file (no new line after last word). */
+void AppendSegment(OutputBuffer* buf, BinarySegment* segment, int last);
+
+/* Creates binary object .obj file.
+   Writes code and data words, entries and external references
+   in binary object format (see Object.h).
+   Assumes that arguments are correct.
+   Arguments:
+    fileName    -- Name of the file without extension.
+    code        -- Code binary segment.
+    data        -- Data binary segment.
+    symbols     -- Symbols table.
+    references  -- Vector of symbol references in arguments. */
+void WriteBinaryObjectFile(char* fileName, BinarySegment* code, BinarySegment* data, SymbolsTable* symbols, Vector* references);
+
+/* Writes expanded source lines to .am file.
+   Arguments:
+    fileName    -- Source file name without extension.
+    expanded    -- Expanded source lines. */
+void WriteExpandedSource(char* fileName, Lines* expanded);
+
 /* Creates and fills .ob object file.
    Writes code and binary segments in "special" base to .ob file.
    Assumes that binary segment arguments are correct.
@@ -40,12 +119,12 @@ void WriteBinaryToObject(char* fileName, BinarySegment* code, BinarySegment* dat
    Arguments:
     fileName    -- Source file name without extension.
     symbols     -- Symbols table. */
-void WriteEntries(char* fileName, List* symbols);
+void WriteEntries(char* fileName, SymbolsTable* symbols);
 
 /* Writes external symbols info to .ext file. 
    Arguments:
     fileName    -- Name of source file without extension.
     symbols     -- Symbols table.
-    references  -- List of symbol references in arguments. */
-void WriteExterns(char* fileName, List* symbols, List* references);
+    references  -- Vector of symbol references in arguments. */
+void WriteExterns(char* fileName, SymbolsTable* symbols, Vector* references);
 #endif
\ No newline at end of file
@@ -11,13 +11,13 @@ int IsDigit(char c) {
 
 
 
-/* Returns 1 if line is a number
-   and 0 if it is not. */
-int IsNumber(char* s) {
+/* Returns 1 if first len characters of s are a number
+   and 0 if they are not. */
+int IsNumber(char* s, int len) {
     int pos = 0;
 
     /* Checking for empty string. */
-    if (s[pos] == '\0')
+    if (len == 0)
         return 0;
 
     /* Checking for leading sign. */
@@ -25,7 +25,7 @@ int IsNumber(char* s) {
         pos++;
 
     /* Checking rest of the number. */
-    while (s[pos] != '\0') {
+    while (pos < len) {
         if (s[pos] < 48 || s[pos] > 57)
             return 0;
         pos++;
@@ -125,75 +125,12 @@ int SkipCommas(char* line, int* pos) {
     1   -- s is an instruction name.
     2   -- s is a register name.
     3   -- s is a keyword.
+   Algorithm:
+    Uses ClassifyWord() which returns values of ReservedWordsEnum
+    that are equal to the values above.
 */
 int IsReservedWord(char* s) {
-    int i; /* Iterator */
-    char rx[3] = "r0"; /* Register name <10 */
-    char rxx[4] = "r10"; /* Register name >= 10 */
-    char* instructions[16]; /* Array of instruction names */
-    char* keywords[9];  /* Array of assembly keywords */
-
-    /* Listing instructions names */
-    instructions[0] = "mov";
-    instructions[1] = "cmp";
-    instructions[2] = "add";
-    instructions[3] = "sub";
-
-    instructions[4] = "lea";
-    instructions[5] = "clr";
-    instructions[6] = "not";
-    instructions[7] = "inc";
-
-    instructions[8] = "dec";
-    instructions[9] = "jmp";
-    instructions[10] = "bne";
-    instructions[11] = "jsr";
-
-    instructions[12] = "red";
-    instructions[13] = "prn";
-    instructions[14] = "rts";
-    instructions[15] = "stop";
-    
-    /* Checking if s is an instruction name. */
-    for (i=0; i<16; i++) {
-        if (CompareStrings(s, instructions[i]))
-            return 1;
-    }
-
-    /* Checking if s is an register name. */
-    for (i = 0; i<10; i++) {
-        rx[1] = (48 + i);
-        if (CompareStrings(s, rx))
-            return 2;
-        if (i <=5) {
-            rxx[2] = 48 + i;
-            if (CompareStrings(s, rxx))
-                return 2;
-        }
-    }    
-
-    /* Listing keywords. */
-    keywords[0] = "macro";
-    keywords[1] = "endm";
-    keywords[2] = "data";
-    keywords[3] = ".data";
-
-    keywords[4] = "string";
-    keywords[5] = ".string";
-    keywords[6] = "extern";
-    keywords[7] = ".extern";
-
-    keywords[8] = "entry";
-    keywords[9] = ".entry";
-
-    /* Checking if s is a keyword */
-    for (i=0; i<9; i++) {
-        if (CompareStrings(s, keywords[i]))
-            return 3;
-    }
-
-    /* If not a reserved word */
-    return 0;
+    return ClassifyWord(s, StringLen(s), NULL);
 }
 
 
@@ -271,6 +208,85 @@ char* GetNextWord(char* line, int* pos, char* word, int maxLen, char* end) {
 
 
 
+/* Gets the word from given line starting from given position as a span
+   (position and length in line) and advances position counter.
+   Word is not copied. Word ends at same characters as in GetNextWord().
+   Skips leading blank characters.
+   Arguments:
+    line    -- Source line (null-terminated)
+    pos     -- Initial position in line.
+    span    -- Span for returning the word.
+    maxLen  -- Maximum length of a word to get.
+    end     -- String containing additional characters that considered word end.
+               Can be NULL.
+   Returns:
+    1 if word is found, 0 if nothing was taken.
+    pos will be set to first character after the word. */
+int GetNextSpan(char* line, int* pos, Span* span, int maxLen, char* end) {
+    int c = 1; /* Flag that shows if reading of the word should continue. */
+
+    /* Skipping leading blanks */
+    SkipBlank(line, pos);
+
+    /* Checking if line has ended after leading blanks. */
+    if (line[*pos] == '\0' || maxLen == 0)
+        return 0;
+
+    span->start = *pos;
+    span->len = 0;
+
+    /* Searching for the end of the word. */
+    while (c) {
+        /* Iterator for "end" characters */
+        int end_iter = 0; 
+
+        /* Taking character */
+        span->len++;
+        (*pos)++;
+
+        /* Checking if max word length was read */
+        if (span->len == maxLen)
+            c = 0;
+
+        /* Checking if blank character is met, or line has ended */
+        if (c && (IsBlankChar(line[*pos]) || line[*pos] == '\0'))
+            c = 0;
+
+        /* Checking if any of "end" symbols are met */
+        if (c && end != NULL) {
+            while (end[end_iter] != '\0') {
+                if (line[*pos] == end[end_iter])
+                    c = 0;
+                end_iter++;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+
+/* Copies characters of a span to buffer and adds termination character.
+   Used to get text of argument for error messages.
+   Arguments:
+    line    -- Line that contains the span.
+    span    -- Span in line.
+    buffer  -- Buffer of MAX_STATEMENT_LEN+2 characters.
+   Returns:
+    Pointer to buffer. */
+char* CopySpan(char* line, Span span, char* buffer) {
+    int i; /* Characters iterator. */
+
+    for (i = 0; i < span.len && i < MAX_STATEMENT_LEN+1; i++)
+        buffer[i] = line[span.start+i];
+    buffer[i] = '\0';
+
+    return buffer;
+}
+
+
+
 /* Gets instruction type according by instruction name.
    Argument:
     ins     -- String containing istruction name.
@@ -278,41 +294,10 @@ char* GetNextWord(char* line, int* pos, char* word, int maxLen, char* end) {
     Instruction number according to InstructionsEnum.
     -1 if instruction name not recognized. */
 int GetInstructionType(char* ins) {
-    if (CompareStrings(ins, "mov"))
-        return ins_mov;
-    if (CompareStrings(ins, "cmp"))
-        return ins_cmp;
-    if (CompareStrings(ins, "add"))
-        return ins_add;
-    if (CompareStrings(ins, "sub"))
-        return ins_sub;
-
-    if (CompareStrings(ins, "lea"))
-        return ins_lea;
-    if (CompareStrings(ins, "clr"))
-        return ins_clr;
-    if (CompareStrings(ins, "not"))
-        return ins_not;
-    if (CompareStrings(ins, "inc"))
-        return ins_inc;
-
-    if (CompareStrings(ins, "dec"))
-        return ins_dec;
-    if (CompareStrings(ins, "jmp"))
-        return ins_jmp;
-    if (CompareStrings(ins, "bne"))
-        return ins_bne;
-    if (CompareStrings(ins, "jsr"))
-        return ins_jsr;
-
-    if (CompareStrings(ins, "red"))
-        return ins_red;
-    if (CompareStrings(ins, "prn"))
-        return ins_prn;
-    if (CompareStrings(ins, "rts"))
-        return ins_rts;
-    if (CompareStrings(ins, "stop"))
-        return ins_stop;
+    int type; /* Instruction number. */
+
+    if (ClassifyWord(ins, StringLen(ins), &type) == rw_instruction)
+        return type;
 
     return -1;
 }
@@ -352,61 +337,40 @@ char* TryGetLabel(char* line, int* pos, char* label, int maxLen) {
 
 
 
-/* Gets next argument string starting from specified position in line.
-   Allocates result on heap. Advances position to character after argument.
+/* Gets span of next argument starting from specified position in line.
+   Advances position to character after argument.
    Arguments:
     line    -- Instruction line.
     pos     -- Position in instruction line after which next argument should be taken.
+    arg     -- Span for returning the argument.
    Returns:
-    Argument string allocated on heap, or NULL if only blank symbols were after given position.  */
-char* GetNextArg(char* line, int* pos) {
-    char* arg;  /* String to hold the argument */
-    char* res;  /* Result of getting the argument. */
-
-    /* Allocating result string. */
-    arg = (char*)malloc(sizeof(char)*(MAX_STATEMENT_LEN+2));
-    if (arg == NULL) {
-        perror("Failed to allocate memory.");
-        exit(1);
-    }
-
+    1 if argument is found, 0 if only blank symbols were after given position.  */
+int GetNextArg(char* line, int* pos, Span* arg) {
     /* Getting next argument considering ',' end of the word. */
-    res = GetNextWord(line, pos, arg, MAX_STATEMENT_LEN+1, ",");
-
-    /* If nothing was taken. */
-    if (res == NULL) {
-        free(arg);
-        return NULL;
-    }
-
-    return arg;
+    return GetNextSpan(line, pos, arg, MAX_STATEMENT_LEN+1, ",");
 }
 
 
 
-/* Gets arguments from given line as strings.
+/* Gets arguments from given line as spans.
    Advances line position to line termination character.
    Checks for comma errors.
-   Allocates argument strings on heap.
    Arguments:
     line    -- Instruction line
     pos     -- Position in line after instruction or directive name.
+    args    -- Array for returning argument spans.
+    maxArgs -- Size of args array. Arguments after first maxArgs are counted, but not saved.
     errors  -- List of errors.
-    lineNum -- Number of given line in expanded source code.
-    slr     -- Source line reference.
    Returns:
-    List of stings of arguments. Empty list will be returned if no arguments.
+    Number of arguments in line. 0 will be returned if no arguments.
    Algorithm:
     Uses SkipCommas to count commas before, between and after arguments and
     GetNextArg to get arguments. */
-List* GetRawArgs(char* line, int* pos, Errors* errors) {
-    List* args; /* List for holding arguments. */
-    char* arg; /* Variable for storing an argument. */
+int GetRawArgs(char* line, int* pos, Span* args, int maxArgs, Errors* errors) {
+    Span arg; /* Variable for storing an argument. */
+    int num_args = 0; /* Number of arguments. */
     int num_commas; /* Variable for storing number of commas. */
 
-    /* Initializing the list. */
-    args = CreateList();
-
     /* Skipping possible illegal commas after command name
        and before arguments. */
     num_commas = SkipCommas(line, pos);
@@ -416,9 +380,11 @@ List* GetRawArgs(char* line, int* pos, Errors* errors) {
         AddError(errors, ErrCmm_Before, line, NULL);
 
     /* Getting arguments in a loop.*/
-    while ((arg = GetNextArg(line, pos)) != NULL) {
-        /* Adding argument to the list. */
-        ListAdd(args, arg);
+    while (GetNextArg(line, pos, &arg)) {
+        /* Saving argument. */
+        if (num_args < maxArgs)
+            args[num_args] = arg;
+        num_args++;
         
         /* Checking for comma errors between arguments. */
         num_commas = SkipCommas(line, pos);
@@ -435,44 +401,40 @@ List* GetRawArgs(char* line, int* pos, Errors* errors) {
         }
     }
 
-    return args;
+    return num_args;
 }
 
 
 
-/* Parses a string that is a number. 
+/* Parses first len characters of a string that is a number. 
    Assumes that string represents a number.
    Arguments:
     s   -- Number in a string form.
+    len -- Number of characters in number.
    Returns:
     Number as int.
     0 if failed.  */
-int ParseNumber(char* s) {
+int ParseNumber(char* s, int len) {
     char sign = '+'; /* Character for storing sign of the number. */
-    int pos = 0; /* Position in digits string. */
+    int pos; /* Position in digits string. */
     int num = 0; /* Resulting number. */
     int multiplier = 1; /* Represents 10^n. */
-    char* digits = s;   /* Line without sign character. */
+    int start = 0; /* Position of first digit. */
 
-    /* If string is empty, or doesn't exists. */
-    if (s[0] == '\0' || s == NULL)
+    /* If string is empty. */
+    if (len == 0)
         return 0;
 
     /* Checking if line begins with a sign. */
     if (s[0] == '+' || s[0] == '-') {
-        digits = &(s[1]);
+        start = 1;
         sign = s[0];
     }
 
-    /* Moving position to the last digit in the digits string. */
-    while(digits[pos+1] != '\0')
-        pos++;
-
     /* Going from end of the string to beginning converting
        characters to digits and multiplying them by 10^n. */
-    while (pos != -1) {
-        num += (digits[pos]-48)*multiplier;
-        pos--;
+    for (pos = len-1; pos >= start; pos--) {
+        num += (s[pos]-48)*multiplier;
         multiplier *= 10;
     }
 
@@ -489,24 +451,21 @@ int ParseNumber(char* s) {
    and returns number of a register.
    Arguments:
     s   -- String containing register name.
+    len -- Number of characters in register name.
    Returns:
     Number of a register as int.
     -1 if parsing failed. */
-int ParseRegisterName(char* s) {
+int ParseRegisterName(char* s, int len) {
     /* Checking if first character is 'r'. */
-    if (s[0] != 'r')
-        return -1;
-
-    /* Checking if 'r' isn't only character. */
-    if (s[1] == '\0')
+    if (len == 0 || s[0] != 'r')
         return -1;
 
     /* If string is rx where x is a number. */
-    if (s[2] == '\0' && IsDigit(s[1]))
+    if (len == 2 && IsDigit(s[1]))
         return s[1] - 48; /* Returning x. */
 
     /* If string is rxx where xx is a number. */
-    if (s[3] == '\0' && IsDigit(s[1]) && IsDigit(s[2])) {
+    if (len == 3 && IsDigit(s[1]) && IsDigit(s[2])) {
         int num = (s[1]-48)*10 + (s[2]-48); /* Coverting characters to int. */
         if (num < 16) /* If number is valid register number */
             return num; /* Returning xx. */
@@ -518,77 +477,69 @@ int ParseRegisterName(char* s) {
 
 
 
-/* Tries to get indexer part as string from label argument.
+/* Tries to get indexer part from label argument.
    (rxx from argument label[rxx]).
    Moves position to character after the closing bracket.
-   Allocates resulting string on heap.
    Arguments:
-    arg     -- Label argument.
-    pos     -- Position after label name.
+    line    -- Instruction line.
+    arg     -- Span of label argument in line.
+    pos     -- Position in argument after label name.
+    indexer -- Span for returning indexer name (position in line).
     failed  -- Pointer to result indicator set to 1 if parsing errors encountered.
                If indexer not found left as it was.
+    errors  -- Errors list.
    Returns:
-    Indexer content as sting (if arg is label[r0] "r0" will be returned). */
-char* GetIndexer(char* arg, int* pos, int* failed, Errors* errors) {
-    char* indexer; /* Variable for holding indexer. */
-    int i =0; /* Indexer string iterator. */
+    1 if indexer name is found (if arg is label[r0] span of "r0" will be returned).
+    0 if there is no indexer, or it is empty. */
+int GetIndexer(char* line, Span arg, int* pos, Span* indexer, int* failed, Errors* errors) {
+    char* s = line + arg.start; /* Argument characters. */
+    char text[MAX_STATEMENT_LEN+2]; /* Buffer for argument text in error messages. */
     int start = 0; /* Starting position of indexer name. */
     int len = -1; /* Length of indexer name. */
 
     /* Searching for opening bracket '['. */
-    while (arg[*pos] != '[' && arg[*pos] != '\0')
+    while (*pos < arg.len && s[*pos] != '[')
         (*pos)++;
 
     /* If opening bracket not present there is no indexer. */
-    if (arg[*pos] == '\0')
-        return NULL;
+    if (*pos == arg.len)
+        return 0;
 
     /* Setting name start character. */
     start = (*pos) + 1;
 
     /* Counting name length. */
-    while (arg[*pos] != ']' && arg[*pos] != '\0') {
+    while (*pos < arg.len && s[*pos] != ']') {
         (*pos)++;
         len++;
     }
 
     /* If there is no name after opening bracket. */
     if (len == 0) {
-        AddError(errors, ErrArg_MissingIndex, arg, NULL);
+        AddError(errors, ErrArg_MissingIndex, CopySpan(line, arg, text), NULL);
         *failed = 1;
-        return NULL;
+        return 0;
     }
 
     /* If ']' found advancing position to next character. */
-    if (arg[*pos] == ']') {
+    if (*pos < arg.len) {
         (*pos)++;
         /* Checking for extra text after closing bracket. */
-        if (arg[*pos] != '\n' && arg[*pos] != '\0') {
-            AddError(errors, ErrArg_Extra, arg, NULL);
+        if (*pos < arg.len) {
+            AddError(errors, ErrArg_Extra, CopySpan(line, arg, text), NULL);
             /* Not considered failure, but error will be registered. */
         }
     }
     else /* If there is no closing bracket, but name is present. */ {
-        AddError(errors, ErrArg_MissingBracket, arg, NULL);
+        AddError(errors, ErrArg_MissingBracket, CopySpan(line, arg, text), NULL);
         *failed = 1;
     }
     
-    /* Allocating indexer string.*/
-    indexer = (char*)malloc(sizeof(char)*(len+1));
-    if (indexer == NULL) {
-        perror("Failed to allocate memory.");
-        exit(1);
-    }
+    /* Returning indexer name. */
+    indexer->start = arg.start + start;
+    indexer->len = len;
 
-    /* Copying indexer */
-    while (i<len) {
-        indexer[i] = arg[start+i];
-        i++;
-    }
-    /* Adding termination character. */
-    indexer[i] = '\0';
-
-    return indexer;
+    return 1;
 }
 
 
@@ -596,49 +547,52 @@ char* GetIndexer(char* arg, int* pos, int* failed, Errors* errors) {
 /* Parses label argument of instruction. (label, or label[r0] for example).
    Writes into provided structure, returns NULL if failed, or pointer to structure.
    Arguments:
-    arg     -- Label argument as string.
+    line    -- Instruction line.
+    arg     -- Span of label argument in line.
     parg    -- Pointer for returning result.
+    symbols -- Symbols table where label name is interned.
     errors  -- List of errors.
    Returns:
     Pointer to parsed argument structure if succeeded.
     NULL if parsing failed. */
-InsArg* ParseLabelArgument(char* arg, InsArg* parg, Errors* errors) {
+InsArg* ParseLabelArgument(char* line, Span arg, InsArg* parg, SymbolsTable* symbols, Errors* errors) {
     int failed = 0; /* Flag that shows if errors were found while parsing label.
                         Used for accumulating error codes before returning NULL from function. */
     int pos = 0; /* Char position in arg. */
-    char* indexer; /* Variable for holding indexer part if present (content of [rx] brackets). */
+    char* s = line + arg.start; /* Argument characters. */
+    char text[MAX_STATEMENT_LEN+2]; /* Buffer for argument text in error messages. */
+    char label[MAX_LABEL_LEN+1]; /* Label name. */
+    Span indexer; /* Indexer part if present (content of [rx] brackets). */
 
     /* Copying label until end of argument, or [ ].
         i.e. copying label name without indexer part. */
-    while (arg[pos] != '\0' && pos<MAX_LABEL_LEN && arg[pos] != '[') {
-        (parg->label)[pos] = arg[pos];
+    while (pos < arg.len && pos<MAX_LABEL_LEN && s[pos] != '[') {
+        label[pos] = s[pos];
         pos++;
     }
     /* Adding line termination character. */
-    (parg->label)[pos] = '\0';
+    label[pos] = '\0';
 
     /* Checking if label name is valid. */
-    if (!IsAz09(parg->label) || IsDigit(parg->label[0])) {
-        AddError(errors, ErrArg_InvalidLabel, arg, NULL);
+    if (!IsAz09(label) || IsDigit(label[0])) {
+        AddError(errors, ErrArg_InvalidLabel, CopySpan(line, arg, text), NULL);
         failed = 1;
     }
 
     /* Checking if label is less than 31 character. */
-    if (pos == 31 && arg[pos] != '[' && arg[pos] != '\0') {
-        AddError(errors, ErrArg_LongSymbol, arg, NULL);
+    if (pos == 31 && pos < arg.len && s[pos] != '[') {
+        AddError(errors, ErrArg_LongSymbol, CopySpan(line, arg, text), NULL);
         failed = 1;
     }
 
     /* Trying to get indexer. */
-    if ((indexer = GetIndexer(arg, &pos, &failed, errors)) != NULL) {
+    if (GetIndexer(line, arg, &pos, &indexer, &failed, errors)) {
         /* If indexer is present trying to parse it. */
-        parg->val = ParseRegisterName(indexer);
+        parg->val = ParseRegisterName(line + indexer.start, indexer.len);
         if (parg->val == -1) { /* If failed to parse. */
-            AddError(errors, ErrArg_InvalidIndex, arg, NULL);
+            AddError(errors, ErrArg_InvalidIndex, CopySpan(line, arg, text), NULL);
             failed = 1;
         }
-        /* Freeing memory. */
-        free(indexer);
         /* If index was found and parsed addressing mode is direct index. */
         parg->amode = am_index;
     }
@@ -648,20 +602,21 @@ InsArg* ParseLabelArgument(char* arg, InsArg* parg, Errors* errors) {
     }
 
     /* If errors were found while parsing label argument returning NULL. */
-    if (failed) {
-        free(parg);
+    if (failed)
         return NULL;
-    }
-    else
-    /* If label argument parsed succesfully. */
-        return parg;
+
+    /* If label argument parsed succesfully saving id of the label. */
+    parg->label = InternLabel(symbols, label);
+    return parg;
 }
 
 
 
 /*Parses instruction argument.
   Arguments:
-   arg      -- String containing the argument.
+   line     -- Instruction line.
+   arg      -- Span of the argument in line.
+   symbols  -- Symbols table where label names are interned.
    errors   -- Errors list.
   Returns:
    Structure that describes the argument.
@@ -671,32 +626,33 @@ InsArg* ParseLabelArgument(char* arg, InsArg* parg, Errors* errors) {
     If it starts with # ParseNumber is used
     If it starts with letter r ParseRegisterName is used.
     If ParseRegisterName failed argument considered a label argument and ParseLabelArgument is called.
-    If all parsing failed NULL is returned.  */
-InsArg* ParseInsArg(char* arg, Errors* errors) {
+    If all parsing failed NULL is returned. */
+InsArg* ParseInsArg(char* line, Span arg, SymbolsTable* symbols, Errors* errors) {
     InsArg* parg;   /* Parsed argument. */
+    char* s = line + arg.start; /* Argument characters. */
+    char text[MAX_STATEMENT_LEN+2]; /* Buffer for argument text in error messages. */
 
     /* Allocating argument structure. */
-    parg = (InsArg*)malloc(sizeof(InsArg));
+    parg = (InsArg*)TRACKED_ALLOCATE(sizeof(InsArg), site_parse_ins_arg);
 
     /* Checking if argument is direct number. */
-    if (arg[0] == '#') {
-        if (arg[1] != '\0' && IsNumber(&(arg[1]))) {
+    if (s[0] == '#') {
+        if (arg.len > 1 && IsNumber(s+1, arg.len-1)) {
             parg->amode = am_immediate; /* Setting adressing mode to direct. */
-            parg->val = ParseNumber(&(arg[1])); /* Parsing number (without a #) */
+            parg->val = ParseNumber(s+1, arg.len-1); /* Parsing number (without a #) */
             return parg;
         }
         else {
             /* If arg starts with # it should be a number. */
-            AddError(errors, ErrArg_NotANumber, arg, NULL);
-            free(parg);
+            AddError(errors, ErrArg_NotANumber, CopySpan(line, arg, text), NULL);
             return NULL;
         }
     }
 
     /* Checking if argument is a register if it starts with 'r'. */
-    if (arg[0] == 'r') {
+    if (s[0] == 'r') {
         /* Trying to parse register name. */
-        parg->val = ParseRegisterName(arg);
+        parg->val = ParseRegisterName(s, arg.len);
         if (parg->val != -1) { /* Parsed successfully. */
             parg->amode = am_rdirect; /* Setting adressing mode to register direct. */
             return parg;
@@ -704,7 +660,7 @@ InsArg* ParseInsArg(char* arg, Errors* errors) {
     }
 
     /* Now if argument isn't # number, or rxx register it is a label possibly with index. */ 
-    return ParseLabelArgument(arg, parg, errors);
+    return ParseLabelArgument(line, arg, parg, symbols, errors);
 }
 
 
@@ -764,118 +720,94 @@ char* GetSymbolDirectiveArgument(char* line, int* pos, char arg[MAX_LABEL_LEN+1]
 
 
 
-/* Parses list of .data directive numeric arguments given as strings.
-   Returns dynamic array containing integer value.
+/* Parses .data directive numeric arguments given as spans.
+   Writes integer values of arguments to provided array.
    Arguments:
     line    -- Line with .data directive.
-    rawArgs -- Arguments as strings.
+    args    -- Spans of arguments in line.
+    numArgs -- Number of arguments.
+    values  -- Array for values of arguments (at least numArgs long).
     errors  -- Errors list.
    Returns:
-    Dynamic array containing integer values of corresponding arguments.
-    NULL if parsing failed. */
-DynArr* ParseDataArgs(char* line, List* rawArgs, Errors* errors) {
-    DynArr* pargs; /* Array of parsed arguments values. */
-    ListNode* cur; /* List iterator. */
-
-    /* Creating result array. */
-    pargs = CreateDynArr(8);
-
-    /* If no arguments in the list. */
-    if (rawArgs->count == 0) {
+    1 if all arguments parsed, values array is filled.
+    0 if parsing failed. */
+int ParseDataArgs(char* line, Span* args, int numArgs, int* values, Errors* errors) {
+    int i; /* Arguments iterator. */
+    char text[MAX_STATEMENT_LEN+2]; /* Buffer for argument text in error messages. */
+
+    /* If no arguments given. */
+    if (numArgs == 0) {
         AddError(errors, ErrDir_NoArgument, line, NULL);
-        FreeDynArr(pargs);
-        return NULL;
+        return 0;
     }
 
     /* Parsing arguments in a loop. */
-    cur = rawArgs->head; /* Initializing iterator. */
-    while (cur != NULL) {
-        /* Checking if raw argument is a number and parsing it. */
-        if (IsNumber(cur->data)) {
-            /* Parsing argument value. */
-            int pnum = ParseNumber(cur->data); 
-            
-            AddDynArr(pargs, pnum);
-        }
+    for (i = 0; i < numArgs; i++) {
+        /* Checking if argument is a number and parsing it. */
+        if (IsNumber(line + args[i].start, args[i].len))
+            values[i] = ParseNumber(line + args[i].start, args[i].len);
         else {
             /* Invalid argument encountered. */
-            AddError(errors, ErrDt_DtInvalidArg, line, cur->data);
-            FreeDynArr(pargs);
-            return NULL;
+            AddError(errors, ErrDt_DtInvalidArg, line, CopySpan(line, args[i], text));
+            return 0;
         }
-        cur = cur->next; /* Advancing iterator. */
     }
 
-    return pargs;
+    return 1;
 }
 
-/* Takes line with pos after ".string"  directive keyword.
-   Parses .string argument - Checks if quotation marks are correct and 
-   returns string inside them.
+/* Parses .string argument - Checks if quotation marks are correct and 
+   returns span of string inside them.
    Arguments:
-    line    -- Directive line. For error messages.
-    arg     -- .string argument with quotation marks.   
+    line    -- Directive line.
+    arg     -- Span of .string argument with quotation marks.   
+    str     -- Span for returning string inside quotation marks.
     errors  -- Errors list.    
    Returns:
-    Parsed string argument. 
-*/
-char* ParseStringArgument(char* line, char* arg, Errors* errors) {
-    int start; /* Position of the first character inside "". */
+    1 if argument is parsed, 0 if parsing failed. */
+int ParseStringArgument(char* line, Span arg, Span* str, Errors* errors) {
+    char* s = line + arg.start; /* Argument characters. */
+    char text[MAX_STATEMENT_LEN+2]; /* Buffer for argument text in error messages. */
     int len = 0; /* Length of string inside "". */
-    int pos = 0; /* Position in arg string. */
-    int ipos = 0; /* Position inside of string between "". */
-    char* str; /* Parsed string. */
-
+    int pos = 0; /* Position in arg. */
 
     /* Checking if first character is ". */
-    if (arg[pos] != '"') {
-        AddError(errors, ErrDt_StrInvalidArg, line, arg);
-        return NULL;
+    if (s[pos] != '"') {
+        AddError(errors, ErrDt_StrInvalidArg, line, CopySpan(line, arg, text));
+        return 0;
     }
 
     /* Advancing position by 1 and marking start. */
     pos++;
-    start = pos;
+    str->start = arg.start + pos;
 
     /* Searching for closing " and counting length.*/
-    while (arg[pos] != '"' && arg[pos] != '\0') {
+    while (pos < arg.len && s[pos] != '"') {
         pos++;
         len++;
     }
 
     /* If string wasn't closed. */
-    if (arg[pos] == '\0') {
-        AddError(errors, ErrDt_StrMissingClosing, line, arg);
-        return NULL;
+    if (pos == arg.len) {
+        AddError(errors, ErrDt_StrMissingClosing, line, CopySpan(line, arg, text));
+        return 0;
     }
 
     /* Checking for extra text. */
     pos++; /* Moving to closing ". */
-    if (!IsBlankChar(arg[pos]) && arg[pos] != '\0') {
+    if (pos < arg.len) {
         AddError(errors, ErrDt_StrExtra, line, NULL);
-        return NULL;
-    }
-
-    /* Allocating result string. */
-    str = (char*)malloc(sizeof(char)*(len+1));
-    if (str == NULL) {
-        perror("Failed to allocate memory.");
-        exit(1);
+        return 0;
     }
 
-    /* Copying string content. */
-    for (ipos=0; ipos<len; ipos++)
-        str[ipos] = arg[start+ipos];
-    
-    /* Adding termination character. */
-    str[ipos] = '\0';
+    str->len = len;
 
-    return str;
+    return 1;
 }
 
 
 
-/* Parses instruction line and produces Ins structure allocated on heap.
+/* Parses instruction line and produces Ins structure allocated in current arena.
    Structure contains istruction code and structures that describe arguments.
    Catches parsing and arguments errors.
    Moves position to end of the line.
@@ -883,58 +815,53 @@ char* ParseStringArgument(char* line, char* arg, Errors* errors) {
    Arguments:
     line    -- Instruction line from source code.
     pos     -- Position in line after label and before instruction name.
+    symbols -- Symbols table where label arguments are interned.
     errors  -- Errors list.
    Returns:
     Pointer to allocated instruction structure. NULL if parsing failed.
    Algorithm:
      */
-Ins* ParseInstructionLine(char* line, int* pos, Errors* errors) {
-    char word[MAX_STATEMENT_LEN + 2]; /* Buffer for holding word from line. */
-    char* res;                        /* Result of getting the word. */
+Ins* ParseInstructionLine(char* line, int* pos, SymbolsTable* symbols, Errors* errors) {
+    Span name;                        /* Instruction name. */
+    char text[MAX_STATEMENT_LEN + 2]; /* Buffer for instruction name in error message. */
     Ins* ins;                         /* Parsed instruction structure. */
-    List* rawArgs;                    /* Instruction arguments as strings. */
-    InsInfo insinfo;                  /* Info about instruction. */
+    Span args[2];                     /* Instruction arguments. */
+    int num_raw;                      /* Number of arguments given in line. */
+    const InsInfo* insinfo;           /* Info about instruction. */
     int num_args;                     /* Number of arguments required by instruction (not necessarily actually entered number of arguments).
                                          Deducted from insinfo. */
 
     /* Getting first word after label (possible instruction name). */
-    res = GetNextWord(line, pos, word, MAX_STATEMENT_LEN + 1, ",");
     /* Checking if line is not empty. */
-    if (res == NULL) {
+    if (!GetNextSpan(line, pos, &name, MAX_STATEMENT_LEN + 1, ",")) {
         AddError(errors, ErrStm_Empty, line, NULL);
         return NULL;
     }
 
     /* Allocating instruction structure. */
-    ins = (Ins*)malloc(sizeof(Ins));
-    if (ins == NULL) {
-        perror("Failed to allocate memory.");
-        exit(1);
-    }
+    ins = (Ins*)Allocate(sizeof(Ins));
     /* Initializing fields. */
     ins->source = NULL;
     ins->dest = NULL;
 
     /* Getting instruction code. */
-    ins->ins = GetInstructionType(word);
     /* If instruction is not recognized. */
-    if (ins->ins == -1) {
-        AddError(errors, ErrStm_NotRecognized, line, word);
-        FreeIns(ins);
+    if (ClassifyWord(line + name.start, name.len, &(ins->ins)) != rw_instruction) {
+        AddError(errors, ErrStm_NotRecognized, line, CopySpan(line, name, text));
         return NULL;
     }
 
-    /* Getting instruction arguments as strings. */
-    rawArgs = GetRawArgs(line, pos, errors);
+    /* Getting instruction arguments. Only first two are needed, others are counted. */
+    num_raw = GetRawArgs(line, pos, args, 2, errors);
 
     /* Getting instruction info. */
     insinfo = GetInstructionInfo(ins->ins);
 
     /* Deducting number of arguments that should be in instruction. */
-    if (insinfo.amodes_dest == 0)
+    if (insinfo->amodes_dest == 0)
         num_args = 0; /* If there is no destination argument there is no source argument. */
     else {
-        if (insinfo.amodes_source == 0)
+        if (insinfo->amodes_source == 0)
             num_args = 1; /* Only destination argument. */
         else
             num_args = 2; /* Destination and source arguments. */
@@ -942,15 +869,13 @@ Ins* ParseInstructionLine(char* line, int* pos, Errors* errors) {
 
     /* Checking number of arguments that were extracted from the line. */
     /* Missing arguments. */
-    if (rawArgs->count < num_args) {
+    if (num_raw < num_args) {
         AddError(errors, ErrIns_MissingArg, line, NULL);
-        free(ins);                /* Freeing instruction structure. */
-        FreeListAndData(rawArgs); /* Freeing arguments list. */
         return NULL;
     }
 
     /* Too many arguments. */
-    if (rawArgs->count > num_args)
+    if (num_raw > num_args)
         /* Too many arguments. Appropriate number of arguments will
            be parsed, but error will be saved. */
         AddError(errors, ErrIns_ExtraArg, line, NULL);
@@ -958,24 +883,18 @@ Ins* ParseInstructionLine(char* line, int* pos, Errors* errors) {
     /* If instruction has 2 arguments: */
     if (num_args == 2) {
         /* Parsing arguments. */
-        ins->source = ParseInsArg(rawArgs->head->data, errors);
-        ins->dest = ParseInsArg(rawArgs->head->next->data, errors);
-        /* Freeing raw arguments list. */
-        FreeListAndData(rawArgs);
+        ins->source = ParseInsArg(line, args[0], symbols, errors);
+        ins->dest = ParseInsArg(line, args[1], symbols, errors);
         /* If parsing arguments failed. */
-        if (ins->source == NULL || ins->dest == NULL) {
-            FreeIns(ins); /* Removing instruction structure. */
+        if (ins->source == NULL || ins->dest == NULL)
             return NULL;
-        }
         /* Checking if entered modes are available for instuction arguments. */
-        if (!HasMode(insinfo.amodes_source, ins->source->amode)) {
+        if (!HasMode(insinfo->amodes_source, ins->source->amode)) {
             AddError(errors, ErrIns_InvalidSrcAmode, line, NULL);
-            FreeIns(ins);
             return NULL;
         }
-        if (!HasMode(insinfo.amodes_dest, ins->dest->amode)) {
+        if (!HasMode(insinfo->amodes_dest, ins->dest->amode)) {
             AddError(errors, ErrIns_InvalidDestAmode, line, NULL);
-            FreeIns(ins);
             return NULL;
         }
     }
@@ -983,17 +902,13 @@ Ins* ParseInstructionLine(char* line, int* pos, Errors* errors) {
     /* If instruction has 1 argument it is always a destination argument. */
     if (num_args == 1) {
         /* Parsing arguments. */
-        ins->dest = ParseInsArg(rawArgs->head->data, errors);
-        FreeListAndData(rawArgs); /* Freeing string arguments. */
+        ins->dest = ParseInsArg(line, args[0], symbols, errors);
         /* If parsing arguments failed. */
-        if (ins->dest == NULL) {
-            FreeIns(ins);
+        if (ins->dest == NULL)
             return NULL;
-        }
         /* Checking if entered modes are available for destination argument. */
-        if (!HasMode(insinfo.amodes_dest, ins->dest->amode)) {
+        if (!HasMode(insinfo->amodes_dest, ins->dest->amode)) {
             AddError(errors, ErrIns_InvalidDestAmode, line, NULL);
-            FreeIns(ins);
             return NULL;
         }
     }
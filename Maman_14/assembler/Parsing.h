@@ -14,9 +14,9 @@
    and 0 if it is not. */
 int IsDigit(char c);
 
-/* Returns 1 if line is a number
-   and 0 if it is not. */
-int IsNumber(char* s);
+/* Returns 1 if first len characters of s are a number
+   and 0 if they are not. */
+int IsNumber(char* s, int len);
 
 /* Checks if string s contains only
    letter and number characters.
@@ -86,6 +86,32 @@ int IsReservedWord(char* s);
 */
 char* GetNextWord(char* line, int* pos, char* word, int maxLen, char* end);
 
+/* Gets the word from given line starting from given position as a span
+   (position and length in line) and advances position counter.
+   Word is not copied. Word ends at same characters as in GetNextWord().
+   Skips leading blank characters.
+   Arguments:
+    line    -- Source line (null-terminated)
+    pos     -- Initial position in line.
+    span    -- Span for returning the word.
+    maxLen  -- Maximum length of a word to get.
+    end     -- String containing additional characters that considered word end.
+               Can be NULL.
+   Returns:
+    1 if word is found, 0 if nothing was taken.
+    pos will be set to first character after the word. */
+int GetNextSpan(char* line, int* pos, Span* span, int maxLen, char* end);
+
+/* Copies characters of a span to buffer and adds termination character.
+   Used to get text of argument for error messages.
+   Arguments:
+    line    -- Line that contains the span.
+    span    -- Span in line.
+    buffer  -- Buffer of MAX_STATEMENT_LEN+2 characters.
+   Returns:
+    Pointer to buffer. */
+char* CopySpan(char* line, Span span, char* buffer);
+
 /* Gets instruction type according by instruction name.
    Argument:
     ins     -- String containing istruction name.
@@ -108,79 +134,88 @@ int GetInstructionType(char* ins);
     If label isn't found function will return NULL. */
 char* TryGetLabel(char* line, int* pos, char* label, int maxLen);
 
-/* Gets next argument string starting from specified position in line.
-   Allocates result on heap. Advances position to character after argument.
+/* Gets span of next argument starting from specified position in line.
+   Advances position to character after argument.
    Arguments:
     line    -- Instruction line.
     pos     -- Position in instruction line after which next argument should be taken.
+    arg     -- Span for returning the argument.
    Returns:
-    Argument string allocated on heap, or NULL if only blank symbols were after given position.  */
-char* GetNextArg(char* line, int* pos);
+    1 if argument is found, 0 if only blank symbols were after given position.  */
+int GetNextArg(char* line, int* pos, Span* arg);
 
-/* Gets arguments from given line as strings.
+/* Gets arguments from given line as spans.
    Advances line position to line termination character.
    Checks for comma errors.
-   Allocates argument strings on heap.
    Arguments:
     line    -- Instruction line
     pos     -- Position in line after instruction or directive name.
+    args    -- Array for returning argument spans.
+    maxArgs -- Size of args array. Arguments after first maxArgs are counted, but not saved.
     errors  -- List of errors.
-    lineNum -- Number of given line in expanded source code.
-    slr     -- Source line reference.
    Returns:
-    List of stings of arguments. Empty list will be returned if no arguments.*/
-List* GetRawArgs(char* line, int* pos, Errors* errors);
+    Number of arguments in line. 0 will be returned if no arguments. */
+int GetRawArgs(char* line, int* pos, Span* args, int maxArgs, Errors* errors);
 
-/* Parses a string that is a number. 
+/* Parses first len characters of a string that is a number. 
    Assumes that string represents a number.
    Arguments:
     s   -- Number in a string form.
+    len -- Number of characters in number.
    Returns:
     Number as int.
     0 if failed.  */
-int ParseNumber(char* s);
+int ParseNumber(char* s, int len);
 
 /* Parses a register name (rx, rxx)
    and returns number of a register.
    Arguments:
     s   -- String containing register name.
+    len -- Number of characters in register name.
    Returns:
     Number of a register as int.
     -1 if parsing failed. */
-int ParseRegisterName(char* s);
+int ParseRegisterName(char* s, int len);
 
-/* Tries to get indexer part as string from label argument.
+/* Tries to get indexer part from label argument.
    (rxx from argument label[rxx]).
    Moves position to character after the closing bracket.
-   Allocates resulting string on heap.
    Arguments:
-    arg     -- Label argument.
-    pos     -- Position after label name.
+    line    -- Instruction line.
+    arg     -- Span of label argument in line.
+    pos     -- Position in argument after label name.
+    indexer -- Span for returning indexer name (position in line).
     failed  -- Pointer to result indicator set to 1 if parsing errors encountered.
                If indexer not found left as it was.
+    errors  -- Errors list.
    Returns:
-    Indexer content as sting (if arg is label[r0] "r0" will be returned).
- */
-char* GetIndexer(char* arg, int* pos, int* failed, Errors* errors);
+    1 if indexer name is found (if arg is label[r0] span of "r0" will be returned).
+    0 if there is no indexer, or it is empty. */
+int GetIndexer(char* line, Span arg, int* pos, Span* indexer, int* failed, Errors* errors);
 
 /* Parses label argument of instruction. (label, or label[r0] for example).
+   Writes into provided structure, returns NULL if failed, or pointer to structure.
    Arguments:
-    arg     -- Label argument as string.
+    line    -- Instruction line.
+    arg     -- Span of label argument in line.
     parg    -- Pointer for returning result.
+    symbols -- Symbols table where label name is interned.
     errors  -- List of errors.
    Returns:
     Pointer to parsed argument structure if succeeded.
     NULL if parsing failed. */
-InsArg* ParseLabelArgument(char* arg, InsArg* parg, Errors* errors);
+InsArg* ParseLabelArgument(char* line, Span arg, InsArg* parg, SymbolsTable* symbols, Errors* errors);
 
 /*Parses instruction argument.
   Arguments:
-   arg      -- String containing the argument.
+   line     -- Instruction line.
+   arg      -- Span of the argument in line.
+   symbols  -- Symbols table where label names are interned.
    errors   -- Errors list.
   Returns:
    Structure that describes the argument.
    NULL if failed. */
-InsArg* ParseInsArg(char* arg, Errors* errors);
+InsArg* ParseInsArg(char* line, Span arg, SymbolsTable* symbols, Errors* errors);
 
 /* Gets argument (label) of .extern or .entry directives.
    Writes argument to provided buffer.
@@ -194,29 +229,31 @@ InsArg* ParseInsArg(char* arg, Errors* errors);
     Directly returns pointer to that buffer, or NULL if getting argument failed. */
 char* GetSymbolDirectiveArgument(char* line, int* pos, char arg[MAX_LABEL_LEN+1], Errors* errors);
 
-/* Parses list of .data directive numeric arguments given as strings.
-   Returns dynamic array containing integer value.
+/* Parses .data directive numeric arguments given as spans.
+   Writes integer values of arguments to provided array.
    Arguments:
     line    -- Line with .data directive.
-    rawArgs -- Arguments as strings.
+    args    -- Spans of arguments in line.
+    numArgs -- Number of arguments.
+    values  -- Array for values of arguments (at least numArgs long).
     errors  -- Errors list.
    Returns:
-    Dynamic array containing integer values of corresponding arguments.
-    NULL if parsing failed. */
-DynArr* ParseDataArgs(char* line, List* rawArgs, Errors* errors);
+    1 if all arguments parsed, values array is filled.
+    0 if parsing failed. */
+int ParseDataArgs(char* line, Span* args, int numArgs, int* values, Errors* errors);
 
-/* Takes line with pos after ".string"  directive keyword.
-   Parses .string argument - Checks if quotation marks are correct and 
-   returns string inside them.
+/* Parses .string argument - Checks if quotation marks are correct and 
+   returns span of string inside them.
    Arguments:
-    line    -- Directive line. For error messages.
-    arg     -- .string argument with quotation marks.   
+    line    -- Directive line.
+    arg     -- Span of .string argument with quotation marks.   
+    str     -- Span for returning string inside quotation marks.
     errors  -- Errors list.    
    Returns:
-    Parsed string argument.  */
-char* ParseStringArgument(char* line, char* arg, Errors* errors);
+    1 if argument is parsed, 0 if parsing failed. */
+int ParseStringArgument(char* line, Span arg, Span* str, Errors* errors);
 
-/* Parses instruction line and produces Ins structure allocated on heap.
+/* Parses instruction line and produces Ins structure allocated in current arena.
    Structure contains istruction code and structures that describe arguments.
    Catches parsing and arguments errors.
    Moves position to end of the line.
@@ -224,9 +261,10 @@ char* ParseStringArgument(char* line, char* arg, Errors* errors);
    Arguments:
     line    -- Instruction line from source code.
     pos     -- Position in line after label and before instruction name.
+    symbols -- Symbols table where label arguments are interned.
     errors  -- Errors list.
    Returns:
     Pointer to allocated instruction structure. NULL if parsing failed. */
-Ins* ParseInstructionLine(char* line, int* pos, Errors* errors);
+Ins* ParseInstructionLine(char* line, int* pos, SymbolsTable* symbols, Errors* errors);
 
 #endif
\ No newline at end of file
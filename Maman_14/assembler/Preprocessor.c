@@ -1,28 +1,18 @@
 #include "Preprocessor.h"
 
-/* Searches macro in macros list by name.
+/* Searches macro in macros table by name.
    Arguments:
-    macros  -- List of macros.
+    macros  -- Macros table (hash map by macro name).
     name    -- Name of a macro to find.
    Returns:
     MacroInfo with provided name.
     NULL if not found.*/
-MacroInfo* FindMacroByName(List* macros, char* name) {
-    ListNode* cur; /* List iterator */
-
-    /* Checking if list is empty. */
+MacroInfo* FindMacroByName(HashMap* macros, char* name) {
+    /* Checking if table is empty. */
     if (macros->count == 0)
         return NULL;
 
-    /* Comparing macros names. */
-    cur = macros->head;
-    while (cur != NULL) {
-        if (CompareStrings(name, ((MacroInfo*)cur->data)->name))
-            return (MacroInfo*)(cur->data);
-        cur = cur->next;    
-    }
-
-    return NULL;
+    return (MacroInfo*)HashMapGet(macros, name);
 }
 
 
@@ -74,8 +64,9 @@ int IsLineMacroDef(char* line) {
 
     /* Skipping leading blank characters. */
     SkipBlank(line, &pos);
-    /* Getting first word of the line */
-    GetNextWord(line, &pos, word, 5, NULL);
+    /* Getting first word of the line (blank line has no word). */
+    if (GetNextWord(line, &pos, word, 5, NULL) == NULL)
+        return 0;
     
     /* Checking if this word is "macro" */
     if (CompareStrings(word, "macro")) {
@@ -102,8 +93,9 @@ int IsLineMacroDefEnd(char* line) {
     int pos = 0;
     char word[5]; /* Buffer for holding the first word of the line. */
 
-    /* Getting first word of the line */
-    GetNextWord(line, &pos, word, 4, NULL);
+    /* Getting first word of the line (blank line has no word). */
+    if (GetNextWord(line, &pos, word, 4, NULL) == NULL)
+        return 0;
 
     /* Checking if this word is "endm" */
     if (CompareStrings(word, "endm")) {
@@ -122,11 +114,11 @@ int IsLineMacroDefEnd(char* line) {
 /* Checks if given line is a macro call (macro name).
    Arguments:
     line    -- Source file line (terminated).
-    macros  -- List of macros.
+    macros  -- Macros table.
    Returns:
     0   -- If line is not a macro call.
     1   -- If line is a macro call. */
-int IsLineMacroCall(char* line, List* macros) {
+int IsLineMacroCall(char* line, HashMap* macros) {
     int pos = 0; /* Position in line. */
     char word[MAX_STATEMENT_LEN+2]; /* Buffer for storing words from line. */
     char* res; /* Word reading result. */
@@ -149,7 +141,7 @@ int IsLineMacroCall(char* line, List* macros) {
 
 /* Gets macro name from macro definition line.
    Checks for macro definition line errors.
-   Returned name will be allocated on heap.
+   Returned name will be allocated in current arena.
    Assumes that line is macro definition line (first word is "macro")
    and does not check for that.
    Arguments:
@@ -198,21 +190,18 @@ char* GetMacroName(char* line, int defLineNum, Errors* errors) {
     /* Checking if name is reserved assembly word */
     if (IsReservedWord(name)) {
         AddErrorManual(errors, defLineNum, ErrMacro_NameReserved, line, name);
-        free(name);
         return NULL;
     }
 
     /* Checking if name starts with a number. */
     if (IsDigit(name[0])) {
         AddErrorManual(errors, defLineNum, ErrMacro_NameNumber, line, NULL);
-        free(name);
         return NULL;
     }
 
     /* Checking if name contains only numbers and letters */
     if (!IsAz09(name)) {  
         AddErrorManual(errors, defLineNum, ErrMacro_NameIllegal, line, NULL);
-        free(name);
         return NULL;
     }
 
@@ -222,6 +211,7 @@ char* GetMacroName(char* line, int defLineNum, Errors* errors) {
 
 
 /* Gets macro info from source file.
+   Macro body lines that are not blank or comments are saved in info.
    Arguments:
     source      -- Pointer to source file handler.
     num_lines   -- Variable for returning number of macro lines.
@@ -232,23 +222,25 @@ char* GetMacroName(char* line, int defLineNum, Errors* errors) {
     Directly returns new MacroInfo structure. NULL will be returned if errors encountered.
     Writes number of lines in macro body to num_lines pointer even if getting info failed.
    Algorithm:
-    - Allocates info structure.
+    - Allocates info structure in current arena.
     - Uses GetMacroName to get name of the macro from definition line. If name not found it is noted.
     - Saves defLineNum to info structure.
-    - Uses ftell to save macro body position to info. Since this function is called only from
-      Preprocess(...) reading loop when it will be called macro definition line was read 
-      and source file position is exactly where macro body starts.
-    - Reads macro lines in a loop from source file and counts them including internal comment and blank lines.  
+    - Reads macro lines in a loop from source file and counts them including internal comment and blank lines.
+      Since this function is called only from Preprocess(...) reading loop when it will be called
+      macro definition line was read and source file position is exactly where macro body starts.
+      Lines that are not blank or comments are saved to info body lines together with their
+      index in macro body, so expansion will not need to read source file again.
     - Uses open_tags counter to find line last macro closing line (if there were nested macros).
       While reading lines checks for nested macros and registers error if found.
       When macro closing line is reached checks it for extra text.
       If name was not found, or nested macros found deallocates info structure and returns NULL.
       If errors with macro were only extra text after opening and closing lines then macro info is considered
       correct and returned.
-      Since from project description it is assumed that any opened macro definition always be closed
-      number of lines in macro body counted and written to num_lines pointer even if macro definition
+      Number of lines in macro body counted and written to num_lines pointer even if macro definition
       was incorrect. Number of lines is returned so source file line counter migth be correctly advanced
       even if macro is incorrect.
+      If source file ends before macro is closed registers error on definition line and returns NULL,
+      so no part of the unclosed macro is expanded.
 */
 MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLineNum, Errors* errors) {
     MacroInfo* info; /* Pointer for storing macro info. */
@@ -259,11 +251,7 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
     int failed = 0; /* Flag that shows if errors were encountered. */
 
     /* Allocating info structure */
-    info = (MacroInfo*)malloc(sizeof(MacroInfo));
-    if (info == NULL) {
-        perror("Failed to allocate memory.\n");
-        exit(1); 
-    }
+    info = (MacroInfo*)Allocate(sizeof(MacroInfo));
 
     /* Getting macro name */
     info->name = GetMacroName(defLine, defLineNum, errors);
@@ -273,8 +261,9 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
     /* Saving first macro body line number. */
     info->body_line_num = defLineNum+1;
 
-    /* Saving macro body start position in file. */
-    info->body_pos = ftell(*source);
+    /* Creating macro body lines. */
+    info->body = CreateLines(0);
+    info->body_lines = CreateDynArr(16);
 
     /* Searching where macro ends and counting body lines. */
     /* Macro is considered closed when open_tags counter reaches 0
@@ -285,8 +274,16 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
     while (open_tags>0) {
         /* Counting line. */
         (*num_lines)++;
-        /* Reading line. */
-        fgets(line, MAX_STATEMENT_LEN+2, *source);
+        /* Reading line. If file ends before macro is closed the
+           definition is ignored and error is registered on its first line. */
+        if (fgets(line, MAX_STATEMENT_LEN+2, *source) == NULL) {
+            AddErrorManual(errors, defLineNum, ErrMacro_Unclosed, defLine, NULL);
+            /* Uncounting line that was not read, and the closing tag that
+               was not found, so last line of file is the returned end of macro. */
+            (*num_lines) -= 2;
+            info->num_lines = *num_lines;
+            return NULL;
+        }
 
         /* Checking for nested macro definitions. */
         if (IsLineMacroDef(line)) {
@@ -298,13 +295,17 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
         /* Checking for definition end tag. */
         if (IsLineMacroDefEnd(line))
             open_tags--;
+        /* Saving body line if it should be copied on expansion (not blank, or comment). */
+        else if (!IsLineBlank(line) && !IsLineComment(line)) {
+            AddLine(info->body, line);
+            AddDynArr(info->body_lines, (*num_lines)-1);
+        }
     }
 
     /* Uncounting final closing tag line. */
     (*num_lines)--; 
 
-    /* After cycle we arrive to macro closing line "endm". It is 
-       assumed that it will always appear. */
+    /* After cycle we arrive to macro closing line "endm". */
     /* Checking if closing tag line contains extra code. */
     /* Extra text will be ignored, but error will be displayed. */
     SkipBlank(line, &pos); /* Skipping blanks */
@@ -315,27 +316,22 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
     /* Writing number of line to info. */
     info->num_lines = *num_lines;
 
-    /* Checking for failure flag. */
-    if (failed) {
-        /* Deallocating info structure. */
-        if (info->name != NULL)
-            free(info->name);
-        free(info);
+    /* Checking for failure flag. Info structure stays in arena unused. */
+    if (failed)
         return NULL;
-    }
     else
         return info;
 }
 
 
 
-/* Registers macro definition in list of macros.
+/* Registers macro definition in macros table.
    Will set source file position to the first character
    after macro closing tag line.
    Gives no indication if macro was failed to register.
    Arguments:
     source      -- Pointer to source file handler.
-    macros      -- Macros list.
+    macros      -- Macros table.
     def_line    -- Line (string) where macro name is defined.
     defLineNum  -- Number of line in source file where macro name is defined.
     errors      -- Errors list.
@@ -343,11 +339,11 @@ MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLin
     Number of line in source file after macro closing tag.
    Algorithm:
     Uses GetMacroInfo to read macro info.
-    If macro info acquired successfuly and macro with same name is not in the list
-    adds macro info to the macros list.
+    If macro info acquired successfuly and macro with same name is not in the table
+    adds macro info to the macros table.
     Uses returned lines value from GetMacroInfo to return number of line after macro.
     Assumes that arguments are correct and does not check them. */
-int RegisterMacroInfo(FILE** source, List* macros, char* defLine, int defLineNum, Errors* errors) {
+int RegisterMacroInfo(FILE** source, HashMap* macros, char* defLine, int defLineNum, Errors* errors) {
     MacroInfo* info = NULL; /* Variable to store macro info. */
     int num_lines; /* Number of lines in macro body not counting open/close tags. */
 
@@ -360,7 +356,7 @@ int RegisterMacroInfo(FILE** source, List* macros, char* defLine, int defLineNum
         /* Checking if macro with this name already registered
             and adding it to the list. */
         if (FindMacroByName(macros, info->name) == NULL)
-            ListAdd(macros, info);
+            HashMapAdd(macros, info->name, info);
         else  /* If macro already exists. */
             AddErrorManual(errors, defLineNum, ErrMacro_NameIdentical, defLine, info->name);
     }
@@ -371,33 +367,27 @@ int RegisterMacroInfo(FILE** source, List* macros, char* defLine, int defLineNum
 
 
 /* Expands macro by name defined in callLine.
-   Copies macro body lines from source file to current position
-   in target (expanded) file.
+   Copies saved macro body lines to the end of expanded source lines.
    Arguments:
-    source      -- Pointer to source file hanler.
-    target      -- Pointer to target (expanded) file handler.
-    srcPos      -- Current position in source file (position after macro call line)
+    target      -- Expanded source lines.
     callLine    -- Line of macro call (first word is a macro name)
     callLineNum -- Number of a call line in source file.
-    macros      -- List of registered macros.
+    macros      -- Table of registered macros.
     errors      -- List of errors.
    Algorithm:
     - Gets macro name.
     - Uses FindMacroByName to acquire appropriate macro info structure. Since
       this function is called only if IsMacroCallLine returned true
       macro info necceserily will be found.
-    - Uses fseek and macro info to place source file position to start of macro body.
-    - Copies info->num_lines from source file to target file. By doing that it copies 
-      macro body to expanded file.
-    - Uses srcPos and fseek to return source file position back to line after macro call line.
+    - Copies macro body lines saved by GetMacroInfo to target lines at once.
+    - Adds source line reference for every copied line using its saved index in macro body.
     Checks if there were text after macro name in call line. Text will be ignored and macro expanded,
     but error will be registered.
     Assumes that provided arguments are correct and does not check them. */
-void ExpandMacro(FILE** source, FILE** target, long srcPos, char* callLine, int callLineNum, List* macros, Errors* errors) {
+void ExpandMacro(Lines* target, char* callLine, int callLineNum, HashMap* macros, Errors* errors) {
     int i; /* Line terator */
     MacroInfo* minfo; /* Variable for storing found macro info. */
     int pos =0; /* Position in line. */
-    char mline[MAX_STATEMENT_LEN+2]; /* Buffer for holding macro body line. */
     char word[MAX_STATEMENT_LEN+2]; /* Buffer for storing word from line. */
 
     /* Reading macro name. */
@@ -410,108 +400,74 @@ void ExpandMacro(FILE** source, FILE** target, long srcPos, char* callLine, int
     if (GetNextWord(callLine, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
         AddErrorManual(errors, callLineNum, ErrMacro_ExtraCall, callLine, NULL);
 
-    /* Copying macro body lines to target file. */
-
-    /* Setting source file position to beginning of macro body. */
-    fseek(*source, minfo->body_pos, SEEK_SET);
-
-    /* Copying macro lines from source file to target file. */
-    for (i=0; i<(minfo->num_lines); i++) {
-        /* Reading macro body line */
-        fgets(mline, MAX_STATEMENT_LEN+1, *source);
+    CountStat(cnt_macro_calls);
 
-        /* Checking if line should be copied (not blank, or comment). */
-        if (!IsLineBlank(mline) && !IsLineComment(mline)) {
-            /* Writing line to target file */
-            fputs(mline, *target);
-            /* Saving reference to source line number*/
-            AddLineReference(errors, (minfo->body_line_num)+i);
-        }
-    }
+    /* Copying macro body lines to expanded source. */
+    AddLines(target, minfo->body);
 
-    /* Returning source file stream to initial position (line after macro call line). */
-    fseek(*source, srcPos, SEEK_SET);
+    /* Saving references to source line numbers. */
+    for (i=0; i<(minfo->body_lines->count); i++)
+        AddLineReference(errors, (minfo->body_line_num)+(minfo->body_lines->data)[i]);
 
     return;
 }
 
 
 
-/* Frees memory occupied by macros list.
-   Removes macro info objects, 
-   list nodes and list structure itself.
-   Arguments:
-    macros  -- Macros list. */
-void FreeMacrosList(List* macros) {
-    ListNode* cur;  /* List iterator */
-    ListNode* prev; /* Previous node pointer */
-
-    cur = macros->head;
-    while (cur != NULL) {
-        MacroInfo* info = (MacroInfo*)(cur->data);
-        free(info->name);   /* Freeing macro name string. */
-        free(info);         /* Freeing macro info structure. */
-        prev = cur;         /* Saving current list node pointer. */
-        cur = cur->next;    /* Advancing iterator. */
-        free(prev);         /* Removing current node. */
-    }
-    /* Removing list object. */
-    free(macros);
-}
-
-
-
 /* Executes pre-processing step on assembly source code file:
    Removes comments and blank lines and expands macros.
+   Expanded source is kept in memory, .am file is not written.
    Arguments:
     sourceFileName      -- Name of source file without extension.
-    errors              -- List of errors.
+    errors              -- List of errors. Source line reference is filled here.
    Returns:
-    Source line reference.
+    Lines of expanded source allocated in current arena.
    Algorithm:
-    Creates macro info list.
-    Using AppendExtension combines file name with appropriate extensions.
-    Opens source file for reading and target (expanded) file for writing.
+    Creates macro info table.
+    Using AppendExtension combines file name with source file extension.
+    Opens source file for reading and creates expanded lines with buffer of source file size.
     Reads source file line by line and uses functions from Preprocessor.h
     to determine line type:
-     - If empty or comment line will not be copied to target.
+     - If empty or comment line will not be copied to expanded lines.
      - If line is macro definition RegisterMacroInfo will be called.
-     - If line is a macro call (existing macro name) lines of macro body will be copied to target file.
-     - If line is something else it will be copied to target as it is.
-     SourceLineReference is used to write down order of source line numbers copied to target.
+     - If line is a macro call (existing macro name) lines of macro body will be copied to expanded lines.
+     - If line is something else it will be copied to expanded lines as it is.
+     SourceLineReference is used to write down order of source line numbers copied to expanded lines.
      RegisterMacroInfo and Expand macro will check for errors of macro definition and calls and
      errors will be saved to the errors list.
      Assumes that provided arguments are correct and does not check them. */
-void Preprocess(char* sourceFileName, Errors* errors) {
-    List* macros; /* List of all found macros. */
+Lines* Preprocess(char* sourceFileName, Errors* errors) {
+    Lines* expanded; /* Expanded source lines. */
+    HashMap* macros; /* Table of all found macros. */
     FILE* source; /* Source file handler. */
-    FILE* target; /* Expanded file handler. */
+    long size; /* Size of source file in characters. */
     char* fullFname; /* Buffer for holding full file name with extension. */
     int fullNameLen; /* Length of full file name with extension not counting termination character. */
     char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding line read from source file. */
     int line_num = 0; /* Number of line that is currently read from source file. (first line to be read will be 1) */
 
-    /* Initializing the list */
-    macros = CreateList();
+    /* Initializing the table */
+    macros = CreateHashMap(16);
 
-    /* Opening files. */
+    /* Opening source file. */
     fullNameLen = StringLen(sourceFileName) + 3;
-    fullFname = (char*)malloc(sizeof(char)*(fullNameLen+1));
-    if (fullFname == NULL) { 
-        perror("Failed to allocate memory.\n"); 
-        exit(1); }
-    /* Source file. */
+    fullFname = (char*)Allocate(sizeof(char)*(fullNameLen+1));
     AppendExtension(sourceFileName, "as", fullFname, fullNameLen);
     source = fopen(fullFname, "r"); /* Opening source file for reading. */
-    /* Target file. */
-    AppendExtension(sourceFileName, "am", fullFname, fullNameLen);
-    target = fopen(fullFname, "w"); /* Opening target file for writing*/
     /* Check. */
-    if (source == NULL || target == NULL) { 
+    if (source == NULL) { 
         perror("Failed to open file.\n"); 
         exit(2); 
     }
 
+    /* Expanded source is usually not much longer than the source,
+       so creating lines buffer of source file size. */
+    fseek(source, 0, SEEK_END);
+    size = ftell(source);
+    rewind(source);
+    expanded = CreateLines((int)size+1);
+    ReserveLineReferences(errors, (int)(size / EST_LINE_LEN));
+
     /* Reading source file line by line. */
     while (fgets(line, MAX_STATEMENT_LEN+2, source) != NULL) {
         line_num++;
@@ -538,22 +494,426 @@ void Preprocess(char* sourceFileName, Errors* errors) {
         /* Checking if line is a macro call. */
         if (IsLineMacroCall(line, macros)) {
             /* Expanding macro. */
-            ExpandMacro(&source, &target, ftell(source), line, line_num, macros, errors);
+            ExpandMacro(expanded, line, line_num, macros, errors);
             continue; /* Not copying this line*/
         }
 
         /* If line is not blank, not a comment, not a macro definition
            and not a macro call we copy it as it is. */
-        fputs(line, target);
+        AddLine(expanded, line);
         /* Saving reference to source file number. */
         AddLineReference(errors, line_num);
 
     } /* File reading cycle end */
 
-    /* Closing files. */
+    /* Closing source file. */
     fclose(source);
-    fclose(target);
+    AddStat(cnt_source_lines, line_num);
+
+    /* Macros table stays in arena and is released with it. */
+
+    return expanded;
+}
+
+
+/* Gets size of source file without reading it.
+   Arguments:
+    sourceFileName  -- Name of source file without extension.
+   Returns:
+    Size of source file in characters, -1 if file is not found. */
+long SourceFileSize(char* sourceFileName) {
+    char* fullFname; /* Buffer for holding full file name with extension. */
+    int fullNameLen; /* Length of full file name with extension not counting termination character. */
+    struct stat info; /* Source file info. */
+
+    fullNameLen = StringLen(sourceFileName) + 3;
+    fullFname = (char*)Allocate(sizeof(char)*(fullNameLen+1));
+    AppendExtension(sourceFileName, "as", fullFname, fullNameLen);
+    if (stat(fullFname, &info) != 0)
+        return -1;
+
+    return (long)info.st_size;
+}
+
+
+
+/* Reads source file to memory and splits it to lines.
+   Objects are allocated in current arena.
+   Arguments:
+    sourceFileName  -- Name of source file without extension.
+    source          -- Structure to fill (kinds of lines are not set).
+   Returns:
+    Size of source file in characters.
+   Algorithm:
+    Lines are found in two passes - first one counts lines and second one
+    saves their starts, so array of starts is allocated once.
+    Line ends after new line character, or after MAX_STATEMENT_LEN+1 characters,
+    same as line read by fgets() in Preprocess(). */
+long ReadSourceText(char* sourceFileName, SourceText* source) {
+    FILE* file; /* Source file handler. */
+    char* fullFname; /* Buffer for holding full file name with extension. */
+    int fullNameLen; /* Length of full file name with extension not counting termination character. */
+    long size; /* Size of source file in characters. */
+    long pos; /* Position in text. */
+    int count = 0; /* Number of lines. */
+    int pass; /* Pass number. */
+
+    /* Opening source file. */
+    fullNameLen = StringLen(sourceFileName) + 3;
+    fullFname = (char*)Allocate(sizeof(char)*(fullNameLen+1));
+    AppendExtension(sourceFileName, "as", fullFname, fullNameLen);
+    file = fopen(fullFname, "r");
+    if (file == NULL) {
+        perror("Failed to open file.\n");
+        exit(2);
+    }
+
+    /* Reading whole file. */
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    source->text = (char*)Allocate(sizeof(char)*(size+1));
+    size = (long)fread(source->text, sizeof(char), size, file);
+    fclose(file);
+
+    for (pass = 0; pass < 2; pass++) {
+        count = 0;
+        pos = 0;
+        while (pos < size) {
+            long len = size - pos; /* Length of line. */
+            char* nl; /* New line character of line. */
+            if (len > MAX_STATEMENT_LEN+1)
+                len = MAX_STATEMENT_LEN+1;
+            nl = (char*)memchr(source->text + pos, '\n', len);
+            if (nl != NULL)
+                len = nl - (source->text + pos) + 1;
+            if (pass == 1)
+                source->starts[count] = (int)pos;
+            count++;
+            pos += len;
+        }
+        if (pass == 0)
+            source->starts = (int*)Allocate(sizeof(int)*(count+1));
+    }
+    source->starts[count] = (int)size;
+    source->count = count;
+    source->kinds = (char*)Allocate(sizeof(char)*(count+1));
+
+    return size;
+}
+
+
+
+/* Copies line of source text to buffer (same content as read by fgets()).
+   Arguments:
+    source  -- Source text.
+    i       -- Index of line.
+    line    -- Buffer of MAX_STATEMENT_LEN+2 characters. */
+void GetSourceLine(SourceText* source, int i, char* line) {
+    int len = source->starts[i+1] - source->starts[i]; /* Length of line. */
+
+    memcpy(line, source->text + source->starts[i], len);
+    line[len] = '\0';
+}
+
+
+
+/* Sets kinds of chunk lines (first scan, thread function).
+   Arguments:
+    arg     -- Chunk (PreprocessChunk).
+   Returns:
+    NULL.
+   Algorithm:
+    Blank line, comment, macro definition and end have different first words,
+    so line has one kind and checks stop at first match. */
+void* ScanSourceChunk(void* arg) {
+    PreprocessChunk* chunk = (PreprocessChunk*)arg; /* Chunk to scan. */
+    SourceText* source = chunk->source; /* Source text. */
+    char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding line. */
+    int i; /* Lines iterator. */
+
+    UseThreadArena(chunk->arena);
+    UseThreadStats(&chunk->stats);
+
+    for (i = chunk->first; i < chunk->last; i++) {
+        char kind = 0; /* Kind of line. */
+        GetSourceLine(source, i, line);
+        if (IsLineBlank(line) || IsLineComment(line))
+            kind = sl_skip;
+        else if (IsLineMacroDef(line))
+            kind = sl_def;
+        else if (IsLineMacroDefEnd(line))
+            kind = sl_end;
+        source->kinds[i] = kind;
+    }
+
+    UseThreadArena(NULL);
+    UseThreadStats(NULL);
+    return NULL;
+}
+
+
+
+/* Registers macro definition of source text in macros table.
+   Lines of definition are marked as sl_macro.
+   Arguments:
+    source  -- Source text with kinds of lines.
+    def     -- Index of macro definition line.
+    macros  -- Macros table.
+    errors  -- Errors list.
+   Returns:
+    Index of line after macro closing tag, number of lines if macro is not closed.
+   Algorithm:
+    Same as GetMacroInfo() and RegisterMacroInfo(), but lines are taken from source text
+    and their kinds are already known. If source text ends before macro is closed
+    error is registered on definition line, and rest of lines is not expanded. */
+int ScanMacroInfo(SourceText* source, int def, HashMap* macros, Errors* errors) {
+    MacroInfo* info; /* Pointer for storing macro info. */
+    char def_line[MAX_STATEMENT_LEN+2]; /* Buffer for holding macro definition line. */
+    char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding current line. */
+    char word[MAX_STATEMENT_LEN+2]; /* Buffer for holding word read from line. */
+    int defLineNum = def+1; /* Number of macro definition line. */
+    int num_lines = 0; /* Number of lines in macro body. */
+    int open_tags = 1; /* Counter of opened macro tags.*/
+    int failed = 0; /* Flag that shows if errors were encountered. */
+    int pos = 0; /* Line iterator. */
+    int i = def; /* Lines iterator. */
+
+    /* Allocating info structure */
+    info = (MacroInfo*)Allocate(sizeof(MacroInfo));
+
+    /* Getting macro name */
+    GetSourceLine(source, def, def_line);
+    info->name = GetMacroName(def_line, defLineNum, errors);
+    if (info->name == NULL)
+        failed = 1;
+
+    info->body_line_num = defLineNum+1;
+    info->body = CreateLines(0);
+    info->body_lines = CreateDynArr(16);
+    source->kinds[def] |= sl_macro;
+
+    while (open_tags > 0) {
+        num_lines++;
+        i++;
+        if (i >= source->count) {
+            AddErrorManual(errors, defLineNum, ErrMacro_Unclosed, def_line, NULL);
+            return i;
+        }
+        GetSourceLine(source, i, line);
+        source->kinds[i] |= sl_macro;
+
+        /* Checking for nested macro definitions. */
+        if (source->kinds[i] & sl_def) {
+            AddErrorManual(errors, defLineNum+num_lines, ErrMacro_Nested, NULL, NULL);
+            open_tags++;
+            failed = 1;
+        }
+
+        /* Checking for definition end tag. */
+        if (source->kinds[i] & sl_end)
+            open_tags--;
+        /* Saving body line if it should be copied on expansion (not blank, or comment). */
+        else if (!(source->kinds[i] & sl_skip)) {
+            AddLine(info->body, line);
+            AddDynArr(info->body_lines, num_lines-1);
+        }
+    }
+
+    /* Uncounting final closing tag line. */
+    num_lines--;
+
+    /* Checking if closing tag line contains extra code. */
+    SkipBlank(line, &pos);
+    pos += 4;
+    if (GetNextWord(line, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
+        AddErrorManual(errors, defLineNum+num_lines+1, ErrMacro_ExtraDefEnd, line, NULL);
+
+    info->num_lines = num_lines;
+
+    /* Registering macro. */
+    if (!failed) {
+        if (FindMacroByName(macros, info->name) == NULL)
+            HashMapAdd(macros, info->name, info);
+        else
+            AddErrorManual(errors, defLineNum, ErrMacro_NameIdentical, def_line, info->name);
+    }
 
-    /* Freeing memory. */
-    FreeMacrosList(macros);
-}
\ No newline at end of file
+    return i+1;
+}
+
+
+
+/* Expands lines of chunk that are not macro definitions (second phase, thread function).
+   Arguments:
+    arg     -- Chunk (PreprocessChunk).
+   Returns:
+    NULL.
+   Algorithm:
+    Same as loop of Preprocess(), but macros are already registered, so line
+    is a macro call only if macro is defined before the line. */
+void* ExpandSourceChunk(void* arg) {
+    PreprocessChunk* chunk = (PreprocessChunk*)arg; /* Chunk to expand. */
+    SourceText* source = chunk->source; /* Source text. */
+    char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding line. */
+    char word[MAX_STATEMENT_LEN+2]; /* Buffer for holding first word of line. */
+    int i; /* Lines iterator. */
+
+    UseThreadArena(chunk->arena);
+    UseThreadStats(&chunk->stats);
+
+    chunk->expanded = CreateLines(source->starts[chunk->last] - source->starts[chunk->first] + 1);
+    chunk->errors = CreateErrors();
+
+    for (i = chunk->first; i < chunk->last; i++) {
+        MacroInfo* minfo = NULL; /* Called macro. */
+        int pos = 0; /* Position in line. */
+
+        /* Not copying blank lines, comments and macro definitions. */
+        if (source->kinds[i] & (sl_skip | sl_macro))
+            continue;
+
+        GetSourceLine(source, i, line);
+
+        /* Checking if line is a call of macro defined before it. */
+        if (GetNextWord(line, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
+            minfo = FindMacroByName(chunk->macros, word);
+        if (minfo != NULL && minfo->body_line_num-1 < i+1) {
+            ExpandMacro(chunk->expanded, line, i+1, chunk->macros, chunk->errors);
+            continue;
+        }
+
+        AddLine(chunk->expanded, line);
+        AddLineReference(chunk->errors, i+1);
+    }
+
+    UseThreadArena(NULL);
+    UseThreadStats(NULL);
+    return NULL;
+}
+
+
+
+/* Runs function for every chunk, each chunk in its own thread.
+   Last chunk is processed by calling thread, chunk is processed by it
+   too if thread can't be started.
+   Arguments:
+    chunks  -- Chunks.
+    n       -- Number of chunks (not more than MAX_WORKER_ARENAS).
+    work    -- Thread function. */
+void RunPreprocessChunks(PreprocessChunk* chunks, int n, void* (*work)(void*)) {
+    pthread_t ids[MAX_WORKER_ARENAS]; /* Threads of chunks. */
+    int started[MAX_WORKER_ARENAS];   /* 1 if thread of chunk is started. */
+    int i; /* Chunks iterator. */
+
+    for (i = 0; i < n; i++) {
+        started[i] = i < n-1 && pthread_create(&ids[i], NULL, work, &chunks[i]) == 0;
+        if (!started[i])
+            work(&chunks[i]);
+    }
+    for (i = 0; i < n; i++) {
+        if (started[i])
+            pthread_join(ids[i], NULL);
+    }
+}
+
+
+
+/* Same as Preprocess(), but lines are scanned and expanded by given number of threads.
+   Expanded lines, source line reference and errors are the same.
+   Small files are preprocessed by Preprocess().
+   Arguments:
+    sourceFileName      -- Name of source file without extension.
+    errors              -- List of errors. Source line reference is filled here.
+    threads             -- Maximum number of threads.
+   Returns:
+    Lines of expanded source allocated in current arena.
+   Algorithm:
+    Source file is read to memory and split to lines. Lines are divided to chunks.
+    First phase: every thread finds kinds of lines of its chunk (blank, comment,
+    macro definition and end). Then macro definitions are registered in order of lines
+    by calling thread (definition may cross chunks, errors of duplicate and nested
+    macros are the same as by Preprocess()). Macros table is read only after that.
+    Second phase: every thread expands its chunk to its own lines and source line
+    reference. Chunks are added to expanded lines in order.
+    Errors of macro definitions and calls are on different lines, so after errors are
+    sorted by line they are in the same order as by Preprocess().
+    Number of lines is estimated from file size before file is read, so small
+    file is read only by Preprocess(). */
+Lines* PreprocessParallel(char* sourceFileName, Errors* errors, int threads) {
+    SourceText source; /* Source file in memory. */
+    HashMap* macros; /* Table of all found macros. */
+    Lines* expanded; /* Expanded source lines. */
+    PreprocessChunk* chunks; /* Chunks of lines. */
+    long size; /* Size of source file in characters. */
+    int n = threads; /* Number of chunks. */
+    int num_expanded = 0; /* Number of expanded lines of all chunks. */
+    int i, j; /* Iterators. */
+
+    if (n > MAX_WORKER_ARENAS)
+        n = MAX_WORKER_ARENAS;
+#ifdef TRACK_ALLOC
+    /* Tracking table of allocations is not shared by threads. */
+    n = 1;
+#endif
+    if (n <= 1)
+        return Preprocess(sourceFileName, errors);
+
+    size = SourceFileSize(sourceFileName);
+    if (n > size / EST_LINE_LEN / MIN_PREPROCESS_CHUNK_LINES)
+        n = (int)(size / EST_LINE_LEN / MIN_PREPROCESS_CHUNK_LINES);
+    if (n <= 1)
+        return Preprocess(sourceFileName, errors);
+
+    size = ReadSourceText(sourceFileName, &source);
+
+    EnableThreadArenas();
+    EnableThreadStats();
+    ResetWorkerArenas();
+
+    chunks = (PreprocessChunk*)Allocate(sizeof(PreprocessChunk)*n);
+    memset(chunks, 0, sizeof(PreprocessChunk)*n);
+    for (i = 0; i < n; i++) {
+        chunks[i].source = &source;
+        chunks[i].first = (int)((long)source.count*i/n);
+        chunks[i].last = (int)((long)source.count*(i+1)/n);
+        chunks[i].arena = WorkerArena(i);
+    }
+
+    /* First phase - kinds of lines. */
+    RunPreprocessChunks(chunks, n, ScanSourceChunk);
+
+    /* Registering macros in order of definitions. */
+    macros = CreateHashMap(16);
+    i = 0;
+    while (i < source.count) {
+        if (!(source.kinds[i] & sl_skip) && (source.kinds[i] & sl_def))
+            i = ScanMacroInfo(&source, i, macros, errors);
+        else
+            i++;
+    }
+
+    /* Second phase - expanding chunks. */
+    for (i = 0; i < n; i++)
+        chunks[i].macros = macros;
+    RunPreprocessChunks(chunks, n, ExpandSourceChunk);
+
+    /* Joining chunks in order of lines. */
+    for (i = 0; i < n; i++)
+        num_expanded += LinesCount(chunks[i].expanded);
+    expanded = CreateLines((int)size+1);
+    ReserveDynArr(expanded->offsets, num_expanded);
+    ReserveLineReferences(errors, num_expanded);
+    for (i = 0; i < n; i++) {
+        MergeThreadStats(&chunks[i].stats);
+        AddLines(expanded, chunks[i].expanded);
+        /* First reference of errors list is of line 0. */
+        for (j = 1; j < chunks[i].errors->slr->count; j++)
+            AddLineReference(errors, (chunks[i].errors->slr->data)[j]);
+        MergeErrors(errors, chunks[i].errors);
+        FreeErrors(chunks[i].errors);
+    }
+    AddStat(cnt_source_lines, source.count);
+
+    return expanded;
+}
@@ -2,20 +2,59 @@
     #define PREPROCESSOR_H
 
 #include <stdio.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "Definitions.h"
 #include "Data.h"
 #include "DataContainers.h"
 #include "Errors.h"
 #include "Parsing.h"
+#include "Arena.h"
+#include "Stats.h"
 
-/* Searches macro in macros list by name.
+/* Minimal number of source lines preprocessed by one thread. Smaller files are preprocessed by one thread.
+   Number of lines is estimated from file size (see EST_LINE_LEN), so small file is not read twice. */
+#define MIN_PREPROCESS_CHUNK_LINES 4096
+
+/* Kinds of source lines found by first scan of parallel preprocessing (bit flags). */
+enum SourceLineKindsEnum {
+    sl_skip = 1,    /* Blank line, or comment. */
+    sl_def = 2,     /* Macro definition line. */
+    sl_end = 4,     /* Macro definition end line. */
+    sl_macro = 8    /* Line of macro definition (set when macro is registered). */
+};
+
+/* Source file in memory split to lines the same way as fgets() with buffer
+   of MAX_STATEMENT_LEN+2 characters reads them: line ends after new line character,
+   or after MAX_STATEMENT_LEN+1 characters, so numbers of lines are the same as by Preprocess(). */
+typedef struct SourceText {
+    char* text;   /* Content of source file. */
+    int* starts;  /* Position in text where every line starts, and end of text after last line. */
+    char* kinds;  /* Kind of every line (SourceLineKindsEnum flags). */
+    int count;    /* Number of lines. */
+} SourceText;
+
+/* Chunk of source lines preprocessed by one thread. */
+typedef struct PreprocessChunk {
+    SourceText* source; /* Source file (shared, kinds are written only by first scan). */
+    HashMap* macros;    /* Table of registered macros (shared, read only). */
+    int first;          /* Index of first line of the chunk. */
+    int last;           /* Index of line after the chunk. */
+    Arena* arena;       /* Arena of the thread. */
+    Stats stats;        /* Statistics of the thread. */
+    Lines* expanded;    /* Expanded lines of the chunk. */
+    Errors* errors;     /* Errors of the chunk, its source line reference is of expanded lines of the chunk. */
+} PreprocessChunk;
+
+/* Searches macro in macros table by name.
    Arguments:
-    macros  -- List of macros.
+    macros  -- Macros table (hash map by macro name).
     name    -- Name of a macro to find.
    Returns:
     MacroInfo with provided name.
     NULL if not found.*/
-MacroInfo* FindMacroByName(List* macros, char* name);
+MacroInfo* FindMacroByName(HashMap* macros, char* name);
 
 /* Checks if given line consists of blank characters (' ', '\t', '\n').
    Arguments:
@@ -54,15 +93,15 @@ int IsLineMacroDefEnd(char* line);
 /* Checks if given line is a macro call (macro name).
    Arguments:
     line    -- Source file line (terminated).
-    macros  -- List of macros.
+    macros  -- Macros table.
    Returns:
     0   -- If line is not a macro call.
     1   -- If line is a macro call. */
-int IsLineMacroCall(char* line, List* macros);
+int IsLineMacroCall(char* line, HashMap* macros);
 
 /* Gets macro name from macro definition line.
    Checks for macro definition line errors.
-   Returned name will be allocated on heap.
+   Returned name will be allocated in current arena.
    Assumes that line is macro definition line (first word is "macro")
    and does not check for that.
    Arguments:
@@ -75,6 +114,7 @@ int IsLineMacroCall(char* line, List* macros);
 char* GetMacroName(char* line, int defLineNum, Errors* errors);
 
 /* Gets macro info from source file.
+   Macro body lines that are not blank or comments are saved in info.
    Arguments:
     source      -- Pointer to source file handler.
     num_lines   -- Variable for returning number of macro lines.
@@ -86,48 +126,105 @@ char* GetMacroName(char* line, int defLineNum, Errors* errors);
     Writes number of lines in macro body to num_lines pointer even if getting info failed. */
 MacroInfo* GetMacroInfo(FILE** source, int* num_lines, char* defLine, int defLineNum, Errors* errors);
 
-/* Registers macro definition in list of macros.
+/* Registers macro definition in macros table.
    Will set source file position to the first character
    after macro closing tag line.
    Gives no indication if macro was failed to register.
    Arguments:
     source      -- Pointer to source file handler.
-    macros      -- Macros list.
+    macros      -- Macros table.
     def_line    -- Line (string) where macro name is defined.
     defLineNum  -- Number of line in source file where macro name is defined.
     errors      -- Errors list.
    Returns:
     Number of line in source file after macro closing tag.*/
-int RegisterMacroInfo(FILE** source, List* macros, char* defLine, int defLineNum, Errors* errors);
+int RegisterMacroInfo(FILE** source, HashMap* macros, char* defLine, int defLineNum, Errors* errors);
 
 /* Expands macro by name defined in callLine.
-   Copies macro body lines from source file to
-   current position in target (expanded) file.
+   Copies saved macro body lines to the end of expanded source lines.
    Arguments:
-    source      -- Pointer to source file hanler.
-    target      -- Pointer to target (expanded) file handler.
-    srcPos      -- Current position in source file (position after macro call line)
+    target      -- Expanded source lines.
     callLine    -- Line of macro call (first word is a macro name)
     callLineNum -- Number of a call line in source file.
-    macros      -- List of registered macros.
+    macros      -- Table of registered macros.
     errors      -- List of errors. */
-void ExpandMacro(FILE** source, FILE** target, long srcPos, char* callLine, int callLineNum, List* macros, Errors* errors);
-
-/* Frees memory occupied by macros list.
-   Removes macro info objects, 
-   list nodes and list structure itself.
-   Arguments:
-    macros  -- Macros list. */
-void FreeMacrosList(List* macros);
+void ExpandMacro(Lines* target, char* callLine, int callLineNum, HashMap* macros, Errors* errors);
 
 /* Executes pre-processing step on assembly source code file:
    Removes comments and blank lines and expands macros.
+   Expanded source is kept in memory, .am file is not written.
+   Arguments:
+    sourceFileName      -- Name of source file without extension.
+    errors              -- List of errors. Source line reference is filled here.
+   Returns:
+    Lines of expanded source allocated in current arena. */
+Lines* Preprocess(char* sourceFileName, Errors* errors);
+
+/* Gets size of source file without reading it.
+   Arguments:
+    sourceFileName  -- Name of source file without extension.
+   Returns:
+    Size of source file in characters, -1 if file is not found. */
+long SourceFileSize(char* sourceFileName);
+
+/* Reads source file to memory and splits it to lines.
+   Objects are allocated in current arena.
+   Arguments:
+    sourceFileName  -- Name of source file without extension.
+    source          -- Structure to fill (kinds of lines are not set).
+   Returns:
+    Size of source file in characters. */
+long ReadSourceText(char* sourceFileName, SourceText* source);
+
+/* Copies line of source text to buffer (same content as read by fgets()).
+   Arguments:
+    source  -- Source text.
+    i       -- Index of line.
+    line    -- Buffer of MAX_STATEMENT_LEN+2 characters. */
+void GetSourceLine(SourceText* source, int i, char* line);
+
+/* Sets kinds of chunk lines (first scan, thread function).
+   Arguments:
+    arg     -- Chunk (PreprocessChunk).
+   Returns:
+    NULL. */
+void* ScanSourceChunk(void* arg);
+
+/* Registers macro definition of source text in macros table.
+   Lines of definition are marked as sl_macro.
+   Arguments:
+    source  -- Source text with kinds of lines.
+    def     -- Index of macro definition line.
+    macros  -- Macros table.
+    errors  -- Errors list.
+   Returns:
+    Index of line after macro closing tag, number of lines if macro is not closed. */
+int ScanMacroInfo(SourceText* source, int def, HashMap* macros, Errors* errors);
+
+/* Runs function for every chunk, each chunk in its own thread.
+   Last chunk is processed by calling thread.
+   Arguments:
+    chunks  -- Chunks.
+    n       -- Number of chunks (not more than MAX_WORKER_ARENAS).
+    work    -- Thread function. */
+void RunPreprocessChunks(PreprocessChunk* chunks, int n, void* (*work)(void*));
+
+/* Expands lines of chunk that are not macro definitions (second phase, thread function).
+   Arguments:
+    arg     -- Chunk (PreprocessChunk).
+   Returns:
+    NULL. */
+void* ExpandSourceChunk(void* arg);
+
+/* Same as Preprocess(), but lines are scanned and expanded by given number of threads.
+   Expanded lines, source line reference and errors are the same.
+   Small files are preprocessed by Preprocess().
    Arguments:
     sourceFileName      -- Name of source file without extension.
-    SourceLineReference -- Array of source line references.
-    errors              -- List of errors.
+    errors              -- List of errors. Source line reference is filled here.
+    threads             -- Maximum number of threads.
    Returns:
-    Source line reference. */
-void Preprocess(char* sourceFileName, Errors* errors);
+    Lines of expanded source allocated in current arena. */
+Lines* PreprocessParallel(char* sourceFileName, Errors* errors, int threads);
 
 #endif
\ No newline at end of file
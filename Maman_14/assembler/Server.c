@@ -0,0 +1,1146 @@
+#include "Server.h"
+
+/* Expands heap array if it can't hold needed number of elements.
+   Arguments:
+    arr         -- Array (can be NULL).
+    capacity    -- Capacity of array in elements. Updated when array is expanded.
+    needed      -- Needed number of elements.
+    elemSize    -- Size of element in bytes.
+   Returns:
+    Array that can hold needed elements.
+   Algorithm:
+    Capacity is doubled until needed elements fit, so adding elements
+    one by one takes constant time on average. */
+void* ReserveArray(void* arr, int* capacity, int needed, size_t elemSize) {
+    int new_cap = *capacity > 0 ? *capacity : 16; /* New capacity. */
+
+    if (needed <= *capacity)
+        return arr;
+    while (new_cap < needed)
+        new_cap *= 2;
+    arr = TRACKED_REALLOC(arr, elemSize*(*capacity), elemSize*new_cap, site_server);
+    if (arr == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    *capacity = new_cap;
+    return arr;
+}
+
+/* Copies line to heap.
+   Arguments:
+    text    -- Null-terminated line.
+   Returns:
+    Copy of line allocated on heap. */
+char* CopyLineToHeap(char* text) {
+    int len = StringLen(text); /* Length of line. */
+    char* copy = (char*)TRACKED_MALLOC(sizeof(char)*(len+1), site_server); /* Copy of line. */
+    if (copy == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    memcpy(copy, text, len+1);
+    return copy;
+}
+
+/* Frees line copied by CopyLineToHeap().
+   Arguments:
+    text    -- Copy of line, or NULL. */
+void FreeLineOnHeap(char* text) {
+    if (text != NULL)
+        TRACKED_FREE(text, sizeof(char)*(StringLen(text)+1));
+}
+
+/* Adds statement to array of statements.
+   Arguments:
+    arr         -- Pointer to array.
+    count       -- Number of statements in array.
+    capacity    -- Capacity of array. */
+void AddStatementTo(Statement*** arr, int* count, int* capacity, Statement* stmt) {
+    *arr = (Statement**)ReserveArray(*arr, capacity, *count + 1, sizeof(Statement*));
+    (*arr)[*count] = stmt;
+    (*count)++;
+}
+
+/* Removes one occurrence of statement from array of statements.
+   Last statement takes place of removed one, order is not kept.
+   Arguments:
+    arr     -- Array.
+    count   -- Number of statements in array.
+    stmt    -- Statement to remove. */
+void RemoveStatementFrom(Statement** arr, int* count, Statement* stmt) {
+    int i; /* Statements iterator. */
+    for (i = 0; i < *count; i++) {
+        if (arr[i] == stmt) {
+            arr[i] = arr[*count - 1];
+            (*count)--;
+            return;
+        }
+    }
+}
+
+/* Makes states for every interned label.
+   Arguments:
+    session -- Session. */
+void EnsureLabelStates(Session* session) {
+    int needed = session->symbols->labels->count; /* Number of labels. */
+
+    session->labels = (LabelState*)ReserveArray(session->labels, &session->labels_capacity, needed, sizeof(LabelState));
+    if (session->num_labels < needed) {
+        memset(session->labels + session->num_labels, 0, sizeof(LabelState)*(needed - session->num_labels));
+        session->num_labels = needed;
+    }
+}
+
+/* Releases arrays of label states.
+   Arguments:
+    session -- Session. */
+void FreeLabelStates(Session* session) {
+    int id; /* Labels iterator. */
+    for (id = 0; id < session->num_labels; id++) {
+        TRACKED_FREE(session->labels[id].defs, sizeof(Statement*)*session->labels[id].defs_capacity);
+        TRACKED_FREE(session->labels[id].uses, sizeof(Statement*)*session->labels[id].uses_capacity);
+    }
+    session->num_labels = 0;
+    session->num_dirty = 0;
+}
+
+
+
+/* Creates empty session without open file.
+   Arguments:
+    session -- Session to initialize.
+    arena   -- Arena of session objects. It is reset when session is built. */
+void InitSession(Session* session, Arena* arena) {
+    memset(session, 0, sizeof(Session));
+    session->arena = arena;
+    session->code = CreateBinary();
+    session->data = CreateBinary();
+    session->data_base = PROGRAM_BASE;
+}
+
+
+
+/* Releases memory of session (except for arena).
+   Arguments:
+    session -- Session. */
+void FreeSession(Session* session) {
+    int i; /* Lines iterator. */
+
+    for (i = 0; i < session->num_lines; i++)
+        FreeLineOnHeap(session->lines[i].text);
+    TRACKED_FREE(session->lines, sizeof(SourceLine)*session->lines_capacity);
+    TRACKED_FREE(session->stmts, sizeof(Statement*)*session->stmts_capacity);
+    TRACKED_FREE(session->fresh, sizeof(Statement*)*session->fresh_capacity);
+    FreeLabelStates(session);
+    TRACKED_FREE(session->labels, sizeof(LabelState)*session->labels_capacity);
+    TRACKED_FREE(session->dirty, sizeof(int)*session->dirty_capacity);
+    FreeLineOnHeap(session->name);
+    if (session->kept != NULL)
+        FreeErrors(session->kept);
+    if (session->report != NULL)
+        FreeErrors(session->report);
+    FreeBinary(session->code);
+    FreeBinary(session->data);
+}
+
+
+
+/* Reads source file to session.
+   Arguments:
+    session -- Session.
+    name    -- Source file name without extension.
+   Returns:
+    1 if file is read, 0 if file can't be opened.
+   Algorithm:
+    Lines are read the same way as by Preprocess(), so session of
+    unchanged file has the same statements as assembled file. */
+int OpenSession(Session* session, char* name) {
+    char* fullFname; /* File name with extension. */
+    int fullNameLen = StringLen(name) + 3; /* Length of file name with extension. */
+    char line[MAX_STATEMENT_LEN+2]; /* Buffer for holding line read from source file. */
+    FILE* source; /* Source file handler. */
+    int i; /* Lines iterator. */
+
+    fullFname = (char*)Allocate(sizeof(char)*(fullNameLen+1));
+    AppendExtension(name, "as", fullFname, fullNameLen);
+    source = fopen(fullFname, "r");
+    if (source == NULL)
+        return 0;
+
+    /* Removing previous file. */
+    for (i = 0; i < session->num_lines; i++)
+        FreeLineOnHeap(session->lines[i].text);
+    session->num_lines = 0;
+    FreeLineOnHeap(session->name);
+    session->name = CopyLineToHeap(name);
+
+    /* Reading lines. */
+    while (fgets(line, MAX_STATEMENT_LEN+2, source) != NULL) {
+        session->lines = (SourceLine*)ReserveArray(session->lines, &session->lines_capacity, session->num_lines + 1, sizeof(SourceLine));
+        memset(&session->lines[session->num_lines], 0, sizeof(SourceLine));
+        session->lines[session->num_lines].text = CopyLineToHeap(line);
+        session->num_lines++;
+    }
+    fclose(source);
+
+    BuildSession(session);
+    return 1;
+}
+
+
+
+/* Expands and translates all source lines again.
+   Arguments:
+    session -- Session. Source lines are set.
+   Algorithm:
+    Arena is reset, so every statement, macro and interned label name is made again
+    and memory of replaced statements is released. Lines are expanded in order
+    the same way as by Preprocess(): macro definitions are registered and
+    calls are expanded only after definition. Then every label gets its symbol. */
+void BuildSession(Session* session) {
+    int i = 0; /* Lines iterator. */
+
+    FreeLabelStates(session);
+    ResetArena(session->arena);
+
+    /* Errors are kept with line numbers relative to their line, statement
+       errors are added with line 0 (line reference of current line is 0). */
+    if (session->kept != NULL)
+        FreeErrors(session->kept);
+    if (session->report != NULL)
+        FreeErrors(session->report);
+    session->kept = CreateErrors();
+    AddLineReference(session->kept, 0);
+    ChangeErrCurLine(session->kept, 1);
+    session->report = CreateErrors();
+
+    session->symbols = CreateSymbolsTable(64);
+    session->macros = CreateHashMap(16);
+    session->references = CreateReferences(16);
+    session->num_stmts = 0;
+    session->translated = 0;
+    session->live_errors = 0;
+    session->missing = 0;
+    session->undefined_entries = 0;
+
+    while (i < session->num_lines) {
+        SourceLine* line = &session->lines[i]; /* Current line. */
+        int n; /* Number of statements of line. */
+        int j; /* Statements iterator. */
+
+        line->first = session->num_stmts;
+        line->count = 0;
+        line->macro = NULL;
+        line->num_errors = 0;
+
+        if (IsLineMacroDef(line->text)) {
+            i = ScanMacro(session, i);
+            continue;
+        }
+
+        n = ExpandSourceLine(session, i);
+        session->stmts = (Statement**)ReserveArray(session->stmts, &session->stmts_capacity, session->num_stmts + n, sizeof(Statement*));
+        for (j = 0; j < n; j++) {
+            session->stmts[session->num_stmts] = session->fresh[j];
+            session->fresh[j]->index = session->num_stmts;
+            session->num_stmts++;
+            LinkStatement(session, session->fresh[j]);
+        }
+        line->count = n;
+        i++;
+    }
+
+    session->indexed = session->num_stmts;
+    RefreshSession(session, 0, session->num_stmts);
+}
+
+
+
+/* Checks if source line is part of macro definition, or changes macro definitions.
+   Changes of such lines cause session to be built again.
+   Arguments:
+    text    -- Text of line.
+   Returns:
+    1 if line is macro definition, or end of it, 0 otherwise. */
+int IsStructuralLine(char* text) {
+    return IsLineMacroDef(text) || IsLineMacroDefEnd(text);
+}
+
+
+
+/* Translates one statement.
+   Arguments:
+    session -- Session.
+    text    -- Statement line.
+   Returns:
+    New statement allocated in arena.
+   Algorithm:
+    Statement is translated by StatementToBinary() to empty segments with base 0,
+    so addresses of its label and label arguments are relative to the statement.
+    Words, label arguments and range of added errors are saved in statement. */
+Statement* TranslateStatement(Session* session, char* text) {
+    Statement* stmt = (Statement*)Allocate(sizeof(Statement)); /* New statement. */
+    int i; /* Label arguments iterator. */
+
+    session->code->counter = 0;
+    session->data->counter = 0;
+    session->references->count = 0;
+
+    stmt->first_error = session->kept->count;
+    stmt->symbol = StatementToBinary(text, session->symbols, session->references, session->code, session->data, session->kept);
+    stmt->num_errors = session->kept->count - stmt->first_error;
+
+    stmt->text = text;
+    stmt->index = -1;
+    stmt->code_address = -1;
+    stmt->data_offset = -1;
+    stmt->label = stmt->symbol != NULL ? stmt->symbol->id : -1;
+    stmt->symbol_error = -1;
+
+    /* Copying words. */
+    stmt->code_count = session->code->counter;
+    stmt->data_count = session->data->counter;
+    stmt->words = (int*)Allocate(sizeof(int)*(stmt->code_count + stmt->data_count + 1));
+    memcpy(stmt->words, session->code->words, sizeof(int)*stmt->code_count);
+    memcpy(stmt->words + stmt->code_count, session->data->words, sizeof(int)*stmt->data_count);
+
+    /* Copying label arguments. */
+    stmt->num_refs = session->references->count;
+    stmt->refs = (StatementRef*)Allocate(sizeof(StatementRef)*(stmt->num_refs + 1));
+    for (i = 0; i < stmt->num_refs; i++) {
+        LabelReference* ref = ReferenceAt(session->references, i); /* Label argument. */
+        stmt->refs[i].id = ref->id;
+        stmt->refs[i].offset = ref->address;
+        stmt->refs[i].found = 0;
+    }
+
+    session->translated++;
+    return stmt;
+}
+
+
+
+/* Reads macro definition and marks its lines.
+   Arguments:
+    session -- Session.
+    def     -- Index of macro definition line.
+   Returns:
+    Index of line after macro definition.
+   Algorithm:
+    Same as GetMacroInfo() and RegisterMacroInfo(), but lines are taken from session.
+    Errors of definition are kept with definition line, their line numbers are relative
+    to it. Definition that is not closed lasts until end of file, it is reported
+    and not registered. */
+int ScanMacro(Session* session, int def) {
+    SourceLine* def_line = &session->lines[def]; /* Macro definition line. */
+    MacroInfo* info = (MacroInfo*)Allocate(sizeof(MacroInfo)); /* Macro info. */
+    int open_tags = 1; /* Counter of opened macro tags. */
+    int failed = 0; /* Flag that shows if errors were encountered. */
+    int i = def; /* Lines iterator. */
+
+    def_line->kind = line_macro_def;
+    def_line->first_error = session->kept->count;
+
+    info->name = GetMacroName(def_line->text, 0, session->kept);
+    if (info->name == NULL)
+        failed = 1;
+    info->body_line_num = def + 2;
+    info->body = CreateLines(0);
+    info->body_lines = CreateDynArr(16);
+
+    while (open_tags > 0 && i+1 < session->num_lines) {
+        SourceLine* line; /* Current line. */
+        i++;
+        line = &session->lines[i];
+        line->kind = line_macro_body;
+        line->macro = NULL;
+        line->first = session->num_stmts;
+        line->count = 0;
+        line->num_errors = 0;
+
+        /* Checking for nested macro definitions. */
+        if (IsLineMacroDef(line->text)) {
+            AddErrorManual(session->kept, i - def, ErrMacro_Nested, NULL, NULL);
+            open_tags++;
+            failed = 1;
+        }
+
+        /* Checking for definition end tag. */
+        if (IsLineMacroDefEnd(line->text)) {
+            open_tags--;
+            /* Checking if closing tag line contains extra code. */
+            if (open_tags == 0) {
+                char word[MAX_STATEMENT_LEN+2]; /* Buffer for word after closing tag. */
+                int pos = 0; /* Position in line. */
+                SkipBlank(line->text, &pos);
+                pos += 4;
+                if (GetNextWord(line->text, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
+                    AddErrorManual(session->kept, i - def, ErrMacro_ExtraDefEnd, line->text, NULL);
+            }
+        }
+        /* Saving body line if it should be copied on expansion (not blank, or comment). */
+        else if (!IsLineBlank(line->text) && !IsLineComment(line->text)) {
+            AddLine(info->body, line->text);
+            AddDynArr(info->body_lines, i - def - 1);
+        }
+    }
+    info->num_lines = i - def - 1;
+
+    /* Checking if file ended before macro is closed. */
+    if (open_tags > 0) {
+        AddErrorManual(session->kept, 0, ErrMacro_Unclosed, def_line->text, NULL);
+        failed = 1;
+    }
+
+    /* Registering macro. */
+    if (!failed) {
+        if (FindMacroByName(session->macros, info->name) == NULL)
+            HashMapAdd(session->macros, info->name, info);
+        else
+            AddErrorManual(session->kept, 0, ErrMacro_NameIdentical, def_line->text, info->name);
+    }
+
+    def_line->num_errors = session->kept->count - def_line->first_error;
+    session->live_errors += def_line->num_errors;
+    return i + 1;
+}
+
+
+
+/* Determines kind of source line (not macro definition) and translates its statements.
+   Statements are written to fresh array of session.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+   Returns:
+    Number of statements.
+   Algorithm:
+    Blank and comment lines have no statements. Line is a macro call if its first word is a name
+    of macro defined before the line, then statements are lines of macro body. Other lines
+    are statements. Preprocessing errors of line are added before translation errors. */
+int ExpandSourceLine(Session* session, int i) {
+    SourceLine* line = &session->lines[i]; /* Source line. */
+    char word[MAX_STATEMENT_LEN+2]; /* Buffer for words of line. */
+    int pos = 0; /* Position in line. */
+    int n = 0; /* Number of statements. */
+
+    line->macro = NULL;
+    session->live_errors -= line->num_errors;
+    line->first_error = session->kept->count;
+
+    if (IsLineBlank(line->text) || IsLineComment(line->text))
+        line->kind = line_empty;
+    else {
+        /* Searching macro by first word. */
+        MacroInfo* macro = NULL; /* Called macro. */
+        if (GetNextWord(line->text, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
+            macro = FindMacroByName(session->macros, word);
+
+        if (macro != NULL && macro->body_line_num - 2 < i) {
+            line->kind = line_call;
+            line->macro = macro;
+            /* Checking if there is text after macro name. */
+            if (GetNextWord(line->text, &pos, word, MAX_STATEMENT_LEN+1, NULL) != NULL)
+                AddErrorManual(session->kept, 0, ErrMacro_ExtraCall, line->text, NULL);
+        }
+        else
+            line->kind = line_statement;
+    }
+    line->num_errors = session->kept->count - line->first_error;
+    session->live_errors += line->num_errors;
+
+    /* Translating statements. */
+    if (line->kind == line_statement) {
+        session->fresh = (Statement**)ReserveArray(session->fresh, &session->fresh_capacity, 1, sizeof(Statement*));
+        session->fresh[n++] = TranslateStatement(session, line->text);
+    }
+    else if (line->kind == line_call) {
+        int count = LinesCount(line->macro->body); /* Number of macro body lines. */
+        session->fresh = (Statement**)ReserveArray(session->fresh, &session->fresh_capacity, count, sizeof(Statement*));
+        for (n = 0; n < count; n++)
+            session->fresh[n] = TranslateStatement(session, GetLine(line->macro->body, n));
+    }
+
+    return n;
+}
+
+
+
+/* Adds statement to definitions and uses of its labels.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement. */
+void LinkStatement(Session* session, Statement* stmt) {
+    int i; /* Label arguments iterator. */
+
+    EnsureLabelStates(session);
+    session->live_errors += stmt->num_errors;
+    if (stmt->label != -1) {
+        LabelState* state = &session->labels[stmt->label]; /* State of defined label. */
+        AddStatementTo(&state->defs, &state->num_defs, &state->defs_capacity, stmt);
+        MarkDirty(session, stmt->label);
+    }
+    for (i = 0; i < stmt->num_refs; i++) {
+        LabelState* state = &session->labels[stmt->refs[i].id]; /* State of argument label. */
+        AddStatementTo(&state->uses, &state->num_uses, &state->uses_capacity, stmt);
+        session->missing += !stmt->refs[i].found;
+    }
+}
+
+
+
+/* Removes statement from definitions and uses of its labels.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement. */
+void UnlinkStatement(Session* session, Statement* stmt) {
+    int i; /* Label arguments iterator. */
+
+    session->live_errors -= stmt->num_errors;
+    if (stmt->symbol_error != -1) {
+        session->live_errors--;
+        stmt->symbol_error = -1;
+    }
+    if (stmt->label != -1) {
+        LabelState* state = &session->labels[stmt->label]; /* State of defined label. */
+        RemoveStatementFrom(state->defs, &state->num_defs, stmt);
+        MarkDirty(session, stmt->label);
+    }
+    for (i = 0; i < stmt->num_refs; i++) {
+        LabelState* state = &session->labels[stmt->refs[i].id]; /* State of argument label. */
+        RemoveStatementFrom(state->uses, &state->num_uses, stmt);
+        session->missing -= !stmt->refs[i].found;
+    }
+}
+
+
+
+/* Marks state of label as dirty.
+   Arguments:
+    session -- Session.
+    id      -- Id of label. */
+void MarkDirty(Session* session, int id) {
+    if (session->labels[id].dirty)
+        return;
+    session->labels[id].dirty = 1;
+    session->dirty = (int*)ReserveArray(session->dirty, &session->dirty_capacity, session->num_dirty + 1, sizeof(int));
+    session->dirty[session->num_dirty] = id;
+    session->num_dirty++;
+}
+
+
+
+/* Replaces statements of source line with fresh statements of session.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+    n       -- Number of fresh statements.
+   Algorithm:
+    Old statements are unlinked from their labels, following statements
+    are moved and new statements take their place. Numbers of moved
+    statements are not updated here (see IndexStatements()). */
+void SpliceStatements(Session* session, int i, int n) {
+    SourceLine* line = &session->lines[i]; /* Source line. */
+    int first = line->first; /* Number of first statement of line. */
+    int delta = n - line->count; /* Change of number of statements. */
+    int j; /* Iterator. */
+
+    for (j = first; j < first + line->count; j++)
+        UnlinkStatement(session, session->stmts[j]);
+
+    session->stmts = (Statement**)ReserveArray(session->stmts, &session->stmts_capacity, session->num_stmts + delta, sizeof(Statement*));
+    memmove(session->stmts + first + n, session->stmts + first + line->count,
+            sizeof(Statement*)*(session->num_stmts - first - line->count));
+    memcpy(session->stmts + first, session->fresh, sizeof(Statement*)*n);
+    session->num_stmts += delta;
+    line->count = n;
+
+    /* Numbers of following statements are changed, they are set again when needed. */
+    if (delta != 0) {
+        for (j = i+1; j < session->num_lines; j++)
+            session->lines[j].first += delta;
+        if (session->indexed > first)
+            session->indexed = first;
+    }
+
+    for (j = first; j < first + n; j++) {
+        session->stmts[j]->index = j;
+        LinkStatement(session, session->stmts[j]);
+    }
+
+    RefreshSession(session, first, n);
+}
+
+
+
+/* Updates symbols and label arguments after statements were replaced.
+   Arguments:
+    session -- Session.
+    from    -- Number of first replaced statement.
+    n       -- Number of new statements.
+   Algorithm:
+    Diagnostics don't depend on addresses, so addresses are calculated only
+    when files are written (see PlaceStatements()). Symbols of dirty labels are made
+    again and only arguments of labels that got, or lost symbol are resolved,
+    with arguments of new statements. So edit takes time of changed statements
+    and uses of their labels, not of whole source. */
+void RefreshSession(Session* session, int from, int n) {
+    int k; /* Iterator. */
+
+    /* Making symbols of dirty labels. */
+    for (k = 0; k < session->num_dirty; k++) {
+        int id = session->dirty[k]; /* Id of label. */
+        if (MakeLabelSymbol(session, id)) {
+            LabelState* state = &session->labels[id]; /* State of label. */
+            int u; /* Uses iterator. */
+            for (u = 0; u < state->num_uses; u++) {
+                Statement* stmt = state->uses[u]; /* Statement with label argument. */
+                int r; /* Label arguments iterator. */
+                for (r = 0; r < stmt->num_refs; r++) {
+                    if (stmt->refs[r].id == id)
+                        ResolveArgument(session, stmt, &stmt->refs[r]);
+                }
+            }
+        }
+    }
+    session->num_dirty = 0;
+
+    /* Resolving arguments of new statements. */
+    for (k = from; k < from + n; k++) {
+        Statement* stmt = session->stmts[k]; /* New statement. */
+        int r; /* Label arguments iterator. */
+        for (r = 0; r < stmt->num_refs; r++)
+            ResolveArgument(session, stmt, &stmt->refs[r]);
+    }
+}
+
+
+
+/* Sets numbers of statements that were moved since they were numbered.
+   Arguments:
+    session -- Session. */
+void IndexStatements(Session* session) {
+    int k; /* Statements iterator. */
+    for (k = session->indexed; k < session->num_stmts; k++)
+        session->stmts[k]->index = k;
+    session->indexed = session->num_stmts;
+}
+
+
+
+/* Calculates addresses of statements, makes symbols of labels with
+   their addresses and resolves all label arguments.
+   Arguments:
+    session -- Session.
+   Algorithm:
+    Addresses are prefix sums of code and data sizes of statements,
+    data segment follows code segment. Every label symbol is made
+    again with addresses and words of all arguments are written. */
+void PlaceStatements(Session* session) {
+    int code = PROGRAM_BASE; /* Address of next code word. */
+    int data = 0; /* Offset of next data word. */
+    int k, r; /* Statements and label arguments iterators. */
+
+    for (k = 0; k < session->num_stmts; k++) {
+        Statement* stmt = session->stmts[k]; /* Statement. */
+        stmt->index = k;
+        stmt->code_address = code;
+        stmt->data_offset = data;
+        code += stmt->code_count;
+        data += stmt->data_count;
+    }
+    session->indexed = session->num_stmts;
+    session->data_base = code;
+
+    for (k = 0; k < session->num_labels; k++)
+        MakeLabelSymbol(session, k);
+    for (k = 0; k < session->num_stmts; k++) {
+        Statement* stmt = session->stmts[k]; /* Statement. */
+        for (r = 0; r < stmt->num_refs; r++)
+            ResolveArgument(session, stmt, &stmt->refs[r]);
+    }
+}
+
+
+
+/* Makes symbol of label from its definitions.
+   Arguments:
+    session -- Session.
+    id      -- Id of label.
+   Returns:
+    1 if label got, or lost symbol, 0 otherwise.
+   Algorithm:
+    Definitions are sorted by order of statements and merged as by AddSymbol():
+    first definition makes symbol and next ones are merged to it by MergeSymbol().
+    Error of rejected definition is saved in its statement. Address of symbol
+    is correct only after statements are placed (see PlaceStatements()). */
+int MakeLabelSymbol(Session* session, int id) {
+    LabelState* state = &session->labels[id]; /* State of label. */
+    Symbol old = state->symbol; /* Previous symbol. */
+    int was_defined = state->defined; /* 1 if label had symbol. */
+    int i, j; /* Definitions iterators. */
+
+    /* Sorting definitions by insertion, label usually has one, or two definitions. */
+    if (state->num_defs > 1)
+        IndexStatements(session);
+    for (i = 1; i < state->num_defs; i++) {
+        Statement* def = state->defs[i]; /* Definition being placed. */
+        for (j = i-1; j >= 0 && state->defs[j]->index > def->index; j--)
+            state->defs[j+1] = state->defs[j];
+        state->defs[j+1] = def;
+    }
+
+    if (state->defined && IsEntry(&old) && !IsCode(&old) && !IsData(&old))
+        session->undefined_entries--;
+    state->defined = 0;
+    state->first = NULL;
+    state->dirty = 0;
+    for (i = 0; i < state->num_defs; i++) {
+        Statement* def = state->defs[i]; /* Definition. */
+        Symbol smb = *(def->symbol); /* Symbol of definition with its address. */
+        if (IsCode(&smb))
+            smb.adress = def->code_address;
+        else if (IsData(&smb))
+            smb.adress = session->data_base + def->data_offset;
+
+        session->live_errors -= def->symbol_error != -1;
+        def->symbol_error = -1;
+        if (!state->defined) {
+            state->symbol = smb;
+            state->defined = 1;
+            state->first = def;
+        }
+        else {
+            def->symbol_error = MergeSymbol(&state->symbol, &smb);
+            session->live_errors += def->symbol_error != -1;
+        }
+    }
+    if (state->defined && IsEntry(&state->symbol) && !IsCode(&state->symbol) && !IsData(&state->symbol))
+        session->undefined_entries++;
+
+    return state->defined != was_defined;
+}
+
+
+
+/* Writes words of label argument.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement.
+    ref     -- Label argument of the statement. */
+void ResolveArgument(Session* session, Statement* stmt, StatementRef* ref) {
+    LabelState* state = &session->labels[ref->id]; /* State of label. */
+    int words[2]; /* Base and offset words. */
+
+    session->missing += ref->found - state->defined;
+    ref->found = state->defined;
+    if (state->defined)
+        SymbolToWords(&state->symbol, words);
+    else {
+        words[0] = 0;
+        words[1] = 0;
+    }
+    stmt->words[ref->offset] = words[0];
+    stmt->words[ref->offset+1] = words[1];
+}
+
+
+
+/* Changes line numbers of macros defined after given line.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+    delta   -- Change of line numbers. */
+void MoveMacros(Session* session, int i, int delta) {
+    int k; /* Macros iterator. */
+    for (k = 0; k < session->macros->count; k++) {
+        MacroInfo* macro = (MacroInfo*)HashMapValueAt(session->macros, k); /* Macro. */
+        if (macro->body_line_num - 2 >= i)
+            macro->body_line_num += delta;
+    }
+}
+
+
+
+/* Replaces, inserts or deletes source line.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+    text    -- New text (NULL to delete line).
+    insert  -- 1 if line is inserted before line i.
+   Algorithm:
+    Changes inside of macro definitions, or lines that start or end definitions
+    change expansion of every call, so session is built again. Otherwise only
+    statements of the line are translated and spliced into statements. Session is
+    also built again when replaced statements take too much of arena. */
+void EditSession(Session* session, int i, char* text, int insert) {
+    int structural; /* 1 if edit changes macro definitions. */
+
+    if (text == NULL)
+        structural = session->lines[i].kind == line_macro_def || session->lines[i].kind == line_macro_body;
+    else if (insert)
+        structural = IsStructuralLine(text) || (i < session->num_lines && session->lines[i].kind == line_macro_body);
+    else
+        structural = IsStructuralLine(text) || session->lines[i].kind == line_macro_def || session->lines[i].kind == line_macro_body;
+
+    if (text == NULL) {
+        /* Removing statements of line, then the line. */
+        if (!structural)
+            SpliceStatements(session, i, 0);
+        session->live_errors -= session->lines[i].num_errors;
+        FreeLineOnHeap(session->lines[i].text);
+        memmove(session->lines + i, session->lines + i + 1, sizeof(SourceLine)*(session->num_lines - i - 1));
+        session->num_lines--;
+        if (!structural)
+            MoveMacros(session, i, -1);
+    }
+    else if (insert) {
+        int first = i < session->num_lines ? session->lines[i].first : session->num_stmts; /* Statements position. */
+        session->lines = (SourceLine*)ReserveArray(session->lines, &session->lines_capacity, session->num_lines + 1, sizeof(SourceLine));
+        memmove(session->lines + i + 1, session->lines + i, sizeof(SourceLine)*(session->num_lines - i));
+        session->num_lines++;
+        memset(&session->lines[i], 0, sizeof(SourceLine));
+        session->lines[i].text = CopyLineToHeap(text);
+        session->lines[i].first = first;
+        if (!structural) {
+            MoveMacros(session, i, 1);
+            SpliceStatements(session, i, ExpandSourceLine(session, i));
+        }
+    }
+    else {
+        FreeLineOnHeap(session->lines[i].text);
+        session->lines[i].text = CopyLineToHeap(text);
+        if (!structural)
+            SpliceStatements(session, i, ExpandSourceLine(session, i));
+    }
+
+    if (structural || session->translated > SERVER_GARBAGE_FACTOR*session->num_stmts + SERVER_MIN_GARBAGE)
+        BuildSession(session);
+}
+
+
+
+/* Adds kept errors to report.
+   Arguments:
+    session -- Session.
+    first   -- Number of first error in kept errors.
+    count   -- Number of errors.
+    lineNum -- Number of line that errors belong to. */
+void ReportKeptErrors(Session* session, int first, int count, int lineNum) {
+    int i; /* Errors iterator. */
+    for (i = first; i < first + count; i++) {
+        Error* er = &session->kept->list[i]; /* Kept error. */
+        AddErrorManual(session->report, lineNum + er->source_line_num, er->error_code,
+                       session->kept->strings + er->source, session->kept->strings + er->info);
+    }
+}
+
+/* Returns number of source line of statement.
+   Arguments:
+    session -- Session.
+    i       -- Index of source line of the statement.
+    j       -- Number of the statement in source line.
+   Returns:
+    Number of line, for statements of macro call - line in macro body. */
+int StatementLineNum(Session* session, int i, int j) {
+    SourceLine* line = &session->lines[i]; /* Source line. */
+    if (line->kind == line_call)
+        return line->macro->body_line_num + line->macro->body_lines->data[j];
+    return i + 1;
+}
+
+
+
+/* Collects diagnostics of session to report errors list (sorted by line).
+   Arguments:
+    session -- Session.
+   Algorithm:
+    Errors are added in the same order as assembler adds them: preprocessing,
+    translation and label definition errors of lines, then arguments of labels that are
+    not found, then entries without definition. Stable sort by line gives the same list.
+    Session counts these diagnostics while it changes, so nothing is walked when there are none. */
+void ReportSession(Session* session) {
+    int i, j, r; /* Lines, statements and arguments iterators. */
+
+    session->report->count = 0;
+    session->report->strings_size = 1;
+
+    /* Counters show which passes have anything to report, so file without errors is not walked. */
+    if (session->live_errors > 0) {
+        for (i = 0; i < session->num_lines; i++) {
+            SourceLine* line = &session->lines[i]; /* Source line. */
+            if (line->num_errors > 0)
+                ReportKeptErrors(session, line->first_error, line->num_errors, i+1);
+            for (j = 0; j < line->count; j++) {
+                Statement* stmt = session->stmts[line->first + j]; /* Statement. */
+                if (stmt->num_errors > 0)
+                    ReportKeptErrors(session, stmt->first_error, stmt->num_errors, StatementLineNum(session, i, j));
+                if (stmt->symbol_error != -1)
+                    AddErrorManual(session->report, StatementLineNum(session, i, j), stmt->symbol_error, stmt->symbol->name, NULL);
+            }
+        }
+    }
+
+    if (session->missing > 0) {
+        for (i = 0; i < session->num_lines; i++) {
+            SourceLine* line = &session->lines[i]; /* Source line. */
+            for (j = 0; j < line->count; j++) {
+                Statement* stmt = session->stmts[line->first + j]; /* Statement. */
+                for (r = 0; r < stmt->num_refs; r++) {
+                    if (!stmt->refs[r].found)
+                        AddErrorManual(session->report, StatementLineNum(session, i, j), ErrSmb_NotFound,
+                                       LabelName(session->symbols, stmt->refs[r].id), NULL);
+                }
+            }
+        }
+    }
+
+    if (session->undefined_entries > 0) {
+        for (i = 0; i < session->num_stmts; i++) {
+            Statement* stmt = session->stmts[i]; /* Statement. */
+            if (stmt->label != -1) {
+                LabelState* state = &session->labels[stmt->label]; /* State of defined label. */
+                Symbol* smb = &state->symbol; /* Symbol of label. */
+                if (state->first == stmt && IsEntry(smb) && !IsCode(smb) && !IsData(smb))
+                    AddErrorManual(session->report, 0, ErrSmb_EntryUndefined, smb->name, NULL);
+            }
+        }
+    }
+
+    SortErrors(session->report);
+}
+
+
+
+/* Writes object, entries and externals files of session.
+   Assumes that session has no errors.
+   Arguments:
+    session     -- Session.
+    writeObj    -- 1 if binary object .obj file should be written too.
+   Algorithm:
+    Segments are made of resolved words of statements. Symbols table and
+    references for output functions are made in arena the same way
+    as ProduceInitialBinary() makes them. */
+void WriteSession(Session* session, int writeObj) {
+    BinarySegment* code = CreateBinary(); /* Code segment. */
+    BinarySegment* data = CreateBinary(); /* Data segment. */
+    SymbolsTable* symbols = CreateSymbolsTable(session->symbols->labels->count); /* Symbols of output. */
+    Vector* references = CreateReferences(64); /* Label arguments of output. */
+    int i, r; /* Iterators. */
+
+    PlaceStatements(session);
+
+    /* Interning labels in the same order keeps their ids. */
+    for (i = 0; i < session->symbols->labels->count; i++)
+        InternLabel(symbols, LabelName(session->symbols, i));
+
+    code->base = PROGRAM_BASE;
+    for (i = 0; i < session->num_stmts; i++) {
+        Statement* stmt = session->stmts[i]; /* Statement. */
+        for (r = 0; r < stmt->code_count; r++)
+            AddBinary(code, stmt->words[r]);
+        for (r = 0; r < stmt->data_count; r++)
+            AddBinary(data, stmt->words[stmt->code_count + r]);
+        if (stmt->symbol != NULL) {
+            Symbol* smb = CreateSymbol(symbols, stmt->symbol->name, 0, att_entry); /* Symbol of output. */
+            smb->attributes = stmt->symbol->attributes;
+            smb->adress = IsCode(smb) ? stmt->code_address : (IsData(smb) ? stmt->data_offset : 0);
+            AddSymbol(symbols, smb, session->report);
+        }
+        for (r = 0; r < stmt->num_refs; r++)
+            AddLabelReference(references, stmt->refs[r].id, stmt->code_address + stmt->refs[r].offset, 0);
+    }
+
+    /* Moving data segment and data symbols to address after instructions segment. */
+    data->base = NextSegmentAddress(code);
+    for (i = 0; i < SymbolsCount(symbols); i++) {
+        Symbol* smb = SymbolAt(symbols, i);
+        if (IsData(smb))
+            smb->adress += data->base;
+    }
+
+    printf("Writing object file [ %s.ob ]\n", session->name);
+    WriteBinaryToObject(session->name, code, data);
+    printf("Writing entries file [ %s.ent ]\n", session->name);
+    WriteEntries(session->name, symbols);
+    printf("Writing externals file [ %s.ext ]\n", session->name);
+    WriteExterns(session->name, symbols, references);
+    if (writeObj) {
+        printf("Writing binary object file [ %s.obj ]\n", session->name);
+        WriteBinaryObjectFile(session->name, code, data, symbols, references);
+    }
+
+    FreeBinary(code);
+    FreeBinary(data);
+    /* Output symbols stay in arena until session is built again. */
+    session->translated += session->num_stmts;
+}
+
+
+
+/* Writes diagnostics of report as answer to command.
+   Arguments:
+    session -- Session.
+    reply   -- Output of answers. */
+void PrintReport(Session* session, FILE* reply) {
+    char text[MAX_ERROR_MSG_LEN]; /* Message of error. */
+    int i; /* Errors iterator. */
+
+    fprintf(reply, "ok %d\n", session->report->count);
+    for (i = 0; i < session->report->count; i++) {
+        Error* er = &session->report->list[i]; /* Error. */
+        int len = FormatError(session->report, er, text); /* Length of message. */
+        int pos = 0; /* Position of message after leading blank. */
+        if (text[pos] == ' ')
+            pos++;
+        fprintf(reply, "%d %d ", er->source_line_num, er->error_code);
+        fwrite(text + pos, 1, len - pos, reply);
+    }
+}
+
+/* Reads number of line from command.
+   Arguments:
+    command -- Command line.
+    pos     -- Position in command, moved after the number and one space after it.
+    max     -- Maximum allowed number.
+   Returns:
+    Index of line (number - 1), or -1 if number is illegal. */
+int ReadLineNumber(char* command, int* pos, int max) {
+    int num = 0; /* Line number. */
+
+    if (command[*pos] == ' ')
+        (*pos)++;
+    if (!IsDigit(command[*pos]))
+        return -1;
+    while (IsDigit(command[*pos]) && num <= max) {
+        num = num*10 + (command[*pos] - '0');
+        (*pos)++;
+    }
+    if (num < 1 || num > max)
+        return -1;
+    if (command[*pos] == ' ')
+        (*pos)++;
+    else if (command[*pos] != '\n')
+        return -1;
+    return num - 1;
+}
+
+/* Runs one command of server.
+   Arguments:
+    session     -- Session.
+    command     -- Command line ending with new line character.
+    reply       -- Output of answers.
+    writeObj    -- 1 if binary object .obj file should be written with write command.
+   Returns:
+    0 if server should stop, 1 otherwise. */
+int RunCommand(Session* session, char* command, FILE* reply, int writeObj) {
+    char word[16]; /* Command name. */
+    int pos = 0; /* Position in command. */
+    int i = 0; /* Index of line. */
+
+    if (GetNextWord(command, &pos, word, 15, NULL) == NULL) {
+        fprintf(reply, "error Empty command.\n");
+        return 1;
+    }
+    ReplaceNewLine(word, '\0');
+
+    if (CompareStrings(word, "quit"))
+        return 0;
+
+    if (CompareStrings(word, "open")) {
+        char* name; /* File name. */
+        SkipBlank(command, &pos);
+        name = command + pos;
+        ReplaceNewLine(name, '\0');
+        if (name[0] == '\0') {
+            fprintf(reply, "error File name is missing.\n");
+            return 1;
+        }
+        if (!OpenSession(session, name)) {
+            fprintf(reply, "error Failed to open file [ %s.as ].\n", name);
+            return 1;
+        }
+    }
+    else if (session->name == NULL) {
+        fprintf(reply, "error No file is open.\n");
+        return 1;
+    }
+    else if (CompareStrings(word, "replace") || CompareStrings(word, "delete")) {
+        i = ReadLineNumber(command, &pos, session->num_lines);
+        if (i == -1) {
+            fprintf(reply, "error Illegal line number.\n");
+            return 1;
+        }
+        EditSession(session, i, word[0] == 'r' ? command + pos : NULL, 0);
+    }
+    else if (CompareStrings(word, "insert")) {
+        i = ReadLineNumber(command, &pos, session->num_lines + 1);
+        if (i == -1) {
+            fprintf(reply, "error Illegal line number.\n");
+            return 1;
+        }
+        EditSession(session, i, command + pos, 1);
+    }
+    else if (!CompareStrings(word, "check") && !CompareStrings(word, "write")) {
+        fprintf(reply, "error Unknown command [ %s ].\n", word);
+        return 1;
+    }
+
+    ReportSession(session);
+    if (CompareStrings(word, "write") && session->report->count == 0)
+        WriteSession(session, writeObj);
+    PrintReport(session, reply);
+    return 1;
+}
+
+
+
+/* Reads commands from standard input and answers them until quit command, or end of input.
+   Arguments:
+    arena       -- Arena for session objects.
+    writeObj    -- 1 if binary object .obj file should be written with write command.
+   Algorithm:
+    Answers are written to original standard output and standard output is
+    redirected to standard error, so messages printed while assembling
+    don't mix with answers. */
+void RunServer(Arena* arena, int writeObj) {
+    Session session; /* Session of open file. */
+    char command[SERVER_MAX_COMMAND_LEN+3]; /* Command line. */
+    FILE* reply; /* Output of answers. */
+
+    fflush(stdout);
+    reply = fdopen(dup(STDOUT_FILENO), "w");
+    if (reply == NULL) {
+        perror("Failed to open server output.");
+        exit(2);
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    InitSession(&session, arena);
+    while (fgets(command, SERVER_MAX_COMMAND_LEN+2, stdin) != NULL) {
+        int len = StringLen(command); /* Length of command. */
+
+        if (command[len-1] != '\n') {
+            /* Skipping rest of too long command. */
+            if (len > SERVER_MAX_COMMAND_LEN) {
+                int c; /* Skipped character. */
+                while ((c = getchar()) != EOF && c != '\n')
+                    ;
+                fprintf(reply, "error Command is longer than %d characters.\n", SERVER_MAX_COMMAND_LEN);
+                fflush(reply);
+                continue;
+            }
+            /* Last line of input without new line character. */
+            command[len] = '\n';
+            command[len+1] = '\0';
+        }
+
+        if (!RunCommand(&session, command, reply, writeObj))
+            break;
+        fflush(reply);
+    }
+
+    FreeSession(&session);
+    fclose(reply);
+}
@@ -0,0 +1,284 @@
+#ifndef SERVER_H
+    #define SERVER_H
+
+#include <stdio.h>
+#include <unistd.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Data.h"
+#include "DataContainers.h"
+#include "Symbols.h"
+#include "Errors.h"
+#include "Preprocessor.h"
+#include "Binary.h"
+#include "Output.h"
+#include "Object.h"
+
+/* Maximum length of server command line. */
+#define SERVER_MAX_COMMAND_LEN 1024
+/* Session is built again when number of statements translated since last build
+   is more than SERVER_GARBAGE_FACTOR times number of statements plus SERVER_MIN_GARBAGE.
+   Replaced statements stay in arena until then. */
+#define SERVER_GARBAGE_FACTOR 4
+#define SERVER_MIN_GARBAGE 4096
+
+/* Incremental assembler server (--server).
+   Source file is kept in memory with its expanded and translated statements,
+   symbols and label arguments, and is changed by line edits read from standard input.
+   Only changed statements are translated again and only arguments of labels that got,
+   or lost symbol are resolved again. Diagnostics don't depend on addresses, so addresses
+   are calculated (as prefix sums of statement sizes) only when files are written.
+
+   Protocol. Every command is one line of standard input:
+    open NAME        -- Opens source file NAME.as (name without extension).
+    replace N TEXT   -- Replaces line N (from 1) of source with TEXT.
+    insert N TEXT    -- Inserts TEXT before line N (N can be number of lines + 1).
+    delete N         -- Deletes line N.
+    check            -- Only gives diagnostics.
+    write            -- Writes .ob, .ent, .ext (and .obj with --obj) files if there are no errors.
+    quit             -- Ends the server (same as end of input).
+   Answer to every command is written to standard output:
+    ok K             -- Command is done, K diagnostics follow, one per line:
+    LINE CODE TEXT   -- Source line number (0 if error is not of a line), code according to
+                        ErrorsEnum and the same message as printed by assembler.
+    error TEXT       -- Command is not done, explanation follows.
+   Other messages (warnings, written files) are printed to standard error. */
+
+/* Kinds of source lines. */
+enum LineKindsEnum {
+    line_empty,       /* Blank, or comment line. */
+    line_statement,   /* Instruction, or directive. */
+    line_call,        /* Macro call. */
+    line_macro_def,   /* First line of macro definition. */
+    line_macro_body   /* Other lines of macro definition (body and endm line). */
+};
+
+/* Label argument of translated statement. */
+typedef struct StatementRef {
+    int id;         /* Id of label. */
+    int offset;     /* Offset of base word in words of statement. */
+    int found;      /* 1 if label has symbol. */
+} StatementRef;
+
+/* Statement of expanded source with its translation.
+   Translation doesn't depend on position of statement,
+   so it is kept while the source line is not changed. */
+typedef struct Statement {
+    char* text;         /* Statement line (source line, or line of macro body). */
+    int index;          /* Number of statement in expanded source (from 0), correct if less than indexed of session. */
+    int* words;         /* Code, or data words. Words of label arguments are set when they are resolved. */
+    int code_count;     /* Number of code words. */
+    int data_count;     /* Number of data words. */
+    int code_address;   /* Address of first code word (set when statements are placed). */
+    int data_offset;    /* Offset of first data word from data base (set when statements are placed). */
+    Symbol* symbol;     /* Label defined by statement with address relative to statement, NULL if none. */
+    int label;          /* Id of defined label, -1 if none. */
+    int symbol_error;   /* Error of label definition according to ErrorsEnum, -1 if definition is correct. */
+    StatementRef* refs; /* Label arguments. */
+    int num_refs;       /* Number of label arguments. */
+    int first_error;    /* Number of first translation error in kept errors of session. */
+    int num_errors;     /* Number of translation errors. */
+} Statement;
+
+/* Line of source file. */
+typedef struct SourceLine {
+    char* text;         /* Line with new line character, allocated on heap. */
+    int kind;           /* Kind of line according to LineKindsEnum. */
+    MacroInfo* macro;   /* Called macro of macro call line. */
+    int first;          /* Number of first statement of the line in expanded source. */
+    int count;          /* Number of statements of the line. */
+    int first_error;    /* Number of first preprocessing error in kept errors of session.
+                           Line numbers of these errors are relative to this line. */
+    int num_errors;     /* Number of preprocessing errors. */
+} SourceLine;
+
+/* Symbol of a label made of its definitions. */
+typedef struct LabelState {
+    Statement** defs;   /* Statements that define the label (label before statement, .entry, .extern). */
+    int num_defs;       /* Number of definitions. */
+    int defs_capacity;  /* Capacity of defs array. */
+    Statement** uses;   /* Statements with the label as argument (once for every argument). */
+    int num_uses;       /* Number of uses. */
+    int uses_capacity;  /* Capacity of uses array. */
+    Symbol symbol;      /* Symbol of the label (valid if defined). */
+    int defined;        /* 1 if label has symbol. */
+    Statement* first;   /* Statement of first definition. */
+    int dirty;          /* 1 if definitions, or their addresses were changed. */
+} LabelState;
+
+/* Source file kept by server. */
+typedef struct Session {
+    char* name;             /* Source file name without extension, NULL if no file is open. */
+    SourceLine* lines;      /* Source lines. */
+    int num_lines;          /* Number of source lines. */
+    int lines_capacity;     /* Capacity of lines array. */
+    Statement** stmts;      /* Statements of expanded source. */
+    int num_stmts;          /* Number of statements. */
+    int indexed;            /* Number of first statements whose index is correct. */
+    int stmts_capacity;     /* Capacity of stmts array. */
+    Statement** fresh;      /* Statements of one source line before they are placed. */
+    int fresh_capacity;     /* Capacity of fresh array. */
+    LabelState* labels;     /* State of labels by id. */
+    int num_labels;         /* Number of initialized label states. */
+    int labels_capacity;    /* Capacity of labels array. */
+    int* dirty;             /* Ids of labels with dirty state. */
+    int num_dirty;          /* Number of dirty labels. */
+    int dirty_capacity;     /* Capacity of dirty array. */
+    int data_base;          /* Address of first data word (after code), set when statements are placed. */
+    int translated;         /* Number of statements translated since session was built. */
+    int live_errors;        /* Number of kept errors of current lines and statements with rejected label definitions. */
+    int missing;            /* Number of label arguments of labels without symbol. */
+    int undefined_entries;  /* Number of labels marked as entry without definition. */
+    HashMap* macros;        /* Registered macros by name. */
+    SymbolsTable* symbols;  /* Interned label names (symbols are kept in label states). */
+    Errors* kept;           /* Errors of statements and lines, kept while they are not changed. */
+    Errors* report;         /* Diagnostics of last command. */
+    BinarySegment* code;    /* Code words of statement being translated. */
+    BinarySegment* data;    /* Data words of statement being translated. */
+    Vector* references;     /* Label arguments of statement being translated. */
+    Arena* arena;           /* Arena of session objects. */
+} Session;
+
+/* Creates empty session without open file.
+   Arguments:
+    session -- Session to initialize.
+    arena   -- Arena of session objects. It is reset when session is built. */
+void InitSession(Session* session, Arena* arena);
+
+/* Releases memory of session (except for arena).
+   Arguments:
+    session -- Session. */
+void FreeSession(Session* session);
+
+/* Reads source file to session.
+   Arguments:
+    session -- Session.
+    name    -- Source file name without extension.
+   Returns:
+    1 if file is read, 0 if file can't be opened. */
+int OpenSession(Session* session, char* name);
+
+/* Expands and translates all source lines again.
+   Arguments:
+    session -- Session. Source lines are set. */
+void BuildSession(Session* session);
+
+/* Checks if source line is part of macro definition, or changes macro definitions.
+   Changes of such lines cause session to be built again.
+   Arguments:
+    text    -- Text of line.
+   Returns:
+    1 if line is macro definition, or end of it, 0 otherwise. */
+int IsStructuralLine(char* text);
+
+/* Translates one statement.
+   Arguments:
+    session -- Session.
+    text    -- Statement line.
+   Returns:
+    New statement allocated in arena. */
+Statement* TranslateStatement(Session* session, char* text);
+
+/* Reads macro definition and marks its lines.
+   Arguments:
+    session -- Session.
+    def     -- Index of macro definition line.
+   Returns:
+    Index of line after macro definition. */
+int ScanMacro(Session* session, int def);
+
+/* Determines kind of source line (not macro definition) and translates its statements.
+   Statements are written to fresh array of session.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+   Returns:
+    Number of statements. */
+int ExpandSourceLine(Session* session, int i);
+
+/* Adds statement to definitions and uses of its labels.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement. */
+void LinkStatement(Session* session, Statement* stmt);
+
+/* Removes statement from definitions and uses of its labels.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement. */
+void UnlinkStatement(Session* session, Statement* stmt);
+
+/* Marks state of label as dirty.
+   Arguments:
+    session -- Session.
+    id      -- Id of label. */
+void MarkDirty(Session* session, int id);
+
+/* Replaces statements of source line with fresh statements of session.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+    n       -- Number of fresh statements. */
+void SpliceStatements(Session* session, int i, int n);
+
+/* Updates symbols and label arguments after statements were replaced.
+   Arguments:
+    session -- Session.
+    from    -- Number of first replaced statement.
+    n       -- Number of new statements. */
+void RefreshSession(Session* session, int from, int n);
+
+/* Sets numbers of statements that were moved since they were numbered.
+   Arguments:
+    session -- Session. */
+void IndexStatements(Session* session);
+
+/* Calculates addresses of statements, makes symbols of labels with
+   their addresses and resolves all label arguments.
+   Arguments:
+    session -- Session. */
+void PlaceStatements(Session* session);
+
+/* Makes symbol of label from its definitions.
+   Arguments:
+    session -- Session.
+    id      -- Id of label.
+   Returns:
+    1 if label got, or lost symbol, 0 otherwise. */
+int MakeLabelSymbol(Session* session, int id);
+
+/* Writes words of label argument.
+   Arguments:
+    session -- Session.
+    stmt    -- Statement.
+    ref     -- Label argument of the statement. */
+void ResolveArgument(Session* session, Statement* stmt, StatementRef* ref);
+
+/* Replaces, inserts or deletes source line.
+   Arguments:
+    session -- Session.
+    i       -- Index of line.
+    text    -- New text (NULL to delete line).
+    insert  -- 1 if line is inserted before line i. */
+void EditSession(Session* session, int i, char* text, int insert);
+
+/* Collects diagnostics of session to report errors list (sorted by line).
+   Arguments:
+    session -- Session. */
+void ReportSession(Session* session);
+
+/* Writes object, entries and externals files of session.
+   Assumes that session has no errors.
+   Arguments:
+    session     -- Session.
+    writeObj    -- 1 if binary object .obj file should be written too. */
+void WriteSession(Session* session, int writeObj);
+
+/* Reads commands from standard input and answers them until quit command, or end of input.
+   Arguments:
+    arena       -- Arena for session objects.
+    writeObj    -- 1 if binary object .obj file should be written with write command. */
+void RunServer(Arena* arena, int writeObj);
+
+#endif
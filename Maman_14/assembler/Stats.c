@@ -0,0 +1,501 @@
+#include "Stats.h"
+#ifdef TRACK_ALLOC
+    #include <unistd.h>
+    #include "Arena.h"
+#endif
+
+/* Names of stages in printed statistics by StagesEnum. */
+static const char* stage_names[NUM_STAGES] = {
+    "preprocess",
+    "initial_binary",
+    "validate_symbols",
+    "resolve_references",
+    "write_object",
+    "write_entries",
+    "write_externs",
+    "write_expanded",
+    "write_binary_object"
+};
+
+/* Names of counters in printed statistics by CountersEnum. */
+static const char* counter_names[NUM_COUNTERS] = {
+    "files",
+    "cached",
+    "source_lines",
+    "expanded_lines",
+    "macro_calls",
+    "symbols",
+    "references",
+    "errors",
+    "allocs",
+    "reallocs",
+    "heap_allocs",
+    "heap_reallocs",
+    "heap_frees"
+};
+
+/* Statistics of current file. */
+static Stats current_stats;
+/* Key of statistics of thread (see EnableThreadStats()). */
+static pthread_key_t thread_stats_key;
+/* 1 if threads can have own statistics. */
+static int thread_stats = 0;
+
+/* Returns time of monotonic clock in seconds. */
+double Seconds(void) {
+    struct timespec ts; /* Current time. */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* Returns name of stage.
+   Arguments:
+    stage   -- Stage according to StagesEnum. */
+const char* StageName(int stage) {
+    return stage_names[stage];
+}
+
+/* Returns statistics updated by calling thread. */
+Stats* CurrentStats(void) {
+    Stats* stats; /* Statistics of the thread. */
+
+    if (thread_stats && (stats = (Stats*)pthread_getspecific(thread_stats_key)) != NULL)
+        return stats;
+    return &current_stats;
+}
+
+/* Makes current statistics specific to thread.
+   Should be called by main thread before threads that call UseThreadStats() are started. */
+void EnableThreadStats(void) {
+    if (thread_stats)
+        return;
+    if (pthread_key_create(&thread_stats_key, NULL) != 0) {
+        perror("Failed to create thread key.");
+        exit(1);
+    }
+    thread_stats = 1;
+}
+
+/* Sets statistics that are updated by calling thread.
+   Arguments:
+    stats   -- Statistics of the thread (zeroed by caller), NULL to update statistics of main thread. */
+void UseThreadStats(Stats* stats) {
+    pthread_setspecific(thread_stats_key, stats);
+}
+
+/* Adds statistics of finished thread to current statistics.
+   Counters are summed, heap in use of the thread is added to heap in use.
+   Arguments:
+    stats   -- Statistics of the thread. */
+void MergeThreadStats(Stats* stats) {
+    int i; /* Iterator. */
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+        current_stats.counters[i] += stats->counters[i];
+    if (current_stats.heap_used + stats->heap_peak > current_stats.heap_peak)
+        current_stats.heap_peak = current_stats.heap_used + stats->heap_peak;
+    current_stats.heap_used += stats->heap_used;
+}
+
+/* Increments current counter.
+   Arguments:
+    counter -- Counter according to CountersEnum. */
+void CountStat(int counter) {
+    CurrentStats()->counters[counter]++;
+}
+
+/* Adds value to current counter.
+   Arguments:
+    counter -- Counter according to CountersEnum.
+    value   -- Value to add. */
+void AddStat(int counter, long value) {
+    CurrentStats()->counters[counter] += value;
+}
+
+/* Adds time of stage to current statistics.
+   Arguments:
+    stage   -- Stage according to StagesEnum.
+    seconds -- Time of stage. */
+void AddStageTime(int stage, double seconds) {
+    CurrentStats()->times[stage] += seconds;
+}
+
+/* Counts heap call: malloc() if oldSize is 0, free() if newSize is 0, realloc() otherwise.
+   Arguments:
+    oldSize -- Size of memory before the call in bytes.
+    newSize -- Size of memory after the call in bytes. */
+void CountHeap(size_t oldSize, size_t newSize) {
+    Stats* stats = CurrentStats(); /* Statistics of the thread. */
+
+    if (oldSize == 0)
+        stats->counters[cnt_heap_allocs]++;
+    else if (newSize == 0)
+        stats->counters[cnt_heap_frees]++;
+    else
+        stats->counters[cnt_heap_reallocs]++;
+
+    stats->heap_used += (long)newSize - (long)oldSize;
+    if (stats->heap_used > stats->heap_peak)
+        stats->heap_peak = stats->heap_used;
+}
+
+/* malloc() counted by CountHeap().
+   Arguments:
+    size    -- Number of bytes.
+   Returns:
+    Result of malloc(). */
+void* CountedMalloc(size_t size) {
+    CountHeap(0, size);
+    return malloc(size);
+}
+
+/* realloc() counted by CountHeap().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    oldSize -- Current size of block in bytes (0 if ptr is NULL).
+    newSize -- New number of bytes.
+   Returns:
+    Result of realloc(). */
+void* CountedRealloc(void* ptr, size_t oldSize, size_t newSize) {
+    CountHeap(oldSize, newSize);
+    return realloc(ptr, newSize);
+}
+
+/* free() counted by CountHeap().
+   Arguments:
+    ptr     -- Heap block, or NULL (not counted).
+    size    -- Size of block in bytes. */
+void CountedFree(void* ptr, size_t size) {
+    if (ptr != NULL)
+        CountHeap(size, 0);
+    free(ptr);
+}
+
+/* Resets current statistics before new file.
+   Heap in use is kept and becomes the peak. */
+void ResetStats(void) {
+    int i; /* Iterator. */
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+        current_stats.counters[i] = 0;
+    for (i = 0; i < NUM_STAGES; i++)
+        current_stats.times[i] = 0;
+    current_stats.total_time = 0;
+    current_stats.heap_peak = current_stats.heap_used;
+}
+
+/* Copies current statistics.
+   Arguments:
+    stats   -- Structure to fill. */
+void GetStats(Stats* stats) {
+    *stats = current_stats;
+}
+
+/* Adds statistics of file to total statistics.
+   Counters and times are summed, heap peak is the maximum.
+   Arguments:
+    total   -- Total statistics.
+    stats   -- Statistics to add. */
+void AddStats(Stats* total, Stats* stats) {
+    int i; /* Iterator. */
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+        total->counters[i] += stats->counters[i];
+    for (i = 0; i < NUM_STAGES; i++)
+        total->times[i] += stats->times[i];
+    total->total_time += stats->total_time;
+    total->heap_used = stats->heap_used;
+    if (stats->heap_peak > total->heap_peak)
+        total->heap_peak = stats->heap_peak;
+}
+
+/* Prints statistics as one line of key=value pairs to standard output.
+   Arguments:
+    scope   -- Scope of statistics ("file", or "total").
+    name    -- Name of file (NULL for total).
+    stats   -- Statistics. */
+void PrintStats(char* scope, char* name, Stats* stats) {
+    int i; /* Iterator. */
+
+    printf("stats scope=%s", scope);
+    if (name != NULL)
+        printf(" name=%s", name);
+    for (i = 0; i < NUM_COUNTERS; i++)
+        printf(" %s=%ld", counter_names[i], stats->counters[i]);
+    printf(" heap_peak_bytes=%ld", stats->heap_peak);
+    for (i = 0; i < NUM_STAGES; i++)
+        printf(" time_%s=%.6f", stage_names[i], stats->times[i]);
+    printf(" time_total=%.6f\n", stats->total_time);
+}
+
+#ifdef TRACK_ALLOC
+
+/* Names of allocation sites in report by AllocSitesEnum. */
+static const char* site_names[NUM_ALLOC_SITES] = {
+    "assembler",
+    "Arena",
+    "CreateSymbol",
+    "Vector",
+    "ExpandDynArr",
+    "ParseInsArg",
+    "CreateBinary",
+    "AddBinary",
+    "CreateErrors",
+    "AddError",
+    "SortErrors",
+    "Server"
+};
+
+/* Counters of allocation site. */
+typedef struct AllocSite {
+    long calls;         /* Number of calls. */
+    long bytes;         /* Requested bytes of all calls. */
+    long heap_live;     /* Bytes of live heap blocks. */
+    long arena_live;    /* Bytes allocated from arena since last reset. */
+    long peak;          /* Maximum of live bytes (heap and arena). */
+    long blocks;        /* Number of live heap blocks. */
+} AllocSite;
+
+/* Live heap block. */
+typedef struct LiveBlock {
+    void* ptr;          /* Address of block, NULL for empty slot. */
+    size_t size;        /* Size of block. */
+    int site;           /* Site that allocated the block. */
+} LiveBlock;
+
+/* Counters of every site. */
+static AllocSite alloc_sites[NUM_ALLOC_SITES];
+/* Hash table of live heap blocks by address (open addressing). */
+static LiveBlock* live_blocks = NULL;
+/* Number of slots of live blocks table (power of 2). */
+static size_t live_capacity = 0;
+/* Number of live blocks. */
+static size_t live_count = 0;
+/* Process that prints report, 0 before first tracked call. */
+static pid_t report_pid = 0;
+
+/* Registers report at exit on first tracked call. */
+void StartTracking(void) {
+    if (report_pid == 0) {
+        report_pid = getpid();
+        atexit(ReportAllocations);
+    }
+}
+
+/* Returns slot of block in live blocks table (slot of the block, or empty slot where it should be).
+   Arguments:
+    ptr     -- Address of block. */
+size_t FindLiveSlot(void* ptr) {
+    size_t i = ((size_t)ptr >> 4) * 2654435761UL & (live_capacity - 1); /* Slot iterator. */
+
+    while (live_blocks[i].ptr != NULL && live_blocks[i].ptr != ptr)
+        i = (i + 1) & (live_capacity - 1);
+    return i;
+}
+
+/* Adds live heap block of site.
+   Arguments:
+    ptr     -- Address of block.
+    size    -- Size of block.
+    site    -- Call site. */
+void AddLiveBlock(void* ptr, size_t size, int site) {
+    AllocSite* s = &alloc_sites[site]; /* Counters of site. */
+    size_t i; /* Slot of block. */
+
+    /* Doubling table when it is half full. */
+    if (2*(live_count+1) > live_capacity) {
+        LiveBlock* old = live_blocks; /* Old table. */
+        size_t old_cap = live_capacity; /* Capacity of old table. */
+        size_t j; /* Old slots iterator. */
+
+        live_capacity = live_capacity == 0 ? 1024 : live_capacity*2;
+        live_blocks = (LiveBlock*)calloc(live_capacity, sizeof(LiveBlock));
+        if (live_blocks == NULL) {
+            perror("Failed to allocate memory.");
+            exit(1);
+        }
+        for (j = 0; j < old_cap; j++) {
+            if (old[j].ptr != NULL)
+                live_blocks[FindLiveSlot(old[j].ptr)] = old[j];
+        }
+        free(old);
+    }
+
+    i = FindLiveSlot(ptr);
+    live_blocks[i].ptr = ptr;
+    live_blocks[i].size = size;
+    live_blocks[i].site = site;
+    live_count++;
+
+    s->heap_live += (long)size;
+    s->blocks++;
+    if (s->heap_live + s->arena_live > s->peak)
+        s->peak = s->heap_live + s->arena_live;
+}
+
+/* Removes live heap block.
+   Arguments:
+    ptr     -- Address of block.
+   Returns:
+    1 if block was live, 0 otherwise.
+   Algorithm:
+    Blocks after removed slot are moved back if their place is
+    before it, so search never stops at empty slot before its block. */
+int RemoveLiveBlock(void* ptr) {
+    size_t i, j; /* Removed slot and slots iterator. */
+
+    if (live_capacity == 0)
+        return 0;
+    i = FindLiveSlot(ptr);
+    if (live_blocks[i].ptr == NULL)
+        return 0;
+
+    alloc_sites[live_blocks[i].site].heap_live -= (long)live_blocks[i].size;
+    alloc_sites[live_blocks[i].site].blocks--;
+    live_blocks[i].ptr = NULL;
+    live_count--;
+
+    for (j = (i + 1) & (live_capacity - 1); live_blocks[j].ptr != NULL; j = (j + 1) & (live_capacity - 1)) {
+        LiveBlock moved = live_blocks[j]; /* Block to place again. */
+        live_blocks[j].ptr = NULL;
+        live_blocks[FindLiveSlot(moved.ptr)] = moved;
+    }
+    return 1;
+}
+
+/* Tracked malloc().
+   Arguments:
+    size    -- Number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of malloc(). */
+void* TrackMalloc(size_t size, int site) {
+    void* ptr = CountedMalloc(size); /* New block. */
+
+    StartTracking();
+    alloc_sites[site].calls++;
+    alloc_sites[site].bytes += (long)size;
+    if (ptr != NULL)
+        AddLiveBlock(ptr, size, site);
+    return ptr;
+}
+
+/* Tracked realloc().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    oldSize -- Current size of block in bytes (0 if ptr is NULL).
+    newSize -- New number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of realloc(). */
+void* TrackRealloc(void* ptr, size_t oldSize, size_t newSize, int site) {
+    void* res; /* Moved block. */
+
+    StartTracking();
+    alloc_sites[site].calls++;
+    alloc_sites[site].bytes += (long)newSize;
+
+    /* Old block is removed before the call, its address is not valid after it.
+       Callers exit when realloc() fails, so block is not added back. */
+    if (ptr != NULL)
+        RemoveLiveBlock(ptr);
+    res = CountedRealloc(ptr, oldSize, newSize);
+    if (res != NULL)
+        AddLiveBlock(res, newSize, site);
+    return res;
+}
+
+/* Tracked free().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    size    -- Size of block in bytes. */
+void TrackFree(void* ptr, size_t size) {
+    if (ptr != NULL && !RemoveLiveBlock(ptr))
+        fprintf(stderr, "Freed block [ %p ] was not allocated by tracked call.\n", ptr);
+    CountedFree(ptr, size);
+}
+
+/* Tracked Allocate().
+   Arguments:
+    size    -- Number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of Allocate(). */
+void* TrackAllocate(size_t size, int site) {
+    AllocSite* s = &alloc_sites[site]; /* Counters of site. */
+
+    StartTracking();
+    s->calls++;
+    s->bytes += (long)size;
+    s->arena_live += (long)size;
+    if (s->heap_live + s->arena_live > s->peak)
+        s->peak = s->heap_live + s->arena_live;
+    return Allocate(size);
+}
+
+/* Tracked Reallocate().
+   Old memory is counted as live until the arena is reset (it is not reused).
+   Arguments:
+    ptr     -- Memory allocated by Allocate(), or NULL.
+    oldSize -- Current size of memory in bytes.
+    newSize -- New size of memory in bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of Reallocate(). */
+void* TrackReallocate(void* ptr, size_t oldSize, size_t newSize, int site) {
+    AllocSite* s = &alloc_sites[site]; /* Counters of site. */
+
+    StartTracking();
+    s->calls++;
+    s->bytes += (long)newSize;
+    s->arena_live += (long)newSize;
+    if (s->heap_live + s->arena_live > s->peak)
+        s->peak = s->heap_live + s->arena_live;
+    return Reallocate(ptr, oldSize, newSize);
+}
+
+/* Marks arena allocations of every site as released. */
+void TrackArenaReset(void) {
+    int i; /* Sites iterator. */
+
+    for (i = 0; i < NUM_ALLOC_SITES; i++)
+        alloc_sites[i].arena_live = 0;
+}
+
+/* Prints report of allocation sites and leaks to standard error.
+   Registered by atexit() on first tracked call.
+   Algorithm:
+    Sites without calls are not printed. Leaks are live heap blocks,
+    they are summed by site. */
+void ReportAllocations(void) {
+    int i; /* Sites iterator. */
+    int leaks = 0; /* Number of sites with leaks. */
+
+    if (report_pid != getpid())
+        return;
+
+    fprintf(stderr, "Allocation sites (TRACK_ALLOC):\n");
+    fprintf(stderr, "%-22s %10s %14s %12s\n", "site", "calls", "bytes", "peak_live");
+    for (i = 0; i < NUM_ALLOC_SITES; i++) {
+        if (alloc_sites[i].calls > 0)
+            fprintf(stderr, "%-22s %10ld %14ld %12ld\n", site_names[i],
+                alloc_sites[i].calls, alloc_sites[i].bytes, alloc_sites[i].peak);
+    }
+
+    for (i = 0; i < NUM_ALLOC_SITES; i++) {
+        if (alloc_sites[i].blocks > 0) {
+            fprintf(stderr, "Leak: %ld blocks (%ld bytes) allocated by [ %s ] are not freed.\n",
+                alloc_sites[i].blocks, alloc_sites[i].heap_live, site_names[i]);
+            leaks++;
+        }
+    }
+    if (leaks == 0)
+        fprintf(stderr, "No leaks found.\n");
+
+    free(live_blocks);
+    live_blocks = NULL;
+    live_capacity = 0;
+    live_count = 0;
+}
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef STATS_H
+    #define STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Run statistics (--stats option of assembler).
+   Counters are always updated (every update is an increment), they are only
+   printed on request. Current statistics are global for the process and
+   are reset before every source file. Heap use is counted by modules that
+   call malloc(), realloc() and free() directly: Arena (memory blocks),
+   Data (binary segments) and Errors. Threads that encode statements count
+   to their own statistics (see UseThreadStats()) that are merged when they are done. */
+
+/* Timed stages of assembling a file. */
+enum StagesEnum {
+    st_preprocess,
+    st_initial_binary,
+    st_validate_symbols,
+    st_resolve_references,
+    st_write_object,
+    st_write_entries,
+    st_write_externs,
+    st_write_expanded,
+    st_write_binary_object
+};
+
+/* Number of stages. */
+#define NUM_STAGES 9
+
+/* Counted events and quantities. */
+enum CountersEnum {
+    cnt_files,          /* Processed source files. */
+    cnt_cached,         /* Files restored from build cache. */
+    cnt_source_lines,   /* Lines of source files. */
+    cnt_expanded_lines, /* Lines of expanded sources. */
+    cnt_macro_calls,    /* Expanded macro calls. */
+    cnt_symbols,        /* Symbols in symbols tables. */
+    cnt_references,     /* Label arguments. */
+    cnt_errors,         /* Found errors. */
+    cnt_allocs,         /* Allocations from arena (Allocate()). */
+    cnt_reallocs,       /* Reallocations in arena (Reallocate()). */
+    cnt_heap_allocs,    /* Calls of malloc(). */
+    cnt_heap_reallocs,  /* Calls of realloc(). */
+    cnt_heap_frees      /* Calls of free(). */
+};
+
+/* Number of counters. */
+#define NUM_COUNTERS 13
+
+/* Statistics of one file, or of whole run. */
+typedef struct Stats {
+    long counters[NUM_COUNTERS];    /* Counters by CountersEnum. */
+    double times[NUM_STAGES];       /* Wall time of every stage in seconds by StagesEnum. */
+    double total_time;              /* Wall time of whole file, or run in seconds. */
+    long heap_used;                 /* Bytes of heap in use. */
+    long heap_peak;                 /* Maximum of heap_used. */
+} Stats;
+
+/* Returns time of monotonic clock in seconds. */
+double Seconds(void);
+
+/* Returns name of stage.
+   Arguments:
+    stage   -- Stage according to StagesEnum. */
+const char* StageName(int stage);
+
+/* Returns statistics updated by calling thread. */
+Stats* CurrentStats(void);
+
+/* Increments current counter.
+   Arguments:
+    counter -- Counter according to CountersEnum. */
+void CountStat(int counter);
+
+/* Adds value to current counter.
+   Arguments:
+    counter -- Counter according to CountersEnum.
+    value   -- Value to add. */
+void AddStat(int counter, long value);
+
+/* Adds time of stage to current statistics.
+   Arguments:
+    stage   -- Stage according to StagesEnum.
+    seconds -- Time of stage. */
+void AddStageTime(int stage, double seconds);
+
+/* Counts heap call: malloc() if oldSize is 0, free() if newSize is 0, realloc() otherwise.
+   Arguments:
+    oldSize -- Size of memory before the call in bytes.
+    newSize -- Size of memory after the call in bytes. */
+void CountHeap(size_t oldSize, size_t newSize);
+
+/* malloc() counted by CountHeap().
+   Arguments:
+    size    -- Number of bytes.
+   Returns:
+    Result of malloc(). */
+void* CountedMalloc(size_t size);
+
+/* realloc() counted by CountHeap().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    oldSize -- Current size of block in bytes (0 if ptr is NULL).
+    newSize -- New number of bytes.
+   Returns:
+    Result of realloc(). */
+void* CountedRealloc(void* ptr, size_t oldSize, size_t newSize);
+
+/* free() counted by CountHeap().
+   Arguments:
+    ptr     -- Heap block, or NULL (not counted).
+    size    -- Size of block in bytes. */
+void CountedFree(void* ptr, size_t size);
+
+/* Makes current statistics specific to thread.
+   Should be called by main thread before threads that call UseThreadStats() are started. */
+void EnableThreadStats(void);
+
+/* Sets statistics that are updated by calling thread.
+   Arguments:
+    stats   -- Statistics of the thread (zeroed by caller), NULL to update statistics of main thread. */
+void UseThreadStats(Stats* stats);
+
+/* Adds statistics of finished thread to current statistics.
+   Counters are summed, heap in use of the thread is added to heap in use.
+   Arguments:
+    stats   -- Statistics of the thread. */
+void MergeThreadStats(Stats* stats);
+
+/* Resets current statistics before new file.
+   Heap in use is kept and becomes the peak. */
+void ResetStats(void);
+
+/* Copies current statistics.
+   Arguments:
+    stats   -- Structure to fill. */
+void GetStats(Stats* stats);
+
+/* Adds statistics of file to total statistics.
+   Counters and times are summed, heap peak is the maximum.
+   Arguments:
+    total   -- Total statistics.
+    stats   -- Statistics to add. */
+void AddStats(Stats* total, Stats* stats);
+
+/* Prints statistics as one line of key=value pairs to standard output:
+   stats scope=SCOPE [name=NAME] files=.. cached=.. source_lines=.. ... time_total=..
+   Keys and their order don't change, so the line can be parsed by scripts.
+   Arguments:
+    scope   -- Scope of statistics ("file", or "total").
+    name    -- Name of file (NULL for total).
+    stats   -- Statistics. */
+void PrintStats(char* scope, char* name, Stats* stats);
+
+/* Allocation tracking (compiled with -DTRACK_ALLOC, for example make DEFINES=-DTRACK_ALLOC).
+   Heap calls of Arena, Data, Errors, Server and assembler and arena allocations of
+   the most frequent call sites are made by TRACKED_ macros with the call site as argument.
+   Heap calls are counted for statistics (CountHeap()) by the macros in both builds,
+   so callers give sizes of reallocated and freed blocks.
+   With TRACK_ALLOC macros call tracking functions that count calls, bytes and live
+   bytes of every site and keep every live heap block. At exit report of sites and
+   heap blocks that were not freed (leaks) is printed to standard error by the process
+   that made first tracked call (not by -j workers).
+   Arena allocations are live until the arena is reset.
+   Without TRACK_ALLOC macros are counted calls (CountedMalloc() and others), so tracking costs nothing. */
+
+/* Tagged allocation call sites. */
+enum AllocSitesEnum {
+    site_other,                 /* Heap calls of options and workers in assembler. */
+    site_arena,                 /* Arena structure and memory blocks. */
+    site_create_symbol,         /* CreateSymbol(). */
+    site_vector_add,            /* Arrays of vectors (CreateVector(), ReserveVector()). */
+    site_expand_dyn_arr,        /* ExpandDynArr(). */
+    site_parse_ins_arg,         /* ParseInsArg(). */
+    site_create_binary,         /* CreateBinary(). */
+    site_add_binary,            /* AddBinary(). */
+    site_create_errors,         /* CreateErrors(). */
+    site_add_error,             /* AddErrorManual() and strings pool of errors. */
+    site_sort_errors,           /* SortErrors(). */
+    site_server                 /* Lines and arrays of server session. */
+};
+
+/* Number of allocation sites. */
+#define NUM_ALLOC_SITES 12
+
+#ifdef TRACK_ALLOC
+    #define TRACKED_MALLOC(size, site) TrackMalloc((size), (site))
+    #define TRACKED_REALLOC(ptr, oldSize, newSize, site) TrackRealloc((ptr), (oldSize), (newSize), (site))
+    #define TRACKED_FREE(ptr, size) TrackFree((ptr), (size))
+    #define TRACKED_ALLOCATE(size, site) TrackAllocate((size), (site))
+    #define TRACKED_REALLOCATE(ptr, oldSize, newSize, site) TrackReallocate((ptr), (oldSize), (newSize), (site))
+    #define TRACK_ARENA_RESET() TrackArenaReset()
+
+/* Tracked malloc().
+   Arguments:
+    size    -- Number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of malloc(). */
+void* TrackMalloc(size_t size, int site);
+
+/* Tracked realloc().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    oldSize -- Current size of block in bytes (0 if ptr is NULL).
+    newSize -- New number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of realloc(). */
+void* TrackRealloc(void* ptr, size_t oldSize, size_t newSize, int site);
+
+/* Tracked free().
+   Arguments:
+    ptr     -- Heap block, or NULL.
+    size    -- Size of block in bytes. */
+void TrackFree(void* ptr, size_t size);
+
+/* Tracked Allocate().
+   Arguments:
+    size    -- Number of bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of Allocate(). */
+void* TrackAllocate(size_t size, int site);
+
+/* Tracked Reallocate().
+   Arguments:
+    ptr     -- Memory allocated by Allocate(), or NULL.
+    oldSize -- Current size of memory in bytes.
+    newSize -- New size of memory in bytes.
+    site    -- Call site according to AllocSitesEnum.
+   Returns:
+    Result of Reallocate(). */
+void* TrackReallocate(void* ptr, size_t oldSize, size_t newSize, int site);
+
+/* Marks arena allocations of every site as released. */
+void TrackArenaReset(void);
+
+/* Prints report of allocation sites and leaks to standard error.
+   Registered by atexit() on first tracked call. */
+void ReportAllocations(void);
+#else
+    #define TRACKED_MALLOC(size, site) CountedMalloc(size)
+    #define TRACKED_REALLOC(ptr, oldSize, newSize, site) CountedRealloc((ptr), (oldSize), (newSize))
+    #define TRACKED_FREE(ptr, size) CountedFree((ptr), (size))
+    #define TRACKED_ALLOCATE(size, site) Allocate(size)
+    #define TRACKED_REALLOCATE(ptr, oldSize, newSize, site) Reallocate((ptr), (oldSize), (newSize))
+    #define TRACK_ARENA_RESET()
+#endif
+
+#endif
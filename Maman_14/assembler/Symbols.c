@@ -48,33 +48,104 @@ int IsEntry(Symbol* smb) {
 
 
 
-/* Allocates new symbol structure.
-   Makes new copy of label string, only MAX_LABEL_LEN first characters will be copied.
+/* Creates new empty symbols table in current arena.
    Arguments:
+    capacity    -- Expected number of labels. Table will grow if needed.
+   Returns:
+    New symbols table. */
+SymbolsTable* CreateSymbolsTable(int capacity) {
+    SymbolsTable* symbols = (SymbolsTable*)Allocate(sizeof(SymbolsTable)); /* New table. */
+    if (capacity < 8)
+        capacity = 8;
+
+    symbols->labels = CreateHashMap(capacity);
+    symbols->defined = CreateVector(sizeof(Symbol), capacity);
+    symbols->index = CreateVector(sizeof(int), capacity);
+    return symbols;
+}
+
+
+
+/* Returns id of label name. New name is copied to the table and gets next id.
+   Arguments:
+    symbols    -- Symbols table.
+    label      -- Label name string.
+   Returns:
+    Id of the label.
+   Algorithm:
+    Id is number of entry in labels hash map. Entries are never removed,
+    so id of a name doesn't change. */
+int InternLabel(SymbolsTable* symbols, char* label) {
+    int id = HashMapFind(symbols->labels, label); /* Id of the label. */
+    char* name; /* Copy of the name. */
+    int len;    /* Length of the name. */
+
+    if (id != -1)
+        return id;
+
+    /* Copying the name, map keeps pointer to its key. */
+    len = StringLen(label);
+    name = (char*)Allocate(sizeof(char)*(len+1));
+    memcpy(name, label, len+1);
+
+    /* Label has no symbol until it is defined. */
+    HashMapAdd(symbols->labels, name, NULL);
+    *(int*)VectorAdd(symbols->index) = -1;
+    return symbols->labels->count - 1;
+}
+
+
+
+/* Returns interned name of label.
+   Arguments:
+    symbols    -- Symbols table.
+    id         -- Id of label.
+   Returns:
+    Label name. */
+char* LabelName(SymbolsTable* symbols, int id) {
+    return symbols->labels->entries[id].key;
+}
+
+
+
+/* Returns number of defined symbols. */
+int SymbolsCount(SymbolsTable* symbols) {
+    return symbols->defined->count;
+}
+
+
+
+/* Returns defined symbol by number in order of definition.
+   Arguments:
+    symbols    -- Symbols table.
+    i          -- Number of symbol (0 to SymbolsCount()-1).
+   Returns:
+    Symbol. */
+Symbol* SymbolAt(SymbolsTable* symbols, int i) {
+    return (Symbol*)VectorAt(symbols->defined, i);
+}
+
+
+
+/* Allocates new symbol structure in current arena.
+   Label name is interned in symbols table.
+   Arguments:
+    symbols     -- Symbols table.
     label       -- Label name string.
     address     -- Address of instruction where symbol declared.
     attribute   -- Attribute of the symbol in declaration line according to SymbolAttributesEnum.
    Returns:
     New Symbol structure. */ 
-Symbol* CreateSymbol(char* label, int address, int attribute) {
-    int pos = 0; /* Label string iterator. */
+Symbol* CreateSymbol(SymbolsTable* symbols, char* label, int address, int attribute) {
     int one = 1; /* Binary number one.*/
     /* Allocating structure. */
-    Symbol* smb = (Symbol*)malloc(sizeof(Symbol));
-    if (smb == NULL) {
-        perror("Failed to allocate memory.");
-        exit(1);
-    }
+    Symbol* smb = (Symbol*)TRACKED_ALLOCATE(sizeof(Symbol), site_create_symbol);
     /* Setting attribute with binary shift. */
     smb->attributes = one << attribute; 
 
-    /* Copying label name. */
-    while (label[pos] != '\0' && pos<32) {
-        (smb->name)[pos] = label[pos];
-        pos++;
-    }
-    /* Adding termination character. */
-    (smb->name)[pos] = '\0';
+    /* Getting label id and name. */
+    smb->id = InternLabel(symbols, label);
+    smb->name = LabelName(symbols, smb->id);
 
     /* Setting address. */
     smb->adress = address;
@@ -84,83 +155,97 @@ Symbol* CreateSymbol(char* label, int address, int attribute) {
 
 
 
-/* Adds symbol to symbols table.
+/* Adds attributes of new definition to existing symbol.
    Arguments:
-    symbols    -- Symbols table
-    new_smb    -- Symbol to add.
-    errors     -- Errors list.
+    cur_smb    -- Symbol in symbols table.
+    new_smb    -- Symbol of new definition of the same label.
+   Returns:
+    -1 if definition is added, error code according to ErrorsEnum otherwise.
    Algorithm:
-    If symbol not found in the table it is added immediately.
-    If symbol is already in the table attributes checked:
     Symbol can have only following two attribute pairs:
     code-entry and data-entry. Every other combination of existing and new 
-    attributes produces error without adding new symbol.
+    attributes produces error without changing the symbol.
     If pair is allowed new attribute added to existing attribute.
     If entry existed and new symbol is code or data symbol address rewritten. */
-void AddSymbol(List* symbols, Symbol* new_smb, Errors* errors)
+int MergeSymbol(Symbol* cur_smb, Symbol* new_smb)
 {
-    ListNode* cur = symbols->head; /* List iterator. */
+    /* If symbol has attribute .extern */
+    if (IsExtern(cur_smb))
+    {
+        /* Cannot be re-defined as entry. */
+        if (IsEntry(new_smb))
+            return ErrSmb_EntryExtern;
+        /* Cannot be re-defined as code, or data, or another extern (which will be completely identical definition)*/
+        return ErrSmb_NameIdentical;
+    }
+    /* If existing symbol has attributes code or data
+       new symbol can only has attribute .entry, in every other context it will re-definition. */
+    if ((IsCode(cur_smb) || IsData(cur_smb)) && !IsEntry(new_smb))
+        return ErrSmb_NameIdentical;
+    /* If existing symbol has attribute .entry */
+    if (IsEntry(cur_smb))
+    {
+        /* New symbol can't be. extern. */
+        if (IsExtern(new_smb))
+            return ErrSmb_EntryExtern;
+        /* New symbol can't be also .entry (identical definition). */
+        if (IsEntry(new_smb))
+            return ErrSmb_NameIdentical;
+        /* If .entry was in table and new symbol is code or data its address should overwrite .entry address. */
+        cur_smb->adress = new_smb->adress;
+    }
+    /* In any other case (combinations code||data+entry, or entry+code||data) adding
+       new attribute to existing symbol. */
+    /* Adding attribute using binary OR operation. Example: if existing attribute is 1000 and new is 0001 result is 1001. */
+    cur_smb->attributes = cur_smb->attributes | new_smb->attributes;
+    return -1;
+}
+
 
+
+/* Adds symbol to symbols table. Symbol is copied to the table.
+   Arguments:
+    symbols    -- Symbols table
+    new_smb    -- Symbol to add.
+    errors     -- Errors list.
+   Algorithm:
+    Symbol with the same label id is searched in symbols table.
+    If symbol not found in the table it is copied to the end of defined
+    symbols and its number is saved by label id.
+    If symbol is already in the table new definition is merged
+    to it by MergeSymbol(). */
+void AddSymbol(SymbolsTable* symbols, Symbol* new_smb, Errors* errors)
+{
     /* Searching if symbol already in the table. */
-    while (cur != NULL)
+    Symbol* cur_smb = FindSymbolById(symbols, new_smb->id);
+
+    /* If symbol with the same name found */
+    if (cur_smb != NULL)
     {
-        /* Taking current iteration symbol from table. */
-        Symbol* cur_smb = (Symbol*)(cur->data);
-        /* If symbol with the same name found */
-        if (CompareStrings(cur_smb->name, new_smb->name))
-        {
-            /* If symbol has attribute .extern */
-            if (IsExtern(cur_smb))
-            {
-                /* Cannot be re-defined as entry. */
-                if (IsEntry(new_smb))
-                {
-                    AddError(errors, ErrSmb_EntryExtern, new_smb->name, NULL);
-                    return;
-                }
-                /* Cannot be re-defined as code, or data, or another extern (which will be completely identical definition)*/
-                AddError(errors, ErrSmb_NameIdentical, new_smb->name, NULL);
-                return;
-            }
-            /* If existing symbol has attributes code or data
-               new symbol can only has attribute .entry, in every other context it will re-definition. */
-            if ((IsCode(cur_smb) || IsData(cur_smb)) && !IsEntry(new_smb))
-            {
-                AddError(errors, ErrSmb_NameIdentical, new_smb->name, NULL);
-                return;
-            }
-            /* If existing symbol has attribute .entry */
-            if (IsEntry(cur_smb))
-            {
-                /* New symbol can't be. extern. */
-                if (IsExtern(new_smb))
-                {
-                    AddError(errors, ErrSmb_EntryExtern, new_smb->name, NULL);
-                    return;
-                }
-                /* New symbol can't be also .entry (identical definition). */
-                if (IsEntry(new_smb))
-                {
-                    AddError(errors, ErrSmb_NameIdentical, new_smb->name, NULL);
-                    return;
-                }
-                /* If .entry was in table and new symbol is code or data its address should overwrite .entry address. */
-                cur_smb->adress = new_smb->adress;
-            }
-            /* In any other case (combinations code||data+entry, or entry+code||data) adding
-               new attribute to existing symbol and deallocating new symbol as it is already in table. */
-            /* Adding attribute using binary OR operation. Example: if existing attribute is 1000 and new is 0001 result is 1001. */
-            cur_smb->attributes = cur_smb->attributes | new_smb->attributes;
-
-            free(new_smb);
-            return;
-        }
-        /* Advancing iterator. */
-        cur = cur->next;
+        int err = MergeSymbol(cur_smb, new_smb); /* Error of the definition. */
+        if (err != -1)
+            AddError(errors, err, new_smb->name, NULL);
+        return;
     }
 
-    /* If symbol does not exist in table yet adding it. */
-    ListAdd(symbols, new_smb);
+    /* If symbol does not exist in table yet adding it by label id. */
+    ((int*)symbols->index->items)[new_smb->id] = symbols->defined->count;
+    *(Symbol*)VectorAdd(symbols->defined) = *new_smb;
+}
+
+
+
+/* Searches symbol in symbols table by label id.
+   Symbol is valid until next symbol is added to the table.
+   Arguments:
+    symbols    -- Symbols table.
+    id         -- Id of label.
+   Returns:
+    Symbol with given id.
+    NULL if label is not defined. */
+Symbol* FindSymbolById(SymbolsTable* symbols, int id) {
+   int i = ((int*)symbols->index->items)[id]; /* Number of symbol. */
+   return i == -1 ? NULL : SymbolAt(symbols, i);
 }
 
 
@@ -172,51 +257,48 @@ void AddSymbol(List* symbols, Symbol* new_smb, Errors* errors)
    Returns:
     Symbol with given name.
     NULL if symbol not found.  */
-Symbol* FindSymbolByName(List* symbols, char* label) {
-   ListNode* cur = symbols->head; /* Symbols iterator. */
-   /* Iterating trough symbols list. */
-   while (cur != NULL) {
-      Symbol* cur_smb = cur->data;
-      /* Comparing symbol name. */
-      if (CompareStrings(label,cur_smb->name)) {
-         return cur_smb;
-      }
-      cur = cur->next;
-   }
-   /* If nothing found. */
-   return NULL;
+Symbol* FindSymbolByName(SymbolsTable* symbols, char* label) {
+   int id = HashMapFind(symbols->labels, label); /* Id of the label. */
+   return id == -1 ? NULL : FindSymbolById(symbols, id);
 }
 
 
 
-/* Allocates new LabelReference structure
-   and fills it with provided parameters.
+/* Creates empty vector of label references (LabelReference) in current arena.
    Arguments:
-    label      -- Label name.
-    address    -- Address of data word where label value should be substituted.
-    origin     -- Number of line where label referenced as argument.
+    capacity   -- Expected number of references. Vector will grow if needed.
    Returns:
-    LabelReference structure allocated on heap. 
-    */
-LabelReference* CreateLabelReference(char* label, int address, int origin) {
-   int i = 0; /* Iterator. */
-   LabelReference* la;
-   /* Allocating the structure. */
-   la = (LabelReference*)malloc(sizeof(LabelReference));
-   if (la == NULL) {
-      perror("Failed to allocate memory.");
-      exit(1);
-   }
-   /* Setting address and origin. */
+    New vector. */
+Vector* CreateReferences(int capacity) {
+   return CreateVector(sizeof(LabelReference), capacity);
+}
+
+
+
+/* Adds label reference to the end of references vector.
+   Arguments:
+    references -- Vector of label references.
+    id         -- Id of label.
+    address    -- Address of data word where label value should be substituted.
+    origin     -- Number of line where label referenced as argument. */
+void AddLabelReference(Vector* references, int id, int address, int origin) {
+   LabelReference* la = (LabelReference*)VectorAdd(references); /* New reference. */
+   /* Setting label, address and origin. */
+   la->id = id;
    la->address = address;
    la->origin = origin;
-   /* Copying label name. */
-   while (label[i] != '\0') {
-      la->name[i] = label[i];
-      i++;
-   }
-   la->name[i] = '\0';
-   return la;
+}
+
+
+
+/* Returns label reference by number.
+   Arguments:
+    references -- Vector of label references.
+    i          -- Number of reference (0 to count-1).
+   Returns:
+    Label reference, valid until next reference is added. */
+LabelReference* ReferenceAt(Vector* references, int i) {
+   return (LabelReference*)VectorAt(references, i);
 }
 
 
@@ -227,15 +309,13 @@ LabelReference* CreateLabelReference(char* label, int address, int origin) {
    Arguments:
     symbols    -- Symbols table.
     errors     -- Errors list. */
-void ValidateSymbolsTable(List* symbols, Errors* errors) {
-   ListNode* cur;
-   cur = symbols->head;
-   while (cur != NULL) {
-      Symbol* smb = cur->data;
+void ValidateSymbolsTable(SymbolsTable* symbols, Errors* errors) {
+   int i; /* Symbols iterator. */
+   for (i = 0; i < SymbolsCount(symbols); i++) {
+      Symbol* smb = SymbolAt(symbols, i);
       if (IsEntry(smb)) {
          if (!IsCode(smb) && !IsData(smb))
             AddErrorManual(errors, 0, ErrSmb_EntryUndefined, smb->name, NULL);
       }
-      cur = cur->next;
    }
 }
\ No newline at end of file
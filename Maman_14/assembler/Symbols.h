@@ -9,7 +9,8 @@
 
 /* Structure that represents element of symbols table. */
 typedef struct Symbol {
-   char name[32];    /* Symbol label. */
+   int id;           /* Id of symbol label (see SymbolsTable). */
+   char* name;       /* Symbol label (interned name of symbols table). */
    int adress;       /* Address represented by label (decimal) */
    int attributes;   /* Binary 4-bit value that represent symbol attributes:
                         [8]code-[4]data-[2]extern-[1]entry
@@ -20,11 +21,57 @@ typedef struct Symbol {
    Saved while instruction are parsed and used to resolve 
    argument later using symbols table. */
 typedef struct LabelReference {
-   char name[32];    /* Label name. */
+   int id;           /* Id of label. */
    int address;      /* Instruction or data counter where label content is referenced. */
    int origin;       /* Number of line in original source code (not expanded) where label referenced. */
 } LabelReference;
 
+/* Symbols table.
+   Every distinct label name (defined, or referenced as argument) is interned
+   once and gets integer id - number of its entry in labels hash map.
+   Symbols are stored by value in order of definition, and number of symbol
+   of every label is kept by its id, so symbols are found by id without comparing names.
+   Table is allocated in current arena. */
+typedef struct SymbolsTable {
+   HashMap* labels;  /* Interned label names (values of entries are not used). */
+   Vector* defined;  /* Defined symbols (Symbol) in order of definition. */
+   Vector* index;    /* Number of symbol in defined vector (int) by label id, -1 if label is not defined. */
+} SymbolsTable;
+
+/* Creates new empty symbols table in current arena.
+   Arguments:
+    capacity    -- Expected number of labels. Table will grow if needed.
+   Returns:
+    New symbols table. */
+SymbolsTable* CreateSymbolsTable(int capacity);
+
+/* Returns id of label name. New name is copied to the table and gets next id.
+   Arguments:
+    symbols    -- Symbols table.
+    label      -- Label name string.
+   Returns:
+    Id of the label. */
+int InternLabel(SymbolsTable* symbols, char* label);
+
+/* Returns interned name of label.
+   Arguments:
+    symbols    -- Symbols table.
+    id         -- Id of label.
+   Returns:
+    Label name. */
+char* LabelName(SymbolsTable* symbols, int id);
+
+/* Returns number of defined symbols. */
+int SymbolsCount(SymbolsTable* symbols);
+
+/* Returns defined symbol by number in order of definition.
+   Arguments:
+    symbols    -- Symbols table.
+    i          -- Number of symbol (0 to SymbolsCount()-1).
+   Returns:
+    Symbol. */
+Symbol* SymbolAt(SymbolsTable* symbols, int i);
+
 /* Checks if attribute "code" is set for symbol.
    Arguments:
     attributes -- attributes number from Symbol structure.
@@ -57,22 +104,41 @@ int IsExtern(Symbol* smb);
     1 -- Attribute not set. */
 int IsEntry(Symbol* smb);
 
-/* Allocates new symbol structure.
-   Makes new copy of label string, only MAX_LABEL_LEN first characters will be copied.
+/* Allocates new symbol structure in current arena.
+   Label name is interned in symbols table.
    Arguments:
+    symbols     -- Symbols table.
     label       -- Label name string.
     address     -- Address of instruction where symbol declared.
     attribute   -- Attribute of the symbol in declaration line according to SymbolAttributesEnum.
    Returns:
     New Symbol structure. */ 
-Symbol* CreateSymbol(char* label, int address, int attribute);
+Symbol* CreateSymbol(SymbolsTable* symbols, char* label, int address, int attribute);
 
-/* Adds symbol to symbols table.
+/* Adds attributes of new definition to existing symbol.
+   Arguments:
+    cur_smb    -- Symbol in symbols table.
+    new_smb    -- Symbol of new definition of the same label.
+   Returns:
+    -1 if definition is added, error code according to ErrorsEnum otherwise. */
+int MergeSymbol(Symbol* cur_smb, Symbol* new_smb);
+
+/* Adds symbol to symbols table. Symbol is copied to the table.
    Arguments:
     symbols    -- Symbols table
     new_smb    -- Symbol to add.
     errors     -- Errors list.*/
-void AddSymbol(List* symbols, Symbol* new_smb, Errors* errors);
+void AddSymbol(SymbolsTable* symbols, Symbol* new_smb, Errors* errors);
+
+/* Searches symbol in symbols table by label id.
+   Symbol is valid until next symbol is added to the table.
+   Arguments:
+    symbols    -- Symbols table.
+    id         -- Id of label.
+   Returns:
+    Symbol with given id.
+    NULL if label is not defined. */
+Symbol* FindSymbolById(SymbolsTable* symbols, int id);
 
 /* Searches symbol in symbols table by given name.
    Arguments:
@@ -81,17 +147,30 @@ void AddSymbol(List* symbols, Symbol* new_smb, Errors* errors);
    Returns:
     Symbol with given name.
     NULL if symbol not found.  */
-Symbol* FindSymbolByName(List* symbols, char* label);
+Symbol* FindSymbolByName(SymbolsTable* symbols, char* label);
 
-/* Allocates new LabelReference structure
-   and fills it with provided parameters.
+/* Creates empty vector of label references (LabelReference) in current arena.
    Arguments:
-    label      -- Label name.
+    capacity   -- Expected number of references. Vector will grow if needed.
+   Returns:
+    New vector. */
+Vector* CreateReferences(int capacity);
+
+/* Adds label reference to the end of references vector.
+   Arguments:
+    references -- Vector of label references.
+    id         -- Id of label.
     address    -- Address of data word where label value should be substituted.
-    origin     -- Number of line where label referenced as argument.
+    origin     -- Number of line where label referenced as argument. */
+void AddLabelReference(Vector* references, int id, int address, int origin);
+
+/* Returns label reference by number.
+   Arguments:
+    references -- Vector of label references.
+    i          -- Number of reference (0 to count-1).
    Returns:
-    LabelReference structure allocated on heap. */
-LabelReference* CreateLabelReference(char* label, int address, int origin);
+    Label reference, valid until next reference is added. */
+LabelReference* ReferenceAt(Vector* references, int i);
 
 /* Validates symbols table.
    Checks for last possible error (others checked when symbol is added)
@@ -99,6 +178,6 @@ LabelReference* CreateLabelReference(char* label, int address, int origin);
    Arguments:
     symbols    -- Symbols table.
     errors     -- Errors list. */
-void ValidateSymbolsTable(List* symbols, Errors* errors);
+void ValidateSymbolsTable(SymbolsTable* symbols, Errors* errors);
 
 #endif
\ No newline at end of file
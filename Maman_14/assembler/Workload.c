@@ -0,0 +1,322 @@
+#include "Workload.h"
+
+/* Sets default parameters (1000 lines).
+   Arguments:
+    params  -- Parameters to set. */
+void DefaultWorkload(WorkloadParams* params) {
+    params->lines = 1000;
+    params->label_percent = 30;
+    params->macros = 4;
+    params->macro_size = 3;
+    params->data_percent = 15;
+    params->string_percent = 5;
+    params->externs = 4;
+    params->seed = 1;
+}
+
+
+
+/* Reads non-negative decimal number.
+   Arguments:
+    s       -- String with number.
+    max     -- Maximum allowed value.
+    value   -- Variable for returning the number.
+   Returns:
+    1 if string is a number not bigger than max, 0 otherwise (value is not changed). */
+int ReadNumberValue(char* s, int max, int* value) {
+    int num = 0; /* Number. */
+    int pos = 0; /* Position in string. */
+
+    while (IsDigit(s[pos]) && num <= max) {
+        num = num*10 + (s[pos]-'0');
+        pos++;
+    }
+    if (pos == 0 || s[pos] != '\0' || num > max)
+        return 0;
+    *value = num;
+    return 1;
+}
+
+
+
+/* Reads workload option from command line arguments.
+   Options: -n LINES, --labels PERCENT, --macros N, --macro-size N,
+   --data PERCENT, --string PERCENT, --externs N, --seed N.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    argn    -- Number of current argument. Moved to value of option if option has it.
+    params  -- Parameters to change.
+   Returns:
+    1 if argument is workload option, 0 otherwise. Illegal value is reported and ignored.
+   Algorithm:
+    Options are found in table of names with pointers to parameters and maximum values. */
+int ReadWorkloadOption(int argc, char** argv, int* argn, WorkloadParams* params) {
+    char* names[7]; /* Option names. */
+    int* values[7]; /* Parameters of options. */
+    int maxs[7];    /* Maximum values of options. */
+    int seed;       /* Value of --seed option. */
+    int i;          /* Options iterator. */
+
+    names[0] = "-n";           values[0] = &params->lines;          maxs[0] = 10000000;
+    names[1] = "--labels";     values[1] = &params->label_percent;  maxs[1] = 100;
+    names[2] = "--macros";     values[2] = &params->macros;         maxs[2] = 100000;
+    names[3] = "--macro-size"; values[3] = &params->macro_size;     maxs[3] = 1000;
+    names[4] = "--data";       values[4] = &params->data_percent;   maxs[4] = 100;
+    names[5] = "--string";     values[5] = &params->string_percent; maxs[5] = 100;
+    names[6] = "--externs";    values[6] = &params->externs;        maxs[6] = 100000;
+
+    for (i = 0; i < 7; i++) {
+        if (CompareStrings(argv[*argn], names[i])) {
+            if (*argn+1 >= argc)
+                printf("Option [ %s ] needs a value.\n", names[i]);
+            else if (!ReadNumberValue(argv[++(*argn)], maxs[i], values[i]))
+                printf("Illegal value [ %s ] of option [ %s ] is ignored.\n", argv[*argn], names[i]);
+            return 1;
+        }
+    }
+
+    if (CompareStrings(argv[*argn], "--seed")) {
+        if (*argn+1 >= argc)
+            printf("Option [ --seed ] needs a value.\n");
+        else if (!ReadNumberValue(argv[++(*argn)], 2000000000, &seed))
+            printf("Illegal value [ %s ] of option [ --seed ] is ignored.\n", argv[*argn]);
+        else
+            params->seed = (unsigned long)seed;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Returns next pseudo-random number.
+   Arguments:
+    state   -- State of generator, changed.
+    n       -- Number of possible values.
+   Returns:
+    Number from 0 to n-1.
+   Algorithm:
+    Linear congruential generator with 32 bit state (same numbers on every platform,
+    unlike rand()). High bits are used, because low bits of such generator have short periods. */
+int NextRandom(unsigned long* state, int n) {
+    *state = (*state * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+    return (int)((*state >> 8) % (unsigned long)n);
+}
+
+
+
+/* Chooses addressing mode of instruction argument.
+   Arguments:
+    state       -- State of random generator.
+    amodes      -- Allowed addressing modes (see InsInfo).
+    canLabel    -- 1 if there are labels, or external symbols for direct and index modes.
+   Returns:
+    Addressing mode according to AdressingModesEnum, -1 if instruction has no such argument,
+    -2 if no allowed mode can be used. */
+int PickMode(unsigned long* state, int amodes, int canLabel) {
+    int modes[4]; /* Modes that can be used. */
+    int count = 0; /* Number of modes. */
+    int m; /* Modes iterator. */
+
+    if (amodes == 0)
+        return -1;
+    for (m = am_immediate; m <= am_rdirect; m++) {
+        if (HAS_MODE(amodes, m) && (canLabel || (m != am_direct && m != am_index)))
+            modes[count++] = m;
+    }
+    if (count == 0)
+        return -2;
+    return modes[NextRandom(state, count)];
+}
+
+/* Adds name of label, or external symbol used as argument.
+   Arguments:
+    buf         -- Output buffer.
+    state       -- State of random generator.
+    labels      -- Numbers of labeled lines.
+    numLabels   -- Number of labeled lines.
+    externs     -- Number of external symbols. */
+void AppendLabelArgument(OutputBuffer* buf, unsigned long* state, int* labels, int numLabels, int externs) {
+    if (externs > 0 && (numLabels == 0 || NextRandom(state, 100) < WORKLOAD_EXTERN_PERCENT)) {
+        AppendText(buf, "X", 1);
+        AppendNumber(buf, NextRandom(state, externs), 0);
+    }
+    else {
+        AppendText(buf, "L", 1);
+        AppendNumber(buf, labels[NextRandom(state, numLabels)], 0);
+    }
+}
+
+/* Adds instruction argument.
+   Arguments:
+    buf         -- Output buffer.
+    state       -- State of random generator.
+    mode        -- Addressing mode.
+    labels      -- Numbers of labeled lines.
+    numLabels   -- Number of labeled lines.
+    externs     -- Number of external symbols. */
+void AppendOperand(OutputBuffer* buf, unsigned long* state, int mode, int* labels, int numLabels, int externs) {
+    switch (mode) {
+        case am_immediate:
+            AppendText(buf, "#", 1);
+            AppendNumber(buf, NextRandom(state, 1001) - 500, 0);
+            break;
+        case am_direct:
+            AppendLabelArgument(buf, state, labels, numLabels, externs);
+            break;
+        case am_index:
+            AppendLabelArgument(buf, state, labels, numLabels, externs);
+            AppendText(buf, "[r", 2);
+            AppendNumber(buf, 10 + NextRandom(state, 6), 0);
+            AppendText(buf, "]", 1);
+            break;
+        default:
+            AppendText(buf, "r", 1);
+            AppendNumber(buf, NextRandom(state, 16), 0);
+    }
+}
+
+/* Adds random instruction with arguments of allowed addressing modes.
+   Arguments:
+    buf         -- Output buffer.
+    state       -- State of random generator.
+    labels      -- Numbers of labeled lines.
+    numLabels   -- Number of labeled lines.
+    externs     -- Number of external symbols. */
+void AppendInstruction(OutputBuffer* buf, unsigned long* state, int* labels, int numLabels, int externs) {
+    const InsInfo* info; /* Chosen instruction. */
+    int src, dest; /* Addressing modes of arguments. */
+    int canLabel = numLabels > 0 || externs > 0; /* 1 if label arguments can be used. */
+
+    /* Choosing instruction and modes until combination is allowed. */
+    do {
+        info = GetInstructionInfo(NextRandom(state, ins_stop+1));
+        src = PickMode(state, info->amodes_source, canLabel);
+        dest = PickMode(state, info->amodes_dest, canLabel);
+    } while (src == -2 || dest == -2 || (dest >= 0 && info->second_words[src >= 0 ? src : 0][dest] == -1));
+
+    AppendText(buf, (char*)info->name, StringLen((char*)info->name));
+    if (src >= 0) {
+        AppendText(buf, " ", 1);
+        AppendOperand(buf, state, src, labels, numLabels, externs);
+        AppendText(buf, ",", 1);
+    }
+    if (dest >= 0) {
+        AppendText(buf, " ", 1);
+        AppendOperand(buf, state, dest, labels, numLabels, externs);
+    }
+}
+
+
+
+/* Generates source and writes it to <fileName>.as.
+   Objects are allocated in current arena.
+   Arguments:
+    fileName    -- Source file name without extension.
+    params      -- Parameters of source.
+   Returns:
+    Number of written lines.
+   Algorithm:
+    First pass chooses kind of every line after macro definitions and which
+    statements have labels, so second pass that writes lines can use any label
+    as argument, including labels defined later. Label of line number i is L<i>,
+    external symbols are X<k> and macros are M<k>. Macro bodies have no labels,
+    because every call would define them again. */
+int WriteWorkload(char* fileName, WorkloadParams* params) {
+    unsigned long state = params->seed; /* State of random generator. */
+    OutputBuffer buf; /* Text of source. */
+    int header = 1 + params->externs + params->macros*(params->macro_size + 2); /* Number of lines before statements. */
+    int count = params->lines > header ? params->lines - header : 1; /* Number of lines after macro definitions. */
+    char* kinds = (char*)Allocate(sizeof(char)*count); /* Kinds of lines according to WorkloadLinesEnum. */
+    char* labeled = (char*)Allocate(sizeof(char)*count); /* 1 if line has label. */
+    int* labels = (int*)Allocate(sizeof(int)*count); /* Numbers of labeled lines. */
+    int num_labels = 0; /* Number of labeled lines. */
+    int i, j; /* Iterators. */
+
+    /* Choosing kinds of lines. */
+    for (i = 0; i < count; i++) {
+        int r; /* Random percent. */
+        labeled[i] = 0;
+        if (i > 0 && labeled[i-1] && NextRandom(&state, 100) < WORKLOAD_ENTRY_PERCENT)
+            kinds[i] = wl_entry;
+        else if (params->macros > 0 && NextRandom(&state, 100) < WORKLOAD_CALL_PERCENT)
+            kinds[i] = wl_call;
+        else {
+            r = NextRandom(&state, 100);
+            if (r < params->data_percent)
+                kinds[i] = wl_data;
+            else if (r < params->data_percent + params->string_percent)
+                kinds[i] = wl_string;
+            else
+                kinds[i] = wl_instruction;
+            if (NextRandom(&state, 100) < params->label_percent) {
+                labeled[i] = 1;
+                labels[num_labels++] = i;
+            }
+        }
+    }
+
+    /* Average line is less than 24 characters. */
+    InitOutputBuffer(&buf, 64 + (header + count)*24);
+    AppendText(&buf, "; Synthetic workload\n", 21);
+
+    for (i = 0; i < params->externs; i++) {
+        AppendText(&buf, ".extern X", 9);
+        AppendNumber(&buf, i, 0);
+        AppendText(&buf, "\n", 1);
+    }
+
+    for (i = 0; i < params->macros; i++) {
+        AppendText(&buf, "macro M", 7);
+        AppendNumber(&buf, i, 0);
+        AppendText(&buf, "\n", 1);
+        for (j = 0; j < params->macro_size; j++) {
+            AppendText(&buf, "\t", 1);
+            AppendInstruction(&buf, &state, labels, num_labels, params->externs);
+            AppendText(&buf, "\n", 1);
+        }
+        AppendText(&buf, "endm\n", 5);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (labeled[i]) {
+            AppendText(&buf, "L", 1);
+            AppendNumber(&buf, i, 0);
+            AppendText(&buf, ": ", 2);
+        }
+        switch (kinds[i]) {
+            case wl_entry:
+                AppendText(&buf, ".entry L", 8);
+                AppendNumber(&buf, i-1, 0);
+                break;
+            case wl_call:
+                AppendText(&buf, "M", 1);
+                AppendNumber(&buf, NextRandom(&state, params->macros), 0);
+                break;
+            case wl_data:
+                AppendText(&buf, ".data ", 6);
+                for (j = 1 + NextRandom(&state, WORKLOAD_MAX_DATA); j > 0; j--) {
+                    AppendNumber(&buf, NextRandom(&state, 2001) - 1000, 0);
+                    if (j > 1)
+                        AppendText(&buf, ", ", 2);
+                }
+                break;
+            case wl_string:
+                AppendText(&buf, ".string \"", 9);
+                for (j = NextRandom(&state, WORKLOAD_MAX_STRING+1); j > 0; j--) {
+                    char c = (char)('a' + NextRandom(&state, 26)); /* Character of string. */
+                    AppendText(&buf, &c, 1);
+                }
+                AppendText(&buf, "\"", 1);
+                break;
+            default:
+                AppendInstruction(&buf, &state, labels, num_labels, params->externs);
+        }
+        AppendText(&buf, "\n", 1);
+    }
+
+    WriteOutputFile(fileName, "as", &buf);
+    return header + count;
+}
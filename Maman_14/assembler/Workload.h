@@ -0,0 +1,85 @@
+#ifndef WORKLOAD_H
+    #define WORKLOAD_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Parsing.h"
+#include "Output.h"
+
+/* Percent of source lines that are macro calls (when there are macros). */
+#define WORKLOAD_CALL_PERCENT 5
+/* Percent of labeled statements that are followed by .entry line of their label. */
+#define WORKLOAD_ENTRY_PERCENT 10
+/* Percent of label arguments that are external symbols (when there are externals). */
+#define WORKLOAD_EXTERN_PERCENT 10
+/* Maximum number of values in generated .data line. */
+#define WORKLOAD_MAX_DATA 8
+/* Maximum length of generated .string. */
+#define WORKLOAD_MAX_STRING 20
+
+/* Synthetic workload.
+   Generated source is a correct program (assembler finds no errors in it) with given number of lines:
+   header comment, .extern lines, macro definitions and then statements, macro calls
+   and .entry lines. Instructions and their addressing modes are taken at random
+   from instructions info, so every instruction and allowed modes combination appears.
+   Label arguments refer to labels defined anywhere in the source, or to external symbols.
+   Same parameters (and seed) always give the same source. */
+
+/* Parameters of generated source. */
+typedef struct WorkloadParams {
+    int lines;          /* Number of source lines (not less than header and one statement). */
+    int label_percent;  /* Percent of statements with label. */
+    int macros;         /* Number of macro definitions. */
+    int macro_size;     /* Number of statements in macro body. */
+    int data_percent;   /* Percent of statements that are .data directives. */
+    int string_percent; /* Percent of statements that are .string directives. */
+    int externs;        /* Number of external symbols. */
+    unsigned long seed; /* Seed of random numbers. */
+} WorkloadParams;
+
+/* Kinds of generated source lines. */
+enum WorkloadLinesEnum {
+    wl_instruction,
+    wl_data,
+    wl_string,
+    wl_entry,
+    wl_call
+};
+
+/* Sets default parameters (1000 lines).
+   Arguments:
+    params  -- Parameters to set. */
+void DefaultWorkload(WorkloadParams* params);
+
+/* Reads workload option from command line arguments.
+   Options: -n LINES, --labels PERCENT, --macros N, --macro-size N,
+   --data PERCENT, --string PERCENT, --externs N, --seed N.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    argn    -- Number of current argument. Moved to value of option if option has it.
+    params  -- Parameters to change.
+   Returns:
+    1 if argument is workload option, 0 otherwise. Illegal value is reported and ignored. */
+int ReadWorkloadOption(int argc, char** argv, int* argn, WorkloadParams* params);
+
+/* Returns next pseudo-random number.
+   Arguments:
+    state   -- State of generator, changed.
+    n       -- Number of possible values.
+   Returns:
+    Number from 0 to n-1. */
+int NextRandom(unsigned long* state, int n);
+
+/* Generates source and writes it to <fileName>.as.
+   Objects are allocated in current arena.
+   Arguments:
+    fileName    -- Source file name without extension.
+    params      -- Parameters of source.
+   Returns:
+    Number of written lines. */
+int WriteWorkload(char* fileName, WorkloadParams* params);
+
+#endif
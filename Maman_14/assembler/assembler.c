@@ -1,7 +1,7 @@
 /* Program description:
     This program produces binary object files from pseudo 
     assembly language source files. Also produced files that describe symbols
-    for linking object files but linker is not presented in this project.
+    for linking object files by linker (see linker.c).
    Program operations:
     Program takes file names as arguments, then for each file expands
     macros, reads source code line by line, parses it and translates to binary
@@ -15,9 +15,12 @@
         structure.
     -- MyString
         Collection of small functions for working with strings.
+    -- Arena
+        Arena (bump) allocator. Every object that lives while one source file is
+        assembled is allocated in the arena and released at once after the file is done.
     -- Data
         Contains definitions and functions related to collection data structures --
-        linked list, dynamic integer array and binary segment dynamic array.
+        vector, hash map, dynamic integer array and binary segment dynamic array.
     -- DataContainers
         Othert non-collection data structures that are used in the application
         for storing information and descriptions.
@@ -38,6 +41,14 @@
         to binary machine words.
     -- Output
         Functions for writing binary instruction and symbols to resulting files.
+    -- Object
+        Layout of binary object file and functions for reading it.
+    -- Cache
+        Build cache - outputs of assembled files kept by hash of their sources.
+    -- Server
+        Incremental assembler server - source kept in memory and changed by line edits.
+    -- Stats
+        Counters of run statistics, time of stages and heap use (--stats).
     -- assembler
         Main function.
    Algorithm:
@@ -45,7 +56,7 @@
     and lists of symbols and symbol references. This structures are given to functions to fill and
     then used in other function.
     -- Fisrst step of program execution is to expand macros in given assembly source code
-    and to produce expanded source code .am file.
+    and to produce expanded source code lines in memory (written to .am file with --am option).
     Preprocessing is done with two key functions - RegisterMacroInfo() and ExpandMacro(). Preprocessor 
     parent function (Preprocess()) reads source code, determines if line is macro definition, or macro call
     and calls RegisterMacroInfo() or ExpandMacro() accordingly. 
@@ -53,7 +64,7 @@
     stored in Errors structure that allows to determine for each line in expanded source file on which
     line (line number) it was in original source file. It is used for printing errors line numbers for user.
     -- Second step is to produce initial binary representation. Parent function ProduceInitialBinary()
-    reads expanded source file, determines type of command - instruction, or directive, calls
+    reads expanded source lines, determines type of command - instruction, or directive, calls
     for parsing functions to break down the line and the it calls ToBinary functions to translate it to
     machine code. ToBinary() functions take data, translate it to binary code and write it to 
     binary segments. Also ProduceInitialBinary() fills symbols table and symbol references list while 
@@ -78,6 +89,34 @@
    Input:
     Application is given as aguments assembly source code file names (without extensions). Those source code files are
     application input.
+   Options:
+    Arguments starting with '-' are options and may be placed anywhere between file names.
+    --am    Write expanded source of every file to .am file. Expanded source is kept
+            in memory and passed directly to the second step, so by default it is not written.
+    -j N    Assemble up to N files in parallel, each file in its own process.
+            Messages are printed in the order of file names, same as without this option.
+    -t N    Preprocess and encode statements of big file by N threads (first and second
+            steps). Results and messages are the same as without this option. Files with less
+            than MIN_PREPROCESS_CHUNK_LINES source lines (estimated from file size), or
+            MIN_CHUNK_LINES expanded lines per thread use fewer threads (see Preprocessor.h
+            and Binary.h).
+    --obj   Also write binary object .obj file - code and data words, entries and
+            external references in binary form, that can be loaded without parsing.
+    --cache DIR
+            Keep messages and output files of every source in directory DIR under hash
+            of the source, assembler version and options. Unchanged source that was
+            assembled before is not assembled again, its outputs are restored from DIR.
+    --server
+            Run as incremental server for editors. Commands (open file, replace, insert,
+            delete line, check, write) are read from standard input and diagnostics are
+            written to standard output after every command (see Server.h). File names are ignored.
+    --stats
+            Print statistics of every file and of whole run: wall time of every stage,
+            numbers of lines, expanded macros, symbols and references, allocations
+            and peak heap use. Every statistics line starts with "stats" and has fixed
+            keys in fixed order (key=value, see Stats.h). With -j times of stages are
+            summed over files, total time is wall time of whole run.
+   Output files are written under temporary names and renamed when complete.
    Assumtions:
     Almost every function assumes that given input is correct and ready for processing - pointers are not NULL, 
     strings have content and termination, and integer values are in correct ranges, etc. Usually if function is given some argument
@@ -92,93 +131,493 @@
 
 #include "assembler.h"
 
-/* Main function.
-   Processes every file name given as argument in following manner:
-   Calls Preprocess and produces .am file.
-   Calls ProduceInitialBinary and fills binary code and data arrays. References to symbols as arguments left as 0s in code segment.
-   Also fills references and symbols tables.
-   Calls ResolveArguments to substitute symbol reference data words in code segment.
-   After that step full binary image of the assembly code is created.
-   If errors were encountered while producing binary image they are printed and output is not written (except for .am file).
-   If there were no errors calls for Output.h functions and writes .ob .ent and .ext files.
-   */
-int main(int argc, char **argv) {
+/* Checks if command line argument is an option (starts with '-').
+   Arguments:
+    arg     -- Command line argument.
+   Returns:
+    1 if argument is an option, 0 if it is a file name. */
+int IsOption(char* arg) {
+    return arg[0] == '-';
+}
+
+/* Reads options and file names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadOptions(int argc, char** argv, Options* options) {
     int argn; /* Argument number. */
 
-    /* Running assembler for every file name passed as argument. */
-    for (argn = 1; argn<argc; argn++) {
-        char* file_name; /* File name without extension. */
-        Errors* errors; /* List of errors. */
-        BinarySegment* code; /* Structure that contains code binary representation. */
-        BinarySegment* data; /* Structure that contains data binary representation. */
-        List* symbols;  /* Symbols table that contains list of every symbol defined in assembly code.*/
-        List* references; /* List of unresolved label arguments. Reference is use of label as instruction argument. */
+    /* Default options. */
+    options->write_am = 0;
+    options->write_obj = 0;
+    options->cache_dir = NULL;
+    options->server = 0;
+    options->stats = 0;
+    options->jobs = 1;
+    options->threads = 1;
+
+    /* Allocating array of file names. There are no more file names than arguments. */
+    options->files = (char**)TRACKED_MALLOC(sizeof(char*)*argc, site_other);
+    if (options->files == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    options->num_files = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        /* Saving file name. */
+        if (!IsOption(argv[argn])) {
+            options->files[options->num_files] = argv[argn];
+            options->num_files++;
+        }
+        else if (CompareStrings(argv[argn], "--am"))
+            options->write_am = 1;
+        else if (CompareStrings(argv[argn], "--obj"))
+            options->write_obj = 1;
+        else if (CompareStrings(argv[argn], "--server"))
+            options->server = 1;
+        else if (CompareStrings(argv[argn], "--stats"))
+            options->stats = 1;
+        else if (CompareStrings(argv[argn], "--cache")) {
+            if (argn+1 < argc)
+                options->cache_dir = argv[++argn];
+            else
+                printf("Option [ --cache ] needs directory name, files will be assembled without cache.\n");
+        }
+        else if (argv[argn][1] == 'j' && (argv[argn][2] != '\0' || argn+1 < argc)) {
+            /* Number of jobs is given in the same argument (-jN), or in the next one (-j N). */
+            char* num = argv[argn][2] != '\0' ? argv[argn]+2 : argv[++argn]; /* Number of jobs. */
+            int pos = 0; /* Position in number. */
+            options->jobs = 0;
+            while (IsDigit(num[pos]) && options->jobs <= MAX_JOBS) {
+                options->jobs = options->jobs*10 + (num[pos]-'0');
+                pos++;
+            }
+            if (num[pos] != '\0' || options->jobs < 1 || options->jobs > MAX_JOBS) {
+                printf("Illegal number of jobs [ %s ], files will be processed one by one.\n", num);
+                options->jobs = 1;
+            }
+        }
+        else if (argv[argn][1] == 't' && (argv[argn][2] != '\0' || argn+1 < argc)) {
+            /* Number of threads is given in the same argument (-tN), or in the next one (-t N). */
+            char* num = argv[argn][2] != '\0' ? argv[argn]+2 : argv[++argn]; /* Number of threads. */
+            int pos = 0; /* Position in number. */
+            options->threads = 0;
+            while (IsDigit(num[pos]) && options->threads <= MAX_ENCODE_THREADS) {
+                options->threads = options->threads*10 + (num[pos]-'0');
+                pos++;
+            }
+            if (num[pos] != '\0' || options->threads < 1 || options->threads > MAX_ENCODE_THREADS) {
+                printf("Illegal number of threads [ %s ], statements will be encoded by one thread.\n", num);
+                options->threads = 1;
+            }
+        }
+        else
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
 
-        printf("Processing file [ %s.as ]\n", file_name);
+/* Assembles one source file and writes resulting files.
+   Prints progress messages and errors to standard output.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+   Returns:
+    1 if object files are written, 0 if errors were found. */
+int AssembleSource(char* file_name, Options* options) {
+    Errors* errors; /* List of errors. */
+    BinarySegment* code; /* Structure that contains code binary representation. */
+    BinarySegment* data; /* Structure that contains data binary representation. */
+    SymbolsTable* symbols; /* Symbols table that contains every symbol defined in assembly code by label id.*/
+    Vector* references; /* Unresolved label arguments. Reference is use of label as instruction argument. */
+    Lines* expanded; /* Expanded source lines. */
+    int written = 0; /* 1 if object files are written. */
+    double start; /* Start time of current stage. */
 
-        /* Referencing the file name. */
-        file_name = argv[argn];
+    printf("Processing file [ %s.as ]\n", file_name);
 
-        /* Initializing errors list. */ 
-        errors = CreateErrors();
+    /* Initializing errors list. */ 
+    errors = CreateErrors();
 
-        /* Initializing binary segments. */
-        code = CreateBinary();
-        code->base = 100; /* Setting code initial address to 100. */
-        data = CreateBinary();
+    /* Initializing binary segments. */
+    code = CreateBinary();
+    code->base = 100; /* Setting code initial address to 100. */
+    data = CreateBinary();
 
-        /* Initializing symbols table. */
-        symbols = CreateList();
+    /* Initializing symbols table. */
+    symbols = CreateSymbolsTable(64);
 
-        /* Initializing references list. */
-        references = CreateList();
+    /* Initializing references. */
+    references = CreateReferences(64);
 
-        /* Preprocessing the file. Expanding macros, removing comments and empty lines and creating .am file. */
-        Preprocess(file_name, errors);
+    /* Preprocessing the file. Expanding macros, removing comments and empty lines. */
+    start = Seconds();
+    expanded = PreprocessParallel(file_name, errors, options->threads);
+    AddStageTime(st_preprocess, Seconds() - start);
 
+    /* Writing .am file if requested. */
+    if (options->write_am) {
+        start = Seconds();
+        WriteExpandedSource(file_name, expanded);
+        AddStageTime(st_write_expanded, Seconds() - start);
         printf("Preprocess finished, resulting file is [ %s.am ]\n", file_name);
+    }
+    else
+        printf("Preprocess finished.\n");
+
+    /* Processing expanded source. Creates initial code and data binary segments and fills symbols table. */
+    start = Seconds();
+    ProduceInitialBinaryParallel(expanded, code, data, symbols, references, errors, options->threads);
+    AddStageTime(st_initial_binary, Seconds() - start);
+
+    printf("Initial binary representation is created.\n");
+
+    /* Checking if symbols table is valid. */
+    start = Seconds();
+    ValidateSymbolsTable(symbols, errors);
+    AddStageTime(st_validate_symbols, Seconds() - start);
+    /* Resolving symbol reference arguments in binary segments. */
+    start = Seconds();
+    ResolveReferences(code, symbols, references, errors);
+    AddStageTime(st_resolve_references, Seconds() - start);
+
+    /* Counting sizes of the file. */
+    AddStat(cnt_expanded_lines, LinesCount(expanded));
+    AddStat(cnt_symbols, SymbolsCount(symbols));
+    AddStat(cnt_references, references->count);
+    AddStat(cnt_errors, errors->count);
+
+    printf("Symbol references are resolved.\n");
+
+    /* If no errors encountered writing resulting files. */
+    if (errors->count == 0) {
+        printf("File [ %s.as ] processed successfully.\n", file_name);
+        printf("Writing object file [ %s.ob ]\n", file_name);
+        start = Seconds();
+        WriteBinaryToObject(file_name, code, data);
+        AddStageTime(st_write_object, Seconds() - start);
+        printf("Writing entries file [ %s.ent ]\n", file_name);
+        start = Seconds();
+        WriteEntries(file_name, symbols);
+        AddStageTime(st_write_entries, Seconds() - start);
+        printf("Writing externals file [ %s.ext ]\n", file_name);
+        start = Seconds();
+        WriteExterns(file_name, symbols, references);
+        AddStageTime(st_write_externs, Seconds() - start);
+        if (options->write_obj) {
+            printf("Writing binary object file [ %s.obj ]\n", file_name);
+            start = Seconds();
+            WriteBinaryObjectFile(file_name, code, data, symbols, references);
+            AddStageTime(st_write_binary_object, Seconds() - start);
+        }
+        written = 1;
+    }
+    else { /* Or printing errors. */ 
+        printf("Failed to process file [ %s.as ]\n", file_name);
+        printf("%d errors are encountered:\n", errors->count);
+        SortErrors(errors);
+        PrintErrorsList(errors);
+    }
+
+    /* Removing errors list. */
+    FreeErrors(errors);
+
+    /* Removing binary segments. */
+    FreeBinary(code);
+    FreeBinary(data);
+
+    return written;
+}
+
+/* Assembles source file with output captured and saves outputs to build cache.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+    key         -- Cache key of the source.
+   Algorithm:
+    Standard output is redirected to temporary file while the file is assembled
+    (same as output of parallel workers). Then captured messages are printed and
+    saved to cache with every file written by this run. */
+void AssembleToCache(char* file_name, Options* options, char* key) {
+    FILE* log;      /* Captured messages. */
+    int saved;      /* Descriptor of original standard output. */
+    char* text;     /* Text of messages. */
+    long len;       /* Length of messages. */
+    char* exts[5];  /* Extensions of written files. */
+    int num_exts = 0; /* Number of written files. */
+    int written;    /* 1 if object files are written. */
+
+    log = tmpfile();
+    fflush(stdout);
+    saved = log != NULL ? dup(STDOUT_FILENO) : -1;
+    if (saved < 0) {
+        /* Output can't be captured, assembling without cache. */
+        if (log != NULL)
+            fclose(log);
+        AssembleSource(file_name, options);
+        return;
+    }
+
+    dup2(fileno(log), STDOUT_FILENO);
+    written = AssembleSource(file_name, options);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
 
-        /* Processing expanded .am file. Creates initial code and data binary segments and fills symbols table. */
-        ProduceInitialBinary(file_name, code, data, symbols, references, errors);
+    /* Reading and printing captured messages. */
+    fseek(log, 0, SEEK_END);
+    len = ftell(log);
+    rewind(log);
+    text = (char*)Allocate(sizeof(char)*(len+1));
+    len = (long)fread(text, 1, len, log);
+    fclose(log);
+    fwrite(text, 1, len, stdout);
 
-        printf("Initial binary representation is created.\n");
+    /* Saving written files. */
+    if (options->write_am)
+        exts[num_exts++] = "am";
+    if (written) {
+        exts[num_exts++] = "ob";
+        exts[num_exts++] = "ent";
+        exts[num_exts++] = "ext";
+        if (options->write_obj)
+            exts[num_exts++] = "obj";
+    }
+    StoreCacheEntry(options->cache_dir, key, file_name, text, (int)len, exts, num_exts);
+}
+
+/* Assembles one source file, or takes its outputs from build cache (--cache).
+   Statistics of the file are printed with --stats option.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+    arena       -- Arena for objects of the file. It is reset when file is done.
+    stats       -- Variable for returning statistics of the file.
+   Algorithm:
+    Cache key depends on assembler version and options that change written files.
+    If cache has entry of the key, files and messages are restored from it
+    and the source is not assembled. Statistics are printed after the file is done
+    and not captured to cache, so restored file has its own statistics. */
+void AssembleFile(char* file_name, Options* options, Arena* arena, Stats* stats) {
+    char salt[MAX_SALT_LEN];    /* Versions and options. */
+    char key[CACHE_KEY_LEN+1];  /* Cache key of the source. */
+    double start = Seconds();   /* Start time of the file. */
+
+    ResetStats();
+    CountStat(cnt_files);
+
+    if (options->cache_dir == NULL)
+        AssembleSource(file_name, options);
+    else {
+        sprintf(salt, "%.64s outputs=%d am=%d obj=%d", ASSEMBLER_VERSION, CACHE_OUTPUT_VERSION, options->write_am, options->write_obj);
+        if (!FindCacheKey(options->cache_dir, file_name, salt, key))
+            AssembleSource(file_name, options); /* Source can't be read, error is reported as usual. */
+        else if (!RestoreCacheEntry(options->cache_dir, key, file_name))
+            AssembleToCache(file_name, options, key);
+        else
+            CountStat(cnt_cached);
+    }
+
+    /* Releasing symbols table, references list and every other
+       object of this file at once. */
+    ResetArena(arena);
+
+    GetStats(stats);
+    stats->total_time = Seconds() - start;
+    if (options->stats)
+        PrintStats("file", file_name, stats);
+}
 
-        /* Checking if symbols table is valid. */
-        ValidateSymbolsTable(symbols, errors);
-        /* Resolving symbol reference arguments in binary segments. */
-        ResolveReferences(code, symbols, references, errors);
+/* Copies content of temporary output file to standard output and closes it.
+   Arguments:
+    output  -- Temporary file with captured output of worker process. */
+void PrintWorkerOutput(FILE* output) {
+    char buffer[4096]; /* Buffer for copying. */
+    size_t n; /* Number of characters read to buffer. */
 
-        printf("Symbol references are resolved.\n");
+    rewind(output);
+    while ((n = fread(buffer, 1, sizeof(buffer), output)) > 0)
+        fwrite(buffer, 1, n, stdout);
+    fflush(stdout);
+    fclose(output);
+}
 
-        /* If no errors encountered writing resulting files. */
-        if (errors->count == 0) {
-            printf("File [ %s.as ] processed successfully.\n", file_name);
-            printf("Writing object file [ %s.ob ]\n", file_name);
-            WriteBinaryToObject(file_name, code, data);
-            printf("Writing entries file [ %s.ent ]\n", file_name);
-            WriteEntries(file_name, symbols);
-            printf("Writing externals file [ %s.ext ]\n", file_name);
-            WriteExterns(file_name, symbols, references);
+/* Assembles files in parallel by pool of worker processes.
+   At most options->jobs files are assembled at the same time, every file
+   by its own process. Output of every worker (standard output and errors)
+   is captured to temporary file and printed in the order of file names
+   in arguments, so it is the same as if files were assembled one by one.
+   If worker fails (exits with non-zero code) its output is printed,
+   no more files are started and program exits with the same code
+   after running workers are finished.
+   With --stats option worker writes statistics of its file to another
+   temporary file and they are added to total statistics when the worker is finished.
+   Arguments:
+    options -- Command line options with file names.
+    arena   -- Arena used by workers.
+    total   -- Statistics of whole run, statistics of every file are added to it. */
+void AssembleFilesParallel(Options* options, Arena* arena, Stats* total) {
+    FILE** outputs; /* Captured output of every file. */
+    FILE** stats;   /* Statistics of every file (with --stats). */
+    pid_t* pids;    /* Worker process of every file. */
+    int* statuses;  /* Exit code of worker of every file, -1 if worker is not finished. */
+    int next = 0;    /* Index of next file to start. */
+    int running = 0; /* Number of running workers. */
+    int printed = 0; /* Number of files which output is printed. */
+    int i; /* Files iterator. */
+
+    /* Allocating workers info. */
+    outputs = (FILE**)TRACKED_MALLOC(sizeof(FILE*)*options->num_files, site_other);
+    pids = (pid_t*)TRACKED_MALLOC(sizeof(pid_t)*options->num_files, site_other);
+    statuses = (int*)TRACKED_MALLOC(sizeof(int)*options->num_files, site_other);
+    stats = (FILE**)TRACKED_MALLOC(sizeof(FILE*)*options->num_files, site_other);
+    if (outputs == NULL || pids == NULL || statuses == NULL || stats == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    for (i = 0; i < options->num_files; i++)
+        statuses[i] = -1;
+
+    /* Flushing output so it will not be duplicated by workers. */
+    fflush(stdout);
+
+    while (printed < options->num_files) {
+        pid_t pid;  /* Worker process id. */
+        int status; /* Worker exit status. */
+
+        /* Starting workers while there are free slots. */
+        while (running < options->jobs && next < options->num_files) {
+            outputs[next] = tmpfile();
+            stats[next] = options->stats ? tmpfile() : NULL;
+            if (outputs[next] == NULL || (options->stats && stats[next] == NULL)) {
+                perror("Failed to create temporary file.");
+                exit(2);
+            }
+
+            pid = fork();
+            if (pid < 0) {
+                perror("Failed to start worker process.");
+                exit(1);
+            }
+            if (pid == 0) {
+                /* Worker process. Redirecting output to temporary file and assembling the file. */
+                Stats file_stats; /* Statistics of the file. */
+                dup2(fileno(outputs[next]), STDOUT_FILENO);
+                dup2(fileno(outputs[next]), STDERR_FILENO);
+                AssembleFile(options->files[next], options, arena, &file_stats);
+                if (stats[next] != NULL)
+                    fwrite(&file_stats, sizeof(Stats), 1, stats[next]);
+                exit(0);
+            }
+
+            pids[next] = pid;
+            running++;
+            next++;
         }
-        else { /* Or printing errors. */ 
-            printf("Failed to process file [ %s.as ]\n", file_name);
-            printf("%d errors are encountered:\n", errors->count);
-            SortErrors(errors);
-            PrintErrorsList(errors);
+
+        /* Waiting for any worker to finish. */
+        pid = wait(&status);
+        if (pid < 0) {
+            perror("Failed to wait for worker process.");
+            exit(1);
+        }
+        for (i = 0; i < next; i++) {
+            if (pids[i] == pid) {
+                statuses[i] = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+                running--;
+                break;
+            }
+        }
+
+        /* Printing output of finished files in arguments order. */
+        while (printed < next && statuses[printed] != -1) {
+            PrintWorkerOutput(outputs[printed]);
+            if (stats[printed] != NULL) {
+                Stats file_stats; /* Statistics written by worker. */
+                rewind(stats[printed]);
+                if (fread(&file_stats, sizeof(Stats), 1, stats[printed]) == 1)
+                    AddStats(total, &file_stats);
+                fclose(stats[printed]);
+            }
+            if (statuses[printed] != 0) {
+                int code = statuses[printed]; /* Exit code of failed worker. */
+                /* Waiting for running workers and exiting. */
+                while (running > 0) {
+                    if (wait(&status) < 0)
+                        break;
+                    running--;
+                }
+                exit(code);
+            }
+            printed++;
         }
+    }
 
-        /* Removing errors list. */
-        FreeErrors(errors);
+    TRACKED_FREE(outputs, sizeof(FILE*)*options->num_files);
+    TRACKED_FREE(pids, sizeof(pid_t)*options->num_files);
+    TRACKED_FREE(statuses, sizeof(int)*options->num_files);
+    TRACKED_FREE(stats, sizeof(FILE*)*options->num_files);
+}
 
-        /* Removing binary segments. */
-        FreeBinary(code);
-        FreeBinary(data);
+/* Main function.
+   Processes every file name given as argument in following manner:
+   Calls Preprocess and produces expanded source lines (and .am file if --am option is given).
+   Calls ProduceInitialBinary and fills binary code and data arrays. References to symbols as arguments left as 0s in code segment.
+   Also fills references and symbols tables.
+   Calls ResolveArguments to substitute symbol reference data words in code segment.
+   After that step full binary image of the assembly code is created.
+   If errors were encountered while producing binary image they are printed and output is not written (except for .am file).
+   If there were no errors calls for Output.h functions and writes .ob .ent and .ext files.
+   Processing of one file is done by AssembleFile(). With --cache option unchanged files
+   are restored from build cache instead. If -j option is given files are
+   processed in parallel by AssembleFilesParallel(). With --server option files are
+   not assembled, commands are answered by RunServer() instead. With --stats option
+   statistics of whole run are printed after all files.
+   Objects created while processing a file are allocated in arena that is reset after each file.
+   */
+int main(int argc, char **argv) {
+    int i; /* Files iterator. */
+    Arena* arena; /* Arena for objects of currently processed file. */
+    Options options; /* Command line options. */
+    Stats total;     /* Statistics of whole run. */
+    Stats file_stats; /* Statistics of one file. */
+    double start = Seconds(); /* Start time of run. */
+
+    /* Reading options and file names. */
+    ReadOptions(argc, argv, &options);
+
+    /* Checking cache directory. */
+    if (options.cache_dir != NULL && !OpenCacheDir(options.cache_dir))
+        options.cache_dir = NULL;
 
-        /* Removing symbols table. */
-        FreeListAndData(symbols);
+    /* Creating arena. Its memory blocks are reused for every file. */
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
 
-        /* Removing references table. */
-        FreeListAndData(references);
+    ResetStats();
+    GetStats(&total);
+
+    /* Running assembler for every file name passed as argument. */
+    if (options.server)
+        RunServer(arena, options.write_obj);
+    else if (options.jobs > 1 && options.num_files > 1)
+        AssembleFilesParallel(&options, arena, &total);
+    else {
+        for (i = 0; i < options.num_files; i++) {
+            AssembleFile(options.files[i], &options, arena, &file_stats);
+            AddStats(&total, &file_stats);
+        }
+    }
+
+    if (options.stats && !options.server) {
+        total.total_time = Seconds() - start;
+        PrintStats("total", NULL, &total);
     }
+
+    TRACKED_FREE(options.files, sizeof(char*)*argc);
+    FreeWorkerArenas();
+    FreeArena(arena);
     return 0;
-}
\ No newline at end of file
+}
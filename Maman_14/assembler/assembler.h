@@ -2,7 +2,11 @@
     #define ASSEMBLER_H
 
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "Definitions.h"
+#include "Arena.h"
 #include "Data.h"
 #include "DataContainers.h"
 #include "Errors.h"
@@ -10,5 +14,88 @@
 #include "Preprocessor.h"
 #include "Binary.h"
 #include "Output.h"
+#include "Cache.h"
+#include "Server.h"
+#include "Stats.h"
+
+/* Maximal number of parallel jobs (-j option). */
+#define MAX_JOBS 256
+
+/* Version of assembler. */
+#define ASSEMBLER_VERSION "1.0"
+
+/* Version of outputs kept in build cache (--cache). It is part of cache keys, so it
+   should be increased whenever files, or messages produced for the same source and
+   options change. Entries of older versions are not used then. */
+#define CACHE_OUTPUT_VERSION 1
+
+/* Maximum length of cache salt (versions and options). */
+#define MAX_SALT_LEN 128
+
+/* Options given to assembler in command line. */
+typedef struct Options {
+    int write_am;  /* 1 if expanded source .am files should be written (--am). */
+    int write_obj; /* 1 if binary object .obj files should be written (--obj). */
+    char* cache_dir; /* Directory of build cache (--cache DIR), NULL if cache is not used. */
+    int server;      /* 1 if assembler runs as incremental server (--server). */
+    int stats;       /* 1 if statistics of every file and of whole run should be printed (--stats). */
+    int jobs;      /* Number of files assembled in parallel (-j N). */
+    int threads;   /* Number of threads that preprocess and encode one file (-t N). */
+    char** files;  /* File names given as arguments (without extensions). */
+    int num_files; /* Number of file names. */
+} Options;
+
+/* Checks if command line argument is an option (starts with '-').
+   Arguments:
+    arg     -- Command line argument.
+   Returns:
+    1 if argument is an option, 0 if it is a file name. */
+int IsOption(char* arg);
+
+/* Reads options and file names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadOptions(int argc, char** argv, Options* options);
+
+/* Assembles one source file and writes resulting files.
+   Prints progress messages and errors to standard output.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+   Returns:
+    1 if object files are written, 0 if errors were found. */
+int AssembleSource(char* file_name, Options* options);
+
+/* Assembles source file with output captured and saves outputs to build cache.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+    key         -- Cache key of the source. */
+void AssembleToCache(char* file_name, Options* options, char* key);
+
+/* Assembles one source file, or takes its outputs from build cache (--cache).
+   Statistics of the file are printed with --stats option.
+   Arguments:
+    file_name   -- Source file name without extension.
+    options     -- Command line options.
+    arena       -- Arena for objects of the file. It is reset when file is done.
+    stats       -- Variable for returning statistics of the file. */
+void AssembleFile(char* file_name, Options* options, Arena* arena, Stats* stats);
+
+/* Copies content of temporary output file to standard output and closes it.
+   Arguments:
+    output  -- Temporary file with captured output of worker process. */
+void PrintWorkerOutput(FILE* output);
+
+/* Assembles files in parallel by pool of worker processes.
+   Output of every worker is printed in the order of file names in arguments.
+   Arguments:
+    options -- Command line options with file names.
+    arena   -- Arena used by workers.
+    total   -- Statistics of whole run, statistics of every file are added to it. */
+void AssembleFilesParallel(Options* options, Arena* arena, Stats* total);
 
 #endif
\ No newline at end of file
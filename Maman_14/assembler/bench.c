@@ -0,0 +1,456 @@
+/* Program description:
+    This program measures speed of every stage of assembler on generated sources
+    of growing size (see generator.c and Workload.h).
+   Program operations:
+    For every size of sweep source bench_<size>.as is generated in current directory
+    and assembled several times. Stages are the same functions that assembler calls:
+    Preprocess(), ProduceInitialBinary() (their parallel versions with --threads),
+    ValidateSymbolsTable(), ResolveReferences() and writers of .ob, .ent and .ext files.
+    Each one is timed separately and the best time of all runs is reported.
+   Output:
+    Machine-readable table is printed, comma separated with header line:
+    lines,stage,seconds,lines_per_second
+    One row for every size and stage, and row of stage "total" for whole file.
+   Options:
+    --sizes N,N,...     Numbers of lines of sources (default 1000,4000,16000,64000).
+    --repeat N          Number of runs of every size (default 3).
+    --threads N         Number of threads that preprocess and encode a file (default 1).
+    Workload options of generator (except -n) set kind of sources:
+    --labels, --macros, --macro-size, --data, --string, --externs, --seed.
+    --classify          Instead of stages measure classification of reserved words:
+                        ClassifyWord() against IsReservedWord(), GetInstructionType()
+                        and directive names lookup as they were before it. Table is
+                        function,implementation,ns_per_word (best of --repeat runs).
+   */
+
+#include "bench.h"
+
+/* Reads list of sizes of sweep.
+   Arguments:
+    list    -- Comma separated numbers.
+    options -- Options to fill.
+   Returns:
+    1 if list is correct, 0 otherwise (sizes are not changed). */
+int ReadSizes(char* list, BenchOptions* options) {
+    int sizes[MAX_BENCH_SIZES]; /* Read sizes. */
+    int count = 0; /* Number of read sizes. */
+    int pos = 0; /* Position in list. */
+
+    while (count < MAX_BENCH_SIZES) {
+        int num = 0; /* Current number. */
+        int start = pos; /* Position of number. */
+        while (IsDigit(list[pos]) && num <= 10000000) {
+            num = num*10 + (list[pos]-'0');
+            pos++;
+        }
+        if (pos == start || num < 1 || num > 10000000)
+            return 0;
+        sizes[count++] = num;
+        if (list[pos] == '\0')
+            break;
+        if (list[pos] != ',')
+            return 0;
+        pos++;
+    }
+    if (list[pos] != '\0')
+        return 0;
+
+    memcpy(options->sizes, sizes, sizeof(int)*count);
+    options->num_sizes = count;
+    return 1;
+}
+
+/* Reads options from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadBenchOptions(int argc, char** argv, BenchOptions* options) {
+    int argn; /* Argument number. */
+
+    DefaultWorkload(&options->params);
+    options->sizes[0] = 1000;
+    options->sizes[1] = 4000;
+    options->sizes[2] = 16000;
+    options->sizes[3] = 64000;
+    options->num_sizes = 4;
+    options->repeat = 3;
+    options->threads = 1;
+    options->classify = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        if (CompareStrings(argv[argn], "--sizes") && argn+1 < argc) {
+            if (!ReadSizes(argv[++argn], options))
+                fprintf(stderr, "Illegal sizes [ %s ] are ignored.\n", argv[argn]);
+        }
+        else if (CompareStrings(argv[argn], "--repeat") && argn+1 < argc) {
+            int repeat = 0; /* Number of runs. */
+            char* num = argv[++argn]; /* Value of option. */
+            int pos = 0; /* Position in value. */
+            while (IsDigit(num[pos]) && repeat <= 1000) {
+                repeat = repeat*10 + (num[pos]-'0');
+                pos++;
+            }
+            if (num[pos] != '\0' || repeat < 1 || repeat > 1000)
+                fprintf(stderr, "Illegal number of runs [ %s ] is ignored.\n", num);
+            else
+                options->repeat = repeat;
+        }
+        else if (CompareStrings(argv[argn], "--threads") && argn+1 < argc) {
+            int threads = 0; /* Number of threads. */
+            char* num = argv[++argn]; /* Value of option. */
+            int pos = 0; /* Position in value. */
+            while (IsDigit(num[pos]) && threads <= MAX_ENCODE_THREADS) {
+                threads = threads*10 + (num[pos]-'0');
+                pos++;
+            }
+            if (num[pos] != '\0' || threads < 1 || threads > MAX_ENCODE_THREADS)
+                fprintf(stderr, "Illegal number of threads [ %s ] is ignored.\n", num);
+            else
+                options->threads = threads;
+        }
+        else if (CompareStrings(argv[argn], "--classify"))
+            options->classify = 1;
+        else if (CompareStrings(argv[argn], "-n") || !ReadWorkloadOption(argc, argv, &argn, &options->params))
+            fprintf(stderr, "Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+/* Assembles source file and measures time of every stage.
+   Output files are written as by assembler.
+   Arguments:
+    fileName    -- Source file name without extension.
+    times       -- Array for returning time of every stage in seconds (by StagesEnum).
+    threads     -- Number of threads that preprocess and encode the file.
+   Returns:
+    Number of errors found in source.
+   Algorithm:
+    Same steps as AssembleSource() of assembler.c, without messages. */
+int RunStages(char* fileName, double times[BENCH_STAGES], int threads) {
+    Errors* errors = CreateErrors(); /* List of errors. */
+    BinarySegment* code = CreateBinary(); /* Code segment. */
+    BinarySegment* data = CreateBinary(); /* Data segment. */
+    SymbolsTable* symbols = CreateSymbolsTable(64); /* Symbols table. */
+    Vector* references = CreateReferences(64); /* Label arguments. */
+    Lines* expanded; /* Expanded source lines. */
+    int count; /* Number of errors. */
+    double start; /* Start time of stage. */
+
+    code->base = 100;
+
+    start = Seconds();
+    expanded = PreprocessParallel(fileName, errors, threads);
+    times[st_preprocess] = Seconds() - start;
+
+    start = Seconds();
+    ProduceInitialBinaryParallel(expanded, code, data, symbols, references, errors, threads);
+    times[st_initial_binary] = Seconds() - start;
+
+    start = Seconds();
+    ValidateSymbolsTable(symbols, errors);
+    times[st_validate_symbols] = Seconds() - start;
+
+    start = Seconds();
+    ResolveReferences(code, symbols, references, errors);
+    times[st_resolve_references] = Seconds() - start;
+
+    count = errors->count;
+    if (count == 0) {
+        start = Seconds();
+        WriteBinaryToObject(fileName, code, data);
+        times[st_write_object] = Seconds() - start;
+
+        start = Seconds();
+        WriteEntries(fileName, symbols);
+        times[st_write_entries] = Seconds() - start;
+
+        start = Seconds();
+        WriteExterns(fileName, symbols, references);
+        times[st_write_externs] = Seconds() - start;
+    }
+
+    FreeErrors(errors);
+    FreeBinary(code);
+    FreeBinary(data);
+    return count;
+}
+
+/* Checks if word is reserved the way IsReservedWord() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    s   -- Word, null-terminated.
+   Returns:
+    Value of ReservedWordsEnum. ".entry" is not found, as before.
+   Algorithm:
+    Arrays of names are filled on every call and compared one by one.
+    Old version wrote ".entry" after the end of keywords array and did not check it,
+    here array has place for it, but it is not checked either. */
+int OldIsReservedWord(char* s) {
+    int i; /* Iterator */
+    char rx[3] = "r0"; /* Register name <10 */
+    char rxx[4] = "r10"; /* Register name >= 10 */
+    char* instructions[16]; /* Array of instruction names */
+    char* keywords[10];  /* Array of assembly keywords */
+
+    instructions[0] = "mov";
+    instructions[1] = "cmp";
+    instructions[2] = "add";
+    instructions[3] = "sub";
+    instructions[4] = "lea";
+    instructions[5] = "clr";
+    instructions[6] = "not";
+    instructions[7] = "inc";
+    instructions[8] = "dec";
+    instructions[9] = "jmp";
+    instructions[10] = "bne";
+    instructions[11] = "jsr";
+    instructions[12] = "red";
+    instructions[13] = "prn";
+    instructions[14] = "rts";
+    instructions[15] = "stop";
+
+    for (i = 0; i < 16; i++) {
+        if (CompareStrings(s, instructions[i]))
+            return rw_instruction;
+    }
+
+    for (i = 0; i < 10; i++) {
+        rx[1] = (48 + i);
+        if (CompareStrings(s, rx))
+            return rw_register;
+        if (i <= 5) {
+            rxx[2] = 48 + i;
+            if (CompareStrings(s, rxx))
+                return rw_register;
+        }
+    }
+
+    keywords[0] = "macro";
+    keywords[1] = "endm";
+    keywords[2] = "data";
+    keywords[3] = ".data";
+    keywords[4] = "string";
+    keywords[5] = ".string";
+    keywords[6] = "extern";
+    keywords[7] = ".extern";
+    keywords[8] = "entry";
+    keywords[9] = ".entry";
+
+    for (i = 0; i < 9; i++) {
+        if (CompareStrings(s, keywords[i]))
+            return rw_keyword;
+    }
+
+    return rw_none;
+}
+
+/* Gets instruction type the way GetInstructionType() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    ins -- Instruction name, null-terminated.
+   Returns:
+    Instruction number according to InstructionsEnum, -1 if name is not recognized. */
+int OldGetInstructionType(char* ins) {
+    if (CompareStrings(ins, "mov"))
+        return ins_mov;
+    if (CompareStrings(ins, "cmp"))
+        return ins_cmp;
+    if (CompareStrings(ins, "add"))
+        return ins_add;
+    if (CompareStrings(ins, "sub"))
+        return ins_sub;
+    if (CompareStrings(ins, "lea"))
+        return ins_lea;
+    if (CompareStrings(ins, "clr"))
+        return ins_clr;
+    if (CompareStrings(ins, "not"))
+        return ins_not;
+    if (CompareStrings(ins, "inc"))
+        return ins_inc;
+    if (CompareStrings(ins, "dec"))
+        return ins_dec;
+    if (CompareStrings(ins, "jmp"))
+        return ins_jmp;
+    if (CompareStrings(ins, "bne"))
+        return ins_bne;
+    if (CompareStrings(ins, "jsr"))
+        return ins_jsr;
+    if (CompareStrings(ins, "red"))
+        return ins_red;
+    if (CompareStrings(ins, "prn"))
+        return ins_prn;
+    if (CompareStrings(ins, "rts"))
+        return ins_rts;
+    if (CompareStrings(ins, "stop"))
+        return ins_stop;
+    return -1;
+}
+
+/* Gets directive type the way GetDirectiveType() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    name    -- Directive name, null-terminated.
+   Returns:
+    Directive type according to DirectivesEnum, -1 if name is not recognized. */
+int OldGetDirectiveType(char* name) {
+    if (CompareStrings(name, ".data"))
+        return dir_data;
+    if (CompareStrings(name, ".string"))
+        return dir_string;
+    if (CompareStrings(name, ".entry"))
+        return dir_entry;
+    if (CompareStrings(name, ".extern"))
+        return dir_extern;
+    return -1;
+}
+
+/* Classifies word by one of measured functions of classification benchmark.
+   Arguments:
+    func    -- 0 for IsReservedWord(), 1 for GetInstructionType(), 2 for GetDirectiveType().
+    old     -- 1 for version before ClassifyWord(), 0 for current version.
+    word    -- Word, null-terminated.
+    len     -- Length of word.
+   Returns:
+    Result of the function.
+   Algorithm:
+    Current versions are called the same way as by their callers: IsReservedWord() and
+    GetInstructionType() count length of word, directive name length is already known. */
+int ClassifyWithVersion(int func, int old, char* word, int len) {
+    int value = -1; /* Number of word returned by ClassifyWord(). */
+
+    if (func == 0)
+        return old ? OldIsReservedWord(word) : IsReservedWord(word);
+    if (func == 1)
+        return old ? OldGetInstructionType(word) : GetInstructionType(word);
+    if (old)
+        return OldGetDirectiveType(word);
+    if (word[0] == '.' && ClassifyWord(word, len, &value) == rw_keyword)
+        return value;
+    return -1;
+}
+
+/* Measures classification of reserved words by ClassifyWord() and by the
+   functions it replaced, on mixed sample words. Prints table of results.
+   Arguments:
+    repeat  -- Number of runs, the best time is reported.
+   Algorithm:
+    First results of both versions are compared for every sample word, and words
+    with different results are reported to stderr (only ".entry" for IsReservedWord(),
+    see OldIsReservedWord()). Then every function is called CLASSIFY_ROUNDS times for
+    every sample word. Results are summed, so calls are not optimized out. */
+void RunClassifyBench(int repeat) {
+    char* words[] = {
+        "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc",
+        "dec", "jmp", "bne", "jsr", "red", "prn", "rts", "stop",
+        "r0", "r3", "r9", "r10", "r15", "r16",
+        ".data", ".string", ".entry", ".extern", "macro", "endm",
+        "MAIN", "LOOP", "END", "STR", "LIST", "K", "W", "vall", "x", "LBL1234"
+    }; /* Sample words: instructions, registers, directives, keywords and labels. */
+    int num_words = sizeof(words)/sizeof(words[0]); /* Number of sample words. */
+    int lens[sizeof(words)/sizeof(words[0])]; /* Lengths of sample words. */
+    const char* names[3] = { "IsReservedWord", "GetInstructionType", "GetDirectiveType" }; /* Measured functions. */
+    double best[3][2]; /* Best time of every function, current and old version. */
+    long sum = 0; /* Sum of results. */
+    int f, v, r, n, i; /* Functions, versions, runs, rounds and words iterators. */
+
+    for (i = 0; i < num_words; i++)
+        lens[i] = StringLen(words[i]);
+
+    printf("function,implementation,ns_per_word\n");
+    for (f = 0; f < 3; f++) {
+        for (i = 0; i < num_words; i++) {
+            if (ClassifyWithVersion(f, 0, words[i], lens[i]) != ClassifyWithVersion(f, 1, words[i], lens[i]))
+                fprintf(stderr, "Results of %s differ for [ %s ].\n", names[f], words[i]);
+        }
+    }
+
+    for (r = 0; r < repeat; r++) {
+        for (f = 0; f < 3; f++) {
+            for (v = 0; v < 2; v++) {
+                double start = Seconds(); /* Start time. */
+                for (n = 0; n < CLASSIFY_ROUNDS; n++) {
+                    for (i = 0; i < num_words; i++)
+                        sum += ClassifyWithVersion(f, v, words[i], lens[i]);
+                }
+                start = Seconds() - start;
+                if (r == 0 || start < best[f][v])
+                    best[f][v] = start;
+            }
+        }
+    }
+
+    for (f = 0; f < 3; f++) {
+        for (v = 1; v >= 0; v--)
+            printf("%s,%s,%.1f\n", names[f], v ? "old" : "ClassifyWord",
+                best[f][v] * 1e9 / ((double)CLASSIFY_ROUNDS * num_words));
+    }
+    if (sum == 0)
+        printf("No reserved words found.\n");
+}
+
+/* Prints row of output table.
+   Arguments:
+    lines   -- Number of source lines.
+    stage   -- Name of stage.
+    seconds -- Time of stage. */
+void PrintStageRow(int lines, const char* stage, double seconds) {
+    printf("%d,%s,%.6f,%.0f\n", lines, stage, seconds, seconds > 0 ? lines/seconds : 0.0);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options; /* Command line options. */
+    Arena* arena;         /* Arena for objects of current run. */
+    char name[32];        /* Name of generated source. */
+    int i, r, s;          /* Sizes, runs and stages iterators. */
+
+    ReadBenchOptions(argc, argv, &options);
+    if (options.classify) {
+        RunClassifyBench(options.repeat);
+        return 0;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    printf("lines,stage,seconds,lines_per_second\n");
+    for (i = 0; i < options.num_sizes; i++) {
+        double best[BENCH_STAGES]; /* Best time of every stage. */
+        double best_total = 0; /* Best time of whole file. */
+        int lines; /* Number of generated lines. */
+
+        sprintf(name, "bench_%d", options.sizes[i]);
+        options.params.lines = options.sizes[i];
+        lines = WriteWorkload(name, &options.params);
+        ResetArena(arena);
+
+        for (r = 0; r < options.repeat; r++) {
+            double times[BENCH_STAGES]; /* Times of current run. */
+            double total = 0; /* Time of whole file. */
+
+            if (RunStages(name, times, options.threads) != 0) {
+                fprintf(stderr, "Generated source [ %s.as ] has errors.\n", name);
+                FreeArena(arena);
+                return 1;
+            }
+            ResetArena(arena);
+
+            for (s = 0; s < BENCH_STAGES; s++) {
+                total += times[s];
+                if (r == 0 || times[s] < best[s])
+                    best[s] = times[s];
+            }
+            if (r == 0 || total < best_total)
+                best_total = total;
+        }
+
+        for (s = 0; s < BENCH_STAGES; s++)
+            PrintStageRow(lines, StageName(s), best[s]);
+        PrintStageRow(lines, "total", best_total);
+        fflush(stdout);
+    }
+
+    FreeWorkerArenas();
+    FreeArena(arena);
+    return 0;
+}
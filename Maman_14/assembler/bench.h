@@ -0,0 +1,92 @@
+#ifndef BENCH_H
+    #define BENCH_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Data.h"
+#include "DataContainers.h"
+#include "Symbols.h"
+#include "Errors.h"
+#include "Preprocessor.h"
+#include "Binary.h"
+#include "Output.h"
+#include "Stats.h"
+#include "Workload.h"
+
+/* Maximum number of sizes in sweep. */
+#define MAX_BENCH_SIZES 32
+/* Number of measured stages, first stages of StagesEnum (without .am and .obj writers). */
+#define BENCH_STAGES (st_write_externs+1)
+/* Number of rounds over sample words in one run of classification benchmark (--classify). */
+#define CLASSIFY_ROUNDS 50000
+
+/* Options given to benchmark in command line. */
+typedef struct BenchOptions {
+    WorkloadParams params;      /* Parameters of generated sources (number of lines is taken from sizes). */
+    int sizes[MAX_BENCH_SIZES]; /* Numbers of lines of sources. */
+    int num_sizes;              /* Number of sizes. */
+    int repeat;                 /* Number of runs of every size, best time is reported. */
+    int threads;                /* Number of threads that preprocess and encode a file (see PreprocessParallel()). */
+    int classify;               /* 1 if classification of reserved words is measured instead of stages. */
+} BenchOptions;
+
+/* Reads options from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadBenchOptions(int argc, char** argv, BenchOptions* options);
+
+/* Assembles source file and measures time of every stage.
+   Output files are written as by assembler.
+   Arguments:
+    fileName    -- Source file name without extension.
+    times       -- Array for returning time of every stage in seconds (by StagesEnum).
+    threads     -- Number of threads that preprocess and encode the file.
+   Returns:
+    Number of errors found in source. */
+int RunStages(char* fileName, double times[BENCH_STAGES], int threads);
+
+/* Checks if word is reserved the way IsReservedWord() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    s   -- Word, null-terminated.
+   Returns:
+    Value of ReservedWordsEnum. ".entry" is not found, as before. */
+int OldIsReservedWord(char* s);
+
+/* Gets instruction type the way GetInstructionType() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    ins -- Instruction name, null-terminated.
+   Returns:
+    Instruction number according to InstructionsEnum, -1 if name is not recognized. */
+int OldGetInstructionType(char* ins);
+
+/* Gets directive type the way GetDirectiveType() did before ClassifyWord()
+   (reference for classification benchmark).
+   Arguments:
+    name    -- Directive name, null-terminated.
+   Returns:
+    Directive type according to DirectivesEnum, -1 if name is not recognized. */
+int OldGetDirectiveType(char* name);
+
+/* Classifies word by one of measured functions of classification benchmark.
+   Arguments:
+    func    -- 0 for IsReservedWord(), 1 for GetInstructionType(), 2 for GetDirectiveType().
+    old     -- 1 for version before ClassifyWord(), 0 for current version.
+    word    -- Word, null-terminated.
+    len     -- Length of word.
+   Returns:
+    Result of the function. */
+int ClassifyWithVersion(int func, int old, char* word, int len);
+
+/* Measures classification of reserved words by ClassifyWord() and by the
+   functions it replaced, on mixed sample words. Prints table of results.
+   Arguments:
+    repeat  -- Number of runs, the best time is reported. */
+void RunClassifyBench(int repeat);
+
+#endif
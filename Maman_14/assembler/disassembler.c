@@ -0,0 +1,460 @@
+/* Program description:
+    This program turns object files produced by assembler (or by linker, see linker.c)
+    back to assembly source code.
+   Program operations:
+    Program takes names of object files without extensions as arguments. For every
+    program words are read from .ob file, label names from .ent file and external
+    references from .ext file, and disassembled source is written to <name>_dis.as.
+    Source of a correct program is assembled again to the same object file.
+   Algorithm:
+    -- Reading. Object file lines have fixed layout, so every word is read from known
+    positions by table of hex digits values (see ReadTextObject()).
+    -- Decoding. Instructions are found by lookup tables indexed by low 16 bits of first
+    and second words (see DecodeInstruction()), tables are built from instructions info.
+    -- Labels. Entries give names of their addresses and .ext file gives names of external
+    symbols by address of reference. Every other address referenced by instruction gets
+    label L<address> in code and D<address> in data.
+    -- Output. Code is written instruction by instruction, data words go to .data lines.
+    Whole text is collected in memory and written with one call.
+   Input:
+    Files <name>.ob, <name>.ent, <name>.ext (missing .ent and .ext are considered empty),
+    or <name>.obj with --obj option.
+   Output:
+    File <name>_dis.as.
+   Options:
+    --obj   Read programs from binary object .obj files (assembler --obj option).
+   */
+
+#include "disassembler.h"
+
+/* Reads options and program names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadDisassemblerOptions(int argc, char** argv, DisassemblerOptions* options) {
+    int argn; /* Argument number. */
+
+    options->binary = 0;
+
+    /* Allocating array of program names. There are no more program names than arguments. */
+    options->programs = (char**)malloc(sizeof(char*)*argc);
+    if (options->programs == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    options->num_programs = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        if (argv[argn][0] != '-') {
+            options->programs[options->num_programs] = argv[argn];
+            options->num_programs++;
+        }
+        else if (CompareStrings(argv[argn], "--obj"))
+            options->binary = 1;
+        else
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+/* Adds entry name of address.
+   Arguments:
+    d       -- Disassembly.
+    name    -- Entry name (not null-terminated).
+    len     -- Length of entry name.
+    address -- Address of entry. */
+void AddEntryLabel(Disassembly* d, char* name, int len, int address) {
+    char* label; /* Copy of the name. */
+
+    if (len == 0 || address < PROGRAM_BASE || address >= PROGRAM_BASE + d->code_count + d->data_count)
+        return;
+
+    label = (char*)Allocate(sizeof(char)*(len+1));
+    memcpy(label, name, len);
+    label[len] = '\0';
+    d->labels[address - PROGRAM_BASE] = label;
+
+    AppendText(&(d->entries), ".entry ", 7);
+    AppendText(&(d->entries), label, len);
+    AppendText(&(d->entries), "\n", 1);
+}
+
+/* Adds external symbol reference.
+   Arguments:
+    d       -- Disassembly.
+    name    -- Symbol name (not null-terminated).
+    len     -- Length of symbol name.
+    address -- Address of reference base word.
+   Algorithm:
+    Every symbol gets one .extern line when its first reference is added. */
+void AddExternReference(Disassembly* d, char* name, int len, int address) {
+    char* symbol; /* Copy of the name. */
+    char* declared; /* Name in table of declared symbols. */
+
+    if (len == 0 || address < PROGRAM_BASE || address >= PROGRAM_BASE + d->code_count)
+        return;
+
+    symbol = (char*)Allocate(sizeof(char)*(len+1));
+    memcpy(symbol, name, len);
+    symbol[len] = '\0';
+
+    declared = (char*)HashMapGet(d->declared, symbol);
+    if (declared == NULL) {
+        HashMapAdd(d->declared, symbol, symbol);
+        AppendText(&(d->extern_decls), ".extern ", 8);
+        AppendText(&(d->extern_decls), symbol, len);
+        AppendText(&(d->extern_decls), "\n", 1);
+        declared = symbol;
+    }
+    d->externs[address - PROGRAM_BASE] = declared;
+}
+
+/* Reads words, entries and external references of program.
+   Arguments:
+    d       -- Disassembly. Name is set.
+    binary  -- 1 if program is read from binary .obj file, 0 for text .ob, .ent, .ext files.
+   Returns:
+    1 if program is read, 0 otherwise (message is printed).
+   Algorithm:
+    Lines of .ent file are NAME,BASE,OFFSET. Lines of .ext file are NAME BASE ADDRESS
+    and NAME OFFSET ADDRESS+1, only BASE lines are used. */
+int ReadDisassembly(Disassembly* d, int binary) {
+    int len = StringLen(d->name); /* Length of program name. */
+    char* fullName = (char*)Allocate(sizeof(char)*(len+5)); /* Name with extension. */
+    ObjectFile* obj = NULL; /* Binary object file. */
+    unsigned char* text;    /* Content of .ent, or .ext file. */
+    size_t size;            /* Size of .ent, or .ext file. */
+    size_t pos;             /* Position in text. */
+    int nameLen;            /* Length of entry, or symbol name. */
+    int total;              /* Number of words. */
+    int i;                  /* Iterator. */
+
+    /* Reading words. */
+    if (binary) {
+        AppendExtension(d->name, "obj", fullName, len+4);
+        obj = OpenObjectFile(fullName);
+        if (obj == NULL)
+            return 0;
+        d->code_count = obj->code_count;
+        d->data_count = obj->data_count;
+        d->words = (int*)Allocate(sizeof(int)*(d->code_count + d->data_count + 1));
+        for (i = 0; i < d->code_count + d->data_count; i++)
+            d->words[i] = GetObjectWord(obj, i);
+    }
+    else {
+        AppendExtension(d->name, "ob", fullName, len+4);
+        d->words = ReadTextObject(fullName, &(d->code_count), &(d->data_count));
+        if (d->words == NULL)
+            return 0;
+    }
+
+    total = d->code_count + d->data_count;
+    d->labels = (char**)Allocate(sizeof(char*)*(total+1));
+    d->externs = (char**)Allocate(sizeof(char*)*(total+1));
+    d->used = (char*)Allocate(sizeof(char)*(total+1));
+    for (i = 0; i < total; i++) {
+        d->labels[i] = NULL;
+        d->externs[i] = NULL;
+        d->used[i] = 0;
+    }
+    InitOutputBuffer(&(d->entries), 256);
+    InitOutputBuffer(&(d->extern_decls), 256);
+    d->declared = CreateHashMap(64);
+
+    if (binary) {
+        for (i = 0; i < obj->num_entries; i++) {
+            int address; /* Address of entry. */
+            char* name = GetObjectEntry(obj, i, &address); /* Name of entry. */
+            AddEntryLabel(d, name, StringLen(name), address);
+        }
+        for (i = 0; i < obj->num_externs; i++) {
+            int address; /* Address of reference. */
+            char* name = GetObjectExtern(obj, i, &address); /* Name of symbol. */
+            AddExternReference(d, name, StringLen(name), address);
+        }
+        CloseObjectFile(obj);
+        return 1;
+    }
+
+    /* Reading entries. */
+    AppendExtension(d->name, "ent", fullName, len+4);
+    text = MapFile(fullName, &size);
+    for (pos = 0; text != NULL && pos < size; ) {
+        size_t start = pos; /* Position of the name. */
+        int base, offset;   /* Address of the entry. */
+
+        while (pos < size && text[pos] != ',' && text[pos] != '\n')
+            pos++;
+        nameLen = pos - start;
+        pos++;
+        base = ReadTextNumber(text, &pos, size);
+        pos++;
+        offset = ReadTextNumber(text, &pos, size);
+        pos++;
+        if (base == -1 || offset == -1)
+            break;
+        AddEntryLabel(d, (char*)text + start, nameLen, base + offset);
+    }
+    if (text != NULL)
+        UnmapFile(text, size);
+
+    /* Reading external references. */
+    AppendExtension(d->name, "ext", fullName, len+4);
+    text = MapFile(fullName, &size);
+    for (pos = 0; text != NULL && pos < size; ) {
+        size_t start = pos; /* Position of the name. */
+        int is_base;        /* 1 if line is BASE line. */
+        int address;        /* Address in line. */
+
+        /* Skipping empty lines. */
+        if (text[pos] == '\n') {
+            pos++;
+            continue;
+        }
+
+        while (pos < size && text[pos] != ' ' && text[pos] != '\n')
+            pos++;
+        nameLen = pos - start;
+        pos++;
+        is_base = pos + 5 <= size && memcmp(text + pos, "BASE ", 5) == 0;
+        while (pos < size && text[pos] != ' ' && text[pos] != '\n')
+            pos++;
+        pos++;
+        address = ReadTextNumber(text, &pos, size);
+        pos++;
+        if (address == -1)
+            break;
+        if (is_base)
+            AddExternReference(d, (char*)text + start, nameLen, address);
+    }
+    if (text != NULL)
+        UnmapFile(text, size);
+
+    return 1;
+}
+
+/* Finds addresses referenced by instructions.
+   Arguments:
+    d   -- Disassembly. */
+void MarkReferences(Disassembly* d) {
+    int pos = 0;  /* Index of current word in code. */
+
+    while (pos < d->code_count) {
+        DecodedIns ins; /* Decoded instruction. */
+        DecodedArg* args[2]; /* Arguments of instruction. */
+        int i; /* Arguments iterator. */
+
+        if (!DecodeInstruction(d->words, d->code_count, pos, &ins)) {
+            pos++;
+            continue;
+        }
+
+        args[0] = &(ins.src);
+        args[1] = &(ins.dest);
+        for (i = 0; i < 2; i++) {
+            int index = args[i]->value - PROGRAM_BASE; /* Index of referenced address. */
+            if ((args[i]->mode == am_direct || args[i]->mode == am_index) && args[i]->are != 1 &&
+                index >= 0 && index < d->code_count + d->data_count)
+                d->used[index] = 1;
+        }
+
+        pos += ins.length;
+    }
+}
+
+/* Adds name of address (entry name, or L<address>, D<address> for code and data).
+   Arguments:
+    buf     -- Output buffer.
+    d       -- Disassembly.
+    address -- Address. */
+void AppendLabel(OutputBuffer* buf, Disassembly* d, int address) {
+    int index = address - PROGRAM_BASE; /* Index of address. */
+
+    if (index >= 0 && index < d->code_count + d->data_count && d->labels[index] != NULL) {
+        AppendText(buf, d->labels[index], StringLen(d->labels[index]));
+        return;
+    }
+
+    AppendText(buf, index >= 0 && index < d->code_count ? "L" : "D", 1);
+    AppendNumber(buf, address, 0);
+}
+
+/* Adds instruction operand in source code syntax.
+   Arguments:
+    buf     -- Output buffer.
+    d       -- Disassembly.
+    arg     -- Decoded argument. */
+void AppendArgument(OutputBuffer* buf, Disassembly* d, DecodedArg* arg) {
+    switch (arg->mode) {
+    case am_immediate:
+        AppendText(buf, "#", 1);
+        AppendNumber(buf, arg->value, 0);
+        break;
+    case am_direct:
+    case am_index:
+        if (arg->are == 1) {
+            char* name = d->externs[arg->pos]; /* Name of external symbol. */
+            if (name == NULL)
+                name = "?";
+            AppendText(buf, name, StringLen(name));
+        }
+        else
+            AppendLabel(buf, d, arg->value);
+        if (arg->mode == am_index) {
+            AppendText(buf, "[r", 2);
+            AppendNumber(buf, arg->reg, 0);
+            AppendText(buf, "]", 1);
+        }
+        break;
+    case am_rdirect:
+        AppendText(buf, "r", 1);
+        AppendNumber(buf, arg->reg, 0);
+        break;
+    }
+}
+
+/* Writes disassembled program to <name>_dis.as.
+   Arguments:
+    d   -- Disassembly.
+   Algorithm:
+    Line of instruction, or of the first data word gets label if address
+    is an entry, or is referenced by instruction. Words that are not correct
+    instructions are written as comments. References to addresses inside of
+    instructions are reported (possible when program has more than 2^16 words,
+    so that address fields wrap). */
+void WriteDisassembly(Disassembly* d) {
+    OutputBuffer buf;   /* Resulting text. */
+    char* names[16];    /* Names of instructions. */
+    int name_lens[16];  /* Lengths of instruction names. */
+    int len = StringLen(d->name); /* Length of program name. */
+    char* outName = (char*)Allocate(sizeof(char)*(len+5)); /* Name of resulting file without extension. */
+    int pos = 0;        /* Index of current word. */
+    int count = 0;      /* Number of values in current .data line. */
+    int missing = 0;    /* Number of referenced addresses without labels. */
+    int i;              /* Iterator. */
+
+    for (i = ins_mov; i <= ins_stop; i++) {
+        names[i] = (char*)GetInstructionInfo(i)->name;
+        name_lens[i] = StringLen(names[i]);
+    }
+
+    /* Text is about the size of object file. */
+    InitOutputBuffer(&buf, (d->code_count + d->data_count)*12 + d->entries.length + d->extern_decls.length + 256);
+    AppendText(&buf, ";file ", 6);
+    AppendText(&buf, d->name, len);
+    AppendText(&buf, "_dis.as\n", 8);
+    AppendText(&buf, d->entries.text, d->entries.length);
+    AppendText(&buf, d->extern_decls.text, d->extern_decls.length);
+    AppendText(&buf, "\n", 1);
+
+    /* Code. */
+    while (pos < d->code_count) {
+        DecodedIns ins; /* Decoded instruction. */
+
+        if (!DecodeInstruction(d->words, d->code_count, pos, &ins)) {
+            char word[15]; /* Word in object file format. */
+            BinaryToSpecial(d->words[pos], word);
+            AppendText(&buf, "; ", 2);
+            AppendNumber(&buf, PROGRAM_BASE + pos, 4);
+            AppendText(&buf, " ", 1);
+            AppendText(&buf, word, 14);
+            AppendText(&buf, " is not an instruction\n", 23);
+            pos++;
+            continue;
+        }
+
+        if (d->labels[pos] != NULL || d->used[pos]) {
+            AppendLabel(&buf, d, PROGRAM_BASE + pos);
+            AppendText(&buf, ":", 1);
+            d->used[pos] = 2;
+        }
+        AppendText(&buf, "\t", 1);
+        AppendText(&buf, names[ins.ins], name_lens[ins.ins]);
+        if (ins.num_args == 2) {
+            AppendText(&buf, "\t", 1);
+            AppendArgument(&buf, d, &(ins.src));
+            AppendText(&buf, ", ", 2);
+            AppendArgument(&buf, d, &(ins.dest));
+        }
+        else if (ins.num_args == 1) {
+            AppendText(&buf, "\t", 1);
+            AppendArgument(&buf, d, &(ins.dest));
+        }
+        AppendText(&buf, "\n", 1);
+
+        pos += ins.length;
+    }
+
+    /* Data. New line is started for every label. */
+    for (pos = d->code_count; pos < d->code_count + d->data_count; pos++) {
+        int labeled = d->labels[pos] != NULL || d->used[pos]; /* 1 if word has label. */
+
+        if (count > 0 && (labeled || count == DATA_PER_LINE)) {
+            AppendText(&buf, "\n", 1);
+            count = 0;
+        }
+        if (count == 0) {
+            if (labeled) {
+                AppendLabel(&buf, d, PROGRAM_BASE + pos);
+                AppendText(&buf, ":", 1);
+            }
+            AppendText(&buf, "\t.data\t", 7);
+        }
+        else
+            AppendText(&buf, ", ", 2);
+        AppendNumber(&buf, (((d->words[pos]) & 0xffff) ^ 0x8000) - 0x8000, 0);
+        count++;
+    }
+    if (count > 0)
+        AppendText(&buf, "\n", 1);
+
+    /* Referenced addresses inside of instructions can't get labels. */
+    for (pos = 0; pos < d->code_count; pos++)
+        if (d->used[pos] == 1)
+            missing++;
+    if (missing > 0)
+        printf("Program [ %s ] has %d references to addresses inside of instructions, they have no labels.\n", d->name, missing);
+
+    memcpy(outName, d->name, len);
+    memcpy(outName + len, "_dis", 5);
+    WriteOutputFile(outName, "as", &buf);
+}
+
+/* Main function. Disassembles every program given in arguments. */
+int main(int argc, char** argv) {
+    DisassemblerOptions options; /* Command line options. */
+    Arena* arena;               /* Arena for objects of current program. */
+    int failed = 0;             /* Number of programs that were not disassembled. */
+    int i;                      /* Programs iterator. */
+
+    ReadDisassemblerOptions(argc, argv, &options);
+    if (options.num_programs == 0) {
+        printf("No programs to disassemble.\n");
+        return 1;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    for (i = 0; i < options.num_programs; i++) {
+        Disassembly d; /* Current program. */
+
+        d.name = options.programs[i];
+        if (!ReadDisassembly(&d, options.binary)) {
+            printf("Failed to disassemble program [ %s ].\n", d.name);
+            failed++;
+        }
+        else {
+            MarkReferences(&d);
+            WriteDisassembly(&d);
+            printf("Program [ %s ] is disassembled to [ %s_dis.as ]\n", d.name, d.name);
+        }
+
+        ResetArena(arena);
+    }
+
+    FreeArena(arena);
+    free(options.programs);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#ifndef DISASSEMBLER_H
+    #define DISASSEMBLER_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Data.h"
+#include "Object.h"
+#include "Output.h"
+
+/* Maximum number of values in one .data line of disassembled program. */
+#define DATA_PER_LINE 8
+
+/* Options given to disassembler in command line. */
+typedef struct DisassemblerOptions {
+    int binary;         /* 1 if programs are read from binary .obj files (--obj). */
+    char** programs;    /* Program names given as arguments (without extensions). */
+    int num_programs;   /* Number of programs. */
+} DisassemblerOptions;
+
+/* Program being disassembled. */
+typedef struct Disassembly {
+    char* name;         /* Name of object file without extension. */
+    int* words;         /* Code and then data words. */
+    int code_count;     /* Number of code words. */
+    int data_count;     /* Number of data words. */
+    char** labels;      /* Label name by address - PROGRAM_BASE (entries), NULL if there is no name. */
+    char** externs;     /* External symbol name by index of reference base word, NULL if there is no reference. */
+    char* used;         /* 1 by address - PROGRAM_BASE if address is referenced by instruction, 2 after label is written. */
+    OutputBuffer entries; /* Text of .entry lines. */
+    OutputBuffer extern_decls; /* Text of .extern lines. */
+    HashMap* declared;  /* Names of external symbols that have .extern line. */
+} Disassembly;
+
+/* Reads options and program names from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadDisassemblerOptions(int argc, char** argv, DisassemblerOptions* options);
+
+/* Reads words, entries and external references of program.
+   Arguments:
+    d       -- Disassembly. Name is set.
+    binary  -- 1 if program is read from binary .obj file, 0 for text .ob, .ent, .ext files.
+   Returns:
+    1 if program is read, 0 otherwise (message is printed). */
+int ReadDisassembly(Disassembly* d, int binary);
+
+/* Adds entry name of address.
+   Arguments:
+    d       -- Disassembly.
+    name    -- Entry name (not null-terminated).
+    len     -- Length of entry name.
+    address -- Address of entry. */
+void AddEntryLabel(Disassembly* d, char* name, int len, int address);
+
+/* Adds external symbol reference.
+   Arguments:
+    d       -- Disassembly.
+    name    -- Symbol name (not null-terminated).
+    len     -- Length of symbol name.
+    address -- Address of reference base word. */
+void AddExternReference(Disassembly* d, char* name, int len, int address);
+
+/* Finds addresses referenced by instructions.
+   Arguments:
+    d   -- Disassembly. */
+void MarkReferences(Disassembly* d);
+
+/* Adds name of address (entry name, or L<address>, D<address> for code and data).
+   Arguments:
+    buf     -- Output buffer.
+    d       -- Disassembly.
+    address -- Address. */
+void AppendLabel(OutputBuffer* buf, Disassembly* d, int address);
+
+/* Adds instruction operand in source code syntax.
+   Arguments:
+    buf     -- Output buffer.
+    d       -- Disassembly.
+    arg     -- Decoded argument. */
+void AppendArgument(OutputBuffer* buf, Disassembly* d, DecodedArg* arg);
+
+/* Writes disassembled program to <name>_dis.as.
+   Arguments:
+    d   -- Disassembly. */
+void WriteDisassembly(Disassembly* d);
+
+#endif
@@ -0,0 +1,75 @@
+/* Program description:
+    This program generates synthetic assembly sources for measuring
+    the assembler on big inputs (see bench.c).
+   Program operations:
+    Program takes names of sources without extensions as arguments and writes
+    <name>.as for every name. Source is a correct program with given number of lines,
+    label density, macros, part of data directives and external symbols (see Workload.h).
+    Every next source gets next seed, so sources of one run are different.
+   Options:
+    -n LINES            Number of lines of every source (default 1000).
+    --labels PERCENT    Percent of statements with label (default 30).
+    --macros N          Number of macro definitions (default 4).
+    --macro-size N      Number of statements in macro body (default 3).
+    --data PERCENT      Percent of .data statements (default 15).
+    --string PERCENT    Percent of .string statements (default 5).
+    --externs N         Number of external symbols (default 4).
+    --seed N            Seed of random numbers of first source (default 1).
+   */
+
+#include "generator.h"
+
+/* Reads options and source names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadGeneratorOptions(int argc, char** argv, GeneratorOptions* options) {
+    int argn; /* Argument number. */
+
+    DefaultWorkload(&options->params);
+
+    /* Allocating array of source names. There are no more source names than arguments. */
+    options->names = (char**)malloc(sizeof(char*)*argc);
+    if (options->names == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    options->num_names = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        if (argv[argn][0] != '-') {
+            options->names[options->num_names] = argv[argn];
+            options->num_names++;
+        }
+        else if (!ReadWorkloadOption(argc, argv, &argn, &options->params))
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+int main(int argc, char** argv) {
+    GeneratorOptions options; /* Command line options. */
+    Arena* arena;             /* Arena for objects of current source. */
+    int i;                    /* Sources iterator. */
+
+    ReadGeneratorOptions(argc, argv, &options);
+    if (options.num_names == 0) {
+        printf("No sources to generate.\n");
+        return 1;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    for (i = 0; i < options.num_names; i++) {
+        int lines = WriteWorkload(options.names[i], &options.params); /* Number of written lines. */
+        printf("Source [ %s.as ] is generated, %d lines.\n", options.names[i], lines);
+        options.params.seed++;
+        ResetArena(arena);
+    }
+
+    FreeArena(arena);
+    free(options.names);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef GENERATOR_H
+    #define GENERATOR_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Workload.h"
+
+/* Options given to generator in command line. */
+typedef struct GeneratorOptions {
+    WorkloadParams params;  /* Parameters of generated sources. */
+    char** names;           /* Names of sources to generate (without extension). */
+    int num_names;          /* Number of names. */
+} GeneratorOptions;
+
+/* Reads options and source names from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadGeneratorOptions(int argc, char** argv, GeneratorOptions* options);
+
+#endif
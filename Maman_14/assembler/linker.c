@@ -0,0 +1,497 @@
+/* Program description:
+    This program links object files produced by assembler into one object file.
+    Every source file is assembled as if its code starts at address 100 and
+    its data follows its code. References to symbols of other source files
+    (.extern) are left as zero words with ARE=External.
+   Program operations:
+    Program takes module names (source file names without extensions) as arguments,
+    reads object file and symbols files of every module, places code of all modules one
+    after another starting at address 100 and data of all modules after all code.
+    Then base+offset words of references are relocated to new addresses and
+    external references are resolved. If no errors were encountered linked object
+    file is written in the same format as .ob file of assembler.
+   Algorithm:
+    -- Every module is read once. Files are mapped to memory and parsed in place.
+    Words of .ob file go to array of words of the module, entries of .ent file go to global
+    symbols table (hash map by name) and references of .ext file go to list of external
+    references. Code address of a module is known when it is read (sum of code sizes of previous
+    modules), data address is set when all modules are read.
+    -- Relocation. Code of every module is decoded instruction by instruction (addressing modes are
+    taken from second word), so data words of arguments are found without guessing.
+    Base+offset words with ARE=Relocatable are translated from address in module to address
+    in linked program.
+    -- Resolving. Every external reference is searched in global symbols table, address of the symbol
+    is relocated and written to base+offset words of reference with ARE=Relocatable.
+   Input:
+    Files <name>.ob, <name>.ent, <name>.ext of every module (missing .ent and .ext are considered empty),
+    or <name>.obj files with --obj option.
+   Options:
+    -o NAME Name of linked object file without extension (NAME.ob). Default is "a".
+    --obj   Read modules from binary object .obj files (assembler --obj option).
+   */
+
+#include "linker.h"
+
+/* Reads options and module names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadLinkerOptions(int argc, char** argv, LinkerOptions* options) {
+    int argn; /* Argument number. */
+
+    /* Default options. */
+    options->output = "a";
+    options->binary = 0;
+
+    /* Allocating array of module names. There are no more module names than arguments. */
+    options->modules = (char**)malloc(sizeof(char*)*argc);
+    if (options->modules == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    options->num_modules = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        /* Saving module name. */
+        if (argv[argn][0] != '-') {
+            options->modules[options->num_modules] = argv[argn];
+            options->num_modules++;
+        }
+        else if (CompareStrings(argv[argn], "--obj"))
+            options->binary = 1;
+        else if (CompareStrings(argv[argn], "-o") && argn+1 < argc)
+            options->output = argv[++argn];
+        else
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+/* Copies characters to null-terminated string allocated in current arena.
+   Arguments:
+    text    -- Characters.
+    len     -- Number of characters.
+   Returns:
+    New string. */
+char* CopyText(unsigned char* text, int len) {
+    char* s = (char*)Allocate(sizeof(char)*(len+1)); /* New string. */
+
+    memcpy(s, text, len);
+    s[len] = '\0';
+    return s;
+}
+
+/* Adds symbol defined by .entry to global symbols table.
+   Arguments:
+    globals     -- Global symbols table.
+    name        -- Symbol name (copied).
+    len         -- Length of symbol name.
+    module      -- Module where symbol is defined.
+    address     -- Address of symbol in module.
+   Returns:
+    1 if symbol is already defined by another module (message is printed), 0 otherwise. */
+int AddGlobalSymbol(HashMap* globals, char* name, int len, Module* module, int address) {
+    char* key = CopyText((unsigned char*)name, len); /* Symbol name. */
+    GlobalSymbol* smb; /* New symbol. */
+
+    /* Checking if symbol already defined. */
+    smb = HashMapGet(globals, key);
+    if (smb != NULL) {
+        printf("Symbol [ %s ] is defined by both [ %s ] and [ %s ].\n", key, smb->module->name, module->name);
+        return 1;
+    }
+
+    smb = (GlobalSymbol*)Allocate(sizeof(GlobalSymbol));
+    smb->module = module;
+    smb->address = address;
+    HashMapAdd(globals, key, smb);
+
+    return 0;
+}
+
+/* Reads entries of module from text .ent file and adds them to global symbols table.
+   Arguments:
+    module      -- Module.
+    fileName    -- Full file name.
+    globals     -- Global symbols table.
+   Returns:
+    Number of errors.
+   Algorithm:
+    Every line is NAME,BASE,OFFSET. Address of the symbol is BASE+OFFSET.
+    Missing file is considered empty. */
+int ReadTextEntries(Module* module, char* fileName, HashMap* globals) {
+    unsigned char* text; /* Content of the file. */
+    size_t size;         /* Size of the file. */
+    size_t pos = 0;      /* Position in text. */
+    int errors = 0;      /* Number of errors. */
+
+    text = MapFile(fileName, &size);
+    if (text == NULL)
+        return 0;
+
+    while (pos < size) {
+        size_t start = pos; /* Position of the name. */
+        int len;            /* Length of the name. */
+        int base, offset;   /* Address of the symbol. */
+
+        /* Reading name. */
+        while (pos < size && text[pos] != ',' && text[pos] != '\n')
+            pos++;
+        len = pos - start;
+        /* Reading address. */
+        pos++;
+        base = ReadTextNumber(text, &pos, size);
+        pos++;
+        offset = ReadTextNumber(text, &pos, size);
+        if (len == 0 || base == -1 || offset == -1 || (pos < size && text[pos] != '\n')) {
+            printf("Entries file [ %s ] has incorrect line.\n", fileName);
+            errors++;
+            break;
+        }
+        pos++;
+
+        errors += AddGlobalSymbol(globals, (char*)text + start, len, module, base + offset);
+    }
+
+    UnmapFile(text, size);
+    return errors;
+}
+
+/* Reads references to external symbols of module from text .ext file.
+   Arguments:
+    module      -- Module.
+    fileName    -- Full file name.
+    externs     -- Vector of references to add to.
+   Returns:
+    Number of errors.
+   Algorithm:
+    Every reference is two lines NAME BASE ADDRESS and NAME OFFSET ADDRESS+1,
+    references are separated by empty line. Only BASE lines are used.
+    Missing file is considered empty. */
+int ReadTextExterns(Module* module, char* fileName, Vector* externs) {
+    unsigned char* text; /* Content of the file. */
+    size_t size;         /* Size of the file. */
+    size_t pos = 0;      /* Position in text. */
+    int errors = 0;      /* Number of errors. */
+
+    text = MapFile(fileName, &size);
+    if (text == NULL)
+        return 0;
+
+    while (pos < size) {
+        size_t start = pos; /* Position of the name. */
+        int len;            /* Length of the name. */
+        int is_base;        /* 1 if line is BASE line. */
+        int address;        /* Address in line. */
+
+        /* Skipping empty lines. */
+        if (text[pos] == '\n') {
+            pos++;
+            continue;
+        }
+
+        /* Reading name. */
+        while (pos < size && text[pos] != ' ' && text[pos] != '\n')
+            pos++;
+        len = pos - start;
+        /* Reading word type. */
+        is_base = pos + 6 <= size && memcmp(text + pos, " BASE ", 6) == 0;
+        if (is_base)
+            pos += 6;
+        else if (pos + 8 <= size && memcmp(text + pos, " OFFSET ", 8) == 0)
+            pos += 8;
+        else
+            len = 0;
+        address = ReadTextNumber(text, &pos, size);
+        if (len == 0 || address == -1 || (pos < size && text[pos] != '\n')) {
+            printf("Externals file [ %s ] has incorrect line.\n", fileName);
+            errors++;
+            break;
+        }
+
+        /* Saving reference. */
+        if (is_base) {
+            ExternReference* ref = (ExternReference*)VectorAdd(externs);
+            ref->module = module;
+            ref->name = CopyText(text + start, len);
+            ref->address = address;
+        }
+    }
+
+    UnmapFile(text, size);
+    return errors;
+}
+
+/* Reads module from binary .obj file.
+   Arguments:
+    module      -- Module. Words and counts are set.
+    fileName    -- Full file name.
+    globals     -- Global symbols table.
+    externs     -- Vector of references to add to.
+   Returns:
+    Number of errors. */
+int ReadBinaryModule(Module* module, char* fileName, HashMap* globals, Vector* externs) {
+    ObjectFile* obj; /* Binary object file. */
+    int errors = 0;  /* Number of errors. */
+    int i;           /* Iterator. */
+
+    obj = OpenObjectFile(fileName);
+    if (obj == NULL) {
+        module->failed = 1;
+        return 1;
+    }
+    if (obj->code_base != PROGRAM_BASE) {
+        printf("Object file [ %s ] has code base %d instead of %d.\n", fileName, obj->code_base, PROGRAM_BASE);
+        module->failed = 1;
+        CloseObjectFile(obj);
+        return 1;
+    }
+
+    /* Copying words. */
+    module->code_count = obj->code_count;
+    module->data_count = obj->data_count;
+    module->words = (int*)Allocate(sizeof(int)*(module->code_count + module->data_count + 1));
+    for (i = 0; i < module->code_count + module->data_count; i++)
+        module->words[i] = GetObjectWord(obj, i);
+
+    /* Adding entries to global symbols table. */
+    for (i = 0; i < obj->num_entries; i++) {
+        int address; /* Entry address. */
+        char* name = GetObjectEntry(obj, i, &address); /* Entry name. */
+        errors += AddGlobalSymbol(globals, name, StringLen(name), module, address);
+    }
+
+    /* Adding references. */
+    for (i = 0; i < obj->num_externs; i++) {
+        ExternReference* ref = (ExternReference*)VectorAdd(externs);
+        ref->module = module;
+        ref->name = CopyStringToHeap(GetObjectExtern(obj, i, &(ref->address)));
+    }
+
+    CloseObjectFile(obj);
+    return errors;
+}
+
+/* Translates address in module (as assembled) to address in linked program.
+   Arguments:
+    module  -- Module.
+    address -- Address in module.
+   Returns:
+    Address in linked program, or -1 if address is not in module. */
+int RelocateAddress(Module* module, int address) {
+    /* Code address. */
+    if (address >= PROGRAM_BASE && address < PROGRAM_BASE + module->code_count)
+        return module->code_base + (address - PROGRAM_BASE);
+
+    /* Data address. Data of the module follows its code. */
+    address -= PROGRAM_BASE + module->code_count;
+    if (address >= 0 && address < module->data_count)
+        return module->data_base + address;
+
+    return -1;
+}
+
+/* Relocates base+offset words of direct, or index argument
+   if they are relocatable (not external).
+   Arguments:
+    module  -- Module.
+    arg     -- Decoded argument.
+   Returns:
+    1 if address is not in module (message is printed), 0 otherwise. */
+int RelocateArgument(Module* module, DecodedArg* arg) {
+    int address; /* Relocated address. */
+    BOAddress bo; /* Relocated address in base+offset format. */
+
+    /* Only direct and index arguments have addresses. 
+       Words of external symbols are written by ResolveExterns(). */
+    if ((arg->mode != am_direct && arg->mode != am_index) || arg->are != 2)
+        return 0;
+
+    address = RelocateAddress(module, arg->value);
+    if (address == -1) {
+        printf("Module [ %s ] has reference to incorrect address %d at address %d.\n", module->name, arg->value, PROGRAM_BASE + arg->pos);
+        return 1;
+    }
+
+    bo = AddressToBO(address);
+    module->words[arg->pos] = (2 << 16) | bo.base;
+    module->words[arg->pos+1] = (2 << 16) | bo.offset;
+
+    return 0;
+}
+
+/* Relocates base+offset words of references to internal symbols in module code.
+   Arguments:
+    module  -- Module.
+   Returns:
+    Number of errors.
+   Algorithm:
+    Code is decoded instruction by instruction, so data words of arguments
+    are found by addressing modes of instructions. */
+int RelocateModule(Module* module) {
+    int i = 0;      /* Index of current word in code. */
+    int errors = 0; /* Number of errors. */
+
+    while (i < module->code_count) {
+        DecodedIns ins; /* Decoded instruction. */
+
+        if (!DecodeInstruction(module->words, module->code_count, i, &ins)) {
+            printf("Module [ %s ] has incorrect instruction at address %d.\n", module->name, PROGRAM_BASE + i);
+            return errors + 1;
+        }
+
+        /* Relocating source and destination arguments. */
+        if (ins.num_args == 2)
+            errors += RelocateArgument(module, &(ins.src));
+        if (ins.num_args >= 1)
+            errors += RelocateArgument(module, &(ins.dest));
+
+        i += ins.length;
+    }
+
+    return errors;
+}
+
+/* Writes base+offset words of references to external symbols.
+   Arguments:
+    externs -- Vector of references.
+    globals -- Global symbols table.
+   Returns:
+    Number of errors. */
+int ResolveExterns(Vector* externs, HashMap* globals) {
+    int errors = 0; /* Number of errors. */
+    int i;          /* References iterator. */
+
+    for (i = 0; i < externs->count; i++) {
+        ExternReference* ref = (ExternReference*)VectorAt(externs, i);
+        GlobalSymbol* smb = HashMapGet(globals, ref->name); /* Referenced symbol. */
+        int index = ref->address - PROGRAM_BASE; /* Index of base word in module code. */
+        BOAddress bo; /* Address of the symbol. */
+
+        if (smb == NULL) {
+            printf("Module [ %s ]: external symbol [ %s ] is not defined by any module.\n", ref->module->name, ref->name);
+            errors++;
+            continue;
+        }
+        if (index < 0 || index + 1 >= ref->module->code_count || RelocateAddress(smb->module, smb->address) == -1) {
+            printf("Module [ %s ]: reference to [ %s ] has incorrect address.\n", ref->module->name, ref->name);
+            errors++;
+            continue;
+        }
+
+        /* Writing address of the symbol. */
+        bo = AddressToBO(RelocateAddress(smb->module, smb->address));
+        ref->module->words[index] = (2 << 16) | bo.base;
+        ref->module->words[index+1] = (2 << 16) | bo.offset;
+    }
+
+    return errors;
+}
+
+/* Main function.
+   Reads every module, relocates modules code and resolves external references.
+   If no errors were encountered writes linked object file. */
+int main(int argc, char** argv) {
+    LinkerOptions options; /* Command line options. */
+    Arena* arena;          /* Arena for all objects of the linker. */
+    Module* modules;       /* Modules. */
+    HashMap* globals;      /* Global symbols table. */
+    Vector* externs;         /* References to external symbols. */
+    BinarySegment* code;   /* Code of linked program. */
+    BinarySegment* data;   /* Data of linked program. */
+    int address;           /* Address of next module code, or data. */
+    int errors = 0;        /* Number of errors. */
+    int i, j;              /* Iterators. */
+
+    ReadLinkerOptions(argc, argv, &options);
+    if (options.num_modules == 0) {
+        printf("No modules to link.\n");
+        return 1;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    modules = (Module*)Allocate(sizeof(Module)*options.num_modules);
+    globals = CreateHashMap(options.num_modules*4);
+    externs = CreateVector(sizeof(ExternReference), 64);
+
+    printf("Linking %d modules into [ %s.ob ]\n", options.num_modules, options.output);
+
+    /* Reading modules. Code is placed one module after another. */
+    address = PROGRAM_BASE;
+    for (i = 0; i < options.num_modules; i++) {
+        Module* module = &(modules[i]);
+        char* name = options.modules[i];
+        int len = StringLen(name);
+        char* fullName = (char*)Allocate(sizeof(char)*(len+5)); /* Name with extension. */
+
+        module->name = name;
+        module->failed = 0;
+        module->code_count = 0;
+        module->data_count = 0;
+
+        if (options.binary) {
+            AppendExtension(name, "obj", fullName, len+4);
+            errors += ReadBinaryModule(module, fullName, globals, externs);
+        }
+        else {
+            AppendExtension(name, "ob", fullName, len+4);
+            module->words = ReadTextObject(fullName, &(module->code_count), &(module->data_count));
+            if (module->words == NULL) {
+                module->failed = 1;
+                errors++;
+            }
+            else {
+                AppendExtension(name, "ent", fullName, len+4);
+                errors += ReadTextEntries(module, fullName, globals);
+                AppendExtension(name, "ext", fullName, len+4);
+                errors += ReadTextExterns(module, fullName, externs);
+            }
+        }
+
+        module->code_base = address;
+        address += module->code_count;
+    }
+
+    /* Data of all modules follows code of all modules. */
+    for (i = 0; i < options.num_modules; i++) {
+        modules[i].data_base = address;
+        address += modules[i].data_count;
+    }
+
+    /* Relocating and resolving. */
+    if (errors == 0) {
+        for (i = 0; i < options.num_modules; i++)
+            errors += RelocateModule(&(modules[i]));
+        errors += ResolveExterns(externs, globals);
+    }
+
+    if (errors != 0) {
+        printf("Linking failed, %d errors are encountered.\n", errors);
+        FreeArena(arena);
+        return 1;
+    }
+
+    /* Collecting linked code and data. */
+    code = CreateBinary();
+    code->base = PROGRAM_BASE;
+    data = CreateBinary();
+    data->base = modules[0].data_base;
+    for (i = 0; i < options.num_modules; i++) {
+        for (j = 0; j < modules[i].code_count; j++)
+            AddBinary(code, modules[i].words[j]);
+        for (j = 0; j < modules[i].data_count; j++)
+            AddBinary(data, modules[i].words[modules[i].code_count + j]);
+    }
+
+    printf("Writing linked object file [ %s.ob ]\n", options.output);
+    WriteBinaryToObject(options.output, code, data);
+
+    FreeBinary(code);
+    FreeBinary(data);
+    FreeArena(arena);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef LINKER_H
+    #define LINKER_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "Data.h"
+#include "DataContainers.h"
+#include "Object.h"
+#include "Output.h"
+
+/* Object module given to linker (files .ob .ent .ext, or .obj of one source file). */
+typedef struct Module {
+    char* name;      /* File name without extension. */
+    int code_count;  /* Number of code words. */
+    int data_count;  /* Number of data words. */
+    int* words;      /* Code words and then data words. */
+    int code_base;   /* Address of module code in linked program. */
+    int data_base;   /* Address of module data in linked program. */
+    int failed;      /* 1 if module files could not be read. */
+} Module;
+
+/* Symbol defined by .entry in one of the modules. */
+typedef struct GlobalSymbol {
+    Module* module;  /* Module where symbol is defined. */
+    int address;     /* Address of symbol in module (as assembled). */
+} GlobalSymbol;
+
+/* Reference to external symbol. */
+typedef struct ExternReference {
+    Module* module;  /* Module with reference. */
+    char* name;      /* Name of external symbol. */
+    int address;     /* Address of base word of reference in module (as assembled). */
+} ExternReference;
+
+/* Options given to linker in command line. */
+typedef struct LinkerOptions {
+    char* output;    /* Name of linked object file without extension (-o). */
+    int binary;      /* 1 if modules are read from binary .obj files (--obj). */
+    char** modules;  /* Module names given as arguments (without extensions). */
+    int num_modules; /* Number of modules. */
+} LinkerOptions;
+
+/* Reads options and module names from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadLinkerOptions(int argc, char** argv, LinkerOptions* options);
+
+/* Reads entries of module from text .ent file and adds them to global symbols table.
+   Arguments:
+    module      -- Module.
+    fileName    -- Full file name.
+    globals     -- Global symbols table.
+   Returns:
+    Number of errors. */
+int ReadTextEntries(Module* module, char* fileName, HashMap* globals);
+
+/* Reads references to external symbols of module from text .ext file.
+   Arguments:
+    module      -- Module.
+    fileName    -- Full file name.
+    externs     -- Vector of references to add to.
+   Returns:
+    Number of errors. */
+int ReadTextExterns(Module* module, char* fileName, Vector* externs);
+
+/* Reads module from binary .obj file.
+   Arguments:
+    module      -- Module. Words and counts are set.
+    fileName    -- Full file name.
+    globals     -- Global symbols table.
+    externs     -- Vector of references to add to.
+   Returns:
+    Number of errors. */
+int ReadBinaryModule(Module* module, char* fileName, HashMap* globals, Vector* externs);
+
+/* Adds symbol defined by .entry to global symbols table.
+   Arguments:
+    globals     -- Global symbols table.
+    name        -- Symbol name (copied).
+    len         -- Length of symbol name.
+    module      -- Module where symbol is defined.
+    address     -- Address of symbol in module.
+   Returns:
+    1 if symbol is already defined by another module (message is printed), 0 otherwise. */
+int AddGlobalSymbol(HashMap* globals, char* name, int len, Module* module, int address);
+
+/* Translates address in module (as assembled) to address in linked program.
+   Arguments:
+    module  -- Module.
+    address -- Address in module.
+   Returns:
+    Address in linked program, or -1 if address is not in module. */
+int RelocateAddress(Module* module, int address);
+
+/* Relocates base+offset words of direct, or index argument
+   if they are relocatable (not external).
+   Arguments:
+    module  -- Module.
+    arg     -- Decoded argument.
+   Returns:
+    1 if address is not in module (message is printed), 0 otherwise. */
+int RelocateArgument(Module* module, DecodedArg* arg);
+
+/* Relocates base+offset words of references to internal symbols in module code.
+   Arguments:
+    module  -- Module.
+   Returns:
+    Number of errors. */
+int RelocateModule(Module* module);
+
+/* Writes base+offset words of references to external symbols.
+   Arguments:
+    externs -- Vector of references.
+    globals -- Global symbols table.
+   Returns:
+    Number of errors. */
+int ResolveExterns(Vector* externs, HashMap* globals);
+
+#endif
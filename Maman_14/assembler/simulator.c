@@ -0,0 +1,482 @@
+/* Program description:
+    This program executes object files produced by assembler (or by linker, see linker.c)
+    on simulated 20 bit machine.
+   Program operations:
+    Program takes name of object file without extension, loads code and data words
+    to memory starting at address 100, predecodes code to array of instructions and
+    executes it from the first instruction until stop instruction.
+   Machine:
+    -- 16 registers r0-r15 and memory of 65536 words. Registers and memory words hold
+    16 bit signed values (data part of machine word).
+    -- mov, add, sub, clr, not, inc, dec, lea, red write destination operand.
+    cmp sets Z flag if operands are equal, bne jumps if Z flag is not set.
+    jsr saves address of next instruction on call stack (separate from memory), rts returns to it.
+    -- prn prints value of operand as decimal number in a line, red reads decimal number
+    (-1 on end of input).
+    -- Writing to memory of code is an error, code is predecoded once and can't be changed.
+    Jump to address that is not a beginning of instruction is an error too.
+   Algorithm:
+    -- Predecoding. Code words are decoded instruction by instruction (see DecodeInstruction()).
+    Every operand is translated to pointer to its cell - register, memory word, or immediate value
+    stored in the instruction itself, and pointer to index register (register that is always 0
+    if operand is not indexed). So handlers read and write operands without checking addressing modes.
+    Jump addresses in direct mode are translated to pointers to instructions.
+    -- Execution. Every instruction keeps address of its handler code and handler jumps directly
+    to handler of next instruction (direct threaded code, GCC computed goto). Other compilers use
+    switch by instruction code.
+   Input:
+    File <name>.ob, or <name>.obj with --obj option. Program must have no external references
+    (link it first). Input of red instructions is read from standard input.
+   Options:
+    --obj   Read program from binary object .obj file (assembler --obj option).
+    -b      Print number of executed instructions and speed (instructions per second).
+    -r      Print registers after execution.
+    -m      Print data words of program after execution.
+    -n MAX  Stop after MAX instructions.
+   */
+
+#include "simulator.h"
+
+/* Reads options and program name from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadSimOptions(int argc, char** argv, SimOptions* options) {
+    int argn; /* Argument number. */
+
+    /* Default options. */
+    options->program = NULL;
+    options->binary = 0;
+    options->benchmark = 0;
+    options->dump = 0;
+    options->dump_memory = 0;
+    options->limit = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        /* Saving program name. */
+        if (argv[argn][0] != '-') {
+            if (options->program != NULL)
+                printf("Only one program can be executed, [ %s ] is ignored.\n", argv[argn]);
+            else
+                options->program = argv[argn];
+        }
+        else if (CompareStrings(argv[argn], "--obj"))
+            options->binary = 1;
+        else if (CompareStrings(argv[argn], "-b"))
+            options->benchmark = 1;
+        else if (CompareStrings(argv[argn], "-r"))
+            options->dump = 1;
+        else if (CompareStrings(argv[argn], "-m"))
+            options->dump_memory = 1;
+        else if (CompareStrings(argv[argn], "-n") && argn+1 < argc)
+            options->limit = strtoul(argv[++argn], NULL, 10);
+        else
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+/* Sets predecoded operand.
+   Arguments:
+    machine -- Machine.
+    op      -- Operand to set.
+    arg     -- Decoded argument.
+    address -- Address of instruction (for messages).
+   Returns:
+    1 if operand can't be executed (message is printed), 0 otherwise. */
+int PredecodeOperand(Machine* machine, SimOperand* op, DecodedArg* arg, int address) {
+    op->index = &(machine->zero);
+    op->address = -1;
+    op->value = 0;
+    op->base = &(op->value);
+
+    switch (arg->mode) {
+    case am_immediate:
+        op->value = arg->value;
+        break;
+    case am_direct:
+    case am_index:
+        if (arg->are == 1) {
+            printf("Instruction at address %d has reference to external symbol, link program first.\n", address);
+            return 1;
+        }
+        if (arg->value >= MEMORY_SIZE) {
+            printf("Instruction at address %d has address %d outside of memory.\n", address, arg->value);
+            return 1;
+        }
+        op->address = arg->value;
+        op->base = &(machine->memory[arg->value]);
+        if (arg->mode == am_index)
+            op->index = &(machine->registers[arg->reg]);
+        break;
+    case am_rdirect:
+        op->base = &(machine->registers[arg->reg]);
+        break;
+    }
+
+    return 0;
+}
+
+/* Finds instruction at jump address.
+   Arguments:
+    machine -- Machine.
+    address -- Jump address.
+   Returns:
+    Instruction, or NULL if no instruction starts at address. */
+SimIns* JumpTarget(Machine* machine, int address) {
+    if (address < PROGRAM_BASE || address >= PROGRAM_BASE + machine->code_count)
+        return NULL;
+    return machine->ins_at[address - PROGRAM_BASE];
+}
+
+/* Loads words to memory and predecodes code of program.
+   Arguments:
+    machine     -- Machine.
+    words       -- Code and then data words.
+    codeCount   -- Number of code words.
+    dataCount   -- Number of data words.
+   Returns:
+    Number of errors (messages are printed).
+   Algorithm:
+    First pass decodes instructions one after another and saves instruction
+    of every address. Second pass translates direct jump addresses to instructions.
+    Instruction with op -1 is placed after the last one, so running out of code
+    is detected by its handler. */
+int PredecodeProgram(Machine* machine, int* words, int codeCount, int dataCount) {
+    int pos = 0;     /* Index of current word in code. */
+    int errors = 0;  /* Number of errors. */
+    int i;           /* Iterator. */
+
+    memset(machine, 0, sizeof(Machine));
+    if (PROGRAM_BASE + codeCount + dataCount > MEMORY_SIZE) {
+        printf("Program of %d words does not fit in memory.\n", codeCount + dataCount);
+        return 1;
+    }
+
+    /* Loading memory. */
+    for (i = 0; i < codeCount + dataCount; i++)
+        machine->memory[PROGRAM_BASE + i] = WORD16(words[i]);
+
+    machine->code_count = codeCount;
+    machine->data_count = dataCount;
+    machine->code = (SimIns*)Allocate(sizeof(SimIns)*(codeCount+1));
+    machine->ins_at = (SimIns**)Allocate(sizeof(SimIns*)*(codeCount+1));
+    for (i = 0; i < codeCount; i++)
+        machine->ins_at[i] = NULL;
+
+    /* Decoding instructions. */
+    while (pos < codeCount) {
+        SimIns* ins = &(machine->code[machine->num_ins]); /* Predecoded instruction. */
+        DecodedIns decoded; /* Decoded instruction. */
+
+        if (!DecodeInstruction(words, codeCount, pos, &decoded)) {
+            printf("Incorrect instruction at address %d.\n", PROGRAM_BASE + pos);
+            return errors + 1;
+        }
+
+        ins->handler = NULL;
+        ins->op = decoded.ins;
+        ins->address = PROGRAM_BASE + pos;
+        ins->target = NULL;
+        errors += PredecodeOperand(machine, &(ins->src), &(decoded.src), ins->address);
+        errors += PredecodeOperand(machine, &(ins->dest), &(decoded.dest), ins->address);
+
+        machine->ins_at[pos] = ins;
+        machine->num_ins++;
+        pos += decoded.length;
+    }
+
+    /* Instruction after the last one. */
+    machine->code[machine->num_ins].handler = NULL;
+    machine->code[machine->num_ins].op = -1;
+    machine->code[machine->num_ins].address = PROGRAM_BASE + codeCount;
+
+    /* Translating direct jump addresses. */
+    for (i = 0; i < machine->num_ins; i++) {
+        SimIns* ins = &(machine->code[i]);
+        if ((ins->op == ins_jmp || ins->op == ins_bne || ins->op == ins_jsr) && ins->dest.address != -1)
+            ins->target = JumpTarget(machine, ins->dest.address);
+    }
+
+    return errors;
+}
+
+/* Checks that indexed address of operand is in memory.
+   Goes to fault otherwise. */
+#define CHECK_INDEX(op) \
+    if ((op).address != -1 && (unsigned int)((op).address + *((op).index)) >= MEMORY_SIZE) { \
+        fault = "Indexed address is outside of memory"; \
+        goto fault; \
+    }
+
+/* Sets p to cell of operand for reading. */
+#define READ_CELL(p, op) \
+    CHECK_INDEX(op) \
+    p = (op).base + *((op).index);
+
+/* Sets p to cell of operand for writing. Writing to code is not allowed.
+   Address of register operand is -1 and is never in code. */
+#define WRITE_CELL(p, op) \
+    CHECK_INDEX(op) \
+    if ((unsigned int)((op).address + *((op).index) - PROGRAM_BASE) < (unsigned int)codeCount) { \
+        fault = "Writing to memory of code"; \
+        goto fault; \
+    } \
+    p = (op).base + *((op).index);
+
+/* Goes to handler of current instruction. Stops if limit of instructions is reached. */
+#ifdef __GNUC__
+#define DISPATCH() \
+    if (executed++ == limit) \
+        goto limit_reached; \
+    __extension__ ({ goto *ip->handler; })
+#else
+#define DISPATCH() goto dispatch
+#endif
+
+/* Goes to next instruction. */
+#define NEXT() \
+    ip++; \
+    DISPATCH()
+
+/* Goes to instruction at destination address. */
+#define JUMP() \
+    next = ip->dest.index == &(machine->zero) ? ip->target : \
+        JumpTarget(machine, ip->dest.address + *(ip->dest.index)); \
+    if (next == NULL) { \
+        fault = "Jump to address that is not an instruction"; \
+        goto fault; \
+    } \
+    ip = next; \
+    DISPATCH()
+
+/* Executes predecoded program from its first instruction.
+   Arguments:
+    machine -- Machine.
+    limit   -- Maximum number of instructions to execute, 0 if unlimited.
+   Returns:
+    1 if program stopped by stop instruction, 0 otherwise (message is printed).
+   Algorithm:
+    Every handler executes one instruction and jumps to handler of next one.
+    With GCC address of handler is written to every instruction before execution
+    and jump is one indirect branch per instruction (computed goto). Handlers are
+    labels in this function, so state of the machine is kept in local variables. */
+int Run(Machine* machine, unsigned long limit) {
+    SimIns* ip = machine->code;      /* Current instruction. */
+    SimIns* next;                    /* Jump target. */
+    SimIns** sp = machine->stack;    /* Top of call stack. */
+    int codeCount = machine->code_count; /* Number of code words. */
+    int zeroFlag = 0;                /* Z flag. */
+    unsigned long executed = 0;      /* Number of executed instructions. */
+    char* fault = NULL;              /* Runtime error message. */
+    int* s;                          /* Cell of source operand. */
+    int* d;                          /* Cell of destination operand. */
+    int value;                       /* Value read by red. */
+#ifdef __GNUC__
+    int i;                           /* Instructions iterator. */
+    /* Handlers by instruction code, the last one is for op -1. */
+    static const void* const handlers[17] = {
+        __extension__ &&op_mov, __extension__ &&op_cmp, __extension__ &&op_add, __extension__ &&op_sub,
+        __extension__ &&op_lea, __extension__ &&op_clr, __extension__ &&op_not, __extension__ &&op_inc,
+        __extension__ &&op_dec, __extension__ &&op_jmp, __extension__ &&op_bne, __extension__ &&op_jsr,
+        __extension__ &&op_red, __extension__ &&op_prn, __extension__ &&op_rts, __extension__ &&op_stop,
+        __extension__ &&op_end
+    };
+
+    for (i = 0; i <= machine->num_ins; i++)
+        machine->code[i].handler = handlers[machine->code[i].op == -1 ? 16 : machine->code[i].op];
+#endif
+
+    /* Maximum number of instructions is never reached if there is no limit. */
+    if (limit == 0)
+        limit = (unsigned long)-1;
+
+    DISPATCH();
+
+#ifndef __GNUC__
+dispatch:
+    if (executed++ == limit)
+        goto limit_reached;
+    switch (ip->op) {
+    case ins_mov: goto op_mov;
+    case ins_cmp: goto op_cmp;
+    case ins_add: goto op_add;
+    case ins_sub: goto op_sub;
+    case ins_lea: goto op_lea;
+    case ins_clr: goto op_clr;
+    case ins_not: goto op_not;
+    case ins_inc: goto op_inc;
+    case ins_dec: goto op_dec;
+    case ins_jmp: goto op_jmp;
+    case ins_bne: goto op_bne;
+    case ins_jsr: goto op_jsr;
+    case ins_red: goto op_red;
+    case ins_prn: goto op_prn;
+    case ins_rts: goto op_rts;
+    case ins_stop: goto op_stop;
+    default: goto op_end;
+    }
+#endif
+
+op_mov:
+    READ_CELL(s, ip->src)
+    WRITE_CELL(d, ip->dest)
+    *d = *s;
+    NEXT();
+op_cmp:
+    READ_CELL(s, ip->src)
+    READ_CELL(d, ip->dest)
+    zeroFlag = *s == *d;
+    NEXT();
+op_add:
+    READ_CELL(s, ip->src)
+    WRITE_CELL(d, ip->dest)
+    *d = WORD16(*d + *s);
+    NEXT();
+op_sub:
+    READ_CELL(s, ip->src)
+    WRITE_CELL(d, ip->dest)
+    *d = WORD16(*d - *s);
+    NEXT();
+op_lea:
+    WRITE_CELL(d, ip->dest)
+    *d = WORD16(ip->src.address + *(ip->src.index));
+    NEXT();
+op_clr:
+    WRITE_CELL(d, ip->dest)
+    *d = 0;
+    NEXT();
+op_not:
+    WRITE_CELL(d, ip->dest)
+    *d = ~*d;
+    NEXT();
+op_inc:
+    WRITE_CELL(d, ip->dest)
+    *d = WORD16(*d + 1);
+    NEXT();
+op_dec:
+    WRITE_CELL(d, ip->dest)
+    *d = WORD16(*d - 1);
+    NEXT();
+op_jmp:
+    JUMP();
+op_bne:
+    if (zeroFlag) {
+        NEXT();
+    }
+    JUMP();
+op_jsr:
+    if (sp == machine->stack + CALL_STACK_SIZE) {
+        fault = "Call stack overflow";
+        goto fault;
+    }
+    *(sp++) = ip + 1;
+    JUMP();
+op_red:
+    WRITE_CELL(d, ip->dest)
+    if (scanf("%d", &value) != 1)
+        value = -1;
+    *d = WORD16(value);
+    NEXT();
+op_prn:
+    READ_CELL(d, ip->dest)
+    printf("%d\n", *d);
+    NEXT();
+op_rts:
+    if (sp == machine->stack) {
+        fault = "Return without subroutine call";
+        goto fault;
+    }
+    ip = *(--sp);
+    DISPATCH();
+op_stop:
+    machine->executed = executed;
+    machine->zero_flag = zeroFlag;
+    return 1;
+op_end:
+    executed--;
+    fault = "Execution reached end of code";
+    goto fault;
+
+limit_reached:
+    machine->executed = executed - 1;
+    machine->zero_flag = zeroFlag;
+    printf("Limit of %lu instructions is reached at address %d.\n", limit, ip->address);
+    return 0;
+
+fault:
+    machine->executed = executed;
+    machine->zero_flag = zeroFlag;
+    printf("Runtime error at address %d: %s.\n", ip->address, fault);
+    return 0;
+}
+
+/* Prints registers and Z flag.
+   Arguments:
+    machine -- Machine. */
+void DumpRegisters(Machine* machine) {
+    int i; /* Registers iterator. */
+
+    for (i = 0; i < NUM_REGISTERS; i++)
+        printf("r%d = %d\n", i, machine->registers[i]);
+    printf("Z = %d\n", machine->zero_flag);
+}
+
+/* Prints data words of program (address and value in every line).
+   Arguments:
+    machine -- Machine. */
+void DumpMemory(Machine* machine) {
+    int address; /* Memory iterator. */
+
+    for (address = PROGRAM_BASE + machine->code_count; address < PROGRAM_BASE + machine->code_count + machine->data_count; address++)
+        printf("%d: %d\n", address, machine->memory[address]);
+}
+
+/* Main function. Loads, predecodes and executes program given in arguments. */
+int main(int argc, char** argv) {
+    SimOptions options; /* Command line options. */
+    Arena* arena;       /* Arena for all objects of the simulator. */
+    Machine* machine;   /* Simulated machine. */
+    int* words;         /* Code and data words. */
+    int codeCount;      /* Number of code words. */
+    int dataCount;      /* Number of data words. */
+    clock_t start;      /* Time of execution start. */
+    double seconds;     /* Execution time. */
+    int stopped;        /* 1 if program stopped by stop instruction. */
+
+    ReadSimOptions(argc, argv, &options);
+    if (options.program == NULL) {
+        printf("No program to execute.\n");
+        return 1;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    machine = (Machine*)Allocate(sizeof(Machine));
+    words = ReadProgram(options.program, options.binary, &codeCount, &dataCount);
+    if (words == NULL || PredecodeProgram(machine, words, codeCount, dataCount) != 0) {
+        printf("Failed to load program [ %s ].\n", options.program);
+        FreeArena(arena);
+        return 1;
+    }
+
+    start = clock();
+    stopped = Run(machine, options.limit);
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (options.dump)
+        DumpRegisters(machine);
+    if (options.dump_memory)
+        DumpMemory(machine);
+    if (options.benchmark) {
+        printf("Executed %lu instructions in %.3f seconds", machine->executed, seconds);
+        if (seconds > 0)
+            printf(" (%.1f million instructions/s)", machine->executed / seconds / 1e6);
+        printf(".\n");
+    }
+
+    FreeArena(arena);
+    return stopped ? 0 : 1;
+}
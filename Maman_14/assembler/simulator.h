@@ -0,0 +1,112 @@
+#ifndef SIMULATOR_H
+    #define SIMULATOR_H
+
+#include <stdio.h>
+#include <time.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Object.h"
+
+/* Converts number to 16 bit signed value of register, or memory word. */
+#define WORD16(x) ((((x) & 0xffff) ^ 0x8000) - 0x8000)
+
+/* Operand of predecoded instruction.
+   Cell of operand is base + *index, so all addressing modes are
+   read and written the same way without checking the mode. */
+typedef struct SimOperand {
+    int* base;      /* Register, memory word at address, or value of immediate operand. */
+    int* index;     /* Index register in index mode, register that is always 0 otherwise. */
+    int address;    /* Memory address in direct and index modes, -1 otherwise. */
+    int value;      /* Value of immediate operand. */
+} SimOperand;
+
+/* Predecoded instruction. */
+typedef struct SimIns {
+    const void* handler;    /* Address of handler code (direct threaded dispatch). */
+    int op;                 /* Instruction according to InstructionsEnum, -1 after last instruction. */
+    int address;            /* Address of instruction. */
+    SimOperand src;         /* Source operand. */
+    SimOperand dest;        /* Destination operand. */
+    struct SimIns* target;  /* Instruction at jump address in direct mode, NULL if there is no instruction. */
+} SimIns;
+
+/* State of simulated machine and predecoded program. */
+typedef struct Machine {
+    int registers[NUM_REGISTERS]; /* Registers r0-r15. */
+    int zero;                     /* Always 0, index of operands that are not in index mode. */
+    int memory[MEMORY_SIZE];      /* Memory words (16 bit signed values). */
+    int zero_flag;                /* Z flag set by cmp. */
+    SimIns* code;                 /* Predecoded instructions, the last one has op -1. */
+    int num_ins;                  /* Number of instructions. */
+    SimIns** ins_at;              /* Instruction by address - PROGRAM_BASE, NULL if no instruction starts there. */
+    int code_count;               /* Number of code words. */
+    int data_count;               /* Number of data words. */
+    SimIns* stack[CALL_STACK_SIZE]; /* Return addresses of subroutine calls. */
+    unsigned long executed;       /* Number of executed instructions. */
+} Machine;
+
+/* Options given to simulator in command line. */
+typedef struct SimOptions {
+    char* program;          /* Name of object file without extension. */
+    int binary;             /* 1 if program is read from binary .obj file (--obj). */
+    int benchmark;          /* 1 if speed is printed (-b). */
+    int dump;               /* 1 if registers are printed after execution (-r). */
+    int dump_memory;        /* 1 if data memory is printed after execution (-m). */
+    unsigned long limit;    /* Maximum number of instructions to execute, 0 if unlimited (-n). */
+} SimOptions;
+
+/* Reads options and program name from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadSimOptions(int argc, char** argv, SimOptions* options);
+
+/* Sets predecoded operand.
+   Arguments:
+    machine -- Machine.
+    op      -- Operand to set.
+    arg     -- Decoded argument.
+    address -- Address of instruction (for messages).
+   Returns:
+    1 if operand can't be executed (message is printed), 0 otherwise. */
+int PredecodeOperand(Machine* machine, SimOperand* op, DecodedArg* arg, int address);
+
+/* Finds instruction at jump address.
+   Arguments:
+    machine -- Machine.
+    address -- Jump address.
+   Returns:
+    Instruction, or NULL if no instruction starts at address. */
+SimIns* JumpTarget(Machine* machine, int address);
+
+/* Loads words to memory and predecodes code of program.
+   Arguments:
+    machine     -- Machine.
+    words       -- Code and then data words.
+    codeCount   -- Number of code words.
+    dataCount   -- Number of data words.
+   Returns:
+    Number of errors (messages are printed). */
+int PredecodeProgram(Machine* machine, int* words, int codeCount, int dataCount);
+
+/* Executes predecoded program from its first instruction.
+   Arguments:
+    machine -- Machine.
+    limit   -- Maximum number of instructions to execute, 0 if unlimited.
+   Returns:
+    1 if program stopped by stop instruction, 0 otherwise (message is printed). */
+int Run(Machine* machine, unsigned long limit);
+
+/* Prints registers and Z flag.
+   Arguments:
+    machine -- Machine. */
+void DumpRegisters(Machine* machine);
+
+/* Prints data words of program (address and value in every line).
+   Arguments:
+    machine -- Machine. */
+void DumpMemory(Machine* machine);
+
+#endif
@@ -0,0 +1,661 @@
+/* Program description:
+    This program translates object files produced by assembler (or by linker, see linker.c)
+    to C source files, so programs are compiled by system C compiler and run at native speed.
+    Translated program behaves as the program executed by simulator (see simulator.c).
+   Program operations:
+    Program takes names of object files without extensions as arguments, decodes code of
+    every program and writes <name>.c with one function that executes the program and main
+    function that calls it.
+   Algorithm:
+    -- Decoding. Code words are decoded instruction by instruction (see DecodeInstruction())
+    using the same opcode, funct and addressing modes layout that assembler encodes.
+    Jump addresses in direct mode are checked and marked as used labels. Entry names (.ent file,
+    or entries table of .obj file) are written as comments of labels.
+    -- Translation. Every instruction becomes straight line C code with label L<address>.
+    Registers are r[0]-r[15] and memory is m[], immediate values and direct addresses are constants.
+    Direct jumps become goto statements. Jumps to addresses known only at runtime (index mode and
+    rts) go to switch by address. Runtime checks of simulator (indexed address outside of memory,
+    writing to code, jumps that are not to instructions, call stack) are kept, so both give the same
+    results and errors.
+   Input:
+    Files <name>.ob and <name>.ent, or <name>.obj with --obj option. Programs must have no
+    external references (link them first).
+   Output:
+    File <name>.c. Compiled program prints registers with -r option and data words with -m option
+    after execution, as simulator does.
+   Options:
+    --obj   Read programs from binary object .obj files (assembler --obj option).
+   */
+
+#include "translator.h"
+
+/* Beginning of translated program (lines, NULL after the last one). */
+static char* prologue[] = {
+    "#include <stdio.h>\n",
+    "#include <string.h>\n",
+    "\n",
+    "/* Converts number to 16 bit signed value of register, or memory word. */\n",
+    "#define WORD16(x) ((((x) & 0xffff) ^ 0x8000) - 0x8000)\n",
+    "/* Stops execution with runtime error. */\n",
+    "#define FAULT(address, message) do { printf(\"Runtime error at address %d: %s.\\n\", address, message); goto fault; } while (0)\n",
+    "/* Stops execution if indexed address is outside of memory. */\n",
+    "#define CHECK_INDEX(address, a) if ((unsigned int)(a) >= MEMORY_SIZE) FAULT(address, \"Indexed address is outside of memory\")\n",
+    "/* Stops execution if address is in memory of code. */\n",
+    "#define CHECK_WRITE(address, a) if ((unsigned int)((a) - PROGRAM_BASE) < CODE_COUNT) FAULT(address, \"Writing to memory of code\")\n",
+    "\n",
+    NULL
+};
+
+/* Main function of translated program up to the call of translated function. */
+static char* mainStart[] = {
+    "/* Executes program. Prints registers with -r option and data words with -m option. */\n",
+    "int main(int argc, char** argv) {\n",
+    "    static int m[MEMORY_SIZE];    /* Memory. */\n",
+    "    int r[NUM_REGISTERS];         /* Registers. */\n",
+    "    int z;                        /* Z flag. */\n",
+    "    int stopped;                  /* 1 if program stopped by stop instruction. */\n",
+    "    int dumpRegisters = 0, dumpMemory = 0; /* Options. */\n",
+    "    int i;                        /* Iterator. */\n",
+    "\n",
+    "    for (i = 1; i < argc; i++) {\n",
+    "        if (strcmp(argv[i], \"-r\") == 0)\n",
+    "            dumpRegisters = 1;\n",
+    "        else if (strcmp(argv[i], \"-m\") == 0)\n",
+    "            dumpMemory = 1;\n",
+    "    }\n",
+    "\n",
+    "    memset(r, 0, sizeof(r));\n",
+    "    stopped = ",
+    NULL
+};
+
+/* Main function of translated program after the call of translated function. */
+static char* mainEnd[] = {
+    "(r, m, &z);\n",
+    "\n",
+    "    if (dumpRegisters) {\n",
+    "        for (i = 0; i < NUM_REGISTERS; i++)\n",
+    "            printf(\"r%d = %d\\n\", i, r[i]);\n",
+    "        printf(\"Z = %d\\n\", z);\n",
+    "    }\n",
+    "    if (dumpMemory) {\n",
+    "        for (i = PROGRAM_BASE + CODE_COUNT; i < PROGRAM_BASE + CODE_COUNT + DATA_COUNT; i++)\n",
+    "            printf(\"%d: %d\\n\", i, m[i]);\n",
+    "    }\n",
+    "\n",
+    "    return stopped ? 0 : 1;\n",
+    "}\n",
+    NULL
+};
+
+/* Reads options and program names from command line arguments.
+   Unknown options are reported and ignored.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadTranslatorOptions(int argc, char** argv, TranslatorOptions* options) {
+    int argn; /* Argument number. */
+
+    options->binary = 0;
+
+    /* Allocating array of program names. There are no more program names than arguments. */
+    options->programs = (char**)malloc(sizeof(char*)*argc);
+    if (options->programs == NULL) {
+        perror("Failed to allocate memory.");
+        exit(1);
+    }
+    options->num_programs = 0;
+
+    for (argn = 1; argn < argc; argn++) {
+        if (argv[argn][0] != '-') {
+            options->programs[options->num_programs] = argv[argn];
+            options->num_programs++;
+        }
+        else if (CompareStrings(argv[argn], "--obj"))
+            options->binary = 1;
+        else
+            printf("Unknown option [ %s ] is ignored.\n", argv[argn]);
+    }
+}
+
+/* Reads entry names of code addresses to use them in comments of translated code.
+   Arguments:
+    t       -- Translation. Labels are set.
+    binary  -- 1 if entries are read from binary .obj file, 0 for text .ent file.
+   Algorithm:
+    Every line of .ent file is NAME,BASE,OFFSET, address of the entry is BASE+OFFSET.
+    Missing, or incorrect file only leaves labels without names. */
+void ReadEntryLabels(Translation* t, int binary) {
+    int len = StringLen(t->name); /* Length of program name. */
+    char* fullName = (char*)Allocate(sizeof(char)*(len+5)); /* Name with extension. */
+    int i; /* Iterator. */
+
+    t->labels = (char**)Allocate(sizeof(char*)*(t->code_count+1));
+    for (i = 0; i < t->code_count; i++)
+        t->labels[i] = NULL;
+
+    if (binary) {
+        ObjectFile* obj; /* Binary object file. */
+
+        AppendExtension(t->name, "obj", fullName, len+4);
+        obj = OpenObjectFile(fullName);
+        if (obj == NULL)
+            return;
+        for (i = 0; i < obj->num_entries; i++) {
+            int address; /* Address of entry. */
+            char* name = GetObjectEntry(obj, i, &address); /* Name of entry (in mapped file). */
+            if (address >= PROGRAM_BASE && address < PROGRAM_BASE + t->code_count) {
+                char* copy = (char*)Allocate(sizeof(char)*(StringLen(name)+1)); /* Copy of name. */
+                memcpy(copy, name, StringLen(name)+1);
+                t->labels[address - PROGRAM_BASE] = copy;
+            }
+        }
+        CloseObjectFile(obj);
+    }
+    else {
+        unsigned char* text; /* Content of .ent file. */
+        size_t size;         /* Size of .ent file. */
+        size_t pos = 0;      /* Position in text. */
+
+        AppendExtension(t->name, "ent", fullName, len+4);
+        text = MapFile(fullName, &size);
+        if (text == NULL)
+            return;
+        while (pos < size) {
+            size_t start = pos; /* Position of the name. */
+            int base, offset;   /* Address of the entry. */
+            char* name;         /* Name of the entry. */
+
+            while (pos < size && text[pos] != ',' && text[pos] != '\n')
+                pos++;
+            name = (char*)Allocate(sizeof(char)*(pos-start+1));
+            memcpy(name, text + start, pos - start);
+            name[pos-start] = '\0';
+            pos++;
+            base = ReadTextNumber(text, &pos, size);
+            pos++;
+            offset = ReadTextNumber(text, &pos, size);
+            if (base == -1 || offset == -1)
+                break;
+            pos++;
+
+            if (base + offset >= PROGRAM_BASE && base + offset < PROGRAM_BASE + t->code_count)
+                t->labels[base + offset - PROGRAM_BASE] = name;
+        }
+        UnmapFile(text, size);
+    }
+}
+
+/* Decodes code of program and finds used labels.
+   Arguments:
+    t   -- Translation. Words and counts are set.
+   Returns:
+    Number of errors (messages are printed).
+   Algorithm:
+    First pass decodes instructions one after another and saves instruction
+    of every address. Second pass marks labels of direct jumps targets. */
+int DecodeProgram(Translation* t) {
+    int pos = 0;    /* Index of current word in code. */
+    int errors = 0; /* Number of errors. */
+    int i;          /* Iterator. */
+
+    t->code = (DecodedIns*)Allocate(sizeof(DecodedIns)*(t->code_count+1));
+    t->ins_at = (int*)Allocate(sizeof(int)*(t->code_count+1));
+    t->is_target = (char*)Allocate(sizeof(char)*(t->code_count+1));
+    t->num_ins = 0;
+    t->uses_dispatch = 0;
+    t->uses_stack = 0;
+    t->uses_return = 0;
+    t->uses_src_index = 0;
+    t->uses_dest_index = 0;
+    t->uses_input = 0;
+    for (i = 0; i < t->code_count; i++) {
+        t->ins_at[i] = -1;
+        t->is_target[i] = 0;
+    }
+
+    /* Decoding instructions. */
+    while (pos < t->code_count) {
+        DecodedIns* ins = &(t->code[t->num_ins]); /* Decoded instruction. */
+
+        if (!DecodeInstruction(t->words, t->code_count, pos, ins)) {
+            printf("Incorrect instruction at address %d.\n", PROGRAM_BASE + pos);
+            return errors + 1;
+        }
+        if (ins->src.are == 1 || ins->dest.are == 1) {
+            printf("Instruction at address %d has reference to external symbol, link program first.\n", PROGRAM_BASE + pos);
+            errors++;
+        }
+        if ((ins->src.mode == am_direct || ins->src.mode == am_index) && ins->src.value >= MEMORY_SIZE) {
+            printf("Instruction at address %d has address %d outside of memory.\n", PROGRAM_BASE + pos, ins->src.value);
+            errors++;
+        }
+        if ((ins->dest.mode == am_direct || ins->dest.mode == am_index) && ins->dest.value >= MEMORY_SIZE) {
+            printf("Instruction at address %d has address %d outside of memory.\n", PROGRAM_BASE + pos, ins->dest.value);
+            errors++;
+        }
+
+        t->ins_at[pos] = t->num_ins;
+        t->num_ins++;
+        pos += ins->length;
+    }
+
+    /* Finding used labels and features. */
+    for (i = 0; i < t->num_ins; i++) {
+        DecodedIns* ins = &(t->code[i]);
+        int jump = ins->ins == ins_jmp || ins->ins == ins_bne || ins->ins == ins_jsr; /* 1 for jumps. */
+        int target = ins->dest.value - PROGRAM_BASE; /* Index of jump address in code. */
+
+        if (jump && ins->dest.mode == am_direct && target >= 0 && target < t->code_count && t->ins_at[target] != -1)
+            t->is_target[target] = 1;
+        if ((jump && ins->dest.mode == am_index) || ins->ins == ins_rts)
+            t->uses_dispatch = 1;
+        if (ins->ins == ins_jsr || ins->ins == ins_rts)
+            t->uses_stack = 1;
+        if (ins->ins == ins_rts)
+            t->uses_return = 1;
+        if (ins->ins == ins_red)
+            t->uses_input = 1;
+        if (ins->src.mode == am_index && ins->ins != ins_lea)
+            t->uses_src_index = 1;
+        if (ins->dest.mode == am_index && !jump)
+            t->uses_dest_index = 1;
+    }
+
+    return errors;
+}
+
+/* Adds null-terminated string to output buffer.
+   Arguments:
+    buf -- Output buffer.
+    s   -- String. */
+void EmitText(OutputBuffer* buf, char* s) {
+    AppendText(buf, s, StringLen(s));
+}
+
+/* Adds lines to output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    lines   -- Lines, NULL after the last one. */
+void EmitLines(OutputBuffer* buf, char** lines) {
+    int i; /* Lines iterator. */
+
+    for (i = 0; lines[i] != NULL; i++)
+        EmitText(buf, lines[i]);
+}
+
+/* Adds C expression of operand cell, or value of immediate operand.
+   Arguments:
+    buf     -- Output buffer.
+    arg     -- Decoded argument.
+    var     -- Name of variable with indexed address. */
+void EmitOperand(OutputBuffer* buf, DecodedArg* arg, char* var) {
+    switch (arg->mode) {
+    case am_immediate:
+        AppendNumber(buf, arg->value, 0);
+        break;
+    case am_direct:
+        EmitText(buf, "m[");
+        AppendNumber(buf, arg->value, 0);
+        EmitText(buf, "]");
+        break;
+    case am_index:
+        EmitText(buf, "m[");
+        EmitText(buf, var);
+        EmitText(buf, "]");
+        break;
+    case am_rdirect:
+        EmitText(buf, "r[");
+        AppendNumber(buf, arg->reg, 0);
+        EmitText(buf, "]");
+        break;
+    }
+}
+
+/* Adds statements that calculate and check address of operand.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    arg     -- Decoded argument.
+    var     -- Name of variable for indexed address.
+    address -- Address of instruction.
+    write   -- 1 if operand is written.
+   Algorithm:
+    Direct addresses are checked here, only indexed addresses are checked at runtime. */
+void EmitOperandCheck(OutputBuffer* buf, Translation* t, DecodedArg* arg, char* var, int address, int write) {
+    if (arg->mode == am_index) {
+        EmitText(buf, "    ");
+        EmitText(buf, var);
+        EmitText(buf, " = ");
+        AppendNumber(buf, arg->value, 0);
+        EmitText(buf, " + r[");
+        AppendNumber(buf, arg->reg, 0);
+        EmitText(buf, "];\n    CHECK_INDEX(");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ", ");
+        EmitText(buf, var);
+        EmitText(buf, ");\n");
+        if (write) {
+            EmitText(buf, "    CHECK_WRITE(");
+            AppendNumber(buf, address, 0);
+            EmitText(buf, ", ");
+            EmitText(buf, var);
+            EmitText(buf, ");\n");
+        }
+    }
+    else if (arg->mode == am_direct && write && arg->value >= PROGRAM_BASE && arg->value < PROGRAM_BASE + t->code_count) {
+        EmitText(buf, "    FAULT(");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ", \"Writing to memory of code\");\n");
+    }
+}
+
+/* Adds jump to destination of instruction.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    ins     -- Decoded instruction.
+    address -- Address of instruction. */
+void EmitJump(OutputBuffer* buf, Translation* t, DecodedIns* ins, int address) {
+    int target = ins->dest.value - PROGRAM_BASE; /* Index of jump address in code. */
+
+    /* Jump address is known only at runtime. */
+    if (ins->dest.mode == am_index) {
+        EmitText(buf, "{ a = ");
+        AppendNumber(buf, ins->dest.value, 0);
+        EmitText(buf, " + r[");
+        AppendNumber(buf, ins->dest.reg, 0);
+        EmitText(buf, "]; pc = ");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, "; goto dispatch; }\n");
+    }
+    else if (target >= 0 && target < t->code_count && t->ins_at[target] != -1) {
+        EmitText(buf, "goto L");
+        AppendNumber(buf, ins->dest.value, 0);
+        EmitText(buf, ";\n");
+    }
+    else {
+        EmitText(buf, "FAULT(");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ", \"Jump to address that is not an instruction\");\n");
+    }
+}
+
+/* Adds C statements of one instruction.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    ins     -- Decoded instruction.
+    address -- Address of instruction. */
+void EmitInstruction(OutputBuffer* buf, Translation* t, DecodedIns* ins, int address) {
+    int writes = ins->ins != ins_cmp && ins->ins != ins_prn; /* 1 if destination is written. */
+
+    /* Checking operands as simulator does - source first. */
+    if (ins->num_args == 2 && ins->ins != ins_lea)
+        EmitOperandCheck(buf, t, &(ins->src), "sa", address, 0);
+    if (ins->num_args >= 1 && ins->ins != ins_jmp && ins->ins != ins_bne && ins->ins != ins_jsr)
+        EmitOperandCheck(buf, t, &(ins->dest), "da", address, writes);
+
+    EmitText(buf, "    ");
+    switch (ins->ins) {
+    case ins_mov:
+    case ins_add:
+    case ins_sub:
+        EmitOperand(buf, &(ins->dest), "da");
+        if (ins->ins == ins_mov) {
+            EmitText(buf, " = ");
+            EmitOperand(buf, &(ins->src), "sa");
+        }
+        else {
+            EmitText(buf, " = WORD16(");
+            EmitOperand(buf, &(ins->dest), "da");
+            EmitText(buf, ins->ins == ins_add ? " + " : " - ");
+            EmitOperand(buf, &(ins->src), "sa");
+            EmitText(buf, ")");
+        }
+        EmitText(buf, ";\n");
+        break;
+    case ins_cmp:
+        EmitText(buf, "zf = ");
+        EmitOperand(buf, &(ins->src), "sa");
+        EmitText(buf, " == ");
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, ";\n");
+        break;
+    case ins_lea:
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, " = WORD16(");
+        AppendNumber(buf, ins->src.value, 0);
+        if (ins->src.mode == am_index) {
+            EmitText(buf, " + r[");
+            AppendNumber(buf, ins->src.reg, 0);
+            EmitText(buf, "]");
+        }
+        EmitText(buf, ");\n");
+        break;
+    case ins_clr:
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, " = 0;\n");
+        break;
+    case ins_not:
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, " = ~");
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, ";\n");
+        break;
+    case ins_inc:
+    case ins_dec:
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, " = WORD16(");
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, ins->ins == ins_inc ? " + 1);\n" : " - 1);\n");
+        break;
+    case ins_jmp:
+        EmitJump(buf, t, ins, address);
+        break;
+    case ins_bne:
+        EmitText(buf, "if (!zf) ");
+        EmitJump(buf, t, ins, address);
+        break;
+    case ins_jsr:
+        EmitText(buf, "if (sp == CALL_STACK_SIZE) FAULT(");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ", \"Call stack overflow\");\n    ");
+        /* Return address is saved only if there are returns. */
+        if (t->uses_return) {
+            EmitText(buf, "stack[sp] = ");
+            AppendNumber(buf, address + ins->length, 0);
+            EmitText(buf, ";\n    ");
+        }
+        EmitText(buf, "sp++;\n    ");
+        EmitJump(buf, t, ins, address);
+        break;
+    case ins_red:
+        EmitText(buf, "if (scanf(\"%d\", &v) != 1) v = -1;\n    ");
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, " = WORD16(v);\n");
+        break;
+    case ins_prn:
+        EmitText(buf, "printf(\"%d\\n\", ");
+        EmitOperand(buf, &(ins->dest), "da");
+        EmitText(buf, ");\n");
+        break;
+    case ins_rts:
+        EmitText(buf, "if (sp == 0) FAULT(");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ", \"Return without subroutine call\");\n    a = stack[--sp];\n    if (a == PROGRAM_BASE + CODE_COUNT) FAULT(a, \"Execution reached end of code\");\n    pc = ");
+        AppendNumber(buf, address, 0);
+        EmitText(buf, ";\n    goto dispatch;\n");
+        break;
+    case ins_stop:
+        EmitText(buf, "*z = zf;\n    return 1;\n");
+        break;
+    }
+}
+
+/* Writes C source file of translated program (<name>.c).
+   Arguments:
+    t   -- Decoded program.
+   Algorithm:
+    Body of the function is translated first, so only variables and labels
+    that are used are declared (translated program compiles without warnings).
+    Then prologue, image of memory, the function and main are written. */
+void WriteTranslation(Translation* t) {
+    OutputBuffer body; /* Translated instructions. */
+    OutputBuffer out;  /* Whole file. */
+    char* func;        /* Name of function (run_ and program name). */
+    char* base = t->name; /* Program name without directories. */
+    int len;           /* Length of program name. */
+    int index;         /* Index of instruction address in code. */
+    int i;             /* Iterator. */
+
+    /* Function name is made of letters and digits of program name. */
+    for (i = 0; t->name[i] != '\0'; i++) {
+        if (t->name[i] == '/')
+            base = t->name + i + 1;
+    }
+    len = StringLen(base);
+    func = (char*)Allocate(sizeof(char)*(len+5));
+    memcpy(func, "run_", 4);
+    for (i = 0; i <= len; i++) {
+        char c = base[i]; /* Character of name. */
+        func[4+i] = (c == '\0' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) ? c : '_';
+    }
+
+    /* Translating instructions. */
+    InitOutputBuffer(&body, t->num_ins*64 + 256);
+    for (index = 0; index < t->code_count; index++) {
+        int address = PROGRAM_BASE + index; /* Address of instruction. */
+
+        if (t->ins_at[index] == -1)
+            continue;
+
+        if (t->uses_dispatch || t->is_target[index]) {
+            EmitText(&body, "L");
+            AppendNumber(&body, address, 0);
+            EmitText(&body, ":");
+            if (t->labels[index] != NULL) {
+                EmitText(&body, " /* ");
+                EmitText(&body, t->labels[index]);
+                EmitText(&body, " */");
+            }
+            EmitText(&body, "\n");
+        }
+        EmitInstruction(&body, t, &(t->code[t->ins_at[index]]), address);
+    }
+    EmitText(&body, "    FAULT(PROGRAM_BASE + CODE_COUNT, \"Execution reached end of code\");\n");
+
+    /* Switch for jumps to addresses known at runtime. */
+    if (t->uses_dispatch) {
+        EmitText(&body, "\ndispatch:\n    switch (a) {\n");
+        for (i = 0; i < t->code_count; i++) {
+            if (t->ins_at[i] != -1) {
+                EmitText(&body, "    case ");
+                AppendNumber(&body, PROGRAM_BASE + i, 0);
+                EmitText(&body, ": goto L");
+                AppendNumber(&body, PROGRAM_BASE + i, 0);
+                EmitText(&body, ";\n");
+            }
+        }
+        EmitText(&body, "    }\n    FAULT(pc, \"Jump to address that is not an instruction\");\n");
+    }
+
+    /* Prologue and constants. */
+    InitOutputBuffer(&out, body.length + (t->code_count + t->data_count)*8 + 4096);
+    EmitText(&out, "/* Program ");
+    EmitText(&out, t->name);
+    EmitText(&out, " translated to C by translator. */\n\n");
+    EmitLines(&out, prologue);
+    EmitText(&out, "/* Address of first code word. */\n#define PROGRAM_BASE ");
+    AppendNumber(&out, PROGRAM_BASE, 0);
+    EmitText(&out, "\n/* Number of memory words. */\n#define MEMORY_SIZE ");
+    AppendNumber(&out, MEMORY_SIZE, 0);
+    EmitText(&out, "u\n/* Number of registers. */\n#define NUM_REGISTERS ");
+    AppendNumber(&out, NUM_REGISTERS, 0);
+    EmitText(&out, "\n/* Maximum depth of subroutine calls. */\n#define CALL_STACK_SIZE ");
+    AppendNumber(&out, CALL_STACK_SIZE, 0);
+    EmitText(&out, "\n/* Number of code words. */\n#define CODE_COUNT ");
+    AppendNumber(&out, t->code_count, 0);
+    EmitText(&out, "u\n/* Number of data words. */\n#define DATA_COUNT ");
+    AppendNumber(&out, t->data_count, 0);
+    EmitText(&out, "\n\n");
+
+    /* Memory image - 16 bit values of code and data words. */
+    EmitText(&out, "/* Code and data words loaded to memory. */\nstatic const int image[CODE_COUNT + DATA_COUNT + 1] = {");
+    for (i = 0; i < t->code_count + t->data_count; i++) {
+        EmitText(&out, i % 10 == 0 ? "\n    " : " ");
+        AppendNumber(&out, (((t->words[i]) & 0xffff) ^ 0x8000) - 0x8000, 0);
+        EmitText(&out, ",");
+    }
+    EmitText(&out, "\n    0\n};\n\n");
+
+    /* Function. */
+    EmitText(&out, "/* Executes program.\n   Arguments:\n    r   -- Registers.\n    m   -- Memory, code and data words are loaded from PROGRAM_BASE.\n"
+                   "    z   -- Variable for returning Z flag.\n   Returns:\n"
+                   "    1 if program stopped by stop instruction, 0 otherwise (message is printed). */\nint ");
+    EmitText(&out, func);
+    EmitText(&out, "(int* r, int* m, int* z) {\n    int zf = 0; /* Z flag. */\n");
+    if (t->uses_dispatch)
+        EmitText(&out, "    int a;      /* Jump address known at runtime. */\n    int pc;     /* Address of jump instruction. */\n");
+    if (t->uses_return)
+        EmitText(&out, "    int stack[CALL_STACK_SIZE]; /* Return addresses. */\n");
+    if (t->uses_stack)
+        EmitText(&out, "    int sp = 0; /* Number of return addresses. */\n");
+    if (t->uses_src_index)
+        EmitText(&out, "    int sa;     /* Indexed address of source operand. */\n");
+    if (t->uses_dest_index)
+        EmitText(&out, "    int da;     /* Indexed address of destination operand. */\n");
+    if (t->uses_input)
+        EmitText(&out, "    int v;      /* Value read by red. */\n");
+    EmitText(&out, "\n    memcpy(m + PROGRAM_BASE, image, sizeof(int)*(CODE_COUNT + DATA_COUNT));\n\n");
+    AppendText(&out, body.text, body.length);
+    EmitText(&out, "\nfault:\n    *z = zf;\n    return 0;\n}\n\n");
+
+    /* Main function. */
+    EmitLines(&out, mainStart);
+    EmitText(&out, func);
+    EmitLines(&out, mainEnd);
+
+    WriteOutputFile(t->name, "c", &out);
+}
+
+/* Main function. Translates every program given in arguments. */
+int main(int argc, char** argv) {
+    TranslatorOptions options; /* Command line options. */
+    Arena* arena;              /* Arena for objects of current program. */
+    int failed = 0;            /* Number of programs that were not translated. */
+    int i;                     /* Programs iterator. */
+
+    ReadTranslatorOptions(argc, argv, &options);
+    if (options.num_programs == 0) {
+        printf("No programs to translate.\n");
+        return 1;
+    }
+
+    arena = CreateArena(ARENA_BLOCK_SIZE);
+    UseArena(arena);
+
+    for (i = 0; i < options.num_programs; i++) {
+        Translation t; /* Current program. */
+
+        t.name = options.programs[i];
+        printf("Translating program [ %s ]\n", t.name);
+        t.words = ReadProgram(t.name, options.binary, &(t.code_count), &(t.data_count));
+        if (t.words == NULL || DecodeProgram(&t) != 0) {
+            printf("Failed to translate program [ %s ].\n", t.name);
+            failed++;
+        }
+        else {
+            ReadEntryLabels(&t, options.binary);
+            WriteTranslation(&t);
+            printf("Program [ %s ] is translated to [ %s.c ]\n", t.name, t.name);
+        }
+
+        ResetArena(arena);
+    }
+
+    FreeArena(arena);
+    free(options.programs);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#ifndef TRANSLATOR_H
+    #define TRANSLATOR_H
+
+#include <stdio.h>
+#include "Definitions.h"
+#include "Arena.h"
+#include "MyString.h"
+#include "Object.h"
+#include "Output.h"
+
+/* Options given to translator in command line. */
+typedef struct TranslatorOptions {
+    int binary;         /* 1 if programs are read from binary .obj files (--obj). */
+    char** programs;    /* Program names given as arguments (without extensions). */
+    int num_programs;   /* Number of programs. */
+} TranslatorOptions;
+
+/* Program being translated. */
+typedef struct Translation {
+    char* name;         /* Name of object file without extension. */
+    int* words;         /* Code and then data words. */
+    int code_count;     /* Number of code words. */
+    int data_count;     /* Number of data words. */
+    DecodedIns* code;   /* Decoded instructions. */
+    int num_ins;        /* Number of instructions. */
+    int* ins_at;        /* Index of instruction by address - PROGRAM_BASE, -1 if no instruction starts there. */
+    char* is_target;    /* 1 by address - PROGRAM_BASE if label of instruction is used. */
+    char** labels;      /* Entry name by address - PROGRAM_BASE, NULL if there is no entry. */
+    int uses_dispatch;  /* 1 if there are jumps to addresses known only at runtime (index mode, rts). */
+    int uses_stack;     /* 1 if there are subroutine calls. */
+    int uses_return;    /* 1 if there are returns from subroutines. */
+    int uses_src_index; /* 1 if there are source operands in index mode. */
+    int uses_dest_index; /* 1 if there are destination operands in index mode. */
+    int uses_input;     /* 1 if there are red instructions. */
+} Translation;
+
+/* Reads options and program names from command line arguments.
+   Arguments:
+    argc    -- Number of arguments.
+    argv    -- Arguments.
+    options -- Structure to fill. */
+void ReadTranslatorOptions(int argc, char** argv, TranslatorOptions* options);
+
+/* Reads entry names of code addresses to use them in comments of translated code.
+   Arguments:
+    t       -- Translation. Labels are set.
+    binary  -- 1 if entries are read from binary .obj file, 0 for text .ent file. */
+void ReadEntryLabels(Translation* t, int binary);
+
+/* Decodes code of program and finds used labels.
+   Arguments:
+    t   -- Translation. Words and counts are set.
+   Returns:
+    Number of errors (messages are printed). */
+int DecodeProgram(Translation* t);
+
+/* Adds null-terminated string to output buffer.
+   Arguments:
+    buf -- Output buffer.
+    s   -- String. */
+void EmitText(OutputBuffer* buf, char* s);
+
+/* Adds lines to output buffer.
+   Arguments:
+    buf     -- Output buffer.
+    lines   -- Lines, NULL after the last one. */
+void EmitLines(OutputBuffer* buf, char** lines);
+
+/* Adds C expression of operand cell, or value of immediate operand.
+   Arguments:
+    buf     -- Output buffer.
+    arg     -- Decoded argument.
+    var     -- Name of variable with indexed address. */
+void EmitOperand(OutputBuffer* buf, DecodedArg* arg, char* var);
+
+/* Adds statements that calculate and check address of operand.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    arg     -- Decoded argument.
+    var     -- Name of variable for indexed address.
+    address -- Address of instruction.
+    write   -- 1 if operand is written. */
+void EmitOperandCheck(OutputBuffer* buf, Translation* t, DecodedArg* arg, char* var, int address, int write);
+
+/* Adds jump to destination of instruction.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    ins     -- Decoded instruction.
+    address -- Address of instruction. */
+void EmitJump(OutputBuffer* buf, Translation* t, DecodedIns* ins, int address);
+
+/* Adds C statements of one instruction.
+   Arguments:
+    buf     -- Output buffer.
+    t       -- Translation.
+    ins     -- Decoded instruction.
+    address -- Address of instruction. */
+void EmitInstruction(OutputBuffer* buf, Translation* t, DecodedIns* ins, int address);
+
+/* Writes C source file of translated program (<name>.c).
+   Arguments:
+    t   -- Decoded program. */
+void WriteTranslation(Translation* t);
+
+#endif